@@ -0,0 +1,105 @@
+/*
+ * Throughput of jq_parse_buf and of the streaming parse on generated corpora.
+ *
+ * Every binary is built by the Makefile with one combination of JQ_WITH_LOCATION
+ * and JQ_WITH_NULLTERM, JQ_WITH_VLEN is always on. `make run` runs all of them and
+ * prints one CSV table, one line per corpus, mode and chunk size:
+ *
+ *     config,corpus,mode,chunk,bytes,documents,events,iterations,seconds,mb_per_s,docs_per_s
+ *
+ * mode is "buf" for the whole corpus parsed at once with jq_parse_buf, and "chunk"
+ * for the corpus coming in chunks of the size given, the tail of every chunk
+ * moved to the beginning of the next one, as it comes from a socket or a pipe.
+ *
+ * Options:
+ *     --header    prints the CSV header and exits
+ *     -t SECONDS  the minimum time of every measurement, 0.3 by default
+ *     -s MB       the size of every generated corpus, 16 by default
+ *     FILE...     json files measured along with the generated corpora
+ */
+#define _POSIX_C_SOURCE 200809L
+#define JQ_WITH_IMPLEMENTATION
+#include "jquick.h"
+#include "bench.h"
+
+#ifndef BENCH_CONFIG
+#define BENCH_CONFIG "custom"
+#endif
+
+static double min_time = 0.3;
+
+/* ==============================
+ *
+ * Measurements
+ *
+ ================================ */
+
+static void measure(const struct corpus *c, size_t chunk) {
+    unsigned long iterations = 0, n;
+    double start, seconds;
+    jq_bool ok;
+
+    /* The one run before the measurement checks the corpus and counts the events */
+    memcpy(work, c->data, c->size + 1);
+    events = 0;
+    ok = chunk ? parse_chunks(c, chunk) : parse_whole(c);
+    n = events;
+    if (!ok) {
+        fprintf(stderr, "%s: %s can't be parsed\n", BENCH_CONFIG, c->name);
+        exit(1);
+    }
+    /* JQ_WITH_NULLTERM puts back every char it substitutes */
+    if (!chunk && memcmp(work, c->data, c->size + 1) != 0) {
+        fprintf(stderr, "%s: %s is changed by the parser\n", BENCH_CONFIG, c->name);
+        exit(1);
+    }
+
+    start = now();
+    do {
+        if (chunk) {
+            parse_chunks(c, chunk);
+        } else {
+            parse_whole(c);
+        }
+        ++iterations;
+        seconds = now() - start;
+    } while (seconds < min_time);
+
+    printf("%s,%s,%s,%lu,%lu,%lu,%lu,%lu,%.6f,%.2f,%.2f\n", BENCH_CONFIG, c->name, chunk ? "chunk" : "buf",
+            (unsigned long)chunk, (unsigned long)c->size, (unsigned long)c->documents, n, iterations, seconds,
+            c->size * (double)iterations / seconds / 1e6, c->documents * (double)iterations / seconds);
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+    struct corpus corpora[BENCH_CORPORA];
+    size_t size = 16u << 20, count, i, k;
+    int a;
+
+    for (a = 1; a < argc && argv[a][0] == '-'; ++a) {
+        if (strcmp(argv[a], "--header") == 0) {
+            printf("config,corpus,mode,chunk,bytes,documents,events,iterations,seconds,mb_per_s,docs_per_s\n");
+            return 0;
+        } else if (strcmp(argv[a], "-t") == 0 && a + 1 < argc) {
+            min_time = atof(argv[++a]);
+        } else if (strcmp(argv[a], "-s") == 0 && a + 1 < argc) {
+            size = (size_t)(atof(argv[++a]) * (1 << 20));
+        } else {
+            fprintf(stderr, "Usage: %s [--header] [-t SECONDS] [-s MB] [FILE...]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    count = load_corpora(corpora, size, argc - a, argv + a);
+    alloc_work(corpora, count);
+
+    for (i = 0; i < count; ++i) {
+        measure(&corpora[i], 0);
+        for (k = 0; k < sizeof(chunks) / sizeof(chunks[0]); ++k) measure(&corpora[i], chunks[k]);
+    }
+
+    for (i = 0; i < count; ++i) free(corpora[i].data);
+    free(work);
+
+    return 0;
+}
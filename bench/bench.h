@@ -0,0 +1,316 @@
+/*
+ * The corpora and the parse loops of bench.c and profile.c.
+ *
+ * The generated corpora are the same for every run, their seed is fixed.
+ * The corpus is followed by a space in memory, so a number can end it.
+ * It is included after jquick.h.
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* The longest token of the corpora must fit the room left before the chunk */
+#define BENCH_ROOM 4096
+
+struct corpus {
+    const char *name;
+    char *data;
+    size_t size;
+    size_t documents;
+    jq_bool multi;
+};
+
+#define BENCH_CORPORA 64
+
+/* The kind of JQ_PROFILE() for the chunk copies of parse_chunks(), after the kinds of jquick.h */
+#define BENCH_PROFILE_COPY 4
+
+static const size_t chunks[] = { 64, 512, 4096, 65536 };
+
+static unsigned long events;
+
+static void count_events(struct jq_handler *h, enum jq_event_type e) {
+    (void)h;
+    (void)e;
+    ++events;
+}
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/* ==============================
+ *
+ * Corpora
+ *
+ ================================ */
+
+static jq_uint64 seed = 88172645463325252ull;
+
+static jq_uint64 next_random(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return seed;
+}
+
+struct out {
+    char *data;
+    size_t size;
+    size_t cap;
+};
+
+static void put(struct out *o, const char *s, size_t n) {
+    if (o->size + n > o->cap) {
+        o->cap = (o->size + n) * 2;
+        o->data = (char *)realloc(o->data, o->cap);
+        if (o->data == NULL) {
+            perror("Error allocating memory");
+            exit(1);
+        }
+    }
+    memcpy(o->data + o->size, s, n);
+    o->size += n;
+}
+
+static void puts_out(struct out *o, const char *s) {
+    put(o, s, strlen(s));
+}
+
+/* Integers, decimals and doubles of every length with and without exponents */
+static void gen_numbers(struct out *o, size_t size) {
+    char buf[64];
+
+    puts_out(o, "[");
+    while (o->size < size) {
+        jq_uint64 r = next_random();
+        int n;
+
+        switch (r % 5) {
+        case 0: n = sprintf(buf, "%u, ", (unsigned)(r >> 44)); break;
+        case 1: n = sprintf(buf, "-%lu%05u, ", (unsigned long)(r >> 40), (unsigned)(r >> 8) % 100000); break;
+        case 2: n = sprintf(buf, "%.*f, ", (int)(r % 7), (double)(r >> 40) / 1000.0); break;
+        case 3: n = sprintf(buf, "%.17g, ", (double)(r >> 11) / 9007199254740992.0 * 1e10); break;
+        default: n = sprintf(buf, "%.3e, ", (double)(r >> 32) * ((r & 8) ? 1e-200 : 1e200)); break;
+        }
+        put(o, buf, (size_t)n);
+    }
+    puts_out(o, "0]");
+}
+
+/* Short and long strings with escapes, \u sequences and UTF-8 */
+static void gen_strings(struct out *o, size_t size) {
+    static const char *parts[] = { "lorem", " ", "ipsum", "dolor", "\\n", "\\\"", "\\\\", "\\u00e9",
+        "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "sit amet, consectetur", "\\t" };
+
+    puts_out(o, "[");
+    while (o->size < size) {
+        size_t n = next_random() % 40, k;
+
+        puts_out(o, "\"");
+        for (k = 0; k < n; ++k) puts_out(o, parts[next_random() % (sizeof(parts) / sizeof(parts[0]))]);
+        puts_out(o, "\", ");
+    }
+    puts_out(o, "\"\"]");
+}
+
+/* Objects and arrays nested up to 1000 levels deep with few scalars between them */
+static void gen_nested(struct out *o, size_t size) {
+    static char closing[1000];
+
+    puts_out(o, "[");
+    while (o->size < size) {
+        size_t depth = 1 + next_random() % (next_random() % 8 ? 32 : 1000), k;
+
+        for (k = 0; k < depth; ++k) {
+            if (next_random() % 2) {
+                puts_out(o, "{\"k\": ");
+                closing[k] = '}';
+            } else {
+                puts_out(o, "[1, ");
+                closing[k] = ']';
+            }
+        }
+        puts_out(o, "null");
+        while (k--) put(o, &closing[k], 1);
+        puts_out(o, ",\n");
+    }
+    puts_out(o, "[]]");
+}
+
+/* Newline delimited log records, one document each */
+static size_t gen_ndjson(struct out *o, size_t size) {
+    static const char *levels[] = { "debug", "info", "info", "info", "warn", "error" };
+    static const char *paths[] = { "/api/v1/items", "/api/v1/users", "/health", "/static/app.js" };
+    size_t documents = 0;
+
+    while (o->size < size) {
+        jq_uint64 r = next_random();
+        char line[512];
+        int n = sprintf(line, "{\"ts\": \"2026-10-17T%02u:%02u:%02u.%03uZ\", \"level\": \"%s\", "
+                "\"msg\": \"request done\", \"req\": {\"id\": %u, \"method\": \"GET\", \"path\": \"%s/%u\", "
+                "\"status\": %u, \"ms\": %u.%u, \"ua\": \"Mozilla/5.0 (X11; Linux x86_64)\"}, "
+                "\"tags\": [\"edge\", \"eu-%u\"], \"user\": %s}\n",
+                (unsigned)(r % 24), (unsigned)(r >> 8) % 60, (unsigned)(r >> 16) % 60, (unsigned)(r >> 24) % 1000,
+                levels[(r >> 34) % 6], (unsigned)(r >> 40), paths[(r >> 37) % 4], (unsigned)(r >> 50),
+                r % 11 ? 200u : 500u, (unsigned)(r >> 20) % 500, (unsigned)(r >> 30) % 10,
+                (unsigned)(r >> 60), r % 3 ? "null" : "{\"id\": 42, \"admin\": false}");
+
+        put(o, line, (size_t)n);
+        ++documents;
+    }
+
+    return documents;
+}
+
+/* One array of records, as an export of a table */
+static void gen_array(struct out *o, size_t size) {
+    size_t id = 0;
+
+    puts_out(o, "[");
+    while (o->size < size) {
+        jq_uint64 r = next_random();
+        char rec[256];
+        int n = sprintf(rec, "{\"id\": %lu, \"name\": \"item %lu\", \"active\": %s, \"score\": %u.%02u, "
+                "\"tags\": [\"t%u\", \"t%u\"], \"parent\": %s},\n",
+                (unsigned long)id, (unsigned long)id, r % 2 ? "true" : "false", (unsigned)(r >> 8) % 100,
+                (unsigned)(r >> 16) % 100, (unsigned)(r >> 24) % 10, (unsigned)(r >> 28) % 10,
+                r % 5 ? "null" : "0");
+
+        put(o, rec, (size_t)n);
+        ++id;
+    }
+    puts_out(o, "{}]");
+}
+
+static char *read_file(const char *fname, size_t *rsz) {
+    char *rv;
+    long sz;
+    FILE *fp = fopen(fname, "rb");
+
+    if (fp == NULL) {
+        perror(fname);
+        return NULL;
+    }
+
+    fseek(fp, 0L, SEEK_END);
+    sz = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    rv = (char *)malloc((size_t)sz + 1);
+    if (rv == NULL || fread(rv, 1, (size_t)sz, fp) != (size_t)sz) {
+        perror(fname);
+        free(rv);
+        rv = NULL;
+    }
+    fclose(fp);
+    *rsz = (size_t)sz;
+
+    return rv;
+}
+
+/* The generated corpora of size bytes and the files, returns the number of the corpora */
+static size_t load_corpora(struct corpus *corpora, size_t size, int argc, char *argv[]) {
+    size_t count = 0, i;
+    int a;
+
+    for (i = 0; i < 5; ++i) {
+        struct out o = { NULL, 0, 0 };
+        struct corpus *c = &corpora[count++];
+
+        c->documents = 1;
+        c->multi = JQ_FALSE;
+        switch (i) {
+        case 0: c->name = "numbers"; gen_numbers(&o, size); break;
+        case 1: c->name = "strings"; gen_strings(&o, size); break;
+        case 2: c->name = "nested"; gen_nested(&o, size); break;
+        case 3: c->name = "ndjson"; c->documents = gen_ndjson(&o, size); c->multi = JQ_TRUE; break;
+        default: c->name = "array"; gen_array(&o, size); break;
+        }
+        put(&o, " ", 1);
+        c->data = o.data;
+        c->size = o.size - 1;
+    }
+
+    for (a = 0; a < argc && count < BENCH_CORPORA; ++a) {
+        struct corpus *c = &corpora[count];
+
+        c->data = read_file(argv[a], &c->size);
+        if (c->data == NULL) exit(1);
+        c->data[c->size] = ' ';
+        c->name = argv[a];
+        c->documents = 1;
+        c->multi = JQ_FALSE;
+        ++count;
+    }
+
+    return count;
+}
+
+/* ==============================
+ *
+ * Parse loops
+ *
+ ================================ */
+
+/* The buffer parsed has a space after the corpus, so a number can end it */
+static char *work;
+
+/* The work buffer fits the longest corpus and the largest chunk with the room for the tail before it */
+static void alloc_work(const struct corpus *corpora, size_t count) {
+    size_t longest = 0, i;
+
+    for (i = 0; i < count; ++i) {
+        if (corpora[i].size > longest) longest = corpora[i].size;
+    }
+    work = (char *)malloc(longest + 1 + BENCH_ROOM + chunks[sizeof(chunks) / sizeof(chunks[0]) - 1]);
+    if (work == NULL) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+}
+
+static jq_bool parse_whole(const struct corpus *c) {
+    struct jq_handler h;
+
+    jq_init(&h);
+    jq_set_callback(&h, count_events);
+    jq_set_multi(&h, c->multi);
+
+    return jq_parse_buf(&h, work, c->size + 1);
+}
+
+static jq_bool parse_chunks(const struct corpus *c, size_t chunk) {
+    struct jq_handler h;
+    size_t pos = 0, tail = 0;
+
+    jq_init(&h);
+    jq_set_callback(&h, count_events);
+    jq_set_multi(&h, c->multi);
+
+    while (pos <= c->size) {
+        size_t n = c->size + 1 - pos < chunk ? c->size + 1 - pos : chunk;
+
+        JQ_PROFILE(&h, BENCH_PROFILE_COPY, 0);
+        memcpy(work + BENCH_ROOM, c->data + pos, n);
+        pos += n;
+        if (jq_parse_buf(&h, work + BENCH_ROOM - tail, tail + n)) {
+            tail = 0;
+            continue;
+        }
+        if (jq_get_error(&h) != JQ_ERR_LEXER_NEED_MORE) return JQ_FALSE;
+
+        tail = jq_get_tail_size(&h);
+        if (tail > BENCH_ROOM) return JQ_FALSE;
+        memmove(work + BENCH_ROOM - tail, jq_get_tail(&h), tail);
+    }
+
+    return pos > c->size && tail == 0;
+}
+
+#endif /* BENCH_H */
@@ -0,0 +1,331 @@
+/*
+ * Where the parser spends its time: cycles, instructions and branch misses of every
+ * lexer state, of jq_lexer_unget(), of every token case of the parser and of the
+ * callback, over the corpora of bench.c or the files given.
+ *
+ * jquick.h calls JQ_PROFILE(h, kind, id) where the code of another state or case
+ * begins, this file defines it to read the counters there and to add the difference
+ * to the section run before. The counters are read with perf_event_open(), with rdpmc
+ * if the kernel allows it, otherwise clock_gettime() gives the nanoseconds only.
+ * The cost of the reading itself is measured first and taken from every section.
+ *
+ * Options:
+ *     -c NAME     the generated corpus profiled: numbers, strings, nested, ndjson or array
+ *     -k CHUNK    the input comes in chunks of CHUNK bytes, it is parsed whole by default
+ *     -n COUNT    the number of times the corpus is parsed, 3 by default
+ *     -s MB       the size of every generated corpus, 16 by default
+ *     FILE...     json files profiled instead of the generated corpora
+ *
+ * make profile builds it with the options in PROFILE_FLAGS, e.g.
+ *     make profile PROFILE_FLAGS=-DJQ_WITH_LOCATION && bin/profile -c nested
+ */
+#define _GNU_SOURCE
+#define JQ_WITH_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__linux__)
+  #include <linux/perf_event.h>
+  #include <sys/mman.h>
+  #include <sys/syscall.h>
+  #define PROFILE_PERF
+#endif
+
+/* The sections are the ids of every kind, the chunk copies of bench.h are the last kind */
+#define PROFILE_KINDS 5
+#define PROFILE_IDS 512
+#define PROFILE_IDLE (PROFILE_KINDS * PROFILE_IDS)
+#define PROFILE_COUNTERS 3
+
+struct section {
+    unsigned long long v[PROFILE_COUNTERS];
+    unsigned long entries;
+};
+
+static struct section sections[PROFILE_IDLE + 1];
+static unsigned current = PROFILE_IDLE;
+
+static void profile_switch(unsigned s);
+
+/* The callback events go to one section */
+#define JQ_PROFILE(h, kind, id) do { \
+        unsigned profile_s = (unsigned)(kind) * PROFILE_IDS + ((kind) == JQ_PROFILE_CALLBACK ? 0 : (unsigned)(id)); \
+        (void)(h); \
+        if (profile_s != current) profile_switch(profile_s); \
+    } while (0)
+
+#include "jquick.h"
+#include "bench.h"
+
+/* ==============================
+ *
+ * Counters
+ *
+ ================================ */
+
+static const char *counter_names[PROFILE_COUNTERS] = { "cycles", "instructions", "branch-misses" };
+static unsigned long long last[PROFILE_COUNTERS];
+static int counters = 1; /* nanoseconds only */
+
+#ifdef PROFILE_PERF
+
+static int perf_fd[PROFILE_COUNTERS];
+static struct perf_event_mmap_page *perf_page[PROFILE_COUNTERS];
+
+static jq_bool perf_open(void) {
+    static const unsigned long long configs[PROFILE_COUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES };
+    long page = sysconf(_SC_PAGESIZE);
+    int k;
+
+    for (k = 0; k < PROFILE_COUNTERS; ++k) {
+        struct perf_event_attr attr;
+
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[k];
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        perf_fd[k] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (perf_fd[k] < 0) {
+            perror("perf_event_open");
+            while (k--) close(perf_fd[k]);
+            return JQ_FALSE;
+        }
+
+        /* The page tells if the counter can be read with rdpmc */
+        perf_page[k] = (struct perf_event_mmap_page *)mmap(NULL, (size_t)page, PROT_READ, MAP_SHARED, perf_fd[k], 0);
+        if (perf_page[k] == MAP_FAILED) perf_page[k] = NULL;
+    }
+
+    return JQ_TRUE;
+}
+
+static unsigned long long perf_read(int k) {
+    unsigned long long value = 0;
+
+#if defined(__x86_64__) || defined(__i386__)
+    volatile struct perf_event_mmap_page *pg = perf_page[k];
+
+    if (pg && pg->cap_user_rdpmc) {
+        unsigned int seq, index, lo, hi;
+        long long count;
+
+        /* The seqlock protocol of linux/perf_event.h */
+        do {
+            seq = pg->lock;
+            __asm__ __volatile__("" ::: "memory");
+            index = pg->index;
+            count = pg->offset;
+            if (index) {
+                __asm__ __volatile__("rdpmc" : "=a"(lo), "=d"(hi) : "c"(index - 1));
+                count += (long long)((unsigned long long)hi << 32 | lo) << (64 - pg->pmc_width) >> (64 - pg->pmc_width);
+            }
+            __asm__ __volatile__("" ::: "memory");
+        } while (pg->lock != seq);
+
+        if (index) return (unsigned long long)count;
+    }
+#endif
+
+    if (read(perf_fd[k], &value, sizeof(value)) != (ssize_t)sizeof(value)) value = 0;
+    return value;
+}
+
+#endif /* PROFILE_PERF */
+
+static void read_counters(unsigned long long *v) {
+    struct timespec t;
+
+#ifdef PROFILE_PERF
+    if (counters > 1) {
+        int k;
+        for (k = 0; k < PROFILE_COUNTERS; ++k) v[k] = perf_read(k);
+        return;
+    }
+#endif
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    v[0] = (unsigned long long)t.tv_sec * 1000000000ull + (unsigned long long)t.tv_nsec;
+}
+
+/* The counters are read again at the end, so the most of this function is not counted */
+static void profile_switch(unsigned s) {
+    unsigned long long v[PROFILE_COUNTERS];
+    int k;
+
+    read_counters(v);
+    for (k = 0; k < counters; ++k) sections[current].v[k] += v[k] - last[k];
+    ++sections[s].entries;
+    current = s;
+    read_counters(last);
+}
+
+/* ==============================
+ *
+ * Report
+ *
+ ================================ */
+
+static const char *lexer_names[] = { "NORMAL", "STRING", "ESCAPE", "UNICODE", "NULL", "TRUE", "FALSE",
+    "NUM_BEGIN", "NUM_POINT", "NUM_INT0_9", "NUM_INT1_9", "NUM_FRACTION1", "NUM_FRACTION",
+    "NUM_EXPO_PLUS_MINUS", "NUM_EXPO_INT1", "NUM_EXPO_INT" };
+
+static void section_name(unsigned s, char *name) {
+    unsigned id = s % PROFILE_IDS;
+
+    switch (s / PROFILE_IDS) {
+    case JQ_PROFILE_LEXER:
+        sprintf(name, "lexer %s", id < sizeof(lexer_names) / sizeof(lexer_names[0]) ? lexer_names[id] : "?");
+        break;
+    case JQ_PROFILE_UNGET:
+        strcpy(name, "jq_lexer_unget");
+        break;
+    case JQ_PROFILE_TOKEN:
+        switch (id) {
+        case JQ_T_ERROR: strcpy(name, "parser error"); break;
+        case JQ_T_NEED_MORE: strcpy(name, "parser need more"); break;
+        case JQ_T_NULL: strcpy(name, "parser null"); break;
+        case JQ_T_TRUE: strcpy(name, "parser true"); break;
+        case JQ_T_FALSE: strcpy(name, "parser false"); break;
+        case JQ_T_STRING: strcpy(name, "parser string"); break;
+        case JQ_T_NUMBER: strcpy(name, "parser number"); break;
+        default: sprintf(name, "parser '%c'", (char)id); break;
+        }
+        break;
+    case JQ_PROFILE_CALLBACK:
+        strcpy(name, "callback");
+        break;
+    default:
+        strcpy(name, "chunk copies");
+        break;
+    }
+}
+
+/* The cost of a switch is measured between two sections doing nothing */
+static void calibrate(unsigned long long *overhead) {
+    unsigned long n = 200000, i;
+    int k;
+
+    memset(sections, 0, sizeof(sections));
+    current = PROFILE_IDLE;
+    read_counters(last);
+    for (i = 0; i < n; ++i) profile_switch(PROFILE_IDLE - 1 - i % 2);
+    profile_switch(PROFILE_IDLE);
+
+    for (k = 0; k < counters; ++k) {
+        overhead[k] = (sections[PROFILE_IDLE - 1].v[k] + sections[PROFILE_IDLE - 2].v[k]) / n;
+    }
+}
+
+static void report(const struct corpus *c, unsigned long count, const unsigned long long *overhead) {
+    unsigned long long total[PROFILE_COUNTERS] = { 0, 0, 0 };
+    char name[64];
+    unsigned s;
+    int k;
+
+    /* The cost of the counting is taken from the sections counted */
+    for (s = 0; s < PROFILE_IDLE; ++s) {
+        for (k = 0; k < counters; ++k) {
+            unsigned long long o = sections[s].entries * overhead[k];
+            sections[s].v[k] = sections[s].v[k] > o ? sections[s].v[k] - o : 0;
+            total[k] += sections[s].v[k];
+        }
+    }
+
+    printf("\n%s: %lu bytes, %lu times\n", c->name, (unsigned long)c->size, count);
+    if (counters > 1) {
+        printf("%-24s %12s %16s %7s %16s %6s %14s\n", "section", "entries", counter_names[0], "%",
+                counter_names[1], "IPC", counter_names[2]);
+    } else {
+        printf("%-24s %12s %16s %7s\n", "section", "entries", "nanoseconds", "%");
+    }
+
+    for (s = 0; s < PROFILE_IDLE; ++s) {
+        if (sections[s].entries == 0) continue;
+
+        section_name(s, name);
+        printf("%-24s %12lu %16llu %6.2f%%", name, sections[s].entries, sections[s].v[0],
+                total[0] ? 100.0 * (double)sections[s].v[0] / (double)total[0] : 0.0);
+        if (counters > 1) {
+            printf(" %16llu %6.2f %14llu", sections[s].v[1],
+                    sections[s].v[0] ? (double)sections[s].v[1] / (double)sections[s].v[0] : 0.0, sections[s].v[2]);
+        }
+        printf("\n");
+    }
+
+    if (counters > 1) {
+        printf("total %llu cycles, %.3f bytes/cycle, %.2f IPC, switch cost %llu cycles taken\n", total[0],
+                total[0] ? (double)c->size * count / (double)total[0] : 0.0,
+                total[0] ? (double)total[1] / (double)total[0] : 0.0, overhead[0]);
+    } else {
+        printf("total %llu ns, %.3f bytes/ns, switch cost %llu ns taken\n", total[0],
+                total[0] ? (double)c->size * count / (double)total[0] : 0.0, overhead[0]);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    struct corpus corpora[BENCH_CORPORA];
+    unsigned long long overhead[PROFILE_COUNTERS];
+    const char *only = NULL;
+    size_t size = 16u << 20, chunk = 0, count, i;
+    unsigned long times = 3, n;
+    int a;
+
+    for (a = 1; a < argc && argv[a][0] == '-'; ++a) {
+        if (strcmp(argv[a], "-c") == 0 && a + 1 < argc) {
+            only = argv[++a];
+        } else if (strcmp(argv[a], "-k") == 0 && a + 1 < argc) {
+            chunk = (size_t)atol(argv[++a]);
+        } else if (strcmp(argv[a], "-n") == 0 && a + 1 < argc) {
+            times = (unsigned long)atol(argv[++a]);
+        } else if (strcmp(argv[a], "-s") == 0 && a + 1 < argc) {
+            size = (size_t)(atof(argv[++a]) * (1 << 20));
+        } else {
+            fprintf(stderr, "Usage: %s [-c NAME] [-k CHUNK] [-n COUNT] [-s MB] [FILE...]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (chunk > chunks[sizeof(chunks) / sizeof(chunks[0]) - 1]) {
+        fprintf(stderr, "The chunk is up to %lu bytes\n", (unsigned long)chunks[sizeof(chunks) / sizeof(chunks[0]) - 1]);
+        return 1;
+    }
+
+#ifdef PROFILE_PERF
+    if (perf_open()) counters = PROFILE_COUNTERS;
+#endif
+    if (counters == 1) printf("The hardware counters can't be read, clock_gettime() is used\n");
+
+    count = load_corpora(corpora, size, argc - a, argv + a);
+    alloc_work(corpora, count);
+    calibrate(overhead);
+
+    /* The files given are profiled instead of the generated corpora */
+    for (i = a < argc ? count - (size_t)(argc - a) : 0; i < count; ++i) {
+        if (only && strcmp(only, corpora[i].name) != 0) continue;
+
+        memcpy(work, corpora[i].data, corpora[i].size + 1);
+        memset(sections, 0, sizeof(sections));
+        current = PROFILE_IDLE;
+        read_counters(last);
+        for (n = 0; n < times; ++n) {
+            jq_bool ok = chunk ? parse_chunks(&corpora[i], chunk) : parse_whole(&corpora[i]);
+            if (!ok) {
+                fprintf(stderr, "%s can't be parsed\n", corpora[i].name);
+                return 1;
+            }
+        }
+        profile_switch(PROFILE_IDLE);
+        report(&corpora[i], times, overhead);
+    }
+
+    for (i = 0; i < count; ++i) free(corpora[i].data);
+    free(work);
+
+    return 0;
+}
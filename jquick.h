@@ -36,7 +36,7 @@ SOFTWARE.
 /// ## Features
 /// * Single header library
 /// * No dependences. By default it dosen't use any includes or library linkages
-/// * No dynamic memory is allocated
+/// * No dynamic memory is allocated, except the parallel driver of `JQ_WITH_THREADS`
 ///
 /// ## Usage
 /// You can just copy this file nearly to your code and include.
@@ -61,6 +61,52 @@ SOFTWARE.
 #ifndef __JQUICK_H__
 #define __JQUICK_H__
 
+#if defined(JQ_WITH_IMPLEMENTATION) && (defined(JQ_WITH_INDEX) || defined(JQ_WITH_UTF8_CHECK) || defined(JQ_WITH_WRITER) || defined(JQ_WITH_LOCATION)) && !defined(JQ_WITHOUT_SIMD)
+  #if defined(__AVX2__)
+    #include <immintrin.h>
+    #define JQ_SIMD_AVX2
+  #elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define JQ_SIMD_SSE2
+  #endif
+#endif
+
+#if defined(JQ_WITH_IMPLEMENTATION) && defined(JQ_WITH_THREADS)
+  #include <pthread.h>
+  #include <stdlib.h>
+  #include <string.h>
+#endif
+
+#if defined(JQ_WITH_IMPLEMENTATION) && defined(JQ_WITH_MMAP)
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+#if defined(JQ_WITH_IMPLEMENTATION) && defined(JQ_WITH_WRITER)
+  #include <string.h>
+#endif
+
+#if defined(JQ_WITH_IMPLEMENTATION) && defined(JQ_WITH_READER)
+  #include <sys/stat.h>
+  #include <unistd.h>
+  #include <errno.h>
+  #include <string.h>
+  #if defined(__has_include)
+    #if !__has_include(<linux/io_uring.h>) && !defined(JQ_WITHOUT_IO_URING)
+      #define JQ_WITHOUT_IO_URING
+    #endif
+  #endif
+  #if defined(__linux__) && (defined(__GNUC__) || defined(__clang__)) && !defined(JQ_WITHOUT_IO_URING)
+    #include <linux/io_uring.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <sys/uio.h>
+    #define JQ_IO_URING
+  #endif
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -79,9 +125,39 @@ extern "C" {
   #define JQ_INLINE static
 #endif
 
+/* Objects and arrays can be nested JQ_STACK_SIZE - 1 levels deep, one bit is kept per level */
 #ifndef JQ_STACK_SIZE
   #define JQ_STACK_SIZE 4096
 #endif /* JQ_STACK_SIZE */
+#define JQ_STACK_WORDS ((JQ_STACK_SIZE + 63) / 64)
+
+/* The parallel driver keeps the records parsed ahead of their turn on tapes */
+#if defined(JQ_WITH_THREADS) && !defined(JQ_WITH_TAPE)
+  #define JQ_WITH_TAPE
+#endif
+
+/* The value length is always kept now, the macro is left for the code checking it */
+#ifndef JQ_WITH_VLEN
+  #define JQ_WITH_VLEN
+#endif
+
+/* The writer checks the structure of its output in the debug builds */
+#if defined(JQ_WITH_WRITER) && !defined(NDEBUG) && !defined(JQ_WITHOUT_WRITER_CHECK) && !defined(JQ_WITH_WRITER_CHECK)
+  #define JQ_WITH_WRITER_CHECK
+#endif
+
+/*
+ * The profiling hook, it is empty unless defined before the include, see bench/profile.c.
+ * JQ_PROFILE(h, kind, id) marks the code run from there on: the lexer state at every char,
+ * jq_lexer_unget(), the token the parser got and the callback with the event.
+ */
+#ifndef JQ_PROFILE
+  #define JQ_PROFILE(h, kind, id)
+#endif
+#define JQ_PROFILE_LEXER                    0
+#define JQ_PROFILE_UNGET                    1
+#define JQ_PROFILE_TOKEN                    2
+#define JQ_PROFILE_CALLBACK                 3
 
 struct jq_handler;
 
@@ -92,16 +168,44 @@ struct jq_handler;
 /// typedef char jq_char;
 /// typedef unsigned long int jq_size;
 /// typedef int jq_bool;
+/// typedef long long jq_int64;
+/// typedef unsigned long long jq_uint64;
 /// #define JQ_FALSE                          0
 /// #define JQ_TRUE                           1
 /// ~~~
+/// `long long` is C99, in C89 `jq_int64` and `jq_uint64` are `long` and
+/// `unsigned long` if they are 64-bit.
 */
 typedef char jq_char;
 typedef unsigned long int jq_size;
 typedef int jq_bool;
+#if (defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L) || (defined(__cplusplus) && __cplusplus >= 201103L)
+typedef long long jq_int64;
+typedef unsigned long long jq_uint64;
+#else
+  #include <limits.h>
+  #if ULONG_MAX > 0xffffffffUL
+typedef long jq_int64;
+typedef unsigned long jq_uint64;
+  #else
+typedef long long jq_int64;
+typedef unsigned long long jq_uint64;
+  #endif
+#endif
 #define JQ_FALSE                            0
 #define JQ_TRUE                             1
 
+/*///
+/// #### jq_index
+/// Structural index entry, see `jq_set_index`. It is defined with `JQ_WITH_INDEX` only.
+/// ~~~
+/// typedef unsigned int jq_index;
+/// ~~~
+*/
+#ifdef JQ_WITH_INDEX
+typedef unsigned int jq_index;
+#endif
+
 /*//
 /// #### enum jq_error
 /// ~~~
@@ -112,9 +216,34 @@ typedef int jq_bool;
 ///     JQ_ERR_LEXER_UNKNOWN_ESCAPE_SYMBOL,
 ///     JQ_ERR_LEXER_UNKNOWN_HEX_SYMBOL,
 ///     JQ_ERR_LEXER_EXPONENT_ERROR,
-///     JQ_ERR_PARSER_UNEXPECTED_TOKEN
+///     JQ_ERR_PARSER_UNEXPECTED_TOKEN,
+///     JQ_ERR_LEXER_INVALID_UTF8,
+///     JQ_ERR_LEXER_CONTROL_CHAR,
+///     JQ_ERR_TAPE_FULL,
+///     JQ_ERR_STOPPED,
+///     JQ_ERR_FILE,
+///     JQ_ERR_BUFFER_FULL,
+///     JQ_ERR_WRITER_UNEXPECTED,
+///     JQ_ERR_WRITER_FLUSH,
+///     JQ_ERR_MAX_DEPTH
 /// };
 /// ~~~
+/// `JQ_ERR_LEXER_INVALID_UTF8` and `JQ_ERR_LEXER_CONTROL_CHAR` are reported with
+/// `JQ_WITH_UTF8_CHECK` only. With this macro defined
+/// the lexer validates UTF-8 of strings and object keys while it scans them and
+/// rejects raw control chars (0x00-0x1f) in them, as the JSON grammar requires.
+/// Runs of ASCII chars are checked 32, 16 or 8 bytes at a time depending on the
+/// instruction set available, the rest goes through a table driven automaton.
+/// `JQ_ERR_TAPE_FULL` is reported with `JQ_WITH_TAPE` only, see `jq_set_tape`.
+/// `JQ_ERR_STOPPED` is not an error actually, `jq_parse` is stopped by the control
+/// callback and can be called again to go on, see `jq_control_callback`.
+/// `JQ_ERR_FILE` and `JQ_ERR_BUFFER_FULL` are reported by `jq_parse_file` and
+/// `jq_parse_fd` only.
+/// `JQ_ERR_WRITER_UNEXPECTED` and `JQ_ERR_WRITER_FLUSH` are reported by the writer
+/// only, see `struct jq_writer`.
+/// `JQ_ERR_MAX_DEPTH` is reported when objects and arrays are nested deeper than
+/// `JQ_STACK_SIZE - 1` levels, 4095 by default. `JQ_STACK_SIZE` can be defined
+/// before the include, the handler keeps one bit per level.
 */
 enum jq_error {
     JQ_ERR_OK                           = 0,
@@ -123,7 +252,16 @@ enum jq_error {
     JQ_ERR_LEXER_UNKNOWN_ESCAPE_SYMBOL,
     JQ_ERR_LEXER_UNKNOWN_HEX_SYMBOL,
     JQ_ERR_LEXER_EXPONENT_ERROR,
-    JQ_ERR_PARSER_UNEXPECTED_TOKEN
+    JQ_ERR_PARSER_UNEXPECTED_TOKEN,
+    JQ_ERR_LEXER_INVALID_UTF8,
+    JQ_ERR_LEXER_CONTROL_CHAR,
+    JQ_ERR_TAPE_FULL,
+    JQ_ERR_STOPPED,
+    JQ_ERR_FILE,
+    JQ_ERR_BUFFER_FULL,
+    JQ_ERR_WRITER_UNEXPECTED,
+    JQ_ERR_WRITER_FLUSH,
+    JQ_ERR_MAX_DEPTH
 };
 
 enum jq_token_type {
@@ -155,13 +293,21 @@ enum jq_token_type {
 ///    JQ_E_OBJECT_END,
 ///    JQ_E_ARRAY_BEGIN,
 ///    JQ_E_ARRAY_END,
-///    JQ_E_OBJECT_KEY
+///    JQ_E_OBJECT_KEY,
+///    JQ_E_DOCUMENT_BEGIN,
+///    JQ_E_DOCUMENT_END,
+///    JQ_E_ERROR,
+///    JQ_E_NEED_MORE,
+///    JQ_E_DONE
 /// };
 /// ~~~
+/// `JQ_E_DOCUMENT_BEGIN` and `JQ_E_DOCUMENT_END` come in the multi document mode
+/// only, see `jq_set_multi`. The last three are never passed to the callback, they are returned by `jq_next`
+/// only. See `jq_next` for more information.
 */
 /* This enum is used in callbacks */
-/* Except JQ_E_OBJECT_KEY it simply repeats some of jq_token_type constants */
-/* IMPORTANT: except JQ_E_OBJECT_KEY the values must match those of jq_token_type! */
+/* Except JQ_E_OBJECT_KEY and JQ_E_DOCUMENT_* it simply repeats some of jq_token_type constants */
+/* IMPORTANT: except them the values must match those of jq_token_type! */
 enum jq_event_type {
     JQ_E_NULL                           = JQ_T_NULL,
     JQ_E_TRUE                           = JQ_T_TRUE,
@@ -172,7 +318,12 @@ enum jq_event_type {
     JQ_E_OBJECT_END                     = '}',
     JQ_E_ARRAY_BEGIN                    = '[',
     JQ_E_ARRAY_END                      = ']',
-    JQ_E_OBJECT_KEY                     = 255 /* it must be unique */
+    JQ_E_OBJECT_KEY                     = 255, /* it must be unique */
+    JQ_E_DOCUMENT_BEGIN                 = 252, /* it must be unique */
+    JQ_E_DOCUMENT_END                   = 253, /* it must be unique */
+    JQ_E_ERROR                          = JQ_T_ERROR,
+    JQ_E_NEED_MORE                      = JQ_T_NEED_MORE,
+    JQ_E_DONE                           = 254 /* it must be unique */
 };
 
 enum jq_lexer_state {
@@ -187,12 +338,100 @@ enum jq_lexer_state {
     JQ_L_NUM_POINT,
     JQ_L_NUM_INT0_9,
     JQ_L_NUM_INT1_9,
+    JQ_L_NUM_FRACTION1,
     JQ_L_NUM_FRACTION,
     JQ_L_NUM_EXPO_PLUS_MINUS,
     JQ_L_NUM_EXPO_INT1,
     JQ_L_NUM_EXPO_INT
 };
 
+enum jq_skip_state {
+    JQ_SKIP_NONE                        = 0,
+    JQ_SKIP_VALUE,                      /* before the value of the object key */
+    JQ_SKIP_SCALAR,                     /* inside null, true, false or number */
+    JQ_SKIP_NESTED,                     /* inside objects or arrays */
+    JQ_SKIP_STRING,
+    JQ_SKIP_ESCAPE                      /* after '\\' in string */
+};
+
+/*///
+/// #### enum jq_number_flags
+/// Flags of the latest number, see `jq_get_number_flags`.
+/// ~~~
+/// enum jq_number_flags {
+///     JQ_N_NEGATIVE                       = 1,
+///     JQ_N_INTEGRAL                       = 2,
+///     JQ_N_OVERFLOW                       = 4
+/// };
+/// ~~~
+///
+/// Flag              | Description
+/// ------------------|----------------------------------------------------------------
+/// __JQ_N_NEGATIVE__ | The number has '-' sign
+/// __JQ_N_INTEGRAL__ | The number has neither fraction nor exponent part
+/// __JQ_N_OVERFLOW__ | The integer part doesn't fit in `jq_int64` if negative or `jq_uint64` otherwise
+///
+*/
+enum jq_number_flags {
+    JQ_N_NEGATIVE                       = 1,
+    JQ_N_INTEGRAL                       = 2,
+    JQ_N_OVERFLOW                       = 4
+};
+
+/*///
+/// #### enum jq_tape_type
+/// Types of the tape entries, see `jq_set_tape`.
+/// ~~~
+/// enum jq_tape_type {
+///     JQ_TAPE_NULL                        = 'n',
+///     JQ_TAPE_TRUE                        = 't',
+///     JQ_TAPE_FALSE                       = 'f',
+///     JQ_TAPE_STRING                      = '"',
+///     JQ_TAPE_KEY                         = 'k',
+///     JQ_TAPE_NUMBER                      = '#',
+///     JQ_TAPE_INT64                       = 'l',
+///     JQ_TAPE_UINT64                      = 'u',
+///     JQ_TAPE_DOUBLE                      = 'd',
+///     JQ_TAPE_OBJECT_BEGIN                = '{',
+///     JQ_TAPE_OBJECT_END                  = '}',
+///     JQ_TAPE_ARRAY_BEGIN                 = '[',
+///     JQ_TAPE_ARRAY_END                   = ']'
+/// };
+/// ~~~
+///
+/// Type                       | Payload                                         | Next word
+/// ---------------------------|-------------------------------------------------|-----------------
+/// __JQ_TAPE_NULL__           | 0                                               | -
+/// __JQ_TAPE_TRUE__           | 0                                               | -
+/// __JQ_TAPE_FALSE__          | 0                                               | -
+/// __JQ_TAPE_STRING__         | Offset of the string value in the input         | Value length
+/// __JQ_TAPE_KEY__            | Offset of the object key in the input           | Key length
+/// __JQ_TAPE_NUMBER__         | Offset of the number in the input               | Number length
+/// __JQ_TAPE_INT64__          | 0, with `JQ_WITH_NUMBERS` only                  | `jq_int64` value
+/// __JQ_TAPE_UINT64__         | 0, with `JQ_WITH_NUMBERS` only                  | `jq_uint64` value above `jq_int64`
+/// __JQ_TAPE_DOUBLE__         | 0, with `JQ_WITH_NUMBERS` only                  | Bits of the double value
+/// __JQ_TAPE_OBJECT_BEGIN__   | Index of the matching `JQ_TAPE_OBJECT_END`      | -
+/// __JQ_TAPE_OBJECT_END__     | Index of the matching `JQ_TAPE_OBJECT_BEGIN`    | -
+/// __JQ_TAPE_ARRAY_BEGIN__    | Index of the matching `JQ_TAPE_ARRAY_END`       | -
+/// __JQ_TAPE_ARRAY_END__      | Index of the matching `JQ_TAPE_ARRAY_BEGIN`     | -
+///
+*/
+enum jq_tape_type {
+    JQ_TAPE_NULL                        = 'n',
+    JQ_TAPE_TRUE                        = 't',
+    JQ_TAPE_FALSE                       = 'f',
+    JQ_TAPE_STRING                      = '"',
+    JQ_TAPE_KEY                         = 'k',
+    JQ_TAPE_NUMBER                      = '#',
+    JQ_TAPE_INT64                       = 'l',
+    JQ_TAPE_UINT64                      = 'u',
+    JQ_TAPE_DOUBLE                      = 'd',
+    JQ_TAPE_OBJECT_BEGIN                = '{',
+    JQ_TAPE_OBJECT_END                  = '}',
+    JQ_TAPE_ARRAY_BEGIN                 = '[',
+    JQ_TAPE_ARRAY_END                   = ']'
+};
+
 enum jq_parser_state {
     JQ_S_UNDEFINED                      = 0,
     JQ_S_OBJECT,
@@ -209,36 +448,223 @@ enum jq_parser_state {
 */
 typedef void (*jq_callback)(struct jq_handler *h, enum jq_event_type);
 
+/*///
+/// #### enum jq_control
+/// ~~~
+/// enum jq_control {
+///     JQ_C_CONTINUE                       = 0,
+///     JQ_C_SKIP,
+///     JQ_C_STOP
+/// };
+/// ~~~
+/// Values returned by `jq_control_callback`.
+///
+/// Value              | Description
+/// -------------------|----------------------------------------------------------------
+/// __JQ_C_CONTINUE__  | Go on as usual
+/// __JQ_C_SKIP__      | Skip the value of the object key or the rest of the object or array just begun, see `jq_skip`
+/// __JQ_C_STOP__      | Return from `jq_parse` right away with `JQ_ERR_STOPPED`
+*/
+enum jq_control {
+    JQ_C_CONTINUE                       = 0,
+    JQ_C_SKIP,
+    JQ_C_STOP
+};
+
+/*///
+/// #### jq_control_callback
+/// Callback function pointer typedef, the callback steers the parsing with its
+/// return value. See `jq_set_control_callback`.
+/// ~~~
+/// typedef enum jq_control (*jq_control_callback)(struct jq_handler *h, enum jq_event_type);
+/// ~~~
+*/
+typedef enum jq_control (*jq_control_callback)(struct jq_handler *h, enum jq_event_type);
+
+/*///
+/// #### struct jq_stats
+/// Statistics of the parsing, it is defined with `JQ_WITH_STATS` only, see `jq_get_stats`.
+/// ~~~
+/// #define JQ_STATS_BUCKETS                    32
+///
+/// struct jq_stats {
+///     jq_uint64 bytes;
+///     jq_uint64 tokens;
+///     jq_uint64 documents;
+///     jq_uint64 need_more;
+///     jq_uint64 rewinds;
+///     jq_uint64 tail_bytes;
+///     jq_size max_depth;
+///     jq_uint64 nulls, trues, falses, strings, numbers, keys, objects, arrays;
+///     jq_uint64 latency[JQ_STATS_BUCKETS];
+/// };
+/// ~~~
+///
+/// Field            | Description
+/// -----------------|----------------------------------------------------------------
+/// __bytes__        | Bytes of the input parsed
+/// __tokens__       | Tokens the parser got, the values skipped with `jq_skip` are not counted
+/// __documents__    | Documents parsed, the one document or the documents of the multi document mode
+/// __need_more__    | Times the buffer ended before the input, i.e. `JQ_ERR_LEXER_NEED_MORE` was set
+/// __rewinds__      | Times of them the buffer ended inside a token, so the tail went to the next buffer
+/// __tail_bytes__   | Bytes of these tails, the lexer doesn't scan them again but they are moved by the caller
+/// __max_depth__    | Deepest nesting of objects and arrays
+/// __nulls__ ... __arrays__ | Events of every type, the objects and arrays are counted by their beginning
+/// __latency__      | Histogram of the document parse times, `latency[k]` is the number of documents parsed in 2^k to 2^(k+1) clock units, the last bucket has all the longer ones, see `jq_set_stats_clock`
+*/
+#ifdef JQ_WITH_STATS
+#define JQ_STATS_BUCKETS                    32
+
+struct jq_stats {
+    jq_uint64 bytes;
+    jq_uint64 tokens;
+    jq_uint64 documents;
+    jq_uint64 need_more;
+    jq_uint64 rewinds;
+    jq_uint64 tail_bytes;
+    jq_size max_depth;
+    jq_uint64 nulls, trues, falses, strings, numbers, keys, objects, arrays;
+    jq_uint64 latency[JQ_STATS_BUCKETS];
+};
+
+/*///
+/// #### jq_clock_callback
+/// Clock function pointer typedef, see `jq_set_stats_clock`. It returns the time
+/// in any units, e.g. nanoseconds of a monotonic clock.
+/// ~~~
+/// typedef jq_uint64 (*jq_clock_callback)(void);
+/// ~~~
+*/
+typedef jq_uint64 (*jq_clock_callback)(void);
+#endif
+
+/*///
+/// #### struct jq_location
+/// Line and column of a position in the input, it is defined with `JQ_WITH_LOCATION`
+/// only, see `jq_get_location`.
+/// ~~~
+/// struct jq_location {
+///     jq_size line;
+///     jq_size column;
+/// };
+/// ~~~
+///
+/// Field       | Description
+/// ------------|----------------------------------------------------------------
+/// __line__    | Line counted from 0, the lines end with `'\n'`
+/// __column__  | Bytes from the beginning of the line, counted from 0
+*/
+#ifdef JQ_WITH_LOCATION
+struct jq_location {
+    jq_size line;
+    jq_size column;
+};
+#endif
+
 /*///
 /// #### struct hq_handler
 /// The main `jquick` handler.
 /// ~~~
 /// struct jq_handler;
 /// ~~~
+/// The value of the latest string, key, number, `null`, `true` or `false` is `val`
+/// and its length is `vlen`, see `jq_get_view`. `vlen` is always kept, `JQ_WITH_VLEN`
+/// is defined for the code checking it.
+/// With `JQ_WITH_UNESCAPE` defined the escape sequences of strings and object keys
+/// are decoded in place while they are lexed, `\uxxxx` and surrogate pairs go to
+/// UTF-8 and lone surrogates are replaced with U+FFFD. The decoded value is not longer
+/// than the escaped one, so `val` points into the input buffer as usual and `vlen`
+/// is the decoded length.
+/// The input buffer is changed, so it can't be parsed again.
+/// In the read-only mode (see `jq_set_readonly`) the strings are not decoded.
 */ 
 struct jq_handler {
+    /* The fields used for every token go first, they fit in a 64 byte cache line */
     jq_char *buf;                       /* input char buffer */
-    jq_size buf_size;                   /* buf size */
     jq_size i;                          /* position in buf */
-    jq_char cnt;                        /* Counts the element number in array */
-                                        /* or object, should always be 0 >= cnt <= 4 */ 
-    jq_char stack[JQ_STACK_SIZE];       /* jq_parser_state stack */
-    jq_size stack_pos;                  /* position in stack */
+    jq_size buf_size;                   /* buf size */
+    jq_size stack_pos;                  /* number of objects and arrays not closed */
     jq_char *val;                       /* value of the latest token */
-#ifdef JQ_WITH_VLEN
     jq_size vlen;                       /* value length */
+    enum jq_error error;                /* error code */
+    jq_char cnt;                        /* Counts the element number in array */
+                                        /* or object, should always be 0 >= cnt <= 4 */ 
+    jq_char state;                      /* jq_parser_state of the innermost level */
+    jq_char lexer_state;                /* jq_lexer_state of the token interrupted */
+                                        /* by the end of buf */
+    jq_char skip_state;                 /* jq_skip_state of the value being skipped */
+    jq_bool multi;                      /* multi document mode, see jq_set_multi() */
+    jq_bool doc_open;                   /* JQ_E_DOCUMENT_BEGIN is emitted, the end is not */
+    jq_uint64 stack[JQ_STACK_WORDS];    /* bit per level above the top one, 1 for an object */
+    jq_char nft_cnt;                    /* current symbol inside null, true, false */
+                                        /* or unicode (\uxxxx) of that token */
+    jq_size lexed;                      /* number of that token bytes already scanned */
+    jq_size buf_offset;                 /* position of buf in the whole input */
+    jq_size doc_offset;                 /* position of the latest document in the whole input */
+    jq_bool readonly;                   /* buf is never written, see jq_set_readonly() */
+    jq_bool input_end;                  /* buf ends the input, see jq_set_input_end() */
+    jq_bool skip_rest;                  /* the rest of object or array is skipped */
+    jq_size skip_depth;                 /* number of objects and arrays not closed yet */
+#ifdef JQ_WITH_UTF8_CHECK
+    jq_char utf8_state;                 /* UTF-8 automaton state of the current string */
+#endif
+#ifdef JQ_WITH_UNESCAPE
+    jq_size unesc_len;                  /* decoded length of the current string */
+    jq_size unesc_src;                  /* offset of its chars not moved yet */
+    unsigned long unesc_cp;             /* code point of \uxxxx being decoded */
+    unsigned long unesc_hi;             /* high surrogate waiting for the low one */
+#ifdef JQ_WITH_LOCATION
+    jq_bool unesc_newline;              /* '\n' is decoded into the current string */
+#endif
+#endif
+#ifdef JQ_WITH_NUMBERS
+    jq_uint64 num_mantissa;             /* significant digits of the latest number */
+    jq_int64 num_exp10;                 /* power of 10 to scale num_mantissa by, */
+                                        /* without the exponent part */
+    jq_int64 num_exp;                   /* exponent part of the number */
+    jq_size num_len;                    /* number length in chars */
+    jq_char num_flags;                  /* enum jq_number_flags and internal ones */
 #endif
 #ifdef JQ_WITH_LOCATION
-    jq_size position;                   /* current position in buf from line beginning */
-    jq_size line;                       /* current line in buf */
+    jq_size loc_offset;                 /* position in the whole input the lines are counted up to */
+    jq_size loc_line;                   /* lines before loc_offset */
+    jq_size loc_line_offset;            /* position in the whole input of the line loc_offset is on */
 #endif
 #ifdef JQ_WITH_NULLTERM
     jq_char subst_char;                 /* char temporary substituted */
                                         /* with '\0' */
     jq_size subst_pos;                  /* char position in buf */
+#endif
+#ifdef JQ_WITH_INDEX
+    jq_index *index;                    /* structural index of buf, see jq_set_index() */
+    jq_size index_cap;                  /* index capacity in entries */
+    jq_size index_size;                 /* number of entries in index */
+    jq_size index_pos;                  /* next entry to walk */
+    jq_size index_base;                 /* buf position the entries are relative to */
+    jq_size index_end;                  /* buf position stage 1 has reached */
+    jq_uint64 index_escaped;            /* stage 1 carries from the previous block: */
+    jq_uint64 index_in_string;          /* first char is escaped, block ends inside */
+    jq_uint64 index_scalar;             /* a string, last char belongs to a scalar, */
+    jq_bool index_string_bs;            /* current string has a backslash */
+    jq_bool index_after_scalar;         /* the latest token was a scalar read by jq_get_token() */
+#endif
+#ifdef JQ_WITH_TAPE
+    jq_uint64 *tape;                    /* tape words, see jq_set_tape() */
+    jq_size tape_cap;                   /* tape capacity in words */
+    jq_size tape_size;                  /* number of words written or counted */
+    jq_size tape_open;                  /* index of the innermost unclosed begin entry */
+    jq_bool tape_on;                    /* jq_set_tape() was called */
+#endif
+#ifdef JQ_WITH_STATS
+    struct jq_stats stats;              /* see jq_get_stats(), bytes are counted there */
+    jq_size stats_offset;               /* position in the whole input the bytes are counted from */
+    jq_clock_callback stats_clock;      /* see jq_set_stats_clock() */
+    jq_uint64 stats_start;              /* clock at the beginning of the current document */
+    jq_bool stats_open;                 /* the current document is begun */
 #endif
     jq_callback callback;               /* callback function */
-    enum jq_error error;                /* error code */
+    jq_control_callback control;        /* control callback function */
+    void *udata;                        /* user data, jquick doesn't use it */
 };
 
 /*
@@ -278,6 +704,100 @@ JQ_API jq_bool jq_init(struct jq_handler *h);
 */
 JQ_INLINE void jq_set_callback(struct jq_handler *h, jq_callback callback);
 
+/*
+/// #### jq_set_control_callback
+/// Sets the callback function pointer which is called for the same events as
+/// the one set with `jq_set_callback`, but can skip values and stop `jq_parse`
+/// with its return value. A consumer that needs a few fields of a big document
+/// skips the rest of it without any events for it. If both callbacks are set,
+/// only this one is called.
+/// ~~~
+/// void jq_set_control_callback(struct jq_handler *h, jq_control_callback control);
+/// ~~~
+///
+/// Parameter       | Description
+/// ----------------|----------------------------------------------------------------
+/// __h__           | Pointer to previously initialized `jq_handler`
+/// __control__     | Pointer to callback function. See `jq_control_callback` typedef for prototype
+///
+/// This is how the `"id"` of the root object can be found
+/// ~~~
+/// enum jq_control find_id(struct jq_handler *h, enum jq_event_type e) {
+///     if (e == JQ_E_OBJECT_BEGIN || e == JQ_E_ARRAY_BEGIN) return JQ_C_SKIP;
+///     if (e != JQ_E_OBJECT_KEY) return JQ_C_CONTINUE;
+///     return strcmp(h->val, "id") == 0 ? JQ_C_CONTINUE : JQ_C_SKIP;
+/// }
+/// ~~~
+/// It skips every nested object and array and the values of all the keys but
+/// `"id"`, the callback gets the value of `"id"` next to its key.
+///
+*/
+JQ_INLINE void jq_set_control_callback(struct jq_handler *h, jq_control_callback control);
+
+/*
+/// #### jq_set_multi
+/// Turns the multi document mode on or off. In this mode the input is a sequence
+/// of json values, one after another: newline delimited json (NDJSON), RFC 7464
+/// json text sequences, where every record starts with the RS (0x1e) char, or just
+/// values concatenated with or without whitespace between them.
+/// Every value comes between `JQ_E_DOCUMENT_BEGIN` and `JQ_E_DOCUMENT_END` events,
+/// `jq_get_document_offset` returns where it begins, and at `JQ_E_DOCUMENT_END`
+/// `jq_get_offset` returns where it ends.
+/// The input buffer can end anywhere, `jq_parse` returns `JQ_TRUE` if it ends
+/// between documents (the tail is empty then) and `JQ_FALSE` with
+/// `JQ_ERR_LEXER_NEED_MORE` if it ends inside one, the next buffer goes on with
+/// the rest as usual.
+/// ~~~
+/// void jq_set_multi(struct jq_handler *h, jq_bool multi);
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __h__     | Pointer to previously initialized `jq_handler`
+/// __multi__ | `JQ_TRUE` to turn the mode on, `JQ_FALSE` to turn it off
+///
+*/
+JQ_INLINE void jq_set_multi(struct jq_handler *h, jq_bool multi);
+
+/*
+/// #### jq_set_readonly
+/// Turns the read-only mode on or off. In this mode the input buffer is never
+/// written, so it can be a read-only mapping of a file or memory shared with
+/// others. `JQ_WITH_NULLTERM` puts no `'\0'` after the values then and
+/// `JQ_WITH_UNESCAPE` doesn't decode the strings, `val` and `vlen` keep them as
+/// they are in the input.
+/// ~~~
+/// void jq_set_readonly(struct jq_handler *h, jq_bool readonly);
+/// ~~~
+///
+/// Parameter    | Description
+/// -------------|----------------------------------------------------------------
+/// __h__        | Pointer to previously initialized `jq_handler`
+/// __readonly__ | `JQ_TRUE` to turn the mode on, `JQ_FALSE` to turn it off
+///
+*/
+JQ_INLINE void jq_set_readonly(struct jq_handler *h, jq_bool readonly);
+
+/*
+/// #### jq_set_input_end
+/// Tells the handler that the buffer appended is the last one, the input ends with
+/// it. The end of the input finishes a number there, as a whitespace after it would,
+/// otherwise the lexer waits for more digits and `jq_parse` returns `JQ_FALSE` with
+/// `JQ_ERR_LEXER_NEED_MORE`. A string or a literal cut by the end of the input is
+/// `JQ_ERR_LEXER_NEED_MORE` still. There is no byte after such a number to put
+/// `'\0'` to, `JQ_WITH_NULLTERM` leaves it unterminated, `vlen` is its length.
+/// ~~~
+/// void jq_set_input_end(struct jq_handler *h, jq_bool end);
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __h__     | Pointer to previously initialized `jq_handler`
+/// __end__   | `JQ_TRUE` if the input ends with the buffer, `JQ_FALSE` otherwise
+///
+*/
+JQ_INLINE void jq_set_input_end(struct jq_handler *h, jq_bool end);
+
 /*
 /// #### jq_append_buf
 ///  Appends an input buffer which then can be parsed with
@@ -296,695 +816,6243 @@ JQ_INLINE void jq_set_callback(struct jq_handler *h, jq_callback callback);
 JQ_INLINE void jq_append_buf(struct jq_handler *h, jq_char *src, jq_size sz);
 
 /*
-/// #### jq_parse
-/// Parses previously appended with `jq_append_buf` json input buffer.
+/// #### jq_append_const_buf
+/// Appends a constant input buffer, it's `jq_append_buf` turning the read-only mode
+/// on (see `jq_set_readonly`). The handler never writes to the buffer, so it can be
+/// read-only memory, and several handlers can parse one buffer on different threads
+/// at the same time. The values are `val` and `vlen` of the handler, see `jq_get_view`.
 /// ~~~
-/// jq_bool jq_parse(struct jq_handler *h);
+/// void jq_append_const_buf(struct jq_handler *h, const jq_char *src, jq_size sz);
 /// ~~~
 ///
 /// Parameter | Description
 /// ----------|----------------------------------------------------------------
 /// __h__     | Pointer to previously initialized `jq_handler`
-///
-/// Returns `JQ_TRUE(1)` if ok, `JQ_FALSE(0)` if error occured.
-/// The error code can be retrieved with `jq_get_error()` function.
+/// __src__   | Pointer to source buffer
+/// __sz__    | Size of source buffer in bytes
 ///
 */
-JQ_API jq_bool jq_parse(struct jq_handler *h);
+JQ_INLINE void jq_append_const_buf(struct jq_handler *h, const jq_char *src, jq_size sz);
 
 /*
-/// #### jq_parse_buf
-/// Parses json input buffer. This function is just a wrapper which calls `jq_append_buf`
-/// and `jq_parse` functions sequentially returning what the below has returned.
+/// #### jq_set_index
+/// Sets the memory for the structural index, it is available with `JQ_WITH_INDEX` only.
+/// With the index set, `jq_parse` runs stage 1 over the input buffer 64 bytes at
+/// a time (with SSE2 or AVX2 if the compiler targets them and `JQ_WITHOUT_SIMD`
+/// is not defined) and finds the positions of all the structural chars, quotes
+/// and scalar beginnings. Then the parser walks these positions, so punctuation
+/// and strings without escapes are not lexed byte by byte. The index is filled
+/// and walked by turns, so `cap` can be much less than the input buffer.
+/// Passing `JQ_NULL` as `index` turns indexing off.
 /// ~~~
-/// jq_bool jq_parse_buf(struct jq_handler *h, jq_char *src, jq_size sz);
+/// jq_bool jq_set_index(struct jq_handler *h, jq_index *index, jq_size cap);
 /// ~~~
 ///
 /// Parameter | Description
 /// ----------|----------------------------------------------------------------
 /// __h__     | Pointer to previously initialized `jq_handler`
-/// __src__   | Pointer to source buffer
-/// __sz__    | Size in bytes of source buffer
+/// __index__ | Pointer to array of `cap` entries
+/// __cap__   | Number of entries in `index`, it must be at least 64
 ///
-/// Returns `JQ_TRUE(1)` if ok, `JQ_FALSE(0)` if error occured.
-/// The error code can be retrieved with `jq_get_error()` function.
+/// Returns `JQ_TRUE(1)` if ok, `JQ_FALSE(0)` if `cap` is too small.
 ///
 */
-JQ_INLINE jq_bool jq_parse_buf(struct jq_handler *h, jq_char *src, jq_size sz);
+#ifdef JQ_WITH_INDEX
+JQ_API jq_bool jq_set_index(struct jq_handler *h, jq_index *index, jq_size cap);
+#endif
 
 /*
-/// #### jq_get_tail
-/// Returns pointer to the latest part of input buffer, previously parsed with
-/// `jq_parse` or `jq_parse_buf`, which `jquick` was not able to process either
-/// because of an error or end of the input buffer. In both cases you can check
-/// the reason with `jq_get_error`. Together with `jq_get_tail_size` this function
-/// can be used to correct the error or prepare for the next call of `jq_parse`.
-/// It is implemented as a macro.
+/// #### jq_set_tape
+/// Sets the memory for the tape, it is available with `JQ_WITH_TAPE` only.
+/// With the tape set, `jq_parse` and `jq_next` write every value they meet into
+/// a flat array of 64-bit words besides returning it or calling the callback. Every entry is a word with
+/// the type in the highest byte and the payload in the rest, see
+/// `enum jq_tape_type`. Strings, keys and numbers take one more word.
+/// A begin entry keeps the index of its end entry, so a whole object or array
+/// is skipped in O(1) with `jq_tape_next`. Strings and numbers stay in the input,
+/// the tape keeps their offsets counted from the beginning of the first buffer,
+/// so the input should live as long as the tape is used.
+/// Passing `JQ_NULL` as `tape` turns on the size query mode: nothing is written,
+/// the words are only counted, so the input can be parsed once to get the size
+/// with `jq_get_tape_size` and again to fill the tape allocated exactly.
+/// The tape is not allocated or grown by `jquick`, if it is too small `jq_parse`
+/// fails with `JQ_ERR_TAPE_FULL`.
 /// ~~~
-/// jq_char *jq_get_tail(struct jq_handler *h)
+/// void jq_set_tape(struct jq_handler *h, jq_uint64 *tape, jq_size cap);
 /// ~~~
 ///
 /// Parameter | Description
 /// ----------|----------------------------------------------------------------
 /// __h__     | Pointer to previously initialized `jq_handler`
-///
-/// Returns pointer to unprocessed tail of the input buffer.
+/// __tape__  | Pointer to array of `cap` words or `JQ_NULL` to count the words only
+/// __cap__   | Number of words in `tape`
 ///
 */
-#define jq_get_tail(h) ((h)->buf + (h)->i)
+#ifdef JQ_WITH_TAPE
+JQ_API void jq_set_tape(struct jq_handler *h, jq_uint64 *tape, jq_size cap);
+#endif
 
 /*
-/// #### jq_get_tail_size
-/// Returns the size of the latest part of input buffer, previously parsed with
-/// `jq_parse` or `jq_parse_buf`, which `jquick` was not able to process.
-/// See `jq_get_tail` for more information.
-/// It is implemented as a macro.
+/// #### jq_get_tape_size
+/// Returns the number of tape words written, or counted in the size query mode.
+/// It is available with `JQ_WITH_TAPE` only. It is implemented as a macro.
 /// ~~~
-/// jq_size jq_get_tail_size(struct jq_handler *h)
+/// jq_size jq_get_tape_size(struct jq_handler *h)
 /// ~~~
 ///
 /// Parameter | Description
 /// ----------|----------------------------------------------------------------
 /// __h__     | Pointer to previously initialized `jq_handler`
 ///
-/// Returns the size of the latest part of input buffer, previously parsed with
-/// `jq_parse` or `jq_parse_buf`, which `jquick` was not able to process.
+*/
+#define jq_get_tape_size(h) ((h)->tape_size)
+
+/*
+/// #### jq_tape_type, jq_tape_payload
+/// Return the type (`enum jq_tape_type`) and the payload of a tape word.
+/// They are implemented as macros.
+/// ~~~
+/// int jq_tape_type(jq_uint64 word)
+/// jq_uint64 jq_tape_payload(jq_uint64 word)
+/// ~~~
+*/
+#define jq_tape_type(word) ((int)((word) >> 56))
+#define jq_tape_payload(word) ((word) & 0x00ffffffffffffffull)
+
+/*
+/// #### jq_tape_next
+/// Returns the index of the entry following the value at index `i`, i.e. the next
+/// element of an array or the next key of an object. If the value is an object
+/// or an array, all of it is skipped in one step.
+/// It is available with `JQ_WITH_TAPE` only.
+/// ~~~
+/// jq_size jq_tape_next(const jq_uint64 *tape, jq_size i);
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __tape__  | Pointer to the tape filled by `jq_parse`
+/// __i__     | Index of an entry in `tape`
+///
+/// Returns the index of the next entry.
 ///
 */
-#define jq_get_tail_size(h) ((h)->buf_size - (h)->i)
+#ifdef JQ_WITH_TAPE
+JQ_API jq_size jq_tape_next(const jq_uint64 *tape, jq_size i);
+#endif
 
 /*
-/// #### jq_get_error
-/// Returns error code of the latest parsing operation.
-/// It is implemented as a macro.
+/// #### jq_tape_double
+/// Converts the word following `JQ_TAPE_DOUBLE` entry to double.
+/// It is available with `JQ_WITH_TAPE` only.
 /// ~~~
-/// enum jq_error jq_get_error(struct jq_handler *h)
+/// double jq_tape_double(jq_uint64 word);
+/// ~~~
+*/
+#ifdef JQ_WITH_TAPE
+JQ_API double jq_tape_double(jq_uint64 word);
+#endif
+
+/*
+/// #### jq_next
+/// Returns the next event of previously appended with `jq_append_buf` json input
+/// buffer. This is the pull alternative to `jq_parse` with a callback: `jq_parse`
+/// is built on `jq_next`, they share the parser state, and the value of the event
+/// is available in `val` (and `vlen`) of the handler the same way.
+/// `jq_next` is inlined, so a consumer loop compiles to straight-line code with
+/// no indirect calls.
+/// ~~~
+/// enum jq_event_type jq_next(struct jq_handler *h);
 /// ~~~
 ///
 /// Parameter | Description
 /// ----------|----------------------------------------------------------------
 /// __h__     | Pointer to previously initialized `jq_handler`
 ///
-/// Returns error code defined in `enum jq_error`. 
+/// Returns an event from enum `jq_event_type` or one of:
+///
+/// Event               | Description
+/// --------------------|----------------------------------------------------------------
+/// __JQ_E_DONE__       | The document is complete and the input buffer is over
+/// __JQ_E_NEED_MORE__  | The input buffer is over before the end of the document, the next one can be appended
+/// __JQ_E_ERROR__      | An error occured, the error code can be retrieved with `jq_get_error()`
+///
+/// This is how the keys of a flat object can be read
+/// ~~~
+/// enum jq_event_type e;
+/// jq_append_buf(&h, json, sz);
+/// while ((e = jq_next(&h)) != JQ_E_DONE) {
+///     if (e == JQ_E_ERROR || e == JQ_E_NEED_MORE) break;
+///     if (e == JQ_E_OBJECT_KEY) printf("%.*s\n", (int)h.vlen, h.val);
+/// }
+/// ~~~
 ///
 */
-#define jq_get_error(h) ((h)->error)
+JQ_INLINE enum jq_event_type jq_next(struct jq_handler *h);
 
 /*
-/// #### jq_set_error
-/// Sets error code to one of enum `jq_error` constants.
-/// It is implemented as a macro.
+/// #### jq_skip
+/// Skips a value without events for it. Called after `JQ_E_OBJECT_KEY` it skips the
+/// value of the key, the key is not written to the tape then. Called after any other
+/// event inside an object or array it skips the rest of it, so just after
+/// `JQ_E_OBJECT_BEGIN` or `JQ_E_ARRAY_BEGIN` the whole content is skipped. The
+/// closing `JQ_E_OBJECT_END` or `JQ_E_ARRAY_END` is returned as usual then. It does
+/// nothing at the top level.
+/// The skipped chars are not lexed, only quotes, escapes and brackets are counted
+/// to find the end of the value, so they are not validated either. The input
+/// buffer can end in the middle of the skipped value, the next call of `jq_next`
+/// or `jq_parse` goes on skipping in the next buffer then, the tail of the buffer
+/// is always empty.
 /// ~~~
-/// void jq_set_error(struct jq_handler *h, enum jq_error error)
+/// void jq_skip(struct jq_handler *h);
 /// ~~~
 ///
 /// Parameter | Description
 /// ----------|----------------------------------------------------------------
 /// __h__     | Pointer to previously initialized `jq_handler`
-/// __error__ | error code of enum `jq_error`
 ///
 */
-#define jq_set_error(h, e) ((h)->error = e)
+JQ_INLINE void jq_skip(struct jq_handler *h);
 
 /*
-/// #### jq_reset_error
-/// Resets error code to JQ_ERR_OK.
-/// It is implemented as a macro.
+/// #### jq_parse
+/// Parses previously appended with `jq_append_buf` json input buffer.
 /// ~~~
-/// void jq_reset_error(struct jq_handler *h)
+/// jq_bool jq_parse(struct jq_handler *h);
 /// ~~~
 ///
 /// Parameter | Description
 /// ----------|----------------------------------------------------------------
 /// __h__     | Pointer to previously initialized `jq_handler`
 ///
+/// Returns `JQ_TRUE(1)` if ok, `JQ_FALSE(0)` if error occured.
+/// The error code can be retrieved with `jq_get_error()` function.
+/// If the control callback returns `JQ_C_STOP`, the error code is `JQ_ERR_STOPPED`
+/// and the next call of `jq_parse` goes on from the next event.
+///
 */
-#define jq_reset_error(h) jq_set_error(h, JQ_ERR_OK)
+JQ_API jq_bool jq_parse(struct jq_handler *h);
 
 /*
-/// #### jq_errstr
-/// Shows a readable error description.
+/// #### jq_parse_buf
+/// Parses json input buffer. This function is just a wrapper which calls `jq_append_buf`
+/// and `jq_parse` functions sequentially returning what the below has returned.
 /// ~~~
-/// const char *jq_errstr(enum jq_error error);
+/// jq_bool jq_parse_buf(struct jq_handler *h, jq_char *src, jq_size sz);
 /// ~~~
 ///
 /// Parameter | Description
 /// ----------|----------------------------------------------------------------
-/// __error__ | Error code. It can be retrieved with `jq_get_error()` function
+/// __h__     | Pointer to previously initialized `jq_handler`
+/// __src__   | Pointer to source buffer
+/// __sz__    | Size in bytes of source buffer
 ///
-/// Returns a readable error description.
+/// Returns `JQ_TRUE(1)` if ok, `JQ_FALSE(0)` if error occured.
+/// The error code can be retrieved with `jq_get_error()` function.
 ///
 */
-JQ_API const char *jq_errstr(enum jq_error error);
-
-/* ==========================================================================
- *
- * IMPLEMENTATION
- *
- * ========================================================================== */
+JQ_INLINE jq_bool jq_parse_buf(struct jq_handler *h, jq_char *src, jq_size sz);
 
-/* ==========================================================================
- *
- * General
- *
+/*
+/// #### jq_validate
+/// Checks that the buffer is a single json value with optional whitespace around it.
+/// It is the fast path of `jq_parse_buf` for the input which is only checked: no
+/// handler, no events and no values, the buffer is not changed.
+/// The strings are scanned 8 bytes at a time, or as the lexer does it with
+/// `JQ_WITH_UTF8_CHECK`, and the objects and arrays are kept as one bit per level.
+/// It accepts and rejects the same input as `jq_parse_buf` and gives the same error
+/// codes, but the buffer is the whole input, so its end finishes a number or a
+/// literal there, as a whitespace after the buffer would. `jq_parse_buf` can't tell
+/// such a token from a cut one, so where it returns `JQ_ERR_LEXER_NEED_MORE` for a
+/// value out of place at the end, as in `5true` or `[1 2`, `jq_validate` returns
+/// `JQ_ERR_PARSER_UNEXPECTED_TOKEN`. A cut token is `JQ_ERR_LEXER_NEED_MORE` for both.
+/// Objects and arrays nested too deep are `JQ_ERR_MAX_DEPTH` as well.
+/// ~~~
+/// enum jq_error jq_validate(const jq_char *buf, jq_size sz, jq_size *offset);
+/// ~~~
+///
+/// Parameter  | Description
+/// -----------|----------------------------------------------------------------
+/// __buf__    | Pointer to the input
+/// __sz__     | Size of the input in bytes
+/// __offset__ | Pointer to the offset of the byte the error is found at, `sz` if the input is cut. It can be `JQ_NULL`
+///
+/// Returns `JQ_ERR_OK` if the input is valid json, the error code otherwise.
+///
+*/
+JQ_API enum jq_error jq_validate(const jq_char *buf, jq_size sz, jq_size *offset);
+
+/*
+/// #### jq_parse_file
+/// Parses the file in place, it is available with `JQ_WITH_MMAP` only. With this
+/// macro defined `jquick` needs a POSIX system. The file is mapped read-only with
+/// the sequential access hint, so it takes no memory but the page cache, and the
+/// handler is turned to the read-only mode (see `jq_set_readonly`), so the pages
+/// are never copied on write. The values are not null terminated then, they are
+/// `val` and `vlen` of the handler.
+/// The end of the file is the end of the input, so a number of any length can end
+/// the file, see `jq_set_input_end`.
+/// The mapping is released before the return, the values and the strings of the
+/// tape are valid in the callbacks only. `jq_parse` can't go on after
+/// `JQ_ERR_STOPPED` then.
+/// ~~~
+/// jq_bool jq_parse_file(struct jq_handler *h, const char *path);
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __h__     | Pointer to previously initialized `jq_handler`
+/// __path__  | Path to the file
+///
+/// Returns `JQ_TRUE(1)` if ok, `JQ_FALSE(0)` if error occured.
+/// The error code is `JQ_ERR_FILE` if the file can't be opened or mapped.
+///
+*/
+#ifdef JQ_WITH_MMAP
+JQ_API jq_bool jq_parse_file(struct jq_handler *h, const char *path);
+#endif
+
+/*
+/// #### jq_parse_fd
+/// Reads the input from the file descriptor and parses it, it is available with
+/// `JQ_WITH_READER` only. With this macro defined `jquick` needs a POSIX system.
+/// The memory is cut into `depth` buffers. On Linux a regular file is read with
+/// io_uring, all the buffers but the one being parsed are read meanwhile, so the
+/// parser doesn't wait for the disk. io_uring is set up with the system calls,
+/// no library is needed, and `JQ_WITHOUT_IO_URING` turns it off. Anything else,
+/// or if io_uring is not there, is read with `read` one buffer at a time.
+/// The tail of a buffer is carried to the next one, so the first half of every
+/// buffer is the room for it, a token can't be longer than that. The end of the
+/// input is the end of the file, so a number can end it.
+/// A regular file is read from the current position of the descriptor, which
+/// is not changed with io_uring.
+/// ~~~
+/// jq_bool jq_parse_fd(struct jq_handler *h, int fd, jq_char *mem, jq_size size, unsigned depth);
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __h__     | Pointer to previously initialized `jq_handler`
+/// __fd__    | File descriptor open for reading
+/// __mem__   | Memory for the buffers, the values are there in the callbacks
+/// __size__  | Size of `mem` in bytes, e.g. 1 Mb per buffer
+/// __depth__ | Number of buffers, 0 means 4, 64 at most
+///
+/// Returns `JQ_TRUE(1)` if ok, `JQ_FALSE(0)` if error occured. The error code is
+/// `JQ_ERR_FILE` if the file can't be read and `JQ_ERR_BUFFER_FULL` if a token
+/// doesn't fit the room for the tail.
+///
+*/
+#ifdef JQ_WITH_READER
+JQ_API jq_bool jq_parse_fd(struct jq_handler *h, int fd, jq_char *mem, jq_size size, unsigned depth);
+#endif
+
+/*
+/// #### jq_get_int64
+/// Gets the value of the latest number, it is available with `JQ_WITH_NUMBERS` only.
+/// With this macro defined the lexer accumulates the digits of the number while
+/// scanning it, so the value is ready in `JQ_E_NUMBER` callback with no `strtoll()`.
+/// ~~~
+/// jq_bool jq_get_int64(struct jq_handler *h, jq_int64 *v);
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __h__     | Pointer to previously initialized `jq_handler`
+/// __v__     | Pointer to the value to be set
+///
+/// Returns `JQ_TRUE(1)` if ok, `JQ_FALSE(0)` if the number is not integral or it
+/// doesn't fit in `jq_int64`.
+///
+*/
+#ifdef JQ_WITH_NUMBERS
+JQ_API jq_bool jq_get_int64(struct jq_handler *h, jq_int64 *v);
+#endif
+
+/*
+/// #### jq_get_uint64
+/// Gets the value of the latest number, it is available with `JQ_WITH_NUMBERS` only.
+/// ~~~
+/// jq_bool jq_get_uint64(struct jq_handler *h, jq_uint64 *v);
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __h__     | Pointer to previously initialized `jq_handler`
+/// __v__     | Pointer to the value to be set
+///
+/// Returns `JQ_TRUE(1)` if ok, `JQ_FALSE(0)` if the number is not integral,
+/// negative or it doesn't fit in `jq_uint64`.
+///
+*/
+#ifdef JQ_WITH_NUMBERS
+JQ_API jq_bool jq_get_uint64(struct jq_handler *h, jq_uint64 *v);
+#endif
+
+/*
+/// #### jq_get_double
+/// Gets the value of the latest number correctly rounded to the nearest double,
+/// it is available with `JQ_WITH_NUMBERS` only. Most of the numbers are converted
+/// with a couple of multiplications, the numbers with more than 19 significant
+/// digits may need the number chars, so it should be called from `JQ_E_NUMBER` callback.
+/// ~~~
+/// double jq_get_double(struct jq_handler *h);
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __h__     | Pointer to previously initialized `jq_handler`
+///
+/// Returns the value, it is infinity if the number is too big for double.
+///
+*/
+#ifdef JQ_WITH_NUMBERS
+JQ_API double jq_get_double(struct jq_handler *h);
+#endif
+
+/*
+/// #### jq_get_number_flags
+/// Returns the flags of the latest number, it is available with `JQ_WITH_NUMBERS` only.
+/// It is implemented as a macro.
+/// ~~~
+/// int jq_get_number_flags(struct jq_handler *h)
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __h__     | Pointer to previously initialized `jq_handler`
+///
+/// Returns a combination of enum `jq_number_flags` constants.
+///
+*/
+#define jq_get_number_flags(h) ((h)->num_flags & (JQ_N_NEGATIVE | JQ_N_INTEGRAL | JQ_N_OVERFLOW))
+
+/*
+/// #### jq_get_view
+/// Returns the value of the latest string, key, number, `null`, `true` or `false`
+/// as a pointer and a length. The value is in the input buffer, it's not null
+/// terminated in the read-only mode.
+/// ~~~
+/// struct jq_view {
+///     const jq_char *ptr;
+///     jq_size len;
+/// };
+///
+/// struct jq_view jq_get_view(const struct jq_handler *h);
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __h__     | Pointer to previously initialized `jq_handler`
+///
+*/
+struct jq_view {
+    const jq_char *ptr;
+    jq_size len;
+};
+
+JQ_INLINE struct jq_view jq_get_view(const struct jq_handler *h);
+
+/*
+/// #### jq_get_tail
+/// Returns pointer to the latest part of input buffer, previously parsed with
+/// `jq_parse` or `jq_parse_buf`, which `jquick` was not able to process either
+/// because of an error or end of the input buffer. In both cases you can check
+/// the reason with `jq_get_error`. Together with `jq_get_tail_size` this function
+/// can be used to correct the error or prepare for the next call of `jq_parse`.
+/// In case of `JQ_ERR_LEXER_NEED_MORE` the tail starts at the beginning of the
+/// unfinished token and the next buffer appended with `jq_append_buf` must start
+/// with this tail. The lexer remembers its state, so the bytes of the tail
+/// are not scanned again. They are still moved by the caller, a token longer
+/// than the buffer is moved again with every buffer: a 4 MB string read in 16 KB
+/// buffers is scanned once, but it is moved 256 times, about 0.5 GB in all. The
+/// buffer should be larger than the longest token then, `jq_parse_fd` moves the
+/// tail the same way.
+/// It is implemented as a macro.
+/// ~~~
+/// jq_char *jq_get_tail(struct jq_handler *h)
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __h__     | Pointer to previously initialized `jq_handler`
+///
+/// Returns pointer to unprocessed tail of the input buffer.
+///
+*/
+#define jq_get_tail(h) ((h)->buf + (h)->i)
+
+/*
+/// #### jq_get_tail_size
+/// Returns the size of the latest part of input buffer, previously parsed with
+/// `jq_parse` or `jq_parse_buf`, which `jquick` was not able to process.
+/// See `jq_get_tail` for more information.
+/// It is implemented as a macro.
+/// ~~~
+/// jq_size jq_get_tail_size(struct jq_handler *h)
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __h__     | Pointer to previously initialized `jq_handler`
+///
+/// Returns the size of the latest part of input buffer, previously parsed with
+/// `jq_parse` or `jq_parse_buf`, which `jquick` was not able to process.
+///
+*/
+#define jq_get_tail_size(h) ((h)->buf_size - (h)->i)
+
+/*
+/// #### jq_get_offset
+/// Returns the position of the parser in the whole input, i.e. counting from the
+/// beginning of the first buffer appended. After an event it is the position right
+/// after the value of the event. It is implemented as a macro.
+/// ~~~
+/// jq_size jq_get_offset(struct jq_handler *h)
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __h__     | Pointer to previously initialized `jq_handler`
+///
+*/
+#define jq_get_offset(h) ((h)->buf_offset + (h)->i)
+
+/*
+/// #### jq_get_document_offset
+/// Returns the position of the latest document in the whole input, see `jq_set_multi`.
+/// It is implemented as a macro.
+/// ~~~
+/// jq_size jq_get_document_offset(struct jq_handler *h)
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __h__     | Pointer to previously initialized `jq_handler`
+///
+*/
+#define jq_get_document_offset(h) ((h)->doc_offset)
+
+/*
+/// #### jq_get_error
+/// Returns error code of the latest parsing operation.
+/// It is implemented as a macro.
+/// ~~~
+/// enum jq_error jq_get_error(struct jq_handler *h)
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __h__     | Pointer to previously initialized `jq_handler`
+///
+/// Returns error code defined in `enum jq_error`. 
+///
+*/
+#define jq_get_error(h) ((h)->error)
+
+/*
+/// #### jq_set_error
+/// Sets error code to one of enum `jq_error` constants.
+/// It is implemented as a macro.
+/// ~~~
+/// void jq_set_error(struct jq_handler *h, enum jq_error error)
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __h__     | Pointer to previously initialized `jq_handler`
+/// __error__ | error code of enum `jq_error`
+///
+*/
+#define jq_set_error(h, e) ((h)->error = e)
+
+/*
+/// #### jq_reset_error
+/// Resets error code to JQ_ERR_OK.
+/// It is implemented as a macro.
+/// ~~~
+/// void jq_reset_error(struct jq_handler *h)
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __h__     | Pointer to previously initialized `jq_handler`
+///
+*/
+#define jq_reset_error(h) jq_set_error(h, JQ_ERR_OK)
+
+/*
+/// #### jq_errstr
+/// Shows a readable error description.
+/// ~~~
+/// const char *jq_errstr(enum jq_error error);
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __error__ | Error code. It can be retrieved with `jq_get_error()` function
+///
+/// Returns a readable error description.
+///
+*/
+JQ_API const char *jq_errstr(enum jq_error error);
+
+/*///
+/// ### Statistics
+/// With `JQ_WITH_STATS` defined the handler counts what the parser does, see
+/// `struct jq_stats`. The counters are in the handler, they are not shared and
+/// cost nothing without `JQ_WITH_STATS`. `jq_init` sets them to zero.
+///
+/// #### jq_get_stats
+/// Copies the statistics of the handler, since `jq_init` or `jq_reset_stats`.
+/// ~~~
+/// void jq_get_stats(const struct jq_handler *h, struct jq_stats *stats);
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __h__     | Pointer to previously initialized `jq_handler`
+/// __stats__ | Pointer to the copy
+///
+*/
+#ifdef JQ_WITH_STATS
+JQ_INLINE void jq_get_stats(const struct jq_handler *h, struct jq_stats *stats);
+#endif
+
+/*
+/// #### jq_reset_stats
+/// Sets the statistics to zero, e.g. after they are exported. The bytes are
+/// counted from the current position then, the parsing goes on as usual.
+/// ~~~
+/// void jq_reset_stats(struct jq_handler *h);
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __h__     | Pointer to previously initialized `jq_handler`
+///
+*/
+#ifdef JQ_WITH_STATS
+JQ_INLINE void jq_reset_stats(struct jq_handler *h);
+#endif
+
+/*
+/// #### jq_set_stats_clock
+/// Sets the clock the parse time of every document is measured with. The time
+/// is counted from the first token of the document (`JQ_E_DOCUMENT_BEGIN` in the
+/// multi document mode) to its end and goes to the `latency` histogram. The time
+/// the caller spends between the buffers and in the callbacks is counted too.
+/// Without a clock, by default, the time is not measured.
+/// ~~~
+/// void jq_set_stats_clock(struct jq_handler *h, jq_clock_callback clock);
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __h__     | Pointer to previously initialized `jq_handler`
+/// __clock__ | Clock function or `JQ_NULL`
+///
+*/
+#ifdef JQ_WITH_STATS
+JQ_INLINE void jq_set_stats_clock(struct jq_handler *h, jq_clock_callback clock);
+#endif
+
+/*///
+/// ### Location
+/// With `JQ_WITH_LOCATION` defined the line and the column of the parser position
+/// can be got, e.g. to report where the input is broken. They are not tracked
+/// while parsing: the lines are counted when they are asked for, from the position
+/// they were counted up to the latest time. The buffer ending with `JQ_E_NEED_MORE`
+/// is counted before it is given back, so the location is right across the buffers
+/// of the streaming parse, it costs one pass of `'\n'` search over them.
+///
+/// #### jq_get_location
+/// Returns the location of `jq_get_offset`, i.e. right after the value of the latest
+/// event, at the beginning of the broken token after an error, or at the beginning
+/// of the tail after `JQ_E_NEED_MORE`.
+/// ~~~
+/// struct jq_location jq_get_location(struct jq_handler *h);
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __h__     | Pointer to previously initialized `jq_handler`
+///
+*/
+#ifdef JQ_WITH_LOCATION
+JQ_API struct jq_location jq_get_location(struct jq_handler *h);
+#endif
+
+/*///
+/// ### Suspending
+/// With `JQ_WITH_SUSPEND` defined a parse waiting for more input can be saved into
+/// a small blob and resumed from it later, so an idle stream keeps neither the
+/// handler nor its input buffer. The blob has the lexer and parser states, the
+/// bits of the objects and arrays open, the offsets and the tail of the buffer,
+/// i.e. the bytes of the token cut by its end. The numbers are variable length,
+/// so the blob of a usual stream takes a few dozen bytes plus the tail, about twice
+/// as much with `JQ_WITH_STATS`.
+/// The callbacks, the user data and the memory set with `jq_set_index` are not in
+/// the blob, they are set again after `jq_resume`, so is the clock of the
+/// statistics. A handler with the tape can't be suspended.
+/// The blob is read by the `jquick` built with the same options only.
+///
+/// #### jq_suspend
+/// Writes the state of the handler to the blob if it fits there. The handler waits
+/// for more input then, i.e. the latest event is `JQ_E_NEED_MORE`, the buffer ended
+/// between the documents in the multi document mode or nothing was parsed yet. The
+/// handler and its buffer are not needed after that, the handler is not changed.
+/// ~~~
+/// jq_size jq_suspend(struct jq_handler *h, jq_char *blob, jq_size size);
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __h__     | Pointer to previously initialized `jq_handler`
+/// __blob__  | Pointer to the memory for the blob, it can be `JQ_NULL` if `size` is 0
+/// __size__  | Size of this memory
+///
+/// Returns the size of the blob, it is written only if it is not greater than `size`,
+/// so it can be called with 0 `size` first. Returns 0 if the handler can't be suspended.
+///
+*/
+#ifdef JQ_WITH_SUSPEND
+JQ_API jq_size jq_suspend(struct jq_handler *h, jq_char *blob, jq_size size);
+#endif
+
+/*
+/// #### jq_resume
+/// Initializes the handler with the state from the blob. The tail of the suspended
+/// buffer is copied to the beginning of `buf`, which is the buffer of the handler
+/// then, so the next buffer is made as usual: it starts with `jq_get_tail` of
+/// `jq_get_tail_size` bytes followed by the new input, see `jq_append_buf`. It can
+/// be `buf` itself with the new input read after the tail. The tail is not longer
+/// than the blob. The blob is not needed after it.
+/// ~~~
+/// jq_bool jq_resume(struct jq_handler *h, const jq_char *blob, jq_size size, jq_char *buf, jq_size buf_size);
+/// ~~~
+///
+/// Parameter    | Description
+/// -------------|----------------------------------------------------------------
+/// __h__        | Pointer to the handler, it needs not be initialized
+/// __blob__     | Pointer to the blob written by `jq_suspend`
+/// __size__     | Size of the blob
+/// __buf__      | Pointer to the memory for the tail, it can be `JQ_NULL` if `buf_size` is 0
+/// __buf_size__ | Size of this memory, `size` bytes are always enough
+///
+/// Returns `JQ_TRUE(1)` if ok, `JQ_FALSE(0)` if the blob is broken, is written
+/// by `jquick` with other options or its tail doesn't fit into `buf`, the handler
+/// is initialized with `jq_init` then.
+///
+*/
+#ifdef JQ_WITH_SUSPEND
+JQ_API jq_bool jq_resume(struct jq_handler *h, const jq_char *blob, jq_size size, jq_char *buf, jq_size buf_size);
+#endif
+
+/*///
+/// ### Parallel parsing
+/// With `JQ_WITH_THREADS` defined `jquick` parses newline delimited json (NDJSON)
+/// or the elements of a huge top-level array on several threads. It needs POSIX
+/// threads and allocates memory for the tapes of the records parsed ahead of their
+/// turn. `JQ_WITH_TAPE` is defined by it.
+///
+/// #### struct jq_record
+/// A record of NDJSON input or an element of the top-level array, see `jq_parse_parallel`
+/// and `jq_parse_parallel_array`.
+/// ~~~
+/// struct jq_record {
+///     jq_char *json;
+///     jq_size offset;
+///     jq_size size;
+///     const jq_uint64 *tape;
+///     jq_size tape_pos;
+///     jq_size tape_size;
+///     enum jq_error error;
+/// };
+/// ~~~
+///
+/// Field          | Description
+/// ---------------|----------------------------------------------------------------
+/// __json__       | Pointer to the record in the input
+/// __offset__     | Offset of the record in the input
+/// __size__       | Size of the record, without the trailing whitespace
+/// __tape__       | Tape the record is written to, `JQ_NULL` if it has an error
+/// __tape_pos__   | Index of the first word of the record in `tape`, the entries of the record link to each other by their indexes in `tape`
+/// __tape_size__  | Number of words of the record
+/// __error__      | `JQ_ERR_OK` or the error code of the record, the NDJSON record lasts to the end of its line then, the element lasts to the error
+///
+*/
+#ifdef JQ_WITH_THREADS
+struct jq_record {
+    jq_char *json;
+    jq_size offset;
+    jq_size size;
+    const jq_uint64 *tape;
+    jq_size tape_pos;
+    jq_size tape_size;
+    enum jq_error error;
+};
+
+typedef void (*jq_record_callback)(void *udata, const struct jq_record *r);
+
+/*///
+/// #### struct jq_parallel
+/// Settings of `jq_parse_parallel` and `jq_parse_parallel_array`.
+/// ~~~
+/// typedef void (*jq_record_callback)(void *udata, const struct jq_record *r);
+///
+/// struct jq_parallel {
+///     unsigned threads;
+///     jq_size chunk_size;
+///     jq_bool ordered;
+///     jq_record_callback record;
+///     jq_callback callback;
+///     void *udata;
+/// };
+/// ~~~
+///
+/// Field           | Description
+/// ----------------|----------------------------------------------------------------
+/// __threads__     | Number of threads parsing the input, the calling one is among them
+/// __chunk_size__  | Number of input bytes a thread takes at a time, 0 means 1 Mb. A chunk ends at the end of a line or after an element of the array
+/// __ordered__     | `JQ_TRUE` to get the records in the input order, `JQ_FALSE` to get them as soon as they are parsed
+/// __record__      | Callback called for every record or `JQ_NULL`. It is called on one thread at a time in the ordered mode, and on any of them at the same time otherwise
+/// __callback__    | Callback called for every event or `JQ_NULL`. It is called on the threads at the same time in any order, `udata` of the handler is set to `udata`
+/// __udata__       | User data passed to the callbacks
+///
+*/
+struct jq_parallel {
+    unsigned threads;
+    jq_size chunk_size;
+    jq_bool ordered;
+    jq_record_callback record;
+    jq_callback callback;
+    void *udata;
+};
+#endif
+
+/*
+/// #### jq_parse_parallel
+/// Parses NDJSON input on `threads` threads. The input is split into chunks at
+/// line ends and the threads take them one by one, each with its own `jq_handler` in
+/// the multi document mode. Every line can have one or more json values, the
+/// values can't go on to the next line. A record with an error doesn't stop the
+/// others, it is reported with `error` set and the parsing goes on from the next
+/// line. The last line can end without the line end, a number at the end of the
+/// input is finished by it, see `jq_set_input_end`.
+/// The input buffer is changed as `jq_parse` does it.
+/// ~~~
+/// jq_bool jq_parse_parallel(jq_char *buf, jq_size sz, const struct jq_parallel *p);
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __buf__   | Pointer to the whole input
+/// __sz__    | Size of the input in bytes
+/// __p__     | Pointer to the settings
+///
+/// Returns `JQ_TRUE(1)` if all the records are parsed, with or without errors,
+/// `JQ_FALSE(0)` if memory can't be allocated. If some of the threads can't be
+/// started, the rest of them do the work.
+///
+*/
+#ifdef JQ_WITH_THREADS
+JQ_API jq_bool jq_parse_parallel(jq_char *buf, jq_size sz, const struct jq_parallel *p);
+#endif
+
+/*
+/// #### jq_parse_parallel_array
+/// Parses a single json value on `threads` threads, the records are the elements of
+/// it if it is an array, or the whole value otherwise. The events of an element are
+/// the same as `jq_parse` gives, the threads give them at the same time though.
+///
+/// The input is cut into chunks of `chunk_size` bytes and a pre-pass on the threads
+/// counts the quotes and the brackets of every chunk, for the chunk starting inside
+/// and outside a string. Then the chunks are moved to the first ',' of the array
+/// in them, and every thread parses its chunk from the depth of the array. A chunk
+/// without such ',', as an element is longer than the chunk or the chunk starts
+/// more than 16 levels deep in an element, is parsed by the thread of the chunk before.
+///
+/// An error stops the parsing, the record with the error is the last one in the
+/// ordered mode. An empty input is one record with `JQ_ERR_LEXER_NEED_MORE`.
+/// The input buffer is changed as `jq_parse` does it.
+/// ~~~
+/// jq_bool jq_parse_parallel_array(jq_char *buf, jq_size sz, const struct jq_parallel *p);
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __buf__   | Pointer to the whole input
+/// __sz__    | Size of the input in bytes
+/// __p__     | Pointer to the settings
+///
+/// Returns `JQ_TRUE(1)` if the value is parsed, `JQ_FALSE(0)` if it has an error or
+/// memory can't be allocated.
+///
+*/
+#ifdef JQ_WITH_THREADS
+JQ_API jq_bool jq_parse_parallel_array(jq_char *buf, jq_size sz, const struct jq_parallel *p);
+#endif
+
+/*///
+/// ### Writing
+/// With `JQ_WITH_WRITER` defined `jquick` writes json too. The output goes to a
+/// buffer of the caller, when it is full it is given to the flush callback and
+/// reused, nothing is allocated. The writer puts ',' and ':' between the values
+/// itself, the top-level values are written one per line as NDJSON.
+/// Strings are scanned for the chars to escape 32, 16 or 8 bytes at a time
+/// depending on the instruction set available, the runs without them are copied
+/// as they are. Only '"', '\\' and the control chars are escaped, the strings
+/// should be valid UTF-8.
+///
+/// #### struct jq_writer
+/// The writer handler.
+/// ~~~
+/// typedef jq_bool (*jq_flush_callback)(void *udata, const jq_char *data, jq_size sz);
+///
+/// struct jq_writer;
+/// ~~~
+/// The flush callback gets the output written to the buffer and returns `JQ_FALSE`
+/// if it can't take it, the writer fails with `JQ_ERR_WRITER_FLUSH` then. Without
+/// the callback a full buffer is this error too.
+/// With `JQ_WITH_WRITER_CHECK` defined the writer keeps the stack of objects and
+/// arrays as `jq_handler` does and fails with `JQ_ERR_WRITER_UNEXPECTED` if a value
+/// doesn't fit the structure written, e.g. an object value without a key or `]`
+/// closing an object. It is defined by default unless `NDEBUG` or
+/// `JQ_WITHOUT_WRITER_CHECK` is defined, without it the structure is not checked.
+/// An error is kept, the functions do nothing and return `JQ_FALSE` after it.
+/// `jq_get_error` works with `jq_writer` too.
+*/
+#ifdef JQ_WITH_WRITER
+typedef jq_bool (*jq_flush_callback)(void *udata, const jq_char *data, jq_size sz);
+
+struct jq_writer {
+    jq_char *buf;                       /* output buffer */
+    jq_size buf_size;                   /* buf size */
+    jq_size i;                          /* number of chars written to buf */
+    jq_size depth;                      /* number of objects and arrays not closed */
+    jq_char sep;                        /* char to write before the next value or '\0' */
+#ifdef JQ_WITH_WRITER_CHECK
+    jq_char cnt;                        /* the innermost object waits for a key or a value */
+    jq_uint64 stack[JQ_STACK_WORDS];    /* bit per level above the top one, 1 for an object */
+#endif
+    jq_flush_callback flush;            /* flush callback function */
+    void *udata;                        /* user data passed to flush */
+    enum jq_error error;                /* error code */
+};
+#endif
+
+/*
+/// #### jq_writer_init
+/// Initializes struct `jq_writer`. It can be initialized again to be reused.
+/// ~~~
+/// jq_bool jq_writer_init(struct jq_writer *w, jq_char *buf, jq_size size, jq_flush_callback flush, void *udata);
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __w__     | Pointer to struct `jq_writer`
+/// __buf__   | Output buffer
+/// __size__  | Size of `buf` in bytes, it can't be 0
+/// __flush__ | Flush callback or `JQ_NULL`
+/// __udata__ | User data passed to `flush`
+///
+/// Returns `JQ_TRUE(1)` if ok, `JQ_FALSE(0)` if `buf` is empty.
+///
+*/
+#ifdef JQ_WITH_WRITER
+JQ_API jq_bool jq_writer_init(struct jq_writer *w, jq_char *buf, jq_size size, jq_flush_callback flush, void *udata);
+#endif
+
+/*
+/// #### jq_write_object_begin, jq_write_object_end, jq_write_array_begin, jq_write_array_end
+/// Write the beginning or the end of an object or an array.
+/// ~~~
+/// jq_bool jq_write_object_begin(struct jq_writer *w);
+/// jq_bool jq_write_object_end(struct jq_writer *w);
+/// jq_bool jq_write_array_begin(struct jq_writer *w);
+/// jq_bool jq_write_array_end(struct jq_writer *w);
+/// ~~~
+///
+/// Returns `JQ_TRUE(1)` if ok, `JQ_FALSE(0)` if error occured.
+///
+*/
+#ifdef JQ_WITH_WRITER
+JQ_API jq_bool jq_write_object_begin(struct jq_writer *w);
+JQ_API jq_bool jq_write_object_end(struct jq_writer *w);
+JQ_API jq_bool jq_write_array_begin(struct jq_writer *w);
+JQ_API jq_bool jq_write_array_end(struct jq_writer *w);
+#endif
+
+/*
+/// #### jq_write_key, jq_write_string
+/// Write an object key or a string of `len` bytes escaping it. The key is followed
+/// by ':', the string can be a value anywhere.
+/// ~~~
+/// jq_bool jq_write_key(struct jq_writer *w, const jq_char *s, jq_size len);
+/// jq_bool jq_write_string(struct jq_writer *w, const jq_char *s, jq_size len);
+/// ~~~
+///
+/// Returns `JQ_TRUE(1)` if ok, `JQ_FALSE(0)` if error occured.
+///
+*/
+#ifdef JQ_WITH_WRITER
+JQ_API jq_bool jq_write_key(struct jq_writer *w, const jq_char *s, jq_size len);
+JQ_API jq_bool jq_write_string(struct jq_writer *w, const jq_char *s, jq_size len);
+#endif
+
+/*
+/// #### jq_write_int64, jq_write_uint64, jq_write_double, jq_write_bool, jq_write_null
+/// Write a value. The numbers are written as `jq_format_int64`, `jq_format_uint64`
+/// and `jq_format_double` do it. Infinities and NaN can't be written in json,
+/// `jq_write_double` writes `null` for them.
+/// ~~~
+/// jq_bool jq_write_int64(struct jq_writer *w, jq_int64 v);
+/// jq_bool jq_write_uint64(struct jq_writer *w, jq_uint64 v);
+/// jq_bool jq_write_double(struct jq_writer *w, double v);
+/// jq_bool jq_write_bool(struct jq_writer *w, jq_bool v);
+/// jq_bool jq_write_null(struct jq_writer *w);
+/// ~~~
+///
+/// Returns `JQ_TRUE(1)` if ok, `JQ_FALSE(0)` if error occured.
+///
+*/
+#ifdef JQ_WITH_WRITER
+JQ_API jq_bool jq_write_int64(struct jq_writer *w, jq_int64 v);
+JQ_API jq_bool jq_write_uint64(struct jq_writer *w, jq_uint64 v);
+JQ_API jq_bool jq_write_double(struct jq_writer *w, double v);
+JQ_API jq_bool jq_write_bool(struct jq_writer *w, jq_bool v);
+JQ_API jq_bool jq_write_null(struct jq_writer *w);
+#endif
+
+/*
+/// #### jq_write_raw
+/// Writes `len` bytes of json text as a value, e.g. a value serialized before.
+/// The text is not checked or escaped.
+/// ~~~
+/// jq_bool jq_write_raw(struct jq_writer *w, const jq_char *s, jq_size len);
+/// ~~~
+///
+/// Returns `JQ_TRUE(1)` if ok, `JQ_FALSE(0)` if error occured.
+///
+*/
+#ifdef JQ_WITH_WRITER
+JQ_API jq_bool jq_write_raw(struct jq_writer *w, const jq_char *s, jq_size len);
+#endif
+
+/*
+/// #### jq_writer_flush
+/// Gives the output written to the buffer to the flush callback, it should be called
+/// at the end. Without the callback the output is `buf` of `jq_writer_get_size` bytes.
+/// ~~~
+/// jq_bool jq_writer_flush(struct jq_writer *w);
+/// jq_size jq_writer_get_size(struct jq_writer *w)
+/// ~~~
+///
+/// Returns `JQ_TRUE(1)` if ok, `JQ_FALSE(0)` if error occured.
+///
+*/
+#ifdef JQ_WITH_WRITER
+JQ_API jq_bool jq_writer_flush(struct jq_writer *w);
+#endif
+#define jq_writer_get_size(w) ((w)->i)
+
+/*
+/// #### jq_format_int64, jq_format_uint64, jq_format_double
+/// Write the text of a number to `buf` of `JQ_FORMAT_SIZE` bytes at least, without
+/// '\0' at the end. They are available with `JQ_WITH_WRITER`.
+/// The integers are written two digits at a time after the number of the digits
+/// is found with one comparison.
+/// A double is written with the fewest significant digits which are parsed back to
+/// the same double, the closest ones if there are several such, found with the
+/// Schubfach algorithm by Raffaello Giulietti. It is written as an integer up to
+/// 10^21, as a fraction down to 10^-6 and with an exponent otherwise, e.g. `100`,
+/// `0.1`, `-1.5e-7` or `1e21`. The text matches the json number grammar, so `jquick`
+/// parses it back to the same bits, `-0` included.
+/// ~~~
+/// #define JQ_FORMAT_SIZE 32
+///
+/// jq_size jq_format_int64(jq_char *buf, jq_int64 v);
+/// jq_size jq_format_uint64(jq_char *buf, jq_uint64 v);
+/// jq_size jq_format_double(jq_char *buf, double v);
+/// ~~~
+///
+/// Parameter | Description
+/// ----------|----------------------------------------------------------------
+/// __buf__   | Buffer for the text
+/// __v__     | Number
+///
+/// Returns the length of the text, it is 0 for infinities and NaN.
+///
+*/
+#define JQ_FORMAT_SIZE 32
+
+#ifdef JQ_WITH_WRITER
+JQ_API jq_size jq_format_int64(jq_char *buf, jq_int64 v);
+JQ_API jq_size jq_format_uint64(jq_char *buf, jq_uint64 v);
+JQ_API jq_size jq_format_double(jq_char *buf, double v);
+#endif
+
+/*
+/// #### jq_reformat
+/// Copies the json tokens of the buffer appended with `jq_append_buf` to the writer
+/// dropping the whitespace between them, and indents the output if `indent` is
+/// not 0. It is available with `JQ_WITH_WRITER`.
+/// The tokens are taken from the lexer and copied as they are, the strings are not
+/// unescaped and the numbers are not converted, so it goes at close to `memcpy`
+/// speed. The handler is put to the read-only mode for it, see `jq_set_readonly`.
+/// The grammar is checked as `jq_parse` does it, a missing separator or a wrong
+/// closing bracket is `JQ_ERR_PARSER_UNEXPECTED_TOKEN`.
+/// The input can come in chunks as for `jq_parse`, the next buffer starts with
+/// the tail of the previous one, and it can have several top-level values, they
+/// are written one per line. `[]` and `{}` are kept on one line.
+/// A bare `null`, `true` or `false` at the end of the input needs the whitespace
+/// after it to be finished, a bare number needs it or `jq_set_input_end`.
+/// `jq_writer_flush` should be called at the end.
+/// ~~~
+/// jq_bool jq_reformat(struct jq_handler *h, struct jq_writer *w, unsigned indent);
+/// ~~~
+///
+/// Parameter  | Description
+/// -----------|----------------------------------------------------------------
+/// __h__      | Pointer to previously initialized `jq_handler`
+/// __w__      | Pointer to previously initialized `jq_writer`, only the tokens of `h` should be written to it
+/// __indent__ | Number of spaces per level, 0 gives the minified output
+///
+/// Returns `JQ_TRUE(1)` if all the values in the input are complete, `JQ_FALSE(0)`
+/// otherwise. The error code is `JQ_ERR_LEXER_NEED_MORE` if the buffer ends inside
+/// a value, the error code of the lexer or the writer otherwise.
+///
+*/
+#ifdef JQ_WITH_WRITER
+JQ_API jq_bool jq_reformat(struct jq_handler *h, struct jq_writer *w, unsigned indent);
+#endif
+
+/* ==========================================================================
+ *
+ * IMPLEMENTATION
+ *
+ * ========================================================================== */
+
+/* ==========================================================================
+ *
+ * General
+ *
+ * ========================================================================== */
+
+#ifdef JQ_WITH_IMPLEMENTATION
+
+#define JQ_NULL 0
+
+#ifdef JQ_WITH_UTF8_CHECK
+  #define JQ_UTF8_ACCEPT                0
+  #define JQ_UTF8_REJECT                1
+#endif
+
+#ifdef JQ_WITH_INDEX
+/* Forward declarations */
+JQ_INLINE void jq_index_reset(struct jq_handler *h, jq_size pos);
+#endif
+
+JQ_API jq_bool
+jq_init(struct jq_handler *h) {
+    h->buf = JQ_NULL;
+    h->buf_size = 0;
+    h->i = 0;
+    h->cnt = 0;
+    h->state = JQ_S_UNDEFINED;
+    h->stack_pos = 0;
+    h->val = JQ_NULL;
+    h->lexer_state = JQ_L_NORMAL;
+    h->nft_cnt = 0;
+    h->lexed = 0;
+    h->skip_state = JQ_SKIP_NONE;
+    h->buf_offset = 0;
+    h->doc_offset = 0;
+    h->multi = JQ_FALSE;
+    h->doc_open = JQ_FALSE;
+    h->readonly = JQ_FALSE;
+    h->input_end = JQ_FALSE;
+    h->skip_rest = JQ_FALSE;
+    h->skip_depth = 0;
+    h->vlen = 0;
+#ifdef JQ_WITH_LOCATION
+    h->loc_offset = 0;
+    h->loc_line = 0;
+    h->loc_line_offset = 0;
+#endif
+#ifdef JQ_WITH_UTF8_CHECK
+    h->utf8_state = JQ_UTF8_ACCEPT;
+#endif
+#ifdef JQ_WITH_UNESCAPE
+    h->unesc_len = 0;
+    h->unesc_src = 0;
+    h->unesc_cp = 0;
+    h->unesc_hi = 0;
+  #ifdef JQ_WITH_LOCATION
+    h->unesc_newline = JQ_FALSE;
+  #endif
+#endif
+#ifdef JQ_WITH_NUMBERS
+    h->num_mantissa = 0;
+    h->num_exp10 = 0;
+    h->num_exp = 0;
+    h->num_len = 0;
+    h->num_flags = 0;
+#endif
+#ifdef JQ_WITH_NULLTERM
+    h->subst_char = '\0';
+    h->subst_pos = 0; /* subst_pos init doesn't matter, only subst_char is checked */
+#endif
+#ifdef JQ_WITH_INDEX
+    h->index = JQ_NULL;
+    h->index_cap = 0;
+    jq_index_reset(h, 0);
+#endif
+#ifdef JQ_WITH_TAPE
+    h->tape = JQ_NULL;
+    h->tape_cap = 0;
+    h->tape_size = 0;
+    h->tape_open = 0;
+    h->tape_on = JQ_FALSE;
+#endif
+    h->callback = JQ_NULL;
+    h->control = JQ_NULL;
+    h->udata = JQ_NULL;
+    h->error = JQ_ERR_OK;
+#ifdef JQ_WITH_STATS
+    jq_reset_stats(h);
+    h->stats_clock = JQ_NULL;
+    h->stats_start = 0;
+    h->stats_open = JQ_FALSE;
+#endif
+
+    return JQ_TRUE;
+}
+
+JQ_INLINE void
+jq_append_buf(struct jq_handler *h, jq_char *src, jq_size sz) {
+#ifdef JQ_WITH_NULLTERM
+    /* The substituted char belongs to the previous buffer which can be already */
+    /* freed or reused, so it is not restored there */
+    h->subst_char = '\0';
+#endif
+    /* The new buffer starts with the tail of the previous one */
+    if (h->buf) h->buf_offset += h->i;
+    h->buf = src;
+    h->buf_size = sz;
+    h->i = 0;
+#ifdef JQ_WITH_INDEX
+    jq_index_reset(h, 0);
+#endif
+
+    if (jq_get_error(h) == JQ_ERR_LEXER_NEED_MORE) {
+        jq_reset_error(h);
+    }
+}
+
+JQ_INLINE void
+jq_set_callback(struct jq_handler *h, jq_callback callback) {
+    h->callback = callback;
+}
+
+JQ_INLINE void
+jq_set_control_callback(struct jq_handler *h, jq_control_callback control) {
+    h->control = control;
+}
+
+JQ_INLINE void
+jq_set_multi(struct jq_handler *h, jq_bool multi) {
+    h->multi = multi;
+}
+
+JQ_INLINE void
+jq_set_readonly(struct jq_handler *h, jq_bool readonly) {
+    h->readonly = readonly;
+}
+
+JQ_INLINE void
+jq_set_input_end(struct jq_handler *h, jq_bool end) {
+    h->input_end = end;
+}
+
+JQ_INLINE void
+jq_append_const_buf(struct jq_handler *h, const jq_char *src, jq_size sz) {
+    /* The buffer is never written in the read-only mode */
+    h->readonly = JQ_TRUE;
+    jq_append_buf(h, (jq_char *)src, sz);
+}
+
+JQ_INLINE struct jq_view
+jq_get_view(const struct jq_handler *h) {
+    struct jq_view v;
+
+    v.ptr = h->val;
+    v.len = h->vlen;
+
+    return v;
+}
+
+JQ_API const char *
+jq_errstr(enum jq_error error) {
+    switch (error) {
+    case JQ_ERR_OK: return "Ok";
+    case JQ_ERR_LEXER_NEED_MORE: return "Unexpected end of file";
+    case JQ_ERR_LEXER_UNKNOWN_TOKEN: return "Syntax error";
+    case JQ_ERR_LEXER_UNKNOWN_ESCAPE_SYMBOL: return "Syntax error, unknown escape symbol";
+    case JQ_ERR_LEXER_UNKNOWN_HEX_SYMBOL: return "Syntax error, unknown hex symbol after '\\u' escape symbol";
+    case JQ_ERR_LEXER_EXPONENT_ERROR: return "Syntax error in exponent part";
+    case JQ_ERR_PARSER_UNEXPECTED_TOKEN: return "Unexpected token";
+    case JQ_ERR_LEXER_INVALID_UTF8: return "Invalid UTF-8 sequence in string";
+    case JQ_ERR_LEXER_CONTROL_CHAR: return "Unescaped control char in string";
+    case JQ_ERR_TAPE_FULL: return "Tape is full";
+    case JQ_ERR_STOPPED: return "Stopped by the callback";
+    case JQ_ERR_FILE: return "File can't be opened, mapped or read";
+    case JQ_ERR_BUFFER_FULL: return "Token is longer than the read buffer";
+    case JQ_ERR_WRITER_UNEXPECTED: return "Value doesn't fit the structure written";
+    case JQ_ERR_WRITER_FLUSH: return "Output can't be flushed";
+    case JQ_ERR_MAX_DEPTH: return "Objects and arrays are nested too deep";
+    default: return "Ok";
+    }
+}
+
+/* ==========================================================================
+ *
+ * Lexer
+ *
+ * ========================================================================== */
+
+/* Forward declarations */
+JQ_INLINE enum jq_token_type jq_finish_number(struct jq_handler *h);
+JQ_INLINE enum jq_token_type jq_finish_last_number(struct jq_handler *h);
+JQ_API enum jq_token_type jq_handle_lexer_error(struct jq_handler *h, jq_size start_pos, enum jq_error error);
+JQ_API enum jq_token_type jq_handle_lexer_need_more(struct jq_handler *h, jq_size start_pos, enum jq_lexer_state lexer_state, int nft_cnt);
+
+/* The lexer accumulates the number value with these macros */
+#ifdef JQ_WITH_NUMBERS
+  #define JQ_N_TRUNCATED                0x08 /* nonzero digits are dropped from the mantissa */
+  #define JQ_N_EXP_NEGATIVE             0x10 /* the exponent part has '-' sign */
+  #define jq_number_begin(h) ((h)->num_mantissa = 0, (h)->num_exp10 = 0, (h)->num_exp = 0, (h)->num_flags = JQ_N_INTEGRAL)
+  #define jq_number_set_flag(h, flag) ((h)->num_flags |= (flag))
+  #define jq_number_clear_flag(h, flag) ((h)->num_flags &= ~(flag))
+  #define jq_number_int_digit(h, c) jq_number_digit(h, c, JQ_TRUE)
+  #define jq_number_fraction_digit(h, c) jq_number_digit(h, c, JQ_FALSE)
+  JQ_INLINE void jq_number_digit(struct jq_handler *h, int c, jq_bool integer);
+  JQ_INLINE void jq_number_exp_digit(struct jq_handler *h, int c);
+#else
+  #define jq_number_begin(h) ((void)0)
+  #define jq_number_set_flag(h, flag) ((void)0)
+  #define jq_number_clear_flag(h, flag) ((void)0)
+  #define jq_number_int_digit(h, c) ((void)0)
+  #define jq_number_fraction_digit(h, c) ((void)0)
+  #define jq_number_exp_digit(h, c) ((void)0)
+#endif
+
+/* The lexer decodes escape sequences with these macros */
+#ifdef JQ_WITH_UNESCAPE
+  #ifdef JQ_WITH_LOCATION
+    #define jq_unescape_begin(h) ((h)->unesc_len = 0, (h)->unesc_src = 0, (h)->unesc_hi = 0, (h)->unesc_newline = JQ_FALSE)
+  #else
+    #define jq_unescape_begin(h) ((h)->unesc_len = 0, (h)->unesc_src = 0, (h)->unesc_hi = 0)
+  #endif
+  #define jq_unescape_hex_digit(h, c) ((h)->unesc_cp = (h)->unesc_cp << 4 | ((c) <= '9' ? (c) - '0' : ((c) | 0x20) - 'a' + 10))
+  JQ_INLINE void jq_unescape_move(struct jq_handler *h, jq_size end);
+  JQ_INLINE void jq_unescape_finish(struct jq_handler *h, jq_size end);
+  JQ_INLINE void jq_unescape_char(struct jq_handler *h, unsigned long cp, jq_size end);
+#else
+  #define jq_unescape_begin(h) ((void)0)
+  #define jq_unescape_hex_digit(h, c) ((void)0)
+  #define jq_unescape_move(h, end) ((void)0)
+  #define jq_unescape_char(h, cp, end) ((void)0)
+#endif
+
+/* The lexer counts the lines of the buffers it is done with by these functions */
+#ifdef JQ_WITH_LOCATION
+  JQ_INLINE void jq_location_advance(struct jq_handler *h, jq_size pos);
+  JQ_INLINE void jq_location_jump(struct jq_handler *h, jq_size begin, jq_size end);
+#else
+  #define jq_location_advance(h, pos) ((void)0)
+#endif
+
+/* Char classes of jq_char_class[] table */
+#define JQ_C_WC                         0x01 /* " \n\r\t" */
+#define JQ_C_ESC                        0x02 /* "\"\\/bfnrt" */
+#define JQ_C_NUM                        0x04 /* "-0123456789" */
+#define JQ_C_INT                        0x08 /* "123456789" */
+#define JQ_C_DIGIT                      0x10 /* "0123456789" */
+#define JQ_C_HEX                        0x20 /* "0123456789abcdefABCDEF" */
+#define JQ_C_EXP                        0x40 /* "Ee" */
+#define JQ_C_SIGN                       0x80 /* "+-" */
+
+static const unsigned char jq_char_class[256] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, /* 0x00 */
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* 0x10 */
+    0x01, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x00, 0x84, 0x00, 0x02, /* 0x20 */
+    0x34, 0x3c, 0x3c, 0x3c, 0x3c, 0x3c, 0x3c, 0x3c, 0x3c, 0x3c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* 0x30 */
+    0x00, 0x20, 0x20, 0x20, 0x20, 0x60, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* 0x40 */
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, /* 0x50 */
+    0x00, 0x20, 0x22, 0x20, 0x20, 0x60, 0x22, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, /* 0x60 */
+    0x00, 0x00, 0x02, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* 0x70 */
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* 0x80 */
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* 0x90 */
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* 0xa0 */
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* 0xb0 */
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* 0xc0 */
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* 0xd0 */
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* 0xe0 */
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00  /* 0xf0 */
+};
+
+/* These macros take a char or an int returned by jq_lexer_getchar() which is not JQ_T_NEED_MORE */
+#define jq_char_is(c, cls) (jq_char_class[(unsigned char)(c)] & (cls))
+#define jq_iswc(c) jq_char_is(c, JQ_C_WC)
+#define jq_isesc(c) jq_char_is(c, JQ_C_ESC)
+#define jq_isnum(c) jq_char_is(c, JQ_C_NUM)
+#define jq_isint(c) jq_char_is(c, JQ_C_INT)
+#define jq_isdigit(c) jq_char_is(c, JQ_C_DIGIT)
+#define jq_ishex(c) jq_char_is(c, JQ_C_HEX)
+#define jq_isexp(c) jq_char_is(c, JQ_C_EXP)
+#define jq_issign(c) jq_char_is(c, JQ_C_SIGN)
+
+/* The masks are built from jq_uint64, as there are no 64-bit constants in C89 */
+#define JQ_SWAR_ONES                    (~(jq_uint64)0 / 0xff)
+#define JQ_SWAR_HIGHS                   (JQ_SWAR_ONES << 7)
+
+JQ_INLINE int
+jq_ctz64(jq_uint64 x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#else
+    int n = 0;
+    if (!(x & 0xffffffffu)) { n += 32; x >>= 32; }
+    if (!(x & 0xffffu)) { n += 16; x >>= 16; }
+    if (!(x & 0xffu)) { n += 8; x >>= 8; }
+    if (!(x & 0xfu)) { n += 4; x >>= 4; }
+    if (!(x & 0x3u)) { n += 2; x >>= 2; }
+    if (!(x & 0x1u)) { n += 1; }
+    return n;
+#endif
+}
+
+/* Loads 8 chars, p[n] goes to byte n of the result on any endianness */
+JQ_INLINE jq_uint64
+jq_swar_load(const jq_char *p) {
+    const unsigned char *u = (const unsigned char *)p;
+    return (jq_uint64)u[0] | (jq_uint64)u[1] << 8 | (jq_uint64)u[2] << 16 | (jq_uint64)u[3] << 24
+        | (jq_uint64)u[4] << 32 | (jq_uint64)u[5] << 40 | (jq_uint64)u[6] << 48 | (jq_uint64)u[7] << 56;
+}
+
+/* Sets the high bit of every byte of v equal to c and clears the rest */
+JQ_INLINE jq_uint64
+jq_swar_eq(jq_uint64 v, unsigned char c) {
+    jq_uint64 t = v ^ (JQ_SWAR_ONES * c);
+    return ~(((t & ~JQ_SWAR_HIGHS) + ~JQ_SWAR_HIGHS) | t) & JQ_SWAR_HIGHS;
+}
+
+/* Returns position of the first '"' or '\\' in buf starting from i, or size if there is none */
+JQ_INLINE jq_size
+jq_scan_string(const jq_char *buf, jq_size i, jq_size size) {
+    for (; i + 8 <= size; i += 8) {
+        jq_uint64 v = jq_swar_load(buf + i);
+        jq_uint64 m = jq_swar_eq(v, '"') | jq_swar_eq(v, '\\');
+        if (m) return i + (jq_ctz64(m) >> 3);
+    }
+
+    while (i < size && buf[i] != '"' && buf[i] != '\\') ++i;
+    return i;
+}
+
+/* Returns position of the first non whitespace char in buf starting from i, or size if there is none */
+JQ_INLINE jq_size
+jq_skip_whitespace(const jq_char *buf, jq_size i, jq_size size) {
+    for (; i + 8 <= size; i += 8) {
+        jq_uint64 v = jq_swar_load(buf + i);
+        jq_uint64 m = ~(jq_swar_eq(v, ' ') | jq_swar_eq(v, '\n') | jq_swar_eq(v, '\r') | jq_swar_eq(v, '\t')) & JQ_SWAR_HIGHS;
+        if (m) return i + (jq_ctz64(m) >> 3);
+    }
+
+    while (i < size && jq_iswc(buf[i])) ++i;
+    return i;
+}
+
+/* Returns position of the first '"', '{', '}', '[' or ']' in buf starting from i, or size if there is none */
+JQ_INLINE jq_size
+jq_scan_brackets(const jq_char *buf, jq_size i, jq_size size) {
+    for (; i + 8 <= size; i += 8) {
+        jq_uint64 v = jq_swar_load(buf + i);
+        jq_uint64 l = v | JQ_SWAR_ONES * 0x20; /* '[' and ']' go to '{' and '}', nothing else does */
+        jq_uint64 m = jq_swar_eq(v, '"') | jq_swar_eq(l, '{') | jq_swar_eq(l, '}');
+        if (m) return i + (jq_ctz64(m) >> 3);
+    }
+
+    while (i < size && buf[i] != '"' && (buf[i] | 0x20) != '{' && (buf[i] | 0x20) != '}') ++i;
+    return i;
+}
+
+#ifdef JQ_WITH_UNESCAPE
+
+/* Returns the char of a one char escape sequence, c is the char after '\\' */
+#define jq_unescape_esc(c) ((c) == 'b' ? '\b' : (c) == 'f' ? '\f' : (c) == 'n' ? '\n' : (c) == 'r' ? '\r' : (c) == 't' ? '\t' : (c))
+
+/* Appends UTF-8 of cp to the decoded part of the string */
+JQ_INLINE void
+jq_unescape_put(struct jq_handler *h, unsigned long cp) {
+    jq_char *w = h->val + h->unesc_len;
+
+    if (cp < 0x80) {
+        w[0] = (jq_char)cp;
+        h->unesc_len += 1;
+    } else if (cp < 0x800) {
+        w[0] = (jq_char)(0xc0 | cp >> 6);
+        w[1] = (jq_char)(0x80 | (cp & 0x3f));
+        h->unesc_len += 2;
+    } else if (cp < 0x10000) {
+        w[0] = (jq_char)(0xe0 | cp >> 12);
+        w[1] = (jq_char)(0x80 | (cp >> 6 & 0x3f));
+        w[2] = (jq_char)(0x80 | (cp & 0x3f));
+        h->unesc_len += 3;
+    } else {
+        w[0] = (jq_char)(0xf0 | cp >> 18);
+        w[1] = (jq_char)(0x80 | (cp >> 12 & 0x3f));
+        w[2] = (jq_char)(0x80 | (cp >> 6 & 0x3f));
+        w[3] = (jq_char)(0x80 | (cp & 0x3f));
+        h->unesc_len += 4;
+    }
+}
+
+/*
+ * Moves the plain chars of the string before end to the decoded part. They are
+ * moved by runs, so nothing is copied until the first escape sequence is met.
+ * Offsets are relative to h->val, so they stay valid in the next buffer.
+ */
+JQ_INLINE void
+jq_unescape_move(struct jq_handler *h, jq_size end) {
+    jq_size n = end - (h->val - h->buf) - h->unesc_src;
+
+    if (h->readonly) return;
+
+    if (h->unesc_hi && n) {
+        /* The high surrogate is not followed by the low one */
+        jq_unescape_put(h, 0xfffd);
+        h->unesc_hi = 0;
+    }
+
+    if (h->unesc_len != h->unesc_src) {
+        jq_char *dst = h->val + h->unesc_len, *src = h->val + h->unesc_src, *src_end = src + n;
+        while (src != src_end) *dst++ = *src++;
+    }
+
+    h->unesc_len += n;
+    h->unesc_src += n;
+}
+
+/* Moves the rest of the string which ends at end */
+JQ_INLINE void
+jq_unescape_finish(struct jq_handler *h, jq_size end) {
+    jq_unescape_move(h, end);
+
+    if (h->unesc_hi) {
+        jq_unescape_put(h, 0xfffd);
+        h->unesc_hi = 0;
+    }
+#ifdef JQ_WITH_LOCATION
+    /* The '\n' decoded into the string are not line ends, so the lines are counted */
+    /* up to the string now and the string is jumped over, it is never scanned */
+    if (h->unesc_newline) jq_location_jump(h, h->val - 1 - h->buf, end + 1);
+#endif
+}
+
+/* Appends the char of an escape sequence ending at end */
+JQ_INLINE void
+jq_unescape_char(struct jq_handler *h, unsigned long cp, jq_size end) {
+    if (h->readonly) return;
+
+    if (h->unesc_hi) {
+        if (cp >= 0xdc00 && cp <= 0xdfff) {
+            cp = 0x10000 + ((h->unesc_hi - 0xd800) << 10) + (cp - 0xdc00);
+        } else {
+            jq_unescape_put(h, 0xfffd);
+        }
+        h->unesc_hi = 0;
+    }
+
+    if (cp >= 0xd800 && cp <= 0xdbff) {
+        h->unesc_hi = cp; /* it is written when the next char is known */
+    } else {
+#ifdef JQ_WITH_LOCATION
+        if (cp == '\n') h->unesc_newline = JQ_TRUE;
+#endif
+        jq_unescape_put(h, cp >= 0xdc00 && cp <= 0xdfff ? 0xfffd : cp);
+    }
+
+    h->unesc_src = end - (h->val - h->buf);
+}
+
+#else
+  #define jq_unescape_esc(c) (c)
+#endif /* JQ_WITH_UNESCAPE */
+
+#ifdef JQ_WITH_UTF8_CHECK
+
+/* UTF-8 byte classes of the automaton, see The Unicode Standard, Table 3-7 */
+static const unsigned char jq_utf8_class[256] = {
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 0x00 */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 0x10 */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 0x20 */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 0x30 */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 0x40 */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 0x50 */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 0x60 */
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, /* 0x70 */
+     1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1, /* 0x80 */
+     2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2, /* 0x90 */
+     3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3, /* 0xa0 */
+     3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3, /* 0xb0 */
+     4,  4,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5, /* 0xc0 */
+     5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5, /* 0xd0 */
+     6,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  8,  7,  7, /* 0xe0 */
+     9, 10, 10, 10, 11,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4  /* 0xf0 */
+};
+
+/*
+ * UTF-8 automaton transitions by state and byte class. The states are accept,
+ * reject, 1 or 2 more continuation bytes, the second byte of E0, ED, and 3 more
+ * continuation bytes after F1-F3, F0, F4
+ */
+static const unsigned char jq_utf8_next[9][12] = {
+    { 0, 1, 1, 1, 1, 2, 4, 3, 5, 7, 6, 8 },
+    { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 },
+    { 1, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1 },
+    { 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1 },
+    { 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 1 },
+    { 1, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1 },
+    { 1, 3, 3, 3, 1, 1, 1, 1, 1, 1, 1, 1 },
+    { 1, 1, 3, 3, 1, 1, 1, 1, 1, 1, 1, 1 },
+    { 1, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 }
+};
+
+#define jq_utf8_step(state, c) (jq_utf8_next[(unsigned char)(state)][jq_utf8_class[(unsigned char)(c)]])
+
+/* Returns position of the first '"', '\\', control or non ASCII char in buf starting from i, or size */
+JQ_INLINE jq_size
+jq_scan_ascii(const jq_char *buf, jq_size i, jq_size size) {
+#if defined(JQ_SIMD_AVX2)
+    for (; i + 32 <= size; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(buf + i));
+        /* Signed compare, the bytes from 0x80 are negative */
+        __m256i m = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+                _mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), v));
+        unsigned int bits = (unsigned int)_mm256_movemask_epi8(m);
+        if (bits) return i + jq_ctz64(bits);
+    }
+#elif defined(JQ_SIMD_SSE2)
+    for (; i + 16 <= size; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(buf + i));
+        /* Signed compare, the bytes from 0x80 are negative */
+        __m128i m = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+                _mm_cmplt_epi8(v, _mm_set1_epi8(0x20)));
+        unsigned int bits = (unsigned int)_mm_movemask_epi8(m);
+        if (bits) return i + jq_ctz64(bits);
+    }
+#endif
+    for (; i + 8 <= size; i += 8) {
+        jq_uint64 v = jq_swar_load(buf + i);
+        /* Bytes below 0x20 may give false positives above the first one only */
+        jq_uint64 m = jq_swar_eq(v, '"') | jq_swar_eq(v, '\\') | ((v - JQ_SWAR_ONES * 0x20) & ~v & JQ_SWAR_HIGHS) | (v & JQ_SWAR_HIGHS);
+        if (m) return i + (jq_ctz64(m) >> 3);
+    }
+
+    while (i < size && buf[i] != '"' && buf[i] != '\\' && (unsigned char)buf[i] >= 0x20 && (unsigned char)buf[i] < 0x80) ++i;
+    return i;
+}
+
+/*
+ * Returns position of the first '"', '\\' or control char in buf starting from i,
+ * or size, validating UTF-8 of the chars before it. The automaton state is kept
+ * in h->utf8_state, it is JQ_UTF8_REJECT if an invalid sequence is found.
+ */
+JQ_INLINE jq_size
+jq_scan_string_utf8(struct jq_handler *h, jq_size i, jq_size size) {
+    const jq_char *buf = h->buf;
+    unsigned char state = h->utf8_state;
+
+    for (;;) {
+        if (state == JQ_UTF8_ACCEPT) {
+            i = jq_scan_ascii(buf, i, size);
+            if (i == size || (unsigned char)buf[i] < 0x80) break;
+        } else if (i == size || (unsigned char)buf[i] < 0x20) {
+            break; /* a control char is reported before the cut sequence, as jq_get_token() does */
+        }
+
+        state = jq_utf8_step(state, buf[i]);
+        if (state == JQ_UTF8_REJECT) break;
+        ++i;
+    }
+
+    h->utf8_state = state;
+    return i;
+}
+
+#endif /* JQ_WITH_UTF8_CHECK */
+
+JQ_API int
+jq_lexer_getchar(struct jq_handler *h) {
+    if (h->i < h->buf_size) {
+#ifdef JQ_WITH_NULLTERM
+        /* Restoring previously saved char */
+        if (h->subst_char) {
+            h->buf[h->subst_pos] = h->subst_char;
+            h->subst_char = '\0';
+        }
+#endif
+
+        return h->buf[h->i++];
+    } else {
+        return JQ_T_NEED_MORE;
+    }
+}
+
+JQ_API void
+jq_lexer_unget(struct jq_handler *h) {
+/*
+ * h->i can be 0 at the beginning of the buf! So this function should be called after a successive call of jq_getchar(jq_handler *h) only,
+ * i.e. jq_getchar(jq_handler *h) should not have returned JQ_T_NEED_MORE!
+*/
+    JQ_PROFILE(h, JQ_PROFILE_UNGET, 0);
+    --h->i;
+}
+
+/* Puts back the char substituted with '\0' after the latest value */
+JQ_INLINE void
+jq_lexer_restore(struct jq_handler *h) {
+#ifdef JQ_WITH_NULLTERM
+    if (h->subst_char) {
+        h->buf[h->subst_pos] = h->subst_char;
+        h->subst_char = '\0';
+    }
+#else
+    (void)h;
+#endif
+}
+
+/* Puts '\0' at pos after the latest value, jq_lexer_restore() puts the char back */
+JQ_INLINE void
+jq_lexer_terminate(struct jq_handler *h, jq_size pos) {
+#ifdef JQ_WITH_NULLTERM
+    if (h->readonly) return;
+    h->subst_pos = pos;
+    h->subst_char = h->buf[pos];
+    h->buf[pos] = '\0';
+#else
+    (void)h;
+    (void)pos;
+#endif
+}
+
+/* Moves to pos, the chars before are not lexed */
+JQ_INLINE void
+jq_lexer_skip(struct jq_handler *h, jq_size pos) {
+    h->i = pos;
+}
+
+JQ_API enum jq_token_type
+jq_get_token(struct jq_handler *h) {
+    static const char Null[] = "null";
+    static const char True[] = "true";
+    static const char False[] = "false";
+
+    int nft_cnt = h->nft_cnt; /* current symbol inside null, true, false or unicode (\uxxxx) */
+    enum jq_lexer_state lexer_state = (enum jq_lexer_state)h->lexer_state;
+    jq_size start_pos = h->i; /* start position of the token */
+
+    if (lexer_state != JQ_L_NORMAL) {
+        /* The token was interrupted by the end of the previous buffer and this one */
+        /* starts with its tail, so the part scanned before is skipped, not lexed again */
+        h->i += h->lexed;
+        if (lexer_state <= JQ_L_UNICODE) {
+            h->val = &h->buf[start_pos + 1]; /* the string value follows '"' */
+        } else {
+            h->val = &h->buf[start_pos];
+        }
+        h->lexer_state = JQ_L_NORMAL;
+        h->lexed = 0;
+    }
+
+    for (;;) {
+        int c;
+
+        JQ_PROFILE(h, JQ_PROFILE_LEXER, lexer_state);
+        c = jq_lexer_getchar(h);
+        if (c == JQ_T_NEED_MORE) {
+            /* The end of the input finishes a number, as the char after it would */
+            if (h->input_end && (lexer_state == JQ_L_NUM_POINT || lexer_state == JQ_L_NUM_INT0_9
+                    || lexer_state == JQ_L_NUM_FRACTION || lexer_state == JQ_L_NUM_EXPO_INT)) {
+                return jq_finish_last_number(h);
+            }
+            return jq_handle_lexer_need_more(h, start_pos, lexer_state, nft_cnt);
+        }
+
+        switch (lexer_state) {
+        case JQ_L_STRING:
+#ifdef JQ_WITH_UTF8_CHECK
+            if ((unsigned char)c < 0x20) {
+                return jq_handle_lexer_error(h, start_pos, JQ_ERR_LEXER_CONTROL_CHAR);
+            }
+            if ((unsigned char)c >= 0x80 || h->utf8_state != JQ_UTF8_ACCEPT) {
+                h->utf8_state = jq_utf8_step(h->utf8_state, c);
+                if (h->utf8_state == JQ_UTF8_REJECT) {
+                    return jq_handle_lexer_error(h, start_pos, JQ_ERR_LEXER_INVALID_UTF8);
+                }
+            }
+#endif
+            switch (c) {
+            case '"':
+#ifdef JQ_WITH_UNESCAPE
+                jq_unescape_finish(h, h->i - 1);
+                h->vlen = h->readonly ? h->i - 1 - (h->val - h->buf) : h->unesc_len;
+                jq_lexer_terminate(h, h->val + h->unesc_len - h->buf);
+#else
+                h->vlen = h->i - 1 - (h->val - h->buf);
+                jq_lexer_terminate(h, h->i - 1);
+#endif
+
+                return JQ_T_STRING;
+
+            case '\\':
+                jq_unescape_move(h, h->i - 1);
+                lexer_state = JQ_L_ESCAPE;
+                continue;
+            }
+#ifdef JQ_WITH_UTF8_CHECK
+            /* Jumping over the valid chars to the next '"', '\\' or control char */
+            h->i = jq_scan_string_utf8(h, h->i, h->buf_size);
+            if (h->utf8_state == JQ_UTF8_REJECT) {
+                return jq_handle_lexer_error(h, start_pos, JQ_ERR_LEXER_INVALID_UTF8);
+            }
+#else
+            /* Jumping over the plain chars to the next '"' or '\\' */
+            h->i = jq_scan_string(h->buf, h->i, h->buf_size);
+#endif
+            break;
+
+        case JQ_L_ESCAPE:
+            if (c == 'u') {
+                nft_cnt = 0;
+#ifdef JQ_WITH_UNESCAPE
+                h->unesc_cp = 0;
+#endif
+                lexer_state = JQ_L_UNICODE;
+            } else if (jq_isesc(c)) {
+                jq_unescape_char(h, jq_unescape_esc(c), h->i);
+                lexer_state = JQ_L_STRING;
+            } else {
+                return jq_handle_lexer_error(h, start_pos, JQ_ERR_LEXER_UNKNOWN_ESCAPE_SYMBOL);
+            }
+            break;
+
+        case JQ_L_UNICODE:
+            if (nft_cnt++ < 4) {
+                if (!jq_ishex(c)) {
+                    return jq_handle_lexer_error(h, start_pos, JQ_ERR_LEXER_UNKNOWN_ESCAPE_SYMBOL);
+                }
+                jq_unescape_hex_digit(h, c);
+            } else {
+                jq_lexer_unget(h);
+                jq_unescape_char(h, h->unesc_cp, h->i);
+                lexer_state = JQ_L_STRING;
+            }
+            break;
+
+        case JQ_L_NULL:
+            if (Null[nft_cnt]) {
+                if (c == Null[nft_cnt]) {
+                    ++nft_cnt;
+                    continue;
+                } else {
+                    return jq_handle_lexer_error(h, start_pos, JQ_ERR_LEXER_UNKNOWN_TOKEN);
+                }
+            } else {
+                jq_lexer_unget(h);
+                h->val = &h->buf[start_pos];
+                h->vlen = sizeof(Null) - 1;
+                return JQ_T_NULL;
+            }
+            break;
+
+        case JQ_L_TRUE:
+            if (True[nft_cnt]) {
+                if (c == True[nft_cnt]) {
+                    ++nft_cnt;
+                    continue;
+                } else {
+                    return jq_handle_lexer_error(h, start_pos, JQ_ERR_LEXER_UNKNOWN_TOKEN);
+                }
+            } else {
+                jq_lexer_unget(h);
+                h->val = &h->buf[start_pos];
+                h->vlen = sizeof(True) - 1;
+                return JQ_T_TRUE;
+            }
+            break;
+
+        case JQ_L_FALSE:
+            if (False[nft_cnt]) {
+                if (c == False[nft_cnt]) {
+                    ++nft_cnt;
+                    continue;
+                } else {
+                    return jq_handle_lexer_error(h, start_pos, JQ_ERR_LEXER_UNKNOWN_TOKEN);
+                }
+            } else {
+                jq_lexer_unget(h);
+                h->val = &h->buf[start_pos];
+                h->vlen = sizeof(False) - 1;
+                return JQ_T_FALSE;
+            }
+            break;
+
+        case JQ_L_NORMAL:
+            if (jq_iswc(c)) {
+                /* Skipping indentation and other whitespace runs in bulk */
+                if (h->i < h->buf_size && jq_iswc(h->buf[h->i])) {
+                    h->i = jq_skip_whitespace(h->buf, h->i + 1, h->buf_size);
+                }
+                continue;
+            }
+            start_pos = h->i - 1; /* the tail should not include whitespace before the token */
+            if (jq_isnum(c)) {
+                jq_lexer_unget(h);
+                lexer_state = JQ_L_NUM_BEGIN;
+                continue;
+            }
+
+            switch (c) {
+            case '"':
+                h->val = &h->buf[h->i];
+                jq_unescape_begin(h);
+#ifdef JQ_WITH_UTF8_CHECK
+                h->utf8_state = JQ_UTF8_ACCEPT;
+#endif
+                lexer_state = JQ_L_STRING;
+                continue;
+
+            case '{': case '}': case '[': case ']': case ':': case ',':
+                return (enum jq_token_type)c;
+
+            case 'n':
+                nft_cnt = 1;
+                lexer_state = JQ_L_NULL;
+                continue;
+
+            case 't':
+                nft_cnt = 1;
+                lexer_state = JQ_L_TRUE;
+                continue;
+
+            case 'f':
+                nft_cnt = 1;
+                lexer_state = JQ_L_FALSE;
+                continue;
+
+            default:
+                return jq_handle_lexer_error(h, start_pos, JQ_ERR_LEXER_UNKNOWN_TOKEN);
+            }
+            break;
+
+        case JQ_L_NUM_BEGIN:
+                h->val = &h->buf[h->i - 1];
+                jq_number_begin(h);
+
+                switch (c) {
+                case '-':   jq_number_set_flag(h, JQ_N_NEGATIVE); lexer_state = JQ_L_NUM_INT1_9; break;
+                case '0':   lexer_state = JQ_L_NUM_POINT; break;
+                default:    jq_lexer_unget(h); lexer_state = JQ_L_NUM_INT1_9; break;
+                }
+            continue;
+
+        case JQ_L_NUM_POINT:
+            if (c == '.') {
+                lexer_state = JQ_L_NUM_FRACTION1;
+            } else if (jq_isexp(c)) {
+                lexer_state = JQ_L_NUM_EXPO_PLUS_MINUS;
+            } else {
+                return jq_finish_number(h);
+            }
+            continue;
+
+        case JQ_L_NUM_INT0_9:
+            if (jq_isdigit(c)) {
+                jq_number_int_digit(h, c);
+            } else if (c == '.') {
+                lexer_state = JQ_L_NUM_FRACTION1;
+            } else if (jq_isexp(c)) {
+                lexer_state = JQ_L_NUM_EXPO_PLUS_MINUS;
+            } else {
+                return jq_finish_number(h);
+            }
+            continue;
+
+        case JQ_L_NUM_INT1_9:
+            if (jq_isint(c)) {
+                jq_number_int_digit(h, c);
+                lexer_state = JQ_L_NUM_INT0_9;
+            } else if (c == '0') {
+                lexer_state = JQ_L_NUM_POINT;
+            } else {
+                /* Nothing found after '-' */
+                return jq_handle_lexer_error(h, start_pos, JQ_ERR_LEXER_UNKNOWN_TOKEN);
+            }
+            continue;
+
+        case JQ_L_NUM_FRACTION1:
+            if (jq_isdigit(c)) {
+                jq_number_fraction_digit(h, c);
+                lexer_state = JQ_L_NUM_FRACTION;
+            } else {
+                /* Nothing found after '.' */
+                return jq_handle_lexer_error(h, start_pos, JQ_ERR_LEXER_UNKNOWN_TOKEN);
+            }
+            continue;
+
+        case JQ_L_NUM_FRACTION:
+            if (jq_isdigit(c)) {
+                jq_number_fraction_digit(h, c);
+            } else if (jq_isexp(c)) {
+                lexer_state = JQ_L_NUM_EXPO_PLUS_MINUS;
+            } else {
+                return jq_finish_number(h);
+            }
+            continue;
+
+        case JQ_L_NUM_EXPO_PLUS_MINUS:
+            jq_number_clear_flag(h, JQ_N_INTEGRAL);
+            if (jq_issign(c)) {
+                if (c == '-') jq_number_set_flag(h, JQ_N_EXP_NEGATIVE);
+                lexer_state = JQ_L_NUM_EXPO_INT1;
+            } else if (jq_isdigit(c)) {
+                jq_number_exp_digit(h, c);
+                lexer_state = JQ_L_NUM_EXPO_INT;
+            } else {
+                /* Nothing found after exponent E(e) */
+                return jq_handle_lexer_error(h, start_pos, JQ_ERR_LEXER_EXPONENT_ERROR);
+            }
+            continue;
+
+        case JQ_L_NUM_EXPO_INT1:
+            if (!jq_isdigit(c)) {
+                /* Nothing found after exponent E(e)+- */
+                return jq_handle_lexer_error(h, start_pos, JQ_ERR_LEXER_EXPONENT_ERROR);
+            } else {
+                jq_number_exp_digit(h, c);
+                lexer_state = JQ_L_NUM_EXPO_INT;
+            }
+            continue;
+
+        case JQ_L_NUM_EXPO_INT:
+            if (jq_isdigit(c)) {
+                jq_number_exp_digit(h, c);
+            } else {
+                return jq_finish_number(h);
+            }
+            continue;
+        }
+    }
+}
+
+/* The number ends at the end of the input, there is no char after it to be put back or replaced with '\0' */
+JQ_INLINE enum jq_token_type
+jq_finish_last_number(struct jq_handler *h) {
+    h->vlen = h->i - (h->val - h->buf);
+#ifdef JQ_WITH_NUMBERS
+    h->num_len = h->i - (h->val - h->buf);
+    if ((h->num_flags & JQ_N_NEGATIVE) && h->num_mantissa > 0x8000000000000000ull) {
+        h->num_flags |= JQ_N_OVERFLOW;
+    }
+#endif
+
+    return JQ_T_NUMBER;
+}
+
+JQ_INLINE enum jq_token_type
+jq_finish_number(struct jq_handler *h) {
+    jq_lexer_unget(h);
+    jq_finish_last_number(h);
+    jq_lexer_terminate(h, h->i);
+
+    return JQ_T_NUMBER;
+}
+
+JQ_API enum jq_token_type
+jq_handle_lexer_need_more(struct jq_handler *h, jq_size start_pos, enum jq_lexer_state lexer_state, int nft_cnt) {
+    if (lexer_state == JQ_L_NORMAL) {
+        start_pos = h->i; /* only whitespace was read, nothing to keep */
+    }
+#ifdef JQ_WITH_STATS
+    ++h->stats.need_more;
+    if (h->buf_size > start_pos) {
+        ++h->stats.rewinds;
+        h->stats.tail_bytes += h->buf_size - start_pos;
+    }
+#endif
+
+    /* The lexer state is saved and the tail starts at the beginning of the token, */
+    /* the next buffer must start with this tail. h->i is moved back without */
+    /* jq_lexer_unget() as these bytes are not going to be read again */
+    h->lexer_state = lexer_state;
+    h->nft_cnt = nft_cnt;
+    h->lexed = h->i - start_pos;
+    h->i = start_pos;
+    jq_location_advance(h, h->i);
+    jq_set_error(h, JQ_ERR_LEXER_NEED_MORE);
+    return JQ_T_NEED_MORE;
+}
+
+JQ_API enum jq_token_type
+jq_handle_lexer_error(struct jq_handler *h, jq_size start_pos, enum jq_error error) {
+    jq_size n = h->i - start_pos;
+    while (n--) jq_lexer_unget(h);
+    jq_set_error(h, error);
+    return JQ_T_ERROR;
+}
+
+/* ==========================================================================
+ *
+ * Numbers
+ *
+ * ========================================================================== */
+
+#ifdef JQ_WITH_NUMBERS
+
+#define JQ_UINT64_MAX                   0xffffffffffffffffull
+#define JQ_BIGINT_LIMBS                 128 /* 4096 bits are enough to compare any double */
+#define JQ_MAX_DIGITS                   768 /* more digits can't affect rounding of a double */
+
+JQ_INLINE void
+jq_number_digit(struct jq_handler *h, int c, jq_bool integer) {
+    int d = c - '0';
+
+    if (h->num_mantissa < JQ_UINT64_MAX / 10 || (h->num_mantissa == JQ_UINT64_MAX / 10 && d <= (int)(JQ_UINT64_MAX % 10))) {
+        h->num_mantissa = h->num_mantissa * 10 + d;
+        if (!integer) {
+            --h->num_exp10;
+        }
+    } else {
+        /* The mantissa is full, the rest of the digits are only counted */
+        if (d) h->num_flags |= JQ_N_TRUNCATED;
+        if (integer) {
+            ++h->num_exp10;
+            h->num_flags |= JQ_N_OVERFLOW;
+        }
+    }
+
+    if (!integer) h->num_flags &= ~JQ_N_INTEGRAL;
+}
+
+JQ_INLINE void
+jq_number_exp_digit(struct jq_handler *h, int c) {
+    /* The exponent is limited as anything bigger gives zero or infinity anyway */
+    if (h->num_exp < 100000000) {
+        h->num_exp = h->num_exp * 10 + c - '0';
+    }
+}
+
+JQ_API jq_bool
+jq_get_int64(struct jq_handler *h, jq_int64 *v) {
+    if ((h->num_flags & (JQ_N_INTEGRAL | JQ_N_OVERFLOW)) != JQ_N_INTEGRAL) return JQ_FALSE;
+
+    if (h->num_flags & JQ_N_NEGATIVE) {
+        /* -2^63 is not representable as a positive jq_int64 */
+        *v = h->num_mantissa ? -(jq_int64)(h->num_mantissa - 1) - 1 : 0;
+    } else {
+        if (h->num_mantissa > 0x7fffffffffffffffull) return JQ_FALSE;
+        *v = (jq_int64)h->num_mantissa;
+    }
+
+    return JQ_TRUE;
+}
+
+JQ_API jq_bool
+jq_get_uint64(struct jq_handler *h, jq_uint64 *v) {
+    if ((h->num_flags & (JQ_N_INTEGRAL | JQ_N_OVERFLOW)) != JQ_N_INTEGRAL) return JQ_FALSE;
+    if ((h->num_flags & JQ_N_NEGATIVE) && h->num_mantissa) return JQ_FALSE;
+
+    *v = h->num_mantissa;
+
+    return JQ_TRUE;
+}
+
+#endif /* JQ_WITH_NUMBERS */
+
+#if defined(JQ_WITH_NUMBERS) || defined(JQ_WITH_WRITER)
+
+/*
+ * Truncated 128 bit powers of five normalized to have the highest bit set, 5^-342 to 5^324.
+ * 5^-27 to 5^-1 are rounded up, 5^0 to 5^55 are exact. The parser takes 5^-342 to 5^308,
+ * the writer takes 5^-292 to 5^324.
+ */
+static const jq_uint64 jq_pow5_128[][2] = {
+    { 0xeef453d6923bd65aull, 0x113faa2906a13b3full }, /* 5^-342 */
+    { 0x9558b4661b6565f8ull, 0x4ac7ca59a424c507ull }, /* 5^-341 */
+    { 0xbaaee17fa23ebf76ull, 0x5d79bcf00d2df649ull }, /* 5^-340 */
+    { 0xe95a99df8ace6f53ull, 0xf4d82c2c107973dcull }, /* 5^-339 */
+    { 0x91d8a02bb6c10594ull, 0x79071b9b8a4be869ull }, /* 5^-338 */
+    { 0xb64ec836a47146f9ull, 0x9748e2826cdee284ull }, /* 5^-337 */
+    { 0xe3e27a444d8d98b7ull, 0xfd1b1b2308169b25ull }, /* 5^-336 */
+    { 0x8e6d8c6ab0787f72ull, 0xfe30f0f5e50e20f7ull }, /* 5^-335 */
+    { 0xb208ef855c969f4full, 0xbdbd2d335e51a935ull }, /* 5^-334 */
+    { 0xde8b2b66b3bc4723ull, 0xad2c788035e61382ull }, /* 5^-333 */
+    { 0x8b16fb203055ac76ull, 0x4c3bcb5021afcc31ull }, /* 5^-332 */
+    { 0xaddcb9e83c6b1793ull, 0xdf4abe242a1bbf3dull }, /* 5^-331 */
+    { 0xd953e8624b85dd78ull, 0xd71d6dad34a2af0dull }, /* 5^-330 */
+    { 0x87d4713d6f33aa6bull, 0x8672648c40e5ad68ull }, /* 5^-329 */
+    { 0xa9c98d8ccb009506ull, 0x680efdaf511f18c2ull }, /* 5^-328 */
+    { 0xd43bf0effdc0ba48ull, 0x0212bd1b2566def2ull }, /* 5^-327 */
+    { 0x84a57695fe98746dull, 0x014bb630f7604b57ull }, /* 5^-326 */
+    { 0xa5ced43b7e3e9188ull, 0x419ea3bd35385e2dull }, /* 5^-325 */
+    { 0xcf42894a5dce35eaull, 0x52064cac828675b9ull }, /* 5^-324 */
+    { 0x818995ce7aa0e1b2ull, 0x7343efebd1940993ull }, /* 5^-323 */
+    { 0xa1ebfb4219491a1full, 0x1014ebe6c5f90bf8ull }, /* 5^-322 */
+    { 0xca66fa129f9b60a6ull, 0xd41a26e077774ef6ull }, /* 5^-321 */
+    { 0xfd00b897478238d0ull, 0x8920b098955522b4ull }, /* 5^-320 */
+    { 0x9e20735e8cb16382ull, 0x55b46e5f5d5535b0ull }, /* 5^-319 */
+    { 0xc5a890362fddbc62ull, 0xeb2189f734aa831dull }, /* 5^-318 */
+    { 0xf712b443bbd52b7bull, 0xa5e9ec7501d523e4ull }, /* 5^-317 */
+    { 0x9a6bb0aa55653b2dull, 0x47b233c92125366eull }, /* 5^-316 */
+    { 0xc1069cd4eabe89f8ull, 0x999ec0bb696e840aull }, /* 5^-315 */
+    { 0xf148440a256e2c76ull, 0xc00670ea43ca250dull }, /* 5^-314 */
+    { 0x96cd2a865764dbcaull, 0x380406926a5e5728ull }, /* 5^-313 */
+    { 0xbc807527ed3e12bcull, 0xc605083704f5ecf2ull }, /* 5^-312 */
+    { 0xeba09271e88d976bull, 0xf7864a44c633682eull }, /* 5^-311 */
+    { 0x93445b8731587ea3ull, 0x7ab3ee6afbe0211dull }, /* 5^-310 */
+    { 0xb8157268fdae9e4cull, 0x5960ea05bad82964ull }, /* 5^-309 */
+    { 0xe61acf033d1a45dfull, 0x6fb92487298e33bdull }, /* 5^-308 */
+    { 0x8fd0c16206306babull, 0xa5d3b6d479f8e056ull }, /* 5^-307 */
+    { 0xb3c4f1ba87bc8696ull, 0x8f48a4899877186cull }, /* 5^-306 */
+    { 0xe0b62e2929aba83cull, 0x331acdabfe94de87ull }, /* 5^-305 */
+    { 0x8c71dcd9ba0b4925ull, 0x9ff0c08b7f1d0b14ull }, /* 5^-304 */
+    { 0xaf8e5410288e1b6full, 0x07ecf0ae5ee44dd9ull }, /* 5^-303 */
+    { 0xdb71e91432b1a24aull, 0xc9e82cd9f69d6150ull }, /* 5^-302 */
+    { 0x892731ac9faf056eull, 0xbe311c083a225cd2ull }, /* 5^-301 */
+    { 0xab70fe17c79ac6caull, 0x6dbd630a48aaf406ull }, /* 5^-300 */
+    { 0xd64d3d9db981787dull, 0x092cbbccdad5b108ull }, /* 5^-299 */
+    { 0x85f0468293f0eb4eull, 0x25bbf56008c58ea5ull }, /* 5^-298 */
+    { 0xa76c582338ed2621ull, 0xaf2af2b80af6f24eull }, /* 5^-297 */
+    { 0xd1476e2c07286faaull, 0x1af5af660db4aee1ull }, /* 5^-296 */
+    { 0x82cca4db847945caull, 0x50d98d9fc890ed4dull }, /* 5^-295 */
+    { 0xa37fce126597973cull, 0xe50ff107bab528a0ull }, /* 5^-294 */
+    { 0xcc5fc196fefd7d0cull, 0x1e53ed49a96272c8ull }, /* 5^-293 */
+    { 0xff77b1fcbebcdc4full, 0x25e8e89c13bb0f7aull }, /* 5^-292 */
+    { 0x9faacf3df73609b1ull, 0x77b191618c54e9acull }, /* 5^-291 */
+    { 0xc795830d75038c1dull, 0xd59df5b9ef6a2417ull }, /* 5^-290 */
+    { 0xf97ae3d0d2446f25ull, 0x4b0573286b44ad1dull }, /* 5^-289 */
+    { 0x9becce62836ac577ull, 0x4ee367f9430aec32ull }, /* 5^-288 */
+    { 0xc2e801fb244576d5ull, 0x229c41f793cda73full }, /* 5^-287 */
+    { 0xf3a20279ed56d48aull, 0x6b43527578c1110full }, /* 5^-286 */
+    { 0x9845418c345644d6ull, 0x830a13896b78aaa9ull }, /* 5^-285 */
+    { 0xbe5691ef416bd60cull, 0x23cc986bc656d553ull }, /* 5^-284 */
+    { 0xedec366b11c6cb8full, 0x2cbfbe86b7ec8aa8ull }, /* 5^-283 */
+    { 0x94b3a202eb1c3f39ull, 0x7bf7d71432f3d6a9ull }, /* 5^-282 */
+    { 0xb9e08a83a5e34f07ull, 0xdaf5ccd93fb0cc53ull }, /* 5^-281 */
+    { 0xe858ad248f5c22c9ull, 0xd1b3400f8f9cff68ull }, /* 5^-280 */
+    { 0x91376c36d99995beull, 0x23100809b9c21fa1ull }, /* 5^-279 */
+    { 0xb58547448ffffb2dull, 0xabd40a0c2832a78aull }, /* 5^-278 */
+    { 0xe2e69915b3fff9f9ull, 0x16c90c8f323f516cull }, /* 5^-277 */
+    { 0x8dd01fad907ffc3bull, 0xae3da7d97f6792e3ull }, /* 5^-276 */
+    { 0xb1442798f49ffb4aull, 0x99cd11cfdf41779cull }, /* 5^-275 */
+    { 0xdd95317f31c7fa1dull, 0x40405643d711d583ull }, /* 5^-274 */
+    { 0x8a7d3eef7f1cfc52ull, 0x482835ea666b2572ull }, /* 5^-273 */
+    { 0xad1c8eab5ee43b66ull, 0xda3243650005eecfull }, /* 5^-272 */
+    { 0xd863b256369d4a40ull, 0x90bed43e40076a82ull }, /* 5^-271 */
+    { 0x873e4f75e2224e68ull, 0x5a7744a6e804a291ull }, /* 5^-270 */
+    { 0xa90de3535aaae202ull, 0x711515d0a205cb36ull }, /* 5^-269 */
+    { 0xd3515c2831559a83ull, 0x0d5a5b44ca873e03ull }, /* 5^-268 */
+    { 0x8412d9991ed58091ull, 0xe858790afe9486c2ull }, /* 5^-267 */
+    { 0xa5178fff668ae0b6ull, 0x626e974dbe39a872ull }, /* 5^-266 */
+    { 0xce5d73ff402d98e3ull, 0xfb0a3d212dc8128full }, /* 5^-265 */
+    { 0x80fa687f881c7f8eull, 0x7ce66634bc9d0b99ull }, /* 5^-264 */
+    { 0xa139029f6a239f72ull, 0x1c1fffc1ebc44e80ull }, /* 5^-263 */
+    { 0xc987434744ac874eull, 0xa327ffb266b56220ull }, /* 5^-262 */
+    { 0xfbe9141915d7a922ull, 0x4bf1ff9f0062baa8ull }, /* 5^-261 */
+    { 0x9d71ac8fada6c9b5ull, 0x6f773fc3603db4a9ull }, /* 5^-260 */
+    { 0xc4ce17b399107c22ull, 0xcb550fb4384d21d3ull }, /* 5^-259 */
+    { 0xf6019da07f549b2bull, 0x7e2a53a146606a48ull }, /* 5^-258 */
+    { 0x99c102844f94e0fbull, 0x2eda7444cbfc426dull }, /* 5^-257 */
+    { 0xc0314325637a1939ull, 0xfa911155fefb5308ull }, /* 5^-256 */
+    { 0xf03d93eebc589f88ull, 0x793555ab7eba27caull }, /* 5^-255 */
+    { 0x96267c7535b763b5ull, 0x4bc1558b2f3458deull }, /* 5^-254 */
+    { 0xbbb01b9283253ca2ull, 0x9eb1aaedfb016f16ull }, /* 5^-253 */
+    { 0xea9c227723ee8bcbull, 0x465e15a979c1cadcull }, /* 5^-252 */
+    { 0x92a1958a7675175full, 0x0bfacd89ec191ec9ull }, /* 5^-251 */
+    { 0xb749faed14125d36ull, 0xcef980ec671f667bull }, /* 5^-250 */
+    { 0xe51c79a85916f484ull, 0x82b7e12780e7401aull }, /* 5^-249 */
+    { 0x8f31cc0937ae58d2ull, 0xd1b2ecb8b0908810ull }, /* 5^-248 */
+    { 0xb2fe3f0b8599ef07ull, 0x861fa7e6dcb4aa15ull }, /* 5^-247 */
+    { 0xdfbdcece67006ac9ull, 0x67a791e093e1d49aull }, /* 5^-246 */
+    { 0x8bd6a141006042bdull, 0xe0c8bb2c5c6d24e0ull }, /* 5^-245 */
+    { 0xaecc49914078536dull, 0x58fae9f773886e18ull }, /* 5^-244 */
+    { 0xda7f5bf590966848ull, 0xaf39a475506a899eull }, /* 5^-243 */
+    { 0x888f99797a5e012dull, 0x6d8406c952429603ull }, /* 5^-242 */
+    { 0xaab37fd7d8f58178ull, 0xc8e5087ba6d33b83ull }, /* 5^-241 */
+    { 0xd5605fcdcf32e1d6ull, 0xfb1e4a9a90880a64ull }, /* 5^-240 */
+    { 0x855c3be0a17fcd26ull, 0x5cf2eea09a55067full }, /* 5^-239 */
+    { 0xa6b34ad8c9dfc06full, 0xf42faa48c0ea481eull }, /* 5^-238 */
+    { 0xd0601d8efc57b08bull, 0xf13b94daf124da26ull }, /* 5^-237 */
+    { 0x823c12795db6ce57ull, 0x76c53d08d6b70858ull }, /* 5^-236 */
+    { 0xa2cb1717b52481edull, 0x54768c4b0c64ca6eull }, /* 5^-235 */
+    { 0xcb7ddcdda26da268ull, 0xa9942f5dcf7dfd09ull }, /* 5^-234 */
+    { 0xfe5d54150b090b02ull, 0xd3f93b35435d7c4cull }, /* 5^-233 */
+    { 0x9efa548d26e5a6e1ull, 0xc47bc5014a1a6dafull }, /* 5^-232 */
+    { 0xc6b8e9b0709f109aull, 0x359ab6419ca1091bull }, /* 5^-231 */
+    { 0xf867241c8cc6d4c0ull, 0xc30163d203c94b62ull }, /* 5^-230 */
+    { 0x9b407691d7fc44f8ull, 0x79e0de63425dcf1dull }, /* 5^-229 */
+    { 0xc21094364dfb5636ull, 0x985915fc12f542e4ull }, /* 5^-228 */
+    { 0xf294b943e17a2bc4ull, 0x3e6f5b7b17b2939dull }, /* 5^-227 */
+    { 0x979cf3ca6cec5b5aull, 0xa705992ceecf9c42ull }, /* 5^-226 */
+    { 0xbd8430bd08277231ull, 0x50c6ff782a838353ull }, /* 5^-225 */
+    { 0xece53cec4a314ebdull, 0xa4f8bf5635246428ull }, /* 5^-224 */
+    { 0x940f4613ae5ed136ull, 0x871b7795e136be99ull }, /* 5^-223 */
+    { 0xb913179899f68584ull, 0x28e2557b59846e3full }, /* 5^-222 */
+    { 0xe757dd7ec07426e5ull, 0x331aeada2fe589cfull }, /* 5^-221 */
+    { 0x9096ea6f3848984full, 0x3ff0d2c85def7621ull }, /* 5^-220 */
+    { 0xb4bca50b065abe63ull, 0x0fed077a756b53a9ull }, /* 5^-219 */
+    { 0xe1ebce4dc7f16dfbull, 0xd3e8495912c62894ull }, /* 5^-218 */
+    { 0x8d3360f09cf6e4bdull, 0x64712dd7abbbd95cull }, /* 5^-217 */
+    { 0xb080392cc4349decull, 0xbd8d794d96aacfb3ull }, /* 5^-216 */
+    { 0xdca04777f541c567ull, 0xecf0d7a0fc5583a0ull }, /* 5^-215 */
+    { 0x89e42caaf9491b60ull, 0xf41686c49db57244ull }, /* 5^-214 */
+    { 0xac5d37d5b79b6239ull, 0x311c2875c522ced5ull }, /* 5^-213 */
+    { 0xd77485cb25823ac7ull, 0x7d633293366b828bull }, /* 5^-212 */
+    { 0x86a8d39ef77164bcull, 0xae5dff9c02033197ull }, /* 5^-211 */
+    { 0xa8530886b54dbdebull, 0xd9f57f830283fdfcull }, /* 5^-210 */
+    { 0xd267caa862a12d66ull, 0xd072df63c324fd7bull }, /* 5^-209 */
+    { 0x8380dea93da4bc60ull, 0x4247cb9e59f71e6dull }, /* 5^-208 */
+    { 0xa46116538d0deb78ull, 0x52d9be85f074e608ull }, /* 5^-207 */
+    { 0xcd795be870516656ull, 0x67902e276c921f8bull }, /* 5^-206 */
+    { 0x806bd9714632dff6ull, 0x00ba1cd8a3db53b6ull }, /* 5^-205 */
+    { 0xa086cfcd97bf97f3ull, 0x80e8a40eccd228a4ull }, /* 5^-204 */
+    { 0xc8a883c0fdaf7df0ull, 0x6122cd128006b2cdull }, /* 5^-203 */
+    { 0xfad2a4b13d1b5d6cull, 0x796b805720085f81ull }, /* 5^-202 */
+    { 0x9cc3a6eec6311a63ull, 0xcbe3303674053bb0ull }, /* 5^-201 */
+    { 0xc3f490aa77bd60fcull, 0xbedbfc4411068a9cull }, /* 5^-200 */
+    { 0xf4f1b4d515acb93bull, 0xee92fb5515482d44ull }, /* 5^-199 */
+    { 0x991711052d8bf3c5ull, 0x751bdd152d4d1c4aull }, /* 5^-198 */
+    { 0xbf5cd54678eef0b6ull, 0xd262d45a78a0635dull }, /* 5^-197 */
+    { 0xef340a98172aace4ull, 0x86fb897116c87c34ull }, /* 5^-196 */
+    { 0x9580869f0e7aac0eull, 0xd45d35e6ae3d4da0ull }, /* 5^-195 */
+    { 0xbae0a846d2195712ull, 0x8974836059cca109ull }, /* 5^-194 */
+    { 0xe998d258869facd7ull, 0x2bd1a438703fc94bull }, /* 5^-193 */
+    { 0x91ff83775423cc06ull, 0x7b6306a34627ddcfull }, /* 5^-192 */
+    { 0xb67f6455292cbf08ull, 0x1a3bc84c17b1d542ull }, /* 5^-191 */
+    { 0xe41f3d6a7377eecaull, 0x20caba5f1d9e4a93ull }, /* 5^-190 */
+    { 0x8e938662882af53eull, 0x547eb47b7282ee9cull }, /* 5^-189 */
+    { 0xb23867fb2a35b28dull, 0xe99e619a4f23aa43ull }, /* 5^-188 */
+    { 0xdec681f9f4c31f31ull, 0x6405fa00e2ec94d4ull }, /* 5^-187 */
+    { 0x8b3c113c38f9f37eull, 0xde83bc408dd3dd04ull }, /* 5^-186 */
+    { 0xae0b158b4738705eull, 0x9624ab50b148d445ull }, /* 5^-185 */
+    { 0xd98ddaee19068c76ull, 0x3badd624dd9b0957ull }, /* 5^-184 */
+    { 0x87f8a8d4cfa417c9ull, 0xe54ca5d70a80e5d6ull }, /* 5^-183 */
+    { 0xa9f6d30a038d1dbcull, 0x5e9fcf4ccd211f4cull }, /* 5^-182 */
+    { 0xd47487cc8470652bull, 0x7647c3200069671full }, /* 5^-181 */
+    { 0x84c8d4dfd2c63f3bull, 0x29ecd9f40041e073ull }, /* 5^-180 */
+    { 0xa5fb0a17c777cf09ull, 0xf468107100525890ull }, /* 5^-179 */
+    { 0xcf79cc9db955c2ccull, 0x7182148d4066eeb4ull }, /* 5^-178 */
+    { 0x81ac1fe293d599bfull, 0xc6f14cd848405530ull }, /* 5^-177 */
+    { 0xa21727db38cb002full, 0xb8ada00e5a506a7cull }, /* 5^-176 */
+    { 0xca9cf1d206fdc03bull, 0xa6d90811f0e4851cull }, /* 5^-175 */
+    { 0xfd442e4688bd304aull, 0x908f4a166d1da663ull }, /* 5^-174 */
+    { 0x9e4a9cec15763e2eull, 0x9a598e4e043287feull }, /* 5^-173 */
+    { 0xc5dd44271ad3cdbaull, 0x40eff1e1853f29fdull }, /* 5^-172 */
+    { 0xf7549530e188c128ull, 0xd12bee59e68ef47cull }, /* 5^-171 */
+    { 0x9a94dd3e8cf578b9ull, 0x82bb74f8301958ceull }, /* 5^-170 */
+    { 0xc13a148e3032d6e7ull, 0xe36a52363c1faf01ull }, /* 5^-169 */
+    { 0xf18899b1bc3f8ca1ull, 0xdc44e6c3cb279ac1ull }, /* 5^-168 */
+    { 0x96f5600f15a7b7e5ull, 0x29ab103a5ef8c0b9ull }, /* 5^-167 */
+    { 0xbcb2b812db11a5deull, 0x7415d448f6b6f0e7ull }, /* 5^-166 */
+    { 0xebdf661791d60f56ull, 0x111b495b3464ad21ull }, /* 5^-165 */
+    { 0x936b9fcebb25c995ull, 0xcab10dd900beec34ull }, /* 5^-164 */
+    { 0xb84687c269ef3bfbull, 0x3d5d514f40eea742ull }, /* 5^-163 */
+    { 0xe65829b3046b0afaull, 0x0cb4a5a3112a5112ull }, /* 5^-162 */
+    { 0x8ff71a0fe2c2e6dcull, 0x47f0e785eaba72abull }, /* 5^-161 */
+    { 0xb3f4e093db73a093ull, 0x59ed216765690f56ull }, /* 5^-160 */
+    { 0xe0f218b8d25088b8ull, 0x306869c13ec3532cull }, /* 5^-159 */
+    { 0x8c974f7383725573ull, 0x1e414218c73a13fbull }, /* 5^-158 */
+    { 0xafbd2350644eeacfull, 0xe5d1929ef90898faull }, /* 5^-157 */
+    { 0xdbac6c247d62a583ull, 0xdf45f746b74abf39ull }, /* 5^-156 */
+    { 0x894bc396ce5da772ull, 0x6b8bba8c328eb783ull }, /* 5^-155 */
+    { 0xab9eb47c81f5114full, 0x066ea92f3f326564ull }, /* 5^-154 */
+    { 0xd686619ba27255a2ull, 0xc80a537b0efefebdull }, /* 5^-153 */
+    { 0x8613fd0145877585ull, 0xbd06742ce95f5f36ull }, /* 5^-152 */
+    { 0xa798fc4196e952e7ull, 0x2c48113823b73704ull }, /* 5^-151 */
+    { 0xd17f3b51fca3a7a0ull, 0xf75a15862ca504c5ull }, /* 5^-150 */
+    { 0x82ef85133de648c4ull, 0x9a984d73dbe722fbull }, /* 5^-149 */
+    { 0xa3ab66580d5fdaf5ull, 0xc13e60d0d2e0ebbaull }, /* 5^-148 */
+    { 0xcc963fee10b7d1b3ull, 0x318df905079926a8ull }, /* 5^-147 */
+    { 0xffbbcfe994e5c61full, 0xfdf17746497f7052ull }, /* 5^-146 */
+    { 0x9fd561f1fd0f9bd3ull, 0xfeb6ea8bedefa633ull }, /* 5^-145 */
+    { 0xc7caba6e7c5382c8ull, 0xfe64a52ee96b8fc0ull }, /* 5^-144 */
+    { 0xf9bd690a1b68637bull, 0x3dfdce7aa3c673b0ull }, /* 5^-143 */
+    { 0x9c1661a651213e2dull, 0x06bea10ca65c084eull }, /* 5^-142 */
+    { 0xc31bfa0fe5698db8ull, 0x486e494fcff30a62ull }, /* 5^-141 */
+    { 0xf3e2f893dec3f126ull, 0x5a89dba3c3efccfaull }, /* 5^-140 */
+    { 0x986ddb5c6b3a76b7ull, 0xf89629465a75e01cull }, /* 5^-139 */
+    { 0xbe89523386091465ull, 0xf6bbb397f1135823ull }, /* 5^-138 */
+    { 0xee2ba6c0678b597full, 0x746aa07ded582e2cull }, /* 5^-137 */
+    { 0x94db483840b717efull, 0xa8c2a44eb4571cdcull }, /* 5^-136 */
+    { 0xba121a4650e4ddebull, 0x92f34d62616ce413ull }, /* 5^-135 */
+    { 0xe896a0d7e51e1566ull, 0x77b020baf9c81d17ull }, /* 5^-134 */
+    { 0x915e2486ef32cd60ull, 0x0ace1474dc1d122eull }, /* 5^-133 */
+    { 0xb5b5ada8aaff80b8ull, 0x0d819992132456baull }, /* 5^-132 */
+    { 0xe3231912d5bf60e6ull, 0x10e1fff697ed6c69ull }, /* 5^-131 */
+    { 0x8df5efabc5979c8full, 0xca8d3ffa1ef463c1ull }, /* 5^-130 */
+    { 0xb1736b96b6fd83b3ull, 0xbd308ff8a6b17cb2ull }, /* 5^-129 */
+    { 0xddd0467c64bce4a0ull, 0xac7cb3f6d05ddbdeull }, /* 5^-128 */
+    { 0x8aa22c0dbef60ee4ull, 0x6bcdf07a423aa96bull }, /* 5^-127 */
+    { 0xad4ab7112eb3929dull, 0x86c16c98d2c953c6ull }, /* 5^-126 */
+    { 0xd89d64d57a607744ull, 0xe871c7bf077ba8b7ull }, /* 5^-125 */
+    { 0x87625f056c7c4a8bull, 0x11471cd764ad4972ull }, /* 5^-124 */
+    { 0xa93af6c6c79b5d2dull, 0xd598e40d3dd89bcfull }, /* 5^-123 */
+    { 0xd389b47879823479ull, 0x4aff1d108d4ec2c3ull }, /* 5^-122 */
+    { 0x843610cb4bf160cbull, 0xcedf722a585139baull }, /* 5^-121 */
+    { 0xa54394fe1eedb8feull, 0xc2974eb4ee658828ull }, /* 5^-120 */
+    { 0xce947a3da6a9273eull, 0x733d226229feea32ull }, /* 5^-119 */
+    { 0x811ccc668829b887ull, 0x0806357d5a3f525full }, /* 5^-118 */
+    { 0xa163ff802a3426a8ull, 0xca07c2dcb0cf26f7ull }, /* 5^-117 */
+    { 0xc9bcff6034c13052ull, 0xfc89b393dd02f0b5ull }, /* 5^-116 */
+    { 0xfc2c3f3841f17c67ull, 0xbbac2078d443ace2ull }, /* 5^-115 */
+    { 0x9d9ba7832936edc0ull, 0xd54b944b84aa4c0dull }, /* 5^-114 */
+    { 0xc5029163f384a931ull, 0x0a9e795e65d4df11ull }, /* 5^-113 */
+    { 0xf64335bcf065d37dull, 0x4d4617b5ff4a16d5ull }, /* 5^-112 */
+    { 0x99ea0196163fa42eull, 0x504bced1bf8e4e45ull }, /* 5^-111 */
+    { 0xc06481fb9bcf8d39ull, 0xe45ec2862f71e1d6ull }, /* 5^-110 */
+    { 0xf07da27a82c37088ull, 0x5d767327bb4e5a4cull }, /* 5^-109 */
+    { 0x964e858c91ba2655ull, 0x3a6a07f8d510f86full }, /* 5^-108 */
+    { 0xbbe226efb628afeaull, 0x890489f70a55368bull }, /* 5^-107 */
+    { 0xeadab0aba3b2dbe5ull, 0x2b45ac74ccea842eull }, /* 5^-106 */
+    { 0x92c8ae6b464fc96full, 0x3b0b8bc90012929dull }, /* 5^-105 */
+    { 0xb77ada0617e3bbcbull, 0x09ce6ebb40173744ull }, /* 5^-104 */
+    { 0xe55990879ddcaabdull, 0xcc420a6a101d0515ull }, /* 5^-103 */
+    { 0x8f57fa54c2a9eab6ull, 0x9fa946824a12232dull }, /* 5^-102 */
+    { 0xb32df8e9f3546564ull, 0x47939822dc96abf9ull }, /* 5^-101 */
+    { 0xdff9772470297ebdull, 0x59787e2b93bc56f7ull }, /* 5^-100 */
+    { 0x8bfbea76c619ef36ull, 0x57eb4edb3c55b65aull }, /* 5^-99 */
+    { 0xaefae51477a06b03ull, 0xede622920b6b23f1ull }, /* 5^-98 */
+    { 0xdab99e59958885c4ull, 0xe95fab368e45ecedull }, /* 5^-97 */
+    { 0x88b402f7fd75539bull, 0x11dbcb0218ebb414ull }, /* 5^-96 */
+    { 0xaae103b5fcd2a881ull, 0xd652bdc29f26a119ull }, /* 5^-95 */
+    { 0xd59944a37c0752a2ull, 0x4be76d3346f0495full }, /* 5^-94 */
+    { 0x857fcae62d8493a5ull, 0x6f70a4400c562ddbull }, /* 5^-93 */
+    { 0xa6dfbd9fb8e5b88eull, 0xcb4ccd500f6bb952ull }, /* 5^-92 */
+    { 0xd097ad07a71f26b2ull, 0x7e2000a41346a7a7ull }, /* 5^-91 */
+    { 0x825ecc24c873782full, 0x8ed400668c0c28c8ull }, /* 5^-90 */
+    { 0xa2f67f2dfa90563bull, 0x728900802f0f32faull }, /* 5^-89 */
+    { 0xcbb41ef979346bcaull, 0x4f2b40a03ad2ffb9ull }, /* 5^-88 */
+    { 0xfea126b7d78186bcull, 0xe2f610c84987bfa8ull }, /* 5^-87 */
+    { 0x9f24b832e6b0f436ull, 0x0dd9ca7d2df4d7c9ull }, /* 5^-86 */
+    { 0xc6ede63fa05d3143ull, 0x91503d1c79720dbbull }, /* 5^-85 */
+    { 0xf8a95fcf88747d94ull, 0x75a44c6397ce912aull }, /* 5^-84 */
+    { 0x9b69dbe1b548ce7cull, 0xc986afbe3ee11abaull }, /* 5^-83 */
+    { 0xc24452da229b021bull, 0xfbe85badce996168ull }, /* 5^-82 */
+    { 0xf2d56790ab41c2a2ull, 0xfae27299423fb9c3ull }, /* 5^-81 */
+    { 0x97c560ba6b0919a5ull, 0xdccd879fc967d41aull }, /* 5^-80 */
+    { 0xbdb6b8e905cb600full, 0x5400e987bbc1c920ull }, /* 5^-79 */
+    { 0xed246723473e3813ull, 0x290123e9aab23b68ull }, /* 5^-78 */
+    { 0x9436c0760c86e30bull, 0xf9a0b6720aaf6521ull }, /* 5^-77 */
+    { 0xb94470938fa89bceull, 0xf808e40e8d5b3e69ull }, /* 5^-76 */
+    { 0xe7958cb87392c2c2ull, 0xb60b1d1230b20e04ull }, /* 5^-75 */
+    { 0x90bd77f3483bb9b9ull, 0xb1c6f22b5e6f48c2ull }, /* 5^-74 */
+    { 0xb4ecd5f01a4aa828ull, 0x1e38aeb6360b1af3ull }, /* 5^-73 */
+    { 0xe2280b6c20dd5232ull, 0x25c6da63c38de1b0ull }, /* 5^-72 */
+    { 0x8d590723948a535full, 0x579c487e5a38ad0eull }, /* 5^-71 */
+    { 0xb0af48ec79ace837ull, 0x2d835a9df0c6d851ull }, /* 5^-70 */
+    { 0xdcdb1b2798182244ull, 0xf8e431456cf88e65ull }, /* 5^-69 */
+    { 0x8a08f0f8bf0f156bull, 0x1b8e9ecb641b58ffull }, /* 5^-68 */
+    { 0xac8b2d36eed2dac5ull, 0xe272467e3d222f3full }, /* 5^-67 */
+    { 0xd7adf884aa879177ull, 0x5b0ed81dcc6abb0full }, /* 5^-66 */
+    { 0x86ccbb52ea94baeaull, 0x98e947129fc2b4e9ull }, /* 5^-65 */
+    { 0xa87fea27a539e9a5ull, 0x3f2398d747b36224ull }, /* 5^-64 */
+    { 0xd29fe4b18e88640eull, 0x8eec7f0d19a03aadull }, /* 5^-63 */
+    { 0x83a3eeeef9153e89ull, 0x1953cf68300424acull }, /* 5^-62 */
+    { 0xa48ceaaab75a8e2bull, 0x5fa8c3423c052dd7ull }, /* 5^-61 */
+    { 0xcdb02555653131b6ull, 0x3792f412cb06794dull }, /* 5^-60 */
+    { 0x808e17555f3ebf11ull, 0xe2bbd88bbee40bd0ull }, /* 5^-59 */
+    { 0xa0b19d2ab70e6ed6ull, 0x5b6aceaeae9d0ec4ull }, /* 5^-58 */
+    { 0xc8de047564d20a8bull, 0xf245825a5a445275ull }, /* 5^-57 */
+    { 0xfb158592be068d2eull, 0xeed6e2f0f0d56712ull }, /* 5^-56 */
+    { 0x9ced737bb6c4183dull, 0x55464dd69685606bull }, /* 5^-55 */
+    { 0xc428d05aa4751e4cull, 0xaa97e14c3c26b886ull }, /* 5^-54 */
+    { 0xf53304714d9265dfull, 0xd53dd99f4b3066a8ull }, /* 5^-53 */
+    { 0x993fe2c6d07b7fabull, 0xe546a8038efe4029ull }, /* 5^-52 */
+    { 0xbf8fdb78849a5f96ull, 0xde98520472bdd033ull }, /* 5^-51 */
+    { 0xef73d256a5c0f77cull, 0x963e66858f6d4440ull }, /* 5^-50 */
+    { 0x95a8637627989aadull, 0xdde7001379a44aa8ull }, /* 5^-49 */
+    { 0xbb127c53b17ec159ull, 0x5560c018580d5d52ull }, /* 5^-48 */
+    { 0xe9d71b689dde71afull, 0xaab8f01e6e10b4a6ull }, /* 5^-47 */
+    { 0x9226712162ab070dull, 0xcab3961304ca70e8ull }, /* 5^-46 */
+    { 0xb6b00d69bb55c8d1ull, 0x3d607b97c5fd0d22ull }, /* 5^-45 */
+    { 0xe45c10c42a2b3b05ull, 0x8cb89a7db77c506aull }, /* 5^-44 */
+    { 0x8eb98a7a9a5b04e3ull, 0x77f3608e92adb242ull }, /* 5^-43 */
+    { 0xb267ed1940f1c61cull, 0x55f038b237591ed3ull }, /* 5^-42 */
+    { 0xdf01e85f912e37a3ull, 0x6b6c46dec52f6688ull }, /* 5^-41 */
+    { 0x8b61313bbabce2c6ull, 0x2323ac4b3b3da015ull }, /* 5^-40 */
+    { 0xae397d8aa96c1b77ull, 0xabec975e0a0d081aull }, /* 5^-39 */
+    { 0xd9c7dced53c72255ull, 0x96e7bd358c904a21ull }, /* 5^-38 */
+    { 0x881cea14545c7575ull, 0x7e50d64177da2e54ull }, /* 5^-37 */
+    { 0xaa242499697392d2ull, 0xdde50bd1d5d0b9e9ull }, /* 5^-36 */
+    { 0xd4ad2dbfc3d07787ull, 0x955e4ec64b44e864ull }, /* 5^-35 */
+    { 0x84ec3c97da624ab4ull, 0xbd5af13bef0b113eull }, /* 5^-34 */
+    { 0xa6274bbdd0fadd61ull, 0xecb1ad8aeacdd58eull }, /* 5^-33 */
+    { 0xcfb11ead453994baull, 0x67de18eda5814af2ull }, /* 5^-32 */
+    { 0x81ceb32c4b43fcf4ull, 0x80eacf948770ced7ull }, /* 5^-31 */
+    { 0xa2425ff75e14fc31ull, 0xa1258379a94d028dull }, /* 5^-30 */
+    { 0xcad2f7f5359a3b3eull, 0x096ee45813a04330ull }, /* 5^-29 */
+    { 0xfd87b5f28300ca0dull, 0x8bca9d6e188853fcull }, /* 5^-28 */
+    { 0x9e74d1b791e07e48ull, 0x775ea264cf55347eull }, /* 5^-27 */
+    { 0xc612062576589ddaull, 0x95364afe032a819eull }, /* 5^-26 */
+    { 0xf79687aed3eec551ull, 0x3a83ddbd83f52205ull }, /* 5^-25 */
+    { 0x9abe14cd44753b52ull, 0xc4926a9672793543ull }, /* 5^-24 */
+    { 0xc16d9a0095928a27ull, 0x75b7053c0f178294ull }, /* 5^-23 */
+    { 0xf1c90080baf72cb1ull, 0x5324c68b12dd6339ull }, /* 5^-22 */
+    { 0x971da05074da7beeull, 0xd3f6fc16ebca5e04ull }, /* 5^-21 */
+    { 0xbce5086492111aeaull, 0x88f4bb1ca6bcf585ull }, /* 5^-20 */
+    { 0xec1e4a7db69561a5ull, 0x2b31e9e3d06c32e6ull }, /* 5^-19 */
+    { 0x9392ee8e921d5d07ull, 0x3aff322e62439fd0ull }, /* 5^-18 */
+    { 0xb877aa3236a4b449ull, 0x09befeb9fad487c3ull }, /* 5^-17 */
+    { 0xe69594bec44de15bull, 0x4c2ebe687989a9b4ull }, /* 5^-16 */
+    { 0x901d7cf73ab0acd9ull, 0x0f9d37014bf60a11ull }, /* 5^-15 */
+    { 0xb424dc35095cd80full, 0x538484c19ef38c95ull }, /* 5^-14 */
+    { 0xe12e13424bb40e13ull, 0x2865a5f206b06fbaull }, /* 5^-13 */
+    { 0x8cbccc096f5088cbull, 0xf93f87b7442e45d4ull }, /* 5^-12 */
+    { 0xafebff0bcb24aafeull, 0xf78f69a51539d749ull }, /* 5^-11 */
+    { 0xdbe6fecebdedd5beull, 0xb573440e5a884d1cull }, /* 5^-10 */
+    { 0x89705f4136b4a597ull, 0x31680a88f8953031ull }, /* 5^-9 */
+    { 0xabcc77118461cefcull, 0xfdc20d2b36ba7c3eull }, /* 5^-8 */
+    { 0xd6bf94d5e57a42bcull, 0x3d32907604691b4dull }, /* 5^-7 */
+    { 0x8637bd05af6c69b5ull, 0xa63f9a49c2c1b110ull }, /* 5^-6 */
+    { 0xa7c5ac471b478423ull, 0x0fcf80dc33721d54ull }, /* 5^-5 */
+    { 0xd1b71758e219652bull, 0xd3c36113404ea4a9ull }, /* 5^-4 */
+    { 0x83126e978d4fdf3bull, 0x645a1cac083126eaull }, /* 5^-3 */
+    { 0xa3d70a3d70a3d70aull, 0x3d70a3d70a3d70a4ull }, /* 5^-2 */
+    { 0xccccccccccccccccull, 0xcccccccccccccccdull }, /* 5^-1 */
+    { 0x8000000000000000ull, 0x0000000000000000ull }, /* 5^0 */
+    { 0xa000000000000000ull, 0x0000000000000000ull }, /* 5^1 */
+    { 0xc800000000000000ull, 0x0000000000000000ull }, /* 5^2 */
+    { 0xfa00000000000000ull, 0x0000000000000000ull }, /* 5^3 */
+    { 0x9c40000000000000ull, 0x0000000000000000ull }, /* 5^4 */
+    { 0xc350000000000000ull, 0x0000000000000000ull }, /* 5^5 */
+    { 0xf424000000000000ull, 0x0000000000000000ull }, /* 5^6 */
+    { 0x9896800000000000ull, 0x0000000000000000ull }, /* 5^7 */
+    { 0xbebc200000000000ull, 0x0000000000000000ull }, /* 5^8 */
+    { 0xee6b280000000000ull, 0x0000000000000000ull }, /* 5^9 */
+    { 0x9502f90000000000ull, 0x0000000000000000ull }, /* 5^10 */
+    { 0xba43b74000000000ull, 0x0000000000000000ull }, /* 5^11 */
+    { 0xe8d4a51000000000ull, 0x0000000000000000ull }, /* 5^12 */
+    { 0x9184e72a00000000ull, 0x0000000000000000ull }, /* 5^13 */
+    { 0xb5e620f480000000ull, 0x0000000000000000ull }, /* 5^14 */
+    { 0xe35fa931a0000000ull, 0x0000000000000000ull }, /* 5^15 */
+    { 0x8e1bc9bf04000000ull, 0x0000000000000000ull }, /* 5^16 */
+    { 0xb1a2bc2ec5000000ull, 0x0000000000000000ull }, /* 5^17 */
+    { 0xde0b6b3a76400000ull, 0x0000000000000000ull }, /* 5^18 */
+    { 0x8ac7230489e80000ull, 0x0000000000000000ull }, /* 5^19 */
+    { 0xad78ebc5ac620000ull, 0x0000000000000000ull }, /* 5^20 */
+    { 0xd8d726b7177a8000ull, 0x0000000000000000ull }, /* 5^21 */
+    { 0x878678326eac9000ull, 0x0000000000000000ull }, /* 5^22 */
+    { 0xa968163f0a57b400ull, 0x0000000000000000ull }, /* 5^23 */
+    { 0xd3c21bcecceda100ull, 0x0000000000000000ull }, /* 5^24 */
+    { 0x84595161401484a0ull, 0x0000000000000000ull }, /* 5^25 */
+    { 0xa56fa5b99019a5c8ull, 0x0000000000000000ull }, /* 5^26 */
+    { 0xcecb8f27f4200f3aull, 0x0000000000000000ull }, /* 5^27 */
+    { 0x813f3978f8940984ull, 0x4000000000000000ull }, /* 5^28 */
+    { 0xa18f07d736b90be5ull, 0x5000000000000000ull }, /* 5^29 */
+    { 0xc9f2c9cd04674edeull, 0xa400000000000000ull }, /* 5^30 */
+    { 0xfc6f7c4045812296ull, 0x4d00000000000000ull }, /* 5^31 */
+    { 0x9dc5ada82b70b59dull, 0xf020000000000000ull }, /* 5^32 */
+    { 0xc5371912364ce305ull, 0x6c28000000000000ull }, /* 5^33 */
+    { 0xf684df56c3e01bc6ull, 0xc732000000000000ull }, /* 5^34 */
+    { 0x9a130b963a6c115cull, 0x3c7f400000000000ull }, /* 5^35 */
+    { 0xc097ce7bc90715b3ull, 0x4b9f100000000000ull }, /* 5^36 */
+    { 0xf0bdc21abb48db20ull, 0x1e86d40000000000ull }, /* 5^37 */
+    { 0x96769950b50d88f4ull, 0x1314448000000000ull }, /* 5^38 */
+    { 0xbc143fa4e250eb31ull, 0x17d955a000000000ull }, /* 5^39 */
+    { 0xeb194f8e1ae525fdull, 0x5dcfab0800000000ull }, /* 5^40 */
+    { 0x92efd1b8d0cf37beull, 0x5aa1cae500000000ull }, /* 5^41 */
+    { 0xb7abc627050305adull, 0xf14a3d9e40000000ull }, /* 5^42 */
+    { 0xe596b7b0c643c719ull, 0x6d9ccd05d0000000ull }, /* 5^43 */
+    { 0x8f7e32ce7bea5c6full, 0xe4820023a2000000ull }, /* 5^44 */
+    { 0xb35dbf821ae4f38bull, 0xdda2802c8a800000ull }, /* 5^45 */
+    { 0xe0352f62a19e306eull, 0xd50b2037ad200000ull }, /* 5^46 */
+    { 0x8c213d9da502de45ull, 0x4526f422cc340000ull }, /* 5^47 */
+    { 0xaf298d050e4395d6ull, 0x9670b12b7f410000ull }, /* 5^48 */
+    { 0xdaf3f04651d47b4cull, 0x3c0cdd765f114000ull }, /* 5^49 */
+    { 0x88d8762bf324cd0full, 0xa5880a69fb6ac800ull }, /* 5^50 */
+    { 0xab0e93b6efee0053ull, 0x8eea0d047a457a00ull }, /* 5^51 */
+    { 0xd5d238a4abe98068ull, 0x72a4904598d6d880ull }, /* 5^52 */
+    { 0x85a36366eb71f041ull, 0x47a6da2b7f864750ull }, /* 5^53 */
+    { 0xa70c3c40a64e6c51ull, 0x999090b65f67d924ull }, /* 5^54 */
+    { 0xd0cf4b50cfe20765ull, 0xfff4b4e3f741cf6dull }, /* 5^55 */
+    { 0x82818f1281ed449full, 0xbff8f10e7a8921a4ull }, /* 5^56 */
+    { 0xa321f2d7226895c7ull, 0xaff72d52192b6a0dull }, /* 5^57 */
+    { 0xcbea6f8ceb02bb39ull, 0x9bf4f8a69f764490ull }, /* 5^58 */
+    { 0xfee50b7025c36a08ull, 0x02f236d04753d5b4ull }, /* 5^59 */
+    { 0x9f4f2726179a2245ull, 0x01d762422c946590ull }, /* 5^60 */
+    { 0xc722f0ef9d80aad6ull, 0x424d3ad2b7b97ef5ull }, /* 5^61 */
+    { 0xf8ebad2b84e0d58bull, 0xd2e0898765a7deb2ull }, /* 5^62 */
+    { 0x9b934c3b330c8577ull, 0x63cc55f49f88eb2full }, /* 5^63 */
+    { 0xc2781f49ffcfa6d5ull, 0x3cbf6b71c76b25fbull }, /* 5^64 */
+    { 0xf316271c7fc3908aull, 0x8bef464e3945ef7aull }, /* 5^65 */
+    { 0x97edd871cfda3a56ull, 0x97758bf0e3cbb5acull }, /* 5^66 */
+    { 0xbde94e8e43d0c8ecull, 0x3d52eeed1cbea317ull }, /* 5^67 */
+    { 0xed63a231d4c4fb27ull, 0x4ca7aaa863ee4bddull }, /* 5^68 */
+    { 0x945e455f24fb1cf8ull, 0x8fe8caa93e74ef6aull }, /* 5^69 */
+    { 0xb975d6b6ee39e436ull, 0xb3e2fd538e122b44ull }, /* 5^70 */
+    { 0xe7d34c64a9c85d44ull, 0x60dbbca87196b616ull }, /* 5^71 */
+    { 0x90e40fbeea1d3a4aull, 0xbc8955e946fe31cdull }, /* 5^72 */
+    { 0xb51d13aea4a488ddull, 0x6babab6398bdbe41ull }, /* 5^73 */
+    { 0xe264589a4dcdab14ull, 0xc696963c7eed2dd1ull }, /* 5^74 */
+    { 0x8d7eb76070a08aecull, 0xfc1e1de5cf543ca2ull }, /* 5^75 */
+    { 0xb0de65388cc8ada8ull, 0x3b25a55f43294bcbull }, /* 5^76 */
+    { 0xdd15fe86affad912ull, 0x49ef0eb713f39ebeull }, /* 5^77 */
+    { 0x8a2dbf142dfcc7abull, 0x6e3569326c784337ull }, /* 5^78 */
+    { 0xacb92ed9397bf996ull, 0x49c2c37f07965404ull }, /* 5^79 */
+    { 0xd7e77a8f87daf7fbull, 0xdc33745ec97be906ull }, /* 5^80 */
+    { 0x86f0ac99b4e8dafdull, 0x69a028bb3ded71a3ull }, /* 5^81 */
+    { 0xa8acd7c0222311bcull, 0xc40832ea0d68ce0cull }, /* 5^82 */
+    { 0xd2d80db02aabd62bull, 0xf50a3fa490c30190ull }, /* 5^83 */
+    { 0x83c7088e1aab65dbull, 0x792667c6da79e0faull }, /* 5^84 */
+    { 0xa4b8cab1a1563f52ull, 0x577001b891185938ull }, /* 5^85 */
+    { 0xcde6fd5e09abcf26ull, 0xed4c0226b55e6f86ull }, /* 5^86 */
+    { 0x80b05e5ac60b6178ull, 0x544f8158315b05b4ull }, /* 5^87 */
+    { 0xa0dc75f1778e39d6ull, 0x696361ae3db1c721ull }, /* 5^88 */
+    { 0xc913936dd571c84cull, 0x03bc3a19cd1e38e9ull }, /* 5^89 */
+    { 0xfb5878494ace3a5full, 0x04ab48a04065c723ull }, /* 5^90 */
+    { 0x9d174b2dcec0e47bull, 0x62eb0d64283f9c76ull }, /* 5^91 */
+    { 0xc45d1df942711d9aull, 0x3ba5d0bd324f8394ull }, /* 5^92 */
+    { 0xf5746577930d6500ull, 0xca8f44ec7ee36479ull }, /* 5^93 */
+    { 0x9968bf6abbe85f20ull, 0x7e998b13cf4e1ecbull }, /* 5^94 */
+    { 0xbfc2ef456ae276e8ull, 0x9e3fedd8c321a67eull }, /* 5^95 */
+    { 0xefb3ab16c59b14a2ull, 0xc5cfe94ef3ea101eull }, /* 5^96 */
+    { 0x95d04aee3b80ece5ull, 0xbba1f1d158724a12ull }, /* 5^97 */
+    { 0xbb445da9ca61281full, 0x2a8a6e45ae8edc97ull }, /* 5^98 */
+    { 0xea1575143cf97226ull, 0xf52d09d71a3293bdull }, /* 5^99 */
+    { 0x924d692ca61be758ull, 0x593c2626705f9c56ull }, /* 5^100 */
+    { 0xb6e0c377cfa2e12eull, 0x6f8b2fb00c77836cull }, /* 5^101 */
+    { 0xe498f455c38b997aull, 0x0b6dfb9c0f956447ull }, /* 5^102 */
+    { 0x8edf98b59a373fecull, 0x4724bd4189bd5eacull }, /* 5^103 */
+    { 0xb2977ee300c50fe7ull, 0x58edec91ec2cb657ull }, /* 5^104 */
+    { 0xdf3d5e9bc0f653e1ull, 0x2f2967b66737e3edull }, /* 5^105 */
+    { 0x8b865b215899f46cull, 0xbd79e0d20082ee74ull }, /* 5^106 */
+    { 0xae67f1e9aec07187ull, 0xecd8590680a3aa11ull }, /* 5^107 */
+    { 0xda01ee641a708de9ull, 0xe80e6f4820cc9495ull }, /* 5^108 */
+    { 0x884134fe908658b2ull, 0x3109058d147fdcddull }, /* 5^109 */
+    { 0xaa51823e34a7eedeull, 0xbd4b46f0599fd415ull }, /* 5^110 */
+    { 0xd4e5e2cdc1d1ea96ull, 0x6c9e18ac7007c91aull }, /* 5^111 */
+    { 0x850fadc09923329eull, 0x03e2cf6bc604ddb0ull }, /* 5^112 */
+    { 0xa6539930bf6bff45ull, 0x84db8346b786151cull }, /* 5^113 */
+    { 0xcfe87f7cef46ff16ull, 0xe612641865679a63ull }, /* 5^114 */
+    { 0x81f14fae158c5f6eull, 0x4fcb7e8f3f60c07eull }, /* 5^115 */
+    { 0xa26da3999aef7749ull, 0xe3be5e330f38f09dull }, /* 5^116 */
+    { 0xcb090c8001ab551cull, 0x5cadf5bfd3072cc5ull }, /* 5^117 */
+    { 0xfdcb4fa002162a63ull, 0x73d9732fc7c8f7f6ull }, /* 5^118 */
+    { 0x9e9f11c4014dda7eull, 0x2867e7fddcdd9afaull }, /* 5^119 */
+    { 0xc646d63501a1511dull, 0xb281e1fd541501b8ull }, /* 5^120 */
+    { 0xf7d88bc24209a565ull, 0x1f225a7ca91a4226ull }, /* 5^121 */
+    { 0x9ae757596946075full, 0x3375788de9b06958ull }, /* 5^122 */
+    { 0xc1a12d2fc3978937ull, 0x0052d6b1641c83aeull }, /* 5^123 */
+    { 0xf209787bb47d6b84ull, 0xc0678c5dbd23a49aull }, /* 5^124 */
+    { 0x9745eb4d50ce6332ull, 0xf840b7ba963646e0ull }, /* 5^125 */
+    { 0xbd176620a501fbffull, 0xb650e5a93bc3d898ull }, /* 5^126 */
+    { 0xec5d3fa8ce427affull, 0xa3e51f138ab4cebeull }, /* 5^127 */
+    { 0x93ba47c980e98cdfull, 0xc66f336c36b10137ull }, /* 5^128 */
+    { 0xb8a8d9bbe123f017ull, 0xb80b0047445d4184ull }, /* 5^129 */
+    { 0xe6d3102ad96cec1dull, 0xa60dc059157491e5ull }, /* 5^130 */
+    { 0x9043ea1ac7e41392ull, 0x87c89837ad68db2full }, /* 5^131 */
+    { 0xb454e4a179dd1877ull, 0x29babe4598c311fbull }, /* 5^132 */
+    { 0xe16a1dc9d8545e94ull, 0xf4296dd6fef3d67aull }, /* 5^133 */
+    { 0x8ce2529e2734bb1dull, 0x1899e4a65f58660cull }, /* 5^134 */
+    { 0xb01ae745b101e9e4ull, 0x5ec05dcff72e7f8full }, /* 5^135 */
+    { 0xdc21a1171d42645dull, 0x76707543f4fa1f73ull }, /* 5^136 */
+    { 0x899504ae72497ebaull, 0x6a06494a791c53a8ull }, /* 5^137 */
+    { 0xabfa45da0edbde69ull, 0x0487db9d17636892ull }, /* 5^138 */
+    { 0xd6f8d7509292d603ull, 0x45a9d2845d3c42b6ull }, /* 5^139 */
+    { 0x865b86925b9bc5c2ull, 0x0b8a2392ba45a9b2ull }, /* 5^140 */
+    { 0xa7f26836f282b732ull, 0x8e6cac7768d7141eull }, /* 5^141 */
+    { 0xd1ef0244af2364ffull, 0x3207d795430cd926ull }, /* 5^142 */
+    { 0x8335616aed761f1full, 0x7f44e6bd49e807b8ull }, /* 5^143 */
+    { 0xa402b9c5a8d3a6e7ull, 0x5f16206c9c6209a6ull }, /* 5^144 */
+    { 0xcd036837130890a1ull, 0x36dba887c37a8c0full }, /* 5^145 */
+    { 0x802221226be55a64ull, 0xc2494954da2c9789ull }, /* 5^146 */
+    { 0xa02aa96b06deb0fdull, 0xf2db9baa10b7bd6cull }, /* 5^147 */
+    { 0xc83553c5c8965d3dull, 0x6f92829494e5acc7ull }, /* 5^148 */
+    { 0xfa42a8b73abbf48cull, 0xcb772339ba1f17f9ull }, /* 5^149 */
+    { 0x9c69a97284b578d7ull, 0xff2a760414536efbull }, /* 5^150 */
+    { 0xc38413cf25e2d70dull, 0xfef5138519684abaull }, /* 5^151 */
+    { 0xf46518c2ef5b8cd1ull, 0x7eb258665fc25d69ull }, /* 5^152 */
+    { 0x98bf2f79d5993802ull, 0xef2f773ffbd97a61ull }, /* 5^153 */
+    { 0xbeeefb584aff8603ull, 0xaafb550ffacfd8faull }, /* 5^154 */
+    { 0xeeaaba2e5dbf6784ull, 0x95ba2a53f983cf38ull }, /* 5^155 */
+    { 0x952ab45cfa97a0b2ull, 0xdd945a747bf26183ull }, /* 5^156 */
+    { 0xba756174393d88dfull, 0x94f971119aeef9e4ull }, /* 5^157 */
+    { 0xe912b9d1478ceb17ull, 0x7a37cd5601aab85dull }, /* 5^158 */
+    { 0x91abb422ccb812eeull, 0xac62e055c10ab33aull }, /* 5^159 */
+    { 0xb616a12b7fe617aaull, 0x577b986b314d6009ull }, /* 5^160 */
+    { 0xe39c49765fdf9d94ull, 0xed5a7e85fda0b80bull }, /* 5^161 */
+    { 0x8e41ade9fbebc27dull, 0x14588f13be847307ull }, /* 5^162 */
+    { 0xb1d219647ae6b31cull, 0x596eb2d8ae258fc8ull }, /* 5^163 */
+    { 0xde469fbd99a05fe3ull, 0x6fca5f8ed9aef3bbull }, /* 5^164 */
+    { 0x8aec23d680043beeull, 0x25de7bb9480d5854ull }, /* 5^165 */
+    { 0xada72ccc20054ae9ull, 0xaf561aa79a10ae6aull }, /* 5^166 */
+    { 0xd910f7ff28069da4ull, 0x1b2ba1518094da04ull }, /* 5^167 */
+    { 0x87aa9aff79042286ull, 0x90fb44d2f05d0842ull }, /* 5^168 */
+    { 0xa99541bf57452b28ull, 0x353a1607ac744a53ull }, /* 5^169 */
+    { 0xd3fa922f2d1675f2ull, 0x42889b8997915ce8ull }, /* 5^170 */
+    { 0x847c9b5d7c2e09b7ull, 0x69956135febada11ull }, /* 5^171 */
+    { 0xa59bc234db398c25ull, 0x43fab9837e699095ull }, /* 5^172 */
+    { 0xcf02b2c21207ef2eull, 0x94f967e45e03f4bbull }, /* 5^173 */
+    { 0x8161afb94b44f57dull, 0x1d1be0eebac278f5ull }, /* 5^174 */
+    { 0xa1ba1ba79e1632dcull, 0x6462d92a69731732ull }, /* 5^175 */
+    { 0xca28a291859bbf93ull, 0x7d7b8f7503cfdcfeull }, /* 5^176 */
+    { 0xfcb2cb35e702af78ull, 0x5cda735244c3d43eull }, /* 5^177 */
+    { 0x9defbf01b061adabull, 0x3a0888136afa64a7ull }, /* 5^178 */
+    { 0xc56baec21c7a1916ull, 0x088aaa1845b8fdd0ull }, /* 5^179 */
+    { 0xf6c69a72a3989f5bull, 0x8aad549e57273d45ull }, /* 5^180 */
+    { 0x9a3c2087a63f6399ull, 0x36ac54e2f678864bull }, /* 5^181 */
+    { 0xc0cb28a98fcf3c7full, 0x84576a1bb416a7ddull }, /* 5^182 */
+    { 0xf0fdf2d3f3c30b9full, 0x656d44a2a11c51d5ull }, /* 5^183 */
+    { 0x969eb7c47859e743ull, 0x9f644ae5a4b1b325ull }, /* 5^184 */
+    { 0xbc4665b596706114ull, 0x873d5d9f0dde1feeull }, /* 5^185 */
+    { 0xeb57ff22fc0c7959ull, 0xa90cb506d155a7eaull }, /* 5^186 */
+    { 0x9316ff75dd87cbd8ull, 0x09a7f12442d588f2ull }, /* 5^187 */
+    { 0xb7dcbf5354e9beceull, 0x0c11ed6d538aeb2full }, /* 5^188 */
+    { 0xe5d3ef282a242e81ull, 0x8f1668c8a86da5faull }, /* 5^189 */
+    { 0x8fa475791a569d10ull, 0xf96e017d694487bcull }, /* 5^190 */
+    { 0xb38d92d760ec4455ull, 0x37c981dcc395a9acull }, /* 5^191 */
+    { 0xe070f78d3927556aull, 0x85bbe253f47b1417ull }, /* 5^192 */
+    { 0x8c469ab843b89562ull, 0x93956d7478ccec8eull }, /* 5^193 */
+    { 0xaf58416654a6babbull, 0x387ac8d1970027b2ull }, /* 5^194 */
+    { 0xdb2e51bfe9d0696aull, 0x06997b05fcc0319eull }, /* 5^195 */
+    { 0x88fcf317f22241e2ull, 0x441fece3bdf81f03ull }, /* 5^196 */
+    { 0xab3c2fddeeaad25aull, 0xd527e81cad7626c3ull }, /* 5^197 */
+    { 0xd60b3bd56a5586f1ull, 0x8a71e223d8d3b074ull }, /* 5^198 */
+    { 0x85c7056562757456ull, 0xf6872d5667844e49ull }, /* 5^199 */
+    { 0xa738c6bebb12d16cull, 0xb428f8ac016561dbull }, /* 5^200 */
+    { 0xd106f86e69d785c7ull, 0xe13336d701beba52ull }, /* 5^201 */
+    { 0x82a45b450226b39cull, 0xecc0024661173473ull }, /* 5^202 */
+    { 0xa34d721642b06084ull, 0x27f002d7f95d0190ull }, /* 5^203 */
+    { 0xcc20ce9bd35c78a5ull, 0x31ec038df7b441f4ull }, /* 5^204 */
+    { 0xff290242c83396ceull, 0x7e67047175a15271ull }, /* 5^205 */
+    { 0x9f79a169bd203e41ull, 0x0f0062c6e984d386ull }, /* 5^206 */
+    { 0xc75809c42c684dd1ull, 0x52c07b78a3e60868ull }, /* 5^207 */
+    { 0xf92e0c3537826145ull, 0xa7709a56ccdf8a82ull }, /* 5^208 */
+    { 0x9bbcc7a142b17ccbull, 0x88a66076400bb691ull }, /* 5^209 */
+    { 0xc2abf989935ddbfeull, 0x6acff893d00ea435ull }, /* 5^210 */
+    { 0xf356f7ebf83552feull, 0x0583f6b8c4124d43ull }, /* 5^211 */
+    { 0x98165af37b2153deull, 0xc3727a337a8b704aull }, /* 5^212 */
+    { 0xbe1bf1b059e9a8d6ull, 0x744f18c0592e4c5cull }, /* 5^213 */
+    { 0xeda2ee1c7064130cull, 0x1162def06f79df73ull }, /* 5^214 */
+    { 0x9485d4d1c63e8be7ull, 0x8addcb5645ac2ba8ull }, /* 5^215 */
+    { 0xb9a74a0637ce2ee1ull, 0x6d953e2bd7173692ull }, /* 5^216 */
+    { 0xe8111c87c5c1ba99ull, 0xc8fa8db6ccdd0437ull }, /* 5^217 */
+    { 0x910ab1d4db9914a0ull, 0x1d9c9892400a22a2ull }, /* 5^218 */
+    { 0xb54d5e4a127f59c8ull, 0x2503beb6d00cab4bull }, /* 5^219 */
+    { 0xe2a0b5dc971f303aull, 0x2e44ae64840fd61dull }, /* 5^220 */
+    { 0x8da471a9de737e24ull, 0x5ceaecfed289e5d2ull }, /* 5^221 */
+    { 0xb10d8e1456105dadull, 0x7425a83e872c5f47ull }, /* 5^222 */
+    { 0xdd50f1996b947518ull, 0xd12f124e28f77719ull }, /* 5^223 */
+    { 0x8a5296ffe33cc92full, 0x82bd6b70d99aaa6full }, /* 5^224 */
+    { 0xace73cbfdc0bfb7bull, 0x636cc64d1001550bull }, /* 5^225 */
+    { 0xd8210befd30efa5aull, 0x3c47f7e05401aa4eull }, /* 5^226 */
+    { 0x8714a775e3e95c78ull, 0x65acfaec34810a71ull }, /* 5^227 */
+    { 0xa8d9d1535ce3b396ull, 0x7f1839a741a14d0dull }, /* 5^228 */
+    { 0xd31045a8341ca07cull, 0x1ede48111209a050ull }, /* 5^229 */
+    { 0x83ea2b892091e44dull, 0x934aed0aab460432ull }, /* 5^230 */
+    { 0xa4e4b66b68b65d60ull, 0xf81da84d5617853full }, /* 5^231 */
+    { 0xce1de40642e3f4b9ull, 0x36251260ab9d668eull }, /* 5^232 */
+    { 0x80d2ae83e9ce78f3ull, 0xc1d72b7c6b426019ull }, /* 5^233 */
+    { 0xa1075a24e4421730ull, 0xb24cf65b8612f81full }, /* 5^234 */
+    { 0xc94930ae1d529cfcull, 0xdee033f26797b627ull }, /* 5^235 */
+    { 0xfb9b7cd9a4a7443cull, 0x169840ef017da3b1ull }, /* 5^236 */
+    { 0x9d412e0806e88aa5ull, 0x8e1f289560ee864eull }, /* 5^237 */
+    { 0xc491798a08a2ad4eull, 0xf1a6f2bab92a27e2ull }, /* 5^238 */
+    { 0xf5b5d7ec8acb58a2ull, 0xae10af696774b1dbull }, /* 5^239 */
+    { 0x9991a6f3d6bf1765ull, 0xacca6da1e0a8ef29ull }, /* 5^240 */
+    { 0xbff610b0cc6edd3full, 0x17fd090a58d32af3ull }, /* 5^241 */
+    { 0xeff394dcff8a948eull, 0xddfc4b4cef07f5b0ull }, /* 5^242 */
+    { 0x95f83d0a1fb69cd9ull, 0x4abdaf101564f98eull }, /* 5^243 */
+    { 0xbb764c4ca7a4440full, 0x9d6d1ad41abe37f1ull }, /* 5^244 */
+    { 0xea53df5fd18d5513ull, 0x84c86189216dc5edull }, /* 5^245 */
+    { 0x92746b9be2f8552cull, 0x32fd3cf5b4e49bb4ull }, /* 5^246 */
+    { 0xb7118682dbb66a77ull, 0x3fbc8c33221dc2a1ull }, /* 5^247 */
+    { 0xe4d5e82392a40515ull, 0x0fabaf3feaa5334aull }, /* 5^248 */
+    { 0x8f05b1163ba6832dull, 0x29cb4d87f2a7400eull }, /* 5^249 */
+    { 0xb2c71d5bca9023f8ull, 0x743e20e9ef511012ull }, /* 5^250 */
+    { 0xdf78e4b2bd342cf6ull, 0x914da9246b255416ull }, /* 5^251 */
+    { 0x8bab8eefb6409c1aull, 0x1ad089b6c2f7548eull }, /* 5^252 */
+    { 0xae9672aba3d0c320ull, 0xa184ac2473b529b1ull }, /* 5^253 */
+    { 0xda3c0f568cc4f3e8ull, 0xc9e5d72d90a2741eull }, /* 5^254 */
+    { 0x8865899617fb1871ull, 0x7e2fa67c7a658892ull }, /* 5^255 */
+    { 0xaa7eebfb9df9de8dull, 0xddbb901b98feeab7ull }, /* 5^256 */
+    { 0xd51ea6fa85785631ull, 0x552a74227f3ea565ull }, /* 5^257 */
+    { 0x8533285c936b35deull, 0xd53a88958f87275full }, /* 5^258 */
+    { 0xa67ff273b8460356ull, 0x8a892abaf368f137ull }, /* 5^259 */
+    { 0xd01fef10a657842cull, 0x2d2b7569b0432d85ull }, /* 5^260 */
+    { 0x8213f56a67f6b29bull, 0x9c3b29620e29fc73ull }, /* 5^261 */
+    { 0xa298f2c501f45f42ull, 0x8349f3ba91b47b8full }, /* 5^262 */
+    { 0xcb3f2f7642717713ull, 0x241c70a936219a73ull }, /* 5^263 */
+    { 0xfe0efb53d30dd4d7ull, 0xed238cd383aa0110ull }, /* 5^264 */
+    { 0x9ec95d1463e8a506ull, 0xf4363804324a40aaull }, /* 5^265 */
+    { 0xc67bb4597ce2ce48ull, 0xb143c6053edcd0d5ull }, /* 5^266 */
+    { 0xf81aa16fdc1b81daull, 0xdd94b7868e94050aull }, /* 5^267 */
+    { 0x9b10a4e5e9913128ull, 0xca7cf2b4191c8326ull }, /* 5^268 */
+    { 0xc1d4ce1f63f57d72ull, 0xfd1c2f611f63a3f0ull }, /* 5^269 */
+    { 0xf24a01a73cf2dccfull, 0xbc633b39673c8cecull }, /* 5^270 */
+    { 0x976e41088617ca01ull, 0xd5be0503e085d813ull }, /* 5^271 */
+    { 0xbd49d14aa79dbc82ull, 0x4b2d8644d8a74e18ull }, /* 5^272 */
+    { 0xec9c459d51852ba2ull, 0xddf8e7d60ed1219eull }, /* 5^273 */
+    { 0x93e1ab8252f33b45ull, 0xcabb90e5c942b503ull }, /* 5^274 */
+    { 0xb8da1662e7b00a17ull, 0x3d6a751f3b936243ull }, /* 5^275 */
+    { 0xe7109bfba19c0c9dull, 0x0cc512670a783ad4ull }, /* 5^276 */
+    { 0x906a617d450187e2ull, 0x27fb2b80668b24c5ull }, /* 5^277 */
+    { 0xb484f9dc9641e9daull, 0xb1f9f660802dedf6ull }, /* 5^278 */
+    { 0xe1a63853bbd26451ull, 0x5e7873f8a0396973ull }, /* 5^279 */
+    { 0x8d07e33455637eb2ull, 0xdb0b487b6423e1e8ull }, /* 5^280 */
+    { 0xb049dc016abc5e5full, 0x91ce1a9a3d2cda62ull }, /* 5^281 */
+    { 0xdc5c5301c56b75f7ull, 0x7641a140cc7810fbull }, /* 5^282 */
+    { 0x89b9b3e11b6329baull, 0xa9e904c87fcb0a9dull }, /* 5^283 */
+    { 0xac2820d9623bf429ull, 0x546345fa9fbdcd44ull }, /* 5^284 */
+    { 0xd732290fbacaf133ull, 0xa97c177947ad4095ull }, /* 5^285 */
+    { 0x867f59a9d4bed6c0ull, 0x49ed8eabcccc485dull }, /* 5^286 */
+    { 0xa81f301449ee8c70ull, 0x5c68f256bfff5a74ull }, /* 5^287 */
+    { 0xd226fc195c6a2f8cull, 0x73832eec6fff3111ull }, /* 5^288 */
+    { 0x83585d8fd9c25db7ull, 0xc831fd53c5ff7eabull }, /* 5^289 */
+    { 0xa42e74f3d032f525ull, 0xba3e7ca8b77f5e55ull }, /* 5^290 */
+    { 0xcd3a1230c43fb26full, 0x28ce1bd2e55f35ebull }, /* 5^291 */
+    { 0x80444b5e7aa7cf85ull, 0x7980d163cf5b81b3ull }, /* 5^292 */
+    { 0xa0555e361951c366ull, 0xd7e105bcc332621full }, /* 5^293 */
+    { 0xc86ab5c39fa63440ull, 0x8dd9472bf3fefaa7ull }, /* 5^294 */
+    { 0xfa856334878fc150ull, 0xb14f98f6f0feb951ull }, /* 5^295 */
+    { 0x9c935e00d4b9d8d2ull, 0x6ed1bf9a569f33d3ull }, /* 5^296 */
+    { 0xc3b8358109e84f07ull, 0x0a862f80ec4700c8ull }, /* 5^297 */
+    { 0xf4a642e14c6262c8ull, 0xcd27bb612758c0faull }, /* 5^298 */
+    { 0x98e7e9cccfbd7dbdull, 0x8038d51cb897789cull }, /* 5^299 */
+    { 0xbf21e44003acdd2cull, 0xe0470a63e6bd56c3ull }, /* 5^300 */
+    { 0xeeea5d5004981478ull, 0x1858ccfce06cac74ull }, /* 5^301 */
+    { 0x95527a5202df0ccbull, 0x0f37801e0c43ebc8ull }, /* 5^302 */
+    { 0xbaa718e68396cffdull, 0xd30560258f54e6baull }, /* 5^303 */
+    { 0xe950df20247c83fdull, 0x47c6b82ef32a2069ull }, /* 5^304 */
+    { 0x91d28b7416cdd27eull, 0x4cdc331d57fa5441ull }, /* 5^305 */
+    { 0xb6472e511c81471dull, 0xe0133fe4adf8e952ull }, /* 5^306 */
+    { 0xe3d8f9e563a198e5ull, 0x58180fddd97723a6ull }, /* 5^307 */
+    { 0x8e679c2f5e44ff8full, 0x570f09eaa7ea7648ull }, /* 5^308 */
+    { 0xb201833b35d63f73ull, 0x2cd2cc6551e513daull }, /* 5^309 */
+    { 0xde81e40a034bcf4full, 0xf8077f7ea65e58d1ull }, /* 5^310 */
+    { 0x8b112e86420f6191ull, 0xfb04afaf27faf782ull }, /* 5^311 */
+    { 0xadd57a27d29339f6ull, 0x79c5db9af1f9b563ull }, /* 5^312 */
+    { 0xd94ad8b1c7380874ull, 0x18375281ae7822bcull }, /* 5^313 */
+    { 0x87cec76f1c830548ull, 0x8f2293910d0b15b5ull }, /* 5^314 */
+    { 0xa9c2794ae3a3c69aull, 0xb2eb3875504ddb22ull }, /* 5^315 */
+    { 0xd433179d9c8cb841ull, 0x5fa60692a46151ebull }, /* 5^316 */
+    { 0x849feec281d7f328ull, 0xdbc7c41ba6bcd333ull }, /* 5^317 */
+    { 0xa5c7ea73224deff3ull, 0x12b9b522906c0800ull }, /* 5^318 */
+    { 0xcf39e50feae16befull, 0xd768226b34870a00ull }, /* 5^319 */
+    { 0x81842f29f2cce375ull, 0xe6a1158300d46640ull }, /* 5^320 */
+    { 0xa1e53af46f801c53ull, 0x60495ae3c1097fd0ull }, /* 5^321 */
+    { 0xca5e89b18b602368ull, 0x385bb19cb14bdfc4ull }, /* 5^322 */
+    { 0xfcf62c1dee382c42ull, 0x46729e03dd9ed7b5ull }, /* 5^323 */
+    { 0x9e19db92b4e31ba9ull, 0x6c07a2c26a8346d1ull }  /* 5^324 */
+};
+
+static const double jq_pow10_double[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+JQ_INLINE int
+jq_clz64(jq_uint64 x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(x);
+#else
+    int n = 0;
+    if (!(x & 0xffffffff00000000ull)) { n += 32; x <<= 32; }
+    if (!(x & 0xffff000000000000ull)) { n += 16; x <<= 16; }
+    if (!(x & 0xff00000000000000ull)) { n += 8; x <<= 8; }
+    if (!(x & 0xf000000000000000ull)) { n += 4; x <<= 4; }
+    if (!(x & 0xc000000000000000ull)) { n += 2; x <<= 2; }
+    if (!(x & 0x8000000000000000ull)) { n += 1; }
+    return n;
+#endif
+}
+
+/* Returns the low 64 bits of a * b and sets hi to the high ones */
+JQ_INLINE jq_uint64
+jq_mul128(jq_uint64 a, jq_uint64 b, jq_uint64 *hi) {
+#if defined(__SIZEOF_INT128__)
+    __extension__ unsigned __int128 r = (unsigned __int128)a * b;
+    *hi = (jq_uint64)(r >> 64);
+    return (jq_uint64)r;
+#else
+    jq_uint64 a0 = a & 0xffffffff, a1 = a >> 32, b0 = b & 0xffffffff, b1 = b >> 32;
+    jq_uint64 p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+    jq_uint64 mid = (p00 >> 32) + (p01 & 0xffffffff) + (p10 & 0xffffffff);
+    *hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+    return (mid << 32) | (p00 & 0xffffffff);
+#endif
+}
+
+JQ_INLINE double
+jq_double_from_bits(jq_uint64 bits) {
+    union { jq_uint64 u; double d; } v;
+    v.u = bits;
+    return v.d;
+}
+
+#endif /* JQ_WITH_NUMBERS || JQ_WITH_WRITER */
+
+#ifdef JQ_WITH_NUMBERS
+
+/*
+ * Eisel-Lemire algorithm, returns the bits of w * 10^q rounded to the nearest
+ * double. The 128 bit product is always precise enough for w with 19 digits
+ * (Noble Mushtak and Daniel Lemire, Fast Number Parsing Without Fallback).
+ */
+JQ_INLINE jq_uint64
+jq_eisel_lemire(jq_uint64 w, jq_int64 q) {
+    jq_uint64 lo, hi, lo2, hi2, mantissa;
+    jq_int64 power2;
+    int lz, upperbit, shift;
+
+    if (w == 0 || q < -342) return 0;
+    if (q > 308) return (jq_uint64)0x7ff << 52;
+
+    lz = jq_clz64(w);
+    w <<= lz;
+
+    lo = jq_mul128(w, jq_pow5_128[q + 342][0], &hi);
+    if ((hi & 0x1ff) == 0x1ff) {
+        /* The lower bits may be affected by the second half of the power */
+        jq_mul128(w, jq_pow5_128[q + 342][1], &hi2);
+        lo2 = lo + hi2;
+        if (lo2 < lo) ++hi;
+        lo = lo2;
+    }
+
+    upperbit = (int)(hi >> 63);
+    shift = upperbit + 64 - 52 - 3;
+    mantissa = hi >> shift;
+    power2 = (((152170 + 65536) * q) >> 16) + 63 + upperbit - lz + 1023;
+
+    if (power2 <= 0) {
+        /* Subnormal */
+        if (-power2 + 1 >= 64) return 0;
+        mantissa >>= -power2 + 1;
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        power2 = mantissa < ((jq_uint64)1 << 52) ? 0 : 1;
+        return (mantissa & (((jq_uint64)1 << 52) - 1)) | ((jq_uint64)power2 << 52);
+    }
+
+    /* Exactly halfway, rounding to even instead of up */
+    if (lo <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == hi) {
+        mantissa &= ~(jq_uint64)1;
+    }
+
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= ((jq_uint64)2 << 52)) {
+        mantissa = (jq_uint64)1 << 52;
+        ++power2;
+    }
+
+    if (power2 >= 0x7ff) return (jq_uint64)0x7ff << 52;
+
+    return (mantissa & (((jq_uint64)1 << 52) - 1)) | ((jq_uint64)power2 << 52);
+}
+
+struct jq_bigint {
+    unsigned int limb[JQ_BIGINT_LIMBS]; /* 32 bit limbs, the lowest first */
+    int size;
+};
+
+JQ_INLINE void
+jq_bigint_mul_add(struct jq_bigint *b, unsigned int m, unsigned int a) {
+    jq_uint64 carry = a;
+    int k;
+
+    for (k = 0; k < b->size; ++k) {
+        carry += (jq_uint64)b->limb[k] * m;
+        b->limb[k] = (unsigned int)carry;
+        carry >>= 32;
+    }
+
+    if (carry && b->size < JQ_BIGINT_LIMBS) b->limb[b->size++] = (unsigned int)carry;
+}
+
+JQ_INLINE void
+jq_bigint_mul_pow5(struct jq_bigint *b, jq_int64 n) {
+    static const unsigned int pow5[] = {
+        1, 5, 25, 125, 625, 3125, 15625, 78125, 390625, 1953125, 9765625, 48828125, 244140625, 1220703125
+    };
+
+    for (; n >= 13; n -= 13) jq_bigint_mul_add(b, pow5[13], 0);
+    if (n > 0) jq_bigint_mul_add(b, pow5[n], 0);
+}
+
+JQ_INLINE void
+jq_bigint_shl(struct jq_bigint *b, jq_int64 n) {
+    int limbs = (int)(n / 32), bits = (int)(n % 32), k;
+
+    if (b->size + limbs + 1 > JQ_BIGINT_LIMBS) return; /* never happens for the numbers compared */
+
+    b->limb[b->size + limbs] = 0;
+    for (k = b->size - 1; k >= 0; --k) {
+        if (bits) b->limb[k + limbs + 1] |= b->limb[k] >> (32 - bits);
+        b->limb[k + limbs] = b->limb[k] << bits;
+    }
+    for (k = 0; k < limbs; ++k) b->limb[k] = 0;
+
+    b->size += limbs + 1;
+    while (b->size && !b->limb[b->size - 1]) --b->size;
+}
+
+JQ_INLINE int
+jq_bigint_cmp(const struct jq_bigint *a, const struct jq_bigint *b) {
+    int k;
+
+    if (a->size != b->size) return a->size < b->size ? -1 : 1;
+    for (k = a->size - 1; k >= 0; --k) {
+        if (a->limb[k] != b->limb[k]) return a->limb[k] < b->limb[k] ? -1 : 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Slow path for the numbers with too many digits. bits is the double for the
+ * truncated mantissa, the number is either it or the next double. All the digits
+ * are compared with the halfway point between them, both scaled to big integers.
+ */
+JQ_INLINE jq_uint64
+jq_number_slow(struct jq_handler *h, jq_uint64 bits) {
+    struct jq_bigint d, half;
+    const jq_char *p = h->val, *end = h->val + h->num_len;
+    jq_int64 dexp = 0, l2 = 0, r2;
+    jq_uint64 m;
+    jq_bool started = JQ_FALSE, point = JQ_FALSE, more = JQ_FALSE;
+    int ndigits = 0, chunk = 0;
+    unsigned int chunk_val = 0, chunk_mul = 1;
+    int cmp;
+
+    d.size = 0;
+    for (; p < end && *p != 'e' && *p != 'E'; ++p) {
+        int c = *p - '0';
+
+        if (*p == '.') { point = JQ_TRUE; continue; }
+        if (c < 0 || c > 9) continue; /* '-' */
+        if (!started && c == 0) {
+            if (point) --dexp;
+            continue;
+        }
+
+        started = JQ_TRUE;
+        if (ndigits < JQ_MAX_DIGITS) {
+            chunk_val = chunk_val * 10 + c;
+            chunk_mul *= 10;
+            if (++chunk == 9) {
+                jq_bigint_mul_add(&d, chunk_mul, chunk_val);
+                chunk = 0; chunk_val = 0; chunk_mul = 1;
+            }
+            ++ndigits;
+            if (point) --dexp;
+        } else {
+            if (c) more = JQ_TRUE;
+            if (!point) ++dexp;
+        }
+    }
+    if (chunk) jq_bigint_mul_add(&d, chunk_mul, chunk_val);
+    dexp += h->num_flags & JQ_N_EXP_NEGATIVE ? -h->num_exp : h->num_exp;
+
+    /* The halfway point is (2 * m + 1) * 2^(e - 1) */
+    if (bits >> 52) {
+        m = (bits & (((jq_uint64)1 << 52) - 1)) | ((jq_uint64)1 << 52);
+        r2 = (jq_int64)(bits >> 52) - 1075 - 1;
+    } else {
+        m = bits;
+        r2 = -1074 - 1;
+    }
+    m = 2 * m + 1;
+    half.limb[0] = (unsigned int)m;
+    half.limb[1] = (unsigned int)(m >> 32);
+    half.size = half.limb[1] ? 2 : 1;
+
+    /* digits * 10^dexp against half * 2^r2 */
+    if (dexp >= 0) {
+        jq_bigint_mul_pow5(&d, dexp);
+        l2 = dexp;
+    } else {
+        jq_bigint_mul_pow5(&half, -dexp);
+        r2 -= dexp;
+    }
+    if (l2 > r2) {
+        jq_bigint_shl(&d, l2 - r2);
+    } else if (r2 > l2) {
+        jq_bigint_shl(&half, r2 - l2);
+    }
+
+    cmp = jq_bigint_cmp(&d, &half);
+    if (cmp == 0 && more) cmp = 1;
+
+    /* Rounding to even if exactly halfway */
+    return cmp > 0 || (cmp == 0 && (bits & 1)) ? bits + 1 : bits;
+}
+
+JQ_API double
+jq_get_double(struct jq_handler *h) {
+    jq_uint64 w = h->num_mantissa, bits;
+    jq_int64 q = h->num_exp10 + (h->num_flags & JQ_N_EXP_NEGATIVE ? -h->num_exp : h->num_exp);
+    double d;
+
+    if (w == 0) {
+        d = 0.0;
+#if !defined(__FLT_EVAL_METHOD__) || __FLT_EVAL_METHOD__ == 0
+    } else if (!(h->num_flags & JQ_N_TRUNCATED) && w <= ((jq_uint64)1 << 53) && q >= -22 && q <= 22) {
+        /* Clinger's fast path, both w and 10^|q| are exact doubles so one operation rounds correctly */
+        d = (double)w;
+        d = q < 0 ? d / jq_pow10_double[-q] : d * jq_pow10_double[q];
+#endif
+    } else {
+        bits = jq_eisel_lemire(w, q);
+        if ((h->num_flags & JQ_N_TRUNCATED) && (w == JQ_UINT64_MAX || jq_eisel_lemire(w + 1, q) != bits)) {
+            bits = jq_number_slow(h, bits);
+        }
+        d = jq_double_from_bits(bits);
+    }
+
+    return h->num_flags & JQ_N_NEGATIVE ? -d : d;
+}
+
+#endif /* JQ_WITH_NUMBERS */
+
+/* ==========================================================================
+ *
+ * Structural index
+ *
+ * ========================================================================== */
+
+#ifdef JQ_WITH_INDEX
+
+#define JQ_INDEX_POS                    0x7fffffffu /* entry position relative to index_base */
+#define JQ_INDEX_ESCAPED                0x80000000u /* closing quote of a string with escapes */
+#define JQ_EVEN_BITS                    0x5555555555555555ull
+
+JQ_INLINE void
+jq_index_reset(struct jq_handler *h, jq_size pos) {
+    /* pos must be outside of any token, stage 1 starts from there */
+    h->index_size = 0;
+    h->index_pos = 0;
+    h->index_base = pos;
+    h->index_end = pos;
+    h->index_escaped = 0;
+    h->index_in_string = 0;
+    h->index_scalar = 0;
+    h->index_string_bs = JQ_FALSE;
+    h->index_after_scalar = JQ_FALSE;
+}
+
+JQ_API jq_bool
+jq_set_index(struct jq_handler *h, jq_index *index, jq_size cap) {
+    if (index && cap < 64) return JQ_FALSE;
+
+    h->index = index;
+    h->index_cap = cap;
+    jq_index_reset(h, h->i);
+
+    return JQ_TRUE;
+}
+
+JQ_INLINE jq_uint64
+jq_prefix_xor(jq_uint64 x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+/* Classifies 64 bytes, bit n of every mask stands for p[n] */
+JQ_INLINE void
+jq_index_classify(const unsigned char *p, jq_uint64 *quote, jq_uint64 *bs, jq_uint64 *op, jq_uint64 *ws) {
+#if defined(JQ_SIMD_AVX2)
+    int k;
+    *quote = *bs = *op = *ws = 0;
+    for (k = 0; k < 64; k += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + k));
+        /* '[' | 0x20 == '{' and ']' | 0x20 == '}' */
+        __m256i b = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        __m256i m;
+        m = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'));
+        *quote |= (jq_uint64)(unsigned int)_mm256_movemask_epi8(m) << k;
+        m = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'));
+        *bs |= (jq_uint64)(unsigned int)_mm256_movemask_epi8(m) << k;
+        m = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(b, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(b, _mm256_set1_epi8('}'))),
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(','))));
+        *op |= (jq_uint64)(unsigned int)_mm256_movemask_epi8(m) << k;
+        m = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))),
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))));
+        *ws |= (jq_uint64)(unsigned int)_mm256_movemask_epi8(m) << k;
+    }
+#elif defined(JQ_SIMD_SSE2)
+    int k;
+    *quote = *bs = *op = *ws = 0;
+    for (k = 0; k < 64; k += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + k));
+        /* '[' | 0x20 == '{' and ']' | 0x20 == '}' */
+        __m128i b = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        __m128i m;
+        m = _mm_cmpeq_epi8(v, _mm_set1_epi8('"'));
+        *quote |= (jq_uint64)(unsigned int)_mm_movemask_epi8(m) << k;
+        m = _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'));
+        *bs |= (jq_uint64)(unsigned int)_mm_movemask_epi8(m) << k;
+        m = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(b, _mm_set1_epi8('{')), _mm_cmpeq_epi8(b, _mm_set1_epi8('}'))),
+                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')), _mm_cmpeq_epi8(v, _mm_set1_epi8(','))));
+        *op |= (jq_uint64)(unsigned int)_mm_movemask_epi8(m) << k;
+        m = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))));
+        *ws |= (jq_uint64)(unsigned int)_mm_movemask_epi8(m) << k;
+    }
+#else
+    int k;
+    *quote = *bs = *op = *ws = 0;
+    for (k = 0; k < 64; ++k) {
+        jq_uint64 bit = (jq_uint64)1 << k;
+        switch (p[k]) {
+        case '"': *quote |= bit; break;
+        case '\\': *bs |= bit; break;
+        case '{': case '}': case '[': case ']': case ':': case ',': *op |= bit; break;
+        case ' ': case '\n': case '\r': case '\t': *ws |= bit; break;
+        }
+    }
+#endif
+}
+
+/* Chars following an odd sequence of backslashes, i.e. escaped ones */
+JQ_INLINE jq_uint64
+jq_index_escaped(struct jq_handler *h, jq_uint64 bs) {
+    jq_uint64 start_edges = bs & ~(bs << 1);
+    jq_uint64 even_start_mask = JQ_EVEN_BITS ^ h->index_escaped;
+    jq_uint64 even_starts = start_edges & even_start_mask;
+    jq_uint64 odd_starts = start_edges & ~even_start_mask;
+    jq_uint64 even_carries = bs + even_starts;
+    jq_uint64 odd_carries = bs + odd_starts;
+    jq_uint64 even_carry_ends, odd_carry_ends;
+    /* the carry out of an odd run means the next block starts escaped */
+    jq_uint64 carry = odd_carries < bs;
+
+    odd_carries |= h->index_escaped;
+    h->index_escaped = carry;
+    even_carry_ends = even_carries & ~bs;
+    odd_carry_ends = odd_carries & ~bs;
+
+    return (even_carry_ends & ~JQ_EVEN_BITS) | (odd_carry_ends & JQ_EVEN_BITS);
+}
+
+/* Stage 1, refills the index with the positions starting from index_end */
+JQ_API void
+jq_index_build(struct jq_handler *h) {
+    h->index_size = 0;
+    h->index_pos = 0;
+    h->index_base = h->index_end;
+
+    /* Every block can add up to 64 entries */
+    while (h->index_end < h->buf_size && h->index_size + 64 <= h->index_cap
+            && h->index_end - h->index_base <= JQ_INDEX_POS - 64) {
+        const unsigned char *p = (const unsigned char *)&h->buf[h->index_end];
+        unsigned char block[64];
+        jq_uint64 quote, bs, op, ws, in_string, scalar, string_bs, structural;
+        jq_uint64 lo = ~(jq_uint64)0; /* chars after the latest quote */
+        jq_size rel = h->index_end - h->index_base;
+
+        if (h->buf_size - h->index_end < 64) {
+            /* The last block is padded with whitespace */
+            jq_size n = h->buf_size - h->index_end, k;
+            for (k = 0; k < n; ++k) block[k] = p[k];
+            for (; k < 64; ++k) block[k] = ' ';
+            p = block;
+            h->index_end = h->buf_size;
+        } else {
+            h->index_end += 64;
+        }
+
+        jq_index_classify(p, &quote, &bs, &op, &ws);
+        quote &= ~jq_index_escaped(h, bs);
+        in_string = jq_prefix_xor(quote) ^ h->index_in_string;
+        h->index_in_string = 0 - (in_string >> 63);
+        string_bs = bs & in_string;
+
+        /* A scalar begins with a char which is not a part of another scalar */
+        scalar = ~(op | ws | quote);
+        structural = ((op | (scalar & ~(scalar << 1 | h->index_scalar))) & ~in_string) | quote;
+        h->index_scalar = scalar >> 63;
+
+        while (structural) {
+            int k = jq_ctz64(structural);
+            jq_uint64 bit = (jq_uint64)1 << k;
+            jq_index entry = (jq_index)(rel + k);
+
+            if (quote & bit) {
+                if (!(in_string & bit)) {
+                    /* Closing quote, the string is marked if it has escapes to be lexed */
+                    if (h->index_string_bs || (string_bs & lo & (bit - 1))) entry |= JQ_INDEX_ESCAPED;
+                    h->index_string_bs = JQ_FALSE;
+                }
+                lo = ~((bit << 1) - 1);
+            }
+
+            h->index[h->index_size++] = entry;
+            structural &= structural - 1;
+        }
+
+        if (in_string >> 63) {
+            h->index_string_bs |= (string_bs & lo) != 0;
+        }
+    }
+}
+
+/* Stage 2, returns the tokens found by the index, the rest is left to jq_get_token() */
+JQ_API enum jq_token_type
+jq_index_get_token(struct jq_handler *h) {
+    enum jq_token_type token;
+
+    /* After a scalar the next char is not trusted to be a delimiter, the lexer checks it */
+    if (h->lexer_state == JQ_L_NORMAL && !h->index_after_scalar) {
+#ifdef JQ_WITH_NULLTERM
+        /* Restoring previously saved char */
+        if (h->subst_char) {
+            h->buf[h->subst_pos] = h->subst_char;
+            h->subst_char = '\0';
+        }
+#endif
+
+        for (;;) {
+            jq_size pos;
+
+            if (h->index_pos == h->index_size) {
+                if (h->index_end == h->buf_size) {
+                    break; /* the rest is whitespace or the unfinished token */
+                }
+
+                jq_index_build(h);
+                continue;
+            }
+
+            pos = h->index_base + (h->index[h->index_pos] & JQ_INDEX_POS);
+            if (pos < h->i) {
+                ++h->index_pos; /* already read by jq_get_token() */
+                continue;
+            }
+
+            switch (h->buf[pos]) {
+            case '{': case '}': case '[': case ']': case ':': case ',':
+                ++h->index_pos;
+                jq_lexer_skip(h, pos + 1);
+                return (enum jq_token_type)h->buf[pos];
+
+            case '"':
+                if (h->index_pos + 1 < h->index_size && !(h->index[h->index_pos + 1] & JQ_INDEX_ESCAPED)) {
+                    jq_size end = h->index_base + (h->index[h->index_pos + 1] & JQ_INDEX_POS);
+
+#ifdef JQ_WITH_UTF8_CHECK
+                    /* Invalid strings are left to the lexer to report the error */
+                    h->utf8_state = JQ_UTF8_ACCEPT;
+                    if (jq_scan_string_utf8(h, pos + 1, end) != end || h->utf8_state != JQ_UTF8_ACCEPT) break;
+#endif
+
+                    h->index_pos += 2;
+                    jq_lexer_skip(h, end + 1);
+                    h->val = &h->buf[pos + 1];
+                    h->vlen = end - pos - 1;
+                    jq_lexer_terminate(h, end);
+
+                    return JQ_T_STRING;
+                }
+                break;
+            }
+
+            jq_lexer_skip(h, pos);
+            break;
+        }
+    }
+
+    token = jq_get_token(h);
+#ifdef JQ_WITH_UNESCAPE
+    if (token == JQ_T_STRING && h->index_end < h->i) {
+        /* The string decoded in place has changed the chars stage 1 has not reached yet */
+        jq_index_reset(h, h->i);
+    }
+#endif
+    h->index_after_scalar = token == JQ_T_NUMBER || token == JQ_T_NULL || token == JQ_T_TRUE || token == JQ_T_FALSE;
+
+    return token;
+}
+
+#endif /* JQ_WITH_INDEX */
+
+/* ==========================================================================
+ *
+ * Tape
+ *
+ * ========================================================================== */
+
+#ifdef JQ_WITH_TAPE
+
+#define jq_tape_word(type, payload) ((jq_uint64)(type) << 56 | (jq_uint64)(payload))
+
+JQ_API void
+jq_set_tape(struct jq_handler *h, jq_uint64 *tape, jq_size cap) {
+    h->tape = tape;
+    h->tape_cap = tape ? cap : 0;
+    h->tape_size = 0;
+    h->tape_open = 0;
+    h->tape_on = JQ_TRUE;
+}
+
+JQ_API jq_size
+jq_tape_next(const jq_uint64 *tape, jq_size i) {
+    switch (jq_tape_type(tape[i])) {
+    case JQ_TAPE_OBJECT_BEGIN: case JQ_TAPE_ARRAY_BEGIN:
+        return (jq_size)jq_tape_payload(tape[i]) + 1;
+
+    case JQ_TAPE_STRING: case JQ_TAPE_KEY: case JQ_TAPE_NUMBER:
+    case JQ_TAPE_INT64: case JQ_TAPE_UINT64: case JQ_TAPE_DOUBLE:
+        return i + 2;
+
+    default:
+        return i + 1;
+    }
+}
+
+JQ_API double
+jq_tape_double(jq_uint64 word) {
+    union { jq_uint64 u; double d; } v;
+    v.u = word;
+    return v.d;
+}
+
+/* Writes the entry of the event, in the size query mode only counts its words */
+JQ_INLINE jq_bool
+jq_tape_put(struct jq_handler *h, enum jq_event_type e) {
+    jq_size i = h->tape_size, n;
+    jq_uint64 *t = h->tape;
+
+    n = e == JQ_E_STRING || e == JQ_E_OBJECT_KEY || e == JQ_E_NUMBER ? 2 : 1;
+    h->tape_size += n;
+    if (!t) return JQ_TRUE;
+
+    if (h->tape_size > h->tape_cap) {
+        h->tape_size = i;
+        jq_set_error(h, JQ_ERR_TAPE_FULL);
+        return JQ_FALSE;
+    }
+
+    switch (e) {
+    case JQ_E_NULL: t[i] = jq_tape_word(JQ_TAPE_NULL, 0); break;
+    case JQ_E_TRUE: t[i] = jq_tape_word(JQ_TAPE_TRUE, 0); break;
+    case JQ_E_FALSE: t[i] = jq_tape_word(JQ_TAPE_FALSE, 0); break;
+
+    case JQ_E_STRING: case JQ_E_OBJECT_KEY:
+        t[i] = jq_tape_word(e == JQ_E_STRING ? JQ_TAPE_STRING : JQ_TAPE_KEY, h->buf_offset + (h->val - h->buf));
+        t[i + 1] = h->vlen;
+        break;
+
+    case JQ_E_NUMBER: {
+#ifdef JQ_WITH_NUMBERS
+        jq_int64 v;
+
+        if (jq_get_int64(h, &v)) {
+            t[i] = jq_tape_word(JQ_TAPE_INT64, 0);
+            t[i + 1] = (jq_uint64)v;
+        } else if (jq_get_uint64(h, &t[i + 1])) {
+            t[i] = jq_tape_word(JQ_TAPE_UINT64, 0);
+        } else {
+            union { double d; jq_uint64 u; } d;
+            d.d = jq_get_double(h);
+            t[i] = jq_tape_word(JQ_TAPE_DOUBLE, 0);
+            t[i + 1] = d.u;
+        }
+#else
+        t[i] = jq_tape_word(JQ_TAPE_NUMBER, h->buf_offset + (h->val - h->buf));
+        t[i + 1] = h->vlen;
+#endif
+        break;
+    }
+
+    case JQ_E_OBJECT_BEGIN: case JQ_E_ARRAY_BEGIN:
+        /* Until the end entry is met, the payload links to the enclosing begin entry */
+        t[i] = jq_tape_word(e, h->tape_open);
+        h->tape_open = i;
+        break;
+
+    case JQ_E_OBJECT_END: case JQ_E_ARRAY_END: {
+        jq_size begin = h->tape_open;
+
+        h->tape_open = (jq_size)jq_tape_payload(t[begin]);
+        t[begin] = jq_tape_word(jq_tape_type(t[begin]), i);
+        t[i] = jq_tape_word(e, begin);
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    return JQ_TRUE;
+}
+
+#endif /* JQ_WITH_TAPE */
+
+/* ==========================================================================
+ *
+ * Skipping
+ *
+ * ========================================================================== */
+
+/*
+ * Goes on skipping the value set up by jq_skip(), see it. Returns JQ_FALSE if the buf
+ * is over before the value, the state is kept in the handler for the next buf then.
+ */
+JQ_INLINE jq_bool
+jq_skip_scan(struct jq_handler *h) {
+    const jq_char *buf = h->buf;
+    jq_size i = h->i, size = h->buf_size;
+    jq_size depth = h->skip_depth;
+    enum jq_skip_state state = (enum jq_skip_state)h->skip_state;
+
+    jq_lexer_restore(h); /* it can be the next char to scan */
+
+    while (i < size) {
+        switch (state) {
+        case JQ_SKIP_VALUE:
+            i = jq_skip_whitespace(buf, i, size);
+            if (i == size) break;
+            if (buf[i] == ':') {
+                ++i;
+            } else if (buf[i] == '"') {
+                ++i;
+                state = JQ_SKIP_STRING;
+            } else if (buf[i] == '{' || buf[i] == '[') {
+                ++i;
+                depth = 1;
+                state = JQ_SKIP_NESTED;
+            } else {
+                state = JQ_SKIP_SCALAR;
+            }
+            break;
+
+        case JQ_SKIP_SCALAR:
+            while (i < size && !jq_iswc(buf[i]) && buf[i] != ',' && buf[i] != '}' && buf[i] != ']') ++i;
+            if (i < size) goto done;
+            break;
+
+        case JQ_SKIP_STRING:
+            i = jq_scan_string(buf, i, size);
+            if (i == size) break;
+            if (buf[i++] == '\\') {
+                state = JQ_SKIP_ESCAPE;
+            } else if (depth == 0) {
+                goto done;
+            } else {
+                state = JQ_SKIP_NESTED;
+            }
+            break;
+
+        case JQ_SKIP_ESCAPE:
+            ++i;
+            state = JQ_SKIP_STRING;
+            break;
+
+        case JQ_SKIP_NESTED:
+            i = jq_scan_brackets(buf, i, size);
+            if (i == size) break;
+            if (buf[i] == '"') {
+                state = JQ_SKIP_STRING;
+            } else if (buf[i] == '{' || buf[i] == '[') {
+                ++depth;
+            } else if (--depth == 0) {
+                /* The closing bracket of the rest of object or array is left to the parser */
+                if (!h->skip_rest) ++i;
+                goto done;
+            }
+            ++i;
+            break;
+
+        default:
+            goto done;
+        }
+    }
+
+    h->skip_state = state;
+    h->skip_depth = depth;
+    jq_lexer_skip(h, i);
+    jq_location_advance(h, i);
+#ifdef JQ_WITH_STATS
+    ++h->stats.need_more;
+#endif
+    jq_set_error(h, JQ_ERR_LEXER_NEED_MORE);
+    return JQ_FALSE;
+
+done:
+    h->skip_state = JQ_SKIP_NONE;
+    jq_lexer_skip(h, i);
+#ifdef JQ_WITH_INDEX
+    if (h->index) jq_index_reset(h, i);
+#endif
+    return JQ_TRUE;
+}
+
+/* ==========================================================================
+ *
+ * Statistics
+ *
+ * ========================================================================== */
+
+#ifdef JQ_WITH_STATS
+
+JQ_INLINE void
+jq_get_stats(const struct jq_handler *h, struct jq_stats *stats) {
+    *stats = h->stats;
+    stats->bytes = jq_get_offset(h) - h->stats_offset;
+}
+
+JQ_INLINE void
+jq_reset_stats(struct jq_handler *h) {
+    struct jq_stats *s = &h->stats;
+    int k;
+
+    s->bytes = s->tokens = s->documents = 0;
+    s->need_more = s->rewinds = s->tail_bytes = 0;
+    s->max_depth = 0;
+    s->nulls = s->trues = s->falses = s->strings = s->numbers = s->keys = s->objects = s->arrays = 0;
+    for (k = 0; k < JQ_STATS_BUCKETS; ++k) s->latency[k] = 0;
+    h->stats_offset = jq_get_offset(h);
+}
+
+JQ_INLINE void
+jq_set_stats_clock(struct jq_handler *h, jq_clock_callback clock) {
+    h->stats_clock = clock;
+    h->stats_open = JQ_FALSE; /* the document begun is not timed */
+}
+
+/* A document begins, its time is counted from here */
+JQ_INLINE void
+jq_stats_begin(struct jq_handler *h) {
+    if (h->stats_clock) h->stats_start = h->stats_clock();
+    h->stats_open = JQ_TRUE;
+}
+
+/* A document ends, its time goes to the bucket of its highest bit */
+JQ_INLINE void
+jq_stats_end(struct jq_handler *h) {
+    ++h->stats.documents;
+    if (h->stats_clock && h->stats_open) {
+        jq_uint64 t = h->stats_clock() - h->stats_start;
+        int k = 0;
+
+        while (t > 1 && k < JQ_STATS_BUCKETS - 1) {
+            t >>= 1;
+            ++k;
+        }
+        ++h->stats.latency[k];
+    }
+    h->stats_open = JQ_FALSE;
+}
+
+JQ_INLINE void
+jq_stats_event(struct jq_handler *h, enum jq_event_type e) {
+    switch (e) {
+    case JQ_E_NULL: ++h->stats.nulls; break;
+    case JQ_E_TRUE: ++h->stats.trues; break;
+    case JQ_E_FALSE: ++h->stats.falses; break;
+    case JQ_E_STRING: ++h->stats.strings; break;
+    case JQ_E_NUMBER: ++h->stats.numbers; break;
+    case JQ_E_OBJECT_KEY: ++h->stats.keys; break;
+    case JQ_E_OBJECT_BEGIN: ++h->stats.objects; break;
+    case JQ_E_ARRAY_BEGIN: ++h->stats.arrays; break;
+    default: break;
+    }
+}
+
+#endif /* JQ_WITH_STATS */
+
+/* ==========================================================================
+ *
+ * Location
+ *
+ * ========================================================================== */
+
+#ifdef JQ_WITH_LOCATION
+
+/* Returns the number of '\n' in buf from i to size */
+JQ_INLINE jq_size
+jq_count_newlines(const jq_char *buf, jq_size i, jq_size size) {
+    jq_size n = 0;
+
+#if defined(JQ_SIMD_AVX2)
+    while (i + 32 <= size) {
+        /* Every byte of acc counts up to 255 matches, then they are summed up */
+        __m256i acc = _mm256_setzero_si256();
+        int k;
+        for (k = 0; k < 255 && i + 32 <= size; ++k, i += 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(buf + i));
+            acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+        }
+        acc = _mm256_sad_epu8(acc, _mm256_setzero_si256());
+        n += (jq_size)_mm256_extract_epi64(acc, 0) + (jq_size)_mm256_extract_epi64(acc, 1)
+           + (jq_size)_mm256_extract_epi64(acc, 2) + (jq_size)_mm256_extract_epi64(acc, 3);
+    }
+#elif defined(JQ_SIMD_SSE2)
+    while (i + 16 <= size) {
+        /* Every byte of acc counts up to 255 matches, then they are summed up */
+        __m128i acc = _mm_setzero_si128();
+        int k;
+        for (k = 0; k < 255 && i + 16 <= size; ++k, i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(buf + i));
+            acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+        }
+        acc = _mm_sad_epu8(acc, _mm_setzero_si128());
+        n += (jq_size)_mm_cvtsi128_si32(acc) + (jq_size)_mm_extract_epi16(acc, 4);
+    }
+#endif
+    for (; i + 8 <= size; i += 8) {
+        /* One bit per '\n' goes to the lowest bit of its byte, the multiplication sums them */
+        jq_uint64 m = jq_swar_eq(jq_swar_load(buf + i), '\n') >> 7;
+        n += (jq_size)((m * JQ_SWAR_ONES) >> 56);
+    }
+
+    while (i < size) n += buf[i++] == '\n';
+    return n;
+}
+
+/*
+ * Counts the lines of buf up to pos, the input before h->loc_offset is counted already.
+ * The buffers before buf are counted when they end with JQ_ERR_LEXER_NEED_MORE, so
+ * loc_offset is in buf unless a buffer is appended before the previous one is done.
+ */
+JQ_INLINE void
+jq_location_advance(struct jq_handler *h, jq_size pos) {
+    jq_size from = h->loc_offset > h->buf_offset ? h->loc_offset - h->buf_offset : 0, j = pos;
+#ifdef JQ_WITH_NULLTERM
+    /* The '\n' after the latest value can be substituted with '\0' */
+    jq_bool subst = h->subst_char == '\n' && h->subst_pos >= from && h->subst_pos < pos;
+#endif
+
+    if (from >= pos) return;
+
+    h->loc_line += jq_count_newlines(h->buf, from, pos);
+    while (j > from && h->buf[j - 1] != '\n') --j;
+#ifdef JQ_WITH_NULLTERM
+    if (subst) {
+        ++h->loc_line;
+        if (h->subst_pos >= j) j = h->subst_pos + 1;
+    }
+#endif
+    if (j > from) h->loc_line_offset = h->buf_offset + j;
+    h->loc_offset = h->buf_offset + pos;
+}
+
+/* Counts the lines up to begin and moves over the chars from there to end, they have no line ends */
+JQ_INLINE void
+jq_location_jump(struct jq_handler *h, jq_size begin, jq_size end) {
+    jq_location_advance(h, begin);
+    h->loc_offset = h->buf_offset + end;
+}
+
+JQ_API struct jq_location
+jq_get_location(struct jq_handler *h) {
+    struct jq_location loc;
+    jq_size offset = jq_get_offset(h);
+
+    jq_location_advance(h, h->i);
+    loc.line = h->loc_line;
+    loc.column = offset > h->loc_line_offset ? offset - h->loc_line_offset : 0;
+
+    return loc;
+}
+
+#endif /* JQ_WITH_LOCATION */
+
+/* ==========================================================================
+ *
+ * Parser
+ *
+ * ========================================================================== */
+
+/* Forward declarations */
+JQ_INLINE enum jq_parser_state jq_parser_get_state(struct jq_handler *h);
+JQ_INLINE void jq_parser_set_state(struct jq_handler *h, enum jq_parser_state state);
+JQ_INLINE jq_bool jq_parser_push_state(struct jq_handler *h, enum jq_parser_state state);
+JQ_INLINE enum jq_parser_state jq_parser_pop_state(struct jq_handler *h);
+
+/* Bit n of the stack of JQ_STACK_WORDS words is 1 for an object and 0 for an array */
+#define jq_stack_object(stack, n) ((stack)[(n) / 64] >> (n) % 64 & 1)
+#define jq_stack_put(stack, n, object) \
+    ((object) ? ((stack)[(n) / 64] |= (jq_uint64)1 << (n) % 64) : ((stack)[(n) / 64] &= ~((jq_uint64)1 << (n) % 64)))
+
+/*
+ * h->cnt is the position inside the current object or array.
+ * Object: 0 - after '{', 1 - after key, 2 - after ':', 3 - after value, 4 - after ','
+ * Array: 0 - after '[', 1 - after value, 2 - after ','
+ */
+#define JQ_CNT_OBJECT_KEY               1
+#define JQ_CNT_OBJECT_COLON             2
+#define JQ_CNT_OBJECT_VALUE             3
+#define JQ_CNT_OBJECT_COMMA             4
+#define JQ_CNT_ARRAY_VALUE              1
+#define JQ_CNT_ARRAY_COMMA              2
+
+JQ_INLINE enum jq_token_type
+jq_next_token(struct jq_handler *h) {
+#ifdef JQ_WITH_INDEX
+    if (h->index) return jq_index_get_token(h);
+#endif
+    return jq_get_token(h);
+}
+
+JQ_INLINE enum jq_event_type
+jq_parser_error(struct jq_handler *h) {
+    jq_set_error(h, JQ_ERR_PARSER_UNEXPECTED_TOKEN);
+    return JQ_E_ERROR;
+}
+
+/* Returns the event writing it to the tape first */
+JQ_INLINE enum jq_event_type
+jq_parser_event(struct jq_handler *h, enum jq_event_type e) {
+#ifdef JQ_WITH_TAPE
+    if (h->tape_on && !jq_tape_put(h, e)) return JQ_E_ERROR;
+#endif
+#ifdef JQ_WITH_STATS
+    jq_stats_event(h, e);
+#endif
+#if !defined(JQ_WITH_TAPE) && !defined(JQ_WITH_STATS)
+    (void)h;
+#endif
+    return e;
+}
+
+/* Checks that a value can be placed here and moves the position after it */
+JQ_INLINE jq_bool
+jq_parser_value(struct jq_handler *h, enum jq_parser_state state) {
+    switch (state) {
+    case JQ_S_OBJECT:
+        if (h->cnt != JQ_CNT_OBJECT_COLON) return JQ_FALSE; /* Expected object key, ':', ',' or '}' */
+        h->cnt = JQ_CNT_OBJECT_VALUE;
+        return JQ_TRUE;
+
+    case JQ_S_ARRAY:
+        if (h->cnt == JQ_CNT_ARRAY_VALUE) return JQ_FALSE; /* Expected ',' or ']' */
+        h->cnt = JQ_CNT_ARRAY_VALUE;
+        return JQ_TRUE;
+
+    case JQ_S_UNDEFINED:
+        return JQ_TRUE;
+
+    default:
+        return JQ_FALSE; /* Only one value is allowed at the top level */
+    }
+}
+
+JQ_INLINE enum jq_event_type
+jq_next(struct jq_handler *h) {
+    enum jq_parser_state state = jq_parser_get_state(h);
+
+    switch (jq_get_error(h)) {
+    case JQ_ERR_OK: break;
+    case JQ_ERR_LEXER_NEED_MORE: return JQ_E_NEED_MORE;
+    default: return JQ_E_ERROR;
+    }
+
+    if (h->skip_state != JQ_SKIP_NONE) {
+        if (!jq_skip_scan(h)) return JQ_E_NEED_MORE;
+    }
+
+    if (h->multi && state == JQ_S_COMPLETE) {
+        jq_parser_set_state(h, JQ_S_UNDEFINED);
+        h->doc_open = JQ_FALSE;
+#ifdef JQ_WITH_STATS
+        jq_stats_end(h);
+#endif
+        return JQ_E_DOCUMENT_END;
+    }
+
+    if (h->multi && !h->doc_open) {
+        jq_size i = h->i;
+
+        jq_lexer_restore(h);
+        /* Between documents, RS of RFC 7464 json text sequences is whitespace too */
+        while ((i = jq_skip_whitespace(h->buf, i, h->buf_size)) < h->buf_size && h->buf[i] == 0x1e) ++i;
+        jq_lexer_skip(h, i);
+        if (i == h->buf_size) {
+            jq_location_advance(h, i);
+            return JQ_E_DONE;
+        }
+
+        h->doc_open = JQ_TRUE;
+        h->doc_offset = jq_get_offset(h);
+#ifdef JQ_WITH_STATS
+        jq_stats_begin(h);
+#endif
+#ifdef JQ_WITH_INDEX
+        if (h->index) jq_index_reset(h, i);
+#endif
+        return JQ_E_DOCUMENT_BEGIN;
+    }
+
+#ifdef JQ_WITH_STATS
+    if (!h->multi && state == JQ_S_UNDEFINED && !h->stats_open) jq_stats_begin(h);
+#endif
+
+    for (;;) {
+        enum jq_token_type token = jq_next_token(h);
+
+        JQ_PROFILE(h, JQ_PROFILE_TOKEN, token);
+#ifdef JQ_WITH_STATS
+        if (token != JQ_T_ERROR && token != JQ_T_NEED_MORE) ++h->stats.tokens;
+#endif
+        switch (token) {
+        case JQ_T_ERROR:
+            return JQ_E_ERROR; /* Lexer already set error */
+
+        case JQ_T_NEED_MORE:
+            if (state == JQ_S_COMPLETE && jq_get_tail_size(h) == 0) {
+                jq_reset_error(h); /* nothing but whitespace after the document */
+                return JQ_E_DONE;
+            }
+            return JQ_E_NEED_MORE; /* Lexer already set error */
+
+        case JQ_T_NULL: case JQ_T_TRUE: case JQ_T_FALSE: case JQ_T_NUMBER: case JQ_T_STRING:
+            if (state == JQ_S_OBJECT && token == JQ_T_STRING
+                    && (h->cnt == 0 || h->cnt == JQ_CNT_OBJECT_COMMA)) {
+                h->cnt = JQ_CNT_OBJECT_KEY;
+                return jq_parser_event(h, JQ_E_OBJECT_KEY);
+            }
+
+            if (!jq_parser_value(h, state)) return jq_parser_error(h);
+            if (state == JQ_S_UNDEFINED) {
+                jq_parser_set_state(h, JQ_S_COMPLETE); /* remembered for the next buffers */
+#ifdef JQ_WITH_STATS
+                if (!h->multi) jq_stats_end(h);
+#endif
+            }
+            return jq_parser_event(h, (enum jq_event_type)token);
+
+        case ':':
+            if (state != JQ_S_OBJECT || h->cnt != JQ_CNT_OBJECT_KEY) {
+                return jq_parser_error(h); /* Unexpected ':' */
+            }
+            h->cnt = JQ_CNT_OBJECT_COLON;
+            break;
+
+        case ',':
+            if (state == JQ_S_OBJECT && h->cnt == JQ_CNT_OBJECT_VALUE) {
+                h->cnt = JQ_CNT_OBJECT_COMMA;
+            } else if (state == JQ_S_ARRAY && h->cnt == JQ_CNT_ARRAY_VALUE) {
+                h->cnt = JQ_CNT_ARRAY_COMMA;
+            } else {
+                return jq_parser_error(h); /* Unexpected ',' */
+            }
+            break;
+
+        case '{': case '[':
+            if (!jq_parser_value(h, state)) return jq_parser_error(h);
+            /* The position in the enclosing object or array is restored when this one ends */
+            state = token == '{' ? JQ_S_OBJECT : JQ_S_ARRAY;
+            if (!jq_parser_push_state(h, state)) {
+                jq_set_error(h, JQ_ERR_MAX_DEPTH);
+                return JQ_E_ERROR;
+            }
+            h->cnt = 0;
+            return jq_parser_event(h, (enum jq_event_type)token);
+
+        case '}':
+            if (state != JQ_S_OBJECT || (h->cnt != 0 && h->cnt != JQ_CNT_OBJECT_VALUE)) {
+                return jq_parser_error(h); /* Unexpected '}' */
+            }
+            /* fall through */
+
+        case ']':
+            if (token == ']' && (state != JQ_S_ARRAY || h->cnt == JQ_CNT_ARRAY_COMMA)) {
+                return jq_parser_error(h); /* Unexpected ']' */
+            }
+
+            state = jq_parser_pop_state(h);
+            switch (state) {
+            case JQ_S_OBJECT: h->cnt = JQ_CNT_OBJECT_VALUE; break;
+            case JQ_S_ARRAY: h->cnt = JQ_CNT_ARRAY_VALUE; break;
+            default:
+                jq_parser_set_state(h, JQ_S_COMPLETE); /* remembered for the next buffers */
+#ifdef JQ_WITH_STATS
+                if (!h->multi) jq_stats_end(h);
+#endif
+                break;
+            }
+            return jq_parser_event(h, (enum jq_event_type)token);
+        }
+    }
+}
+
+JQ_INLINE void
+jq_skip(struct jq_handler *h) {
+    switch (jq_parser_get_state(h)) {
+    case JQ_S_OBJECT:
+        if (h->cnt == JQ_CNT_OBJECT_KEY) {
+#ifdef JQ_WITH_TAPE
+            if (h->tape_on) h->tape_size -= 2; /* the key goes along with its value */
+#endif
+            h->cnt = JQ_CNT_OBJECT_VALUE;
+            h->skip_state = JQ_SKIP_VALUE;
+            h->skip_rest = JQ_FALSE;
+            h->skip_depth = 0;
+            return;
+        }
+        h->cnt = 0;
+        break;
+
+    case JQ_S_ARRAY:
+        h->cnt = 0;
+        break;
+
+    default:
+        return;
+    }
+
+    h->skip_state = JQ_SKIP_NESTED;
+    h->skip_rest = JQ_TRUE;
+    h->skip_depth = 1;
+}
+
+JQ_API jq_bool
+jq_parse(struct jq_handler *h) {
+    if (jq_get_error(h) == JQ_ERR_STOPPED) {
+        jq_reset_error(h);
+    }
+
+    for (;;) {
+        enum jq_event_type e = jq_next(h);
+
+        switch (e) {
+        case JQ_E_DONE:
+            return JQ_TRUE;
+
+        case JQ_E_ERROR: case JQ_E_NEED_MORE:
+            return JQ_FALSE;
+
+        default:
+            JQ_PROFILE(h, JQ_PROFILE_CALLBACK, e);
+            if (h->control) {
+                switch (h->control(h, e)) {
+                case JQ_C_SKIP:
+                    jq_skip(h);
+                    break;
+                case JQ_C_STOP:
+                    jq_set_error(h, JQ_ERR_STOPPED);
+                    return JQ_FALSE;
+                default:
+                    break;
+                }
+            } else if (h->callback) {
+                h->callback(h, e);
+            }
+            break;
+        }
+    }
+}
+
+JQ_INLINE jq_bool
+jq_parse_buf(struct jq_handler *h, jq_char *src, jq_size sz) {
+    jq_append_buf(h, src, sz);
+    return jq_parse(h);
+}
+
+/*
+ * The state of the innermost level is h->state. The levels above the top one are
+ * objects or arrays only, so they are kept as the bits of h->stack, 1 for an object.
+ * The top level is JQ_S_UNDEFINED while there are levels above it.
+ */
+JQ_INLINE enum jq_parser_state
+jq_parser_get_state(struct jq_handler *h) {
+    return (enum jq_parser_state)h->state;
+}
+
+JQ_INLINE void
+jq_parser_set_state(struct jq_handler *h, enum jq_parser_state state) {
+    h->state = state;
+}
+
+/* Returns JQ_FALSE if the level would be JQ_STACK_SIZE deep */
+JQ_INLINE jq_bool
+jq_parser_push_state(struct jq_handler *h, enum jq_parser_state state) {
+    jq_size pos = h->stack_pos + 1;
+
+    if (pos >= JQ_STACK_SIZE) return JQ_FALSE;
+    jq_stack_put(h->stack, pos, state == JQ_S_OBJECT);
+    h->stack_pos = pos;
+    h->state = state;
+#ifdef JQ_WITH_STATS
+    if (pos > h->stats.max_depth) h->stats.max_depth = pos;
+#endif
+
+    return JQ_TRUE;
+}
+
+JQ_INLINE enum jq_parser_state
+jq_parser_pop_state(struct jq_handler *h) {
+    jq_size pos = --h->stack_pos;
+
+    if (pos == 0) {
+        h->state = JQ_S_UNDEFINED;
+    } else {
+        h->state = jq_stack_object(h->stack, pos) ? JQ_S_OBJECT : JQ_S_ARRAY;
+    }
+
+    return (enum jq_parser_state)h->state;
+}
+
+/* ==========================================================================
+ *
+ * Suspending
+ *
+ * ========================================================================== */
+
+#ifdef JQ_WITH_SUSPEND
+
+#define JQ_BLOB_VERSION                 1
+
+/* The blob of jq_suspend() is written with w or read from r */
+struct jq_blob {
+    unsigned char *w;                   /* blob written or JQ_NULL */
+    const unsigned char *r;             /* blob read or JQ_NULL */
+    jq_size size;                       /* blob size */
+    jq_size pos;                        /* position in the blob, it goes on past size while writing */
+    jq_bool bad;                        /* the blob read is broken */
+    jq_char *tail;                      /* memory the tail is read to */
+    jq_size tail_cap;                   /* size of this memory */
+};
+
+/* Writes v as 7 bits per byte, the high bit is set in all the bytes but the last, or reads it */
+JQ_INLINE jq_uint64
+jq_blob_value(struct jq_blob *b, jq_uint64 v) {
+    if (b->r) {
+        jq_uint64 r = 0;
+        int shift = 0;
+        unsigned char c;
+
+        do {
+            if (b->pos == b->size || shift > 63) {
+                b->bad = JQ_TRUE;
+                return 0;
+            }
+            c = b->r[b->pos++];
+            r |= (jq_uint64)(c & 0x7f) << shift;
+            shift += 7;
+        } while (c & 0x80);
+
+        return r;
+    } else {
+        jq_uint64 rest = v;
+
+        do {
+            unsigned char c = (unsigned char)(rest & 0x7f);
+            rest >>= 7;
+            if (rest) c |= 0x80;
+            if (b->pos < b->size) b->w[b->pos] = c;
+            ++b->pos;
+        } while (rest);
+
+        return v;
+    }
+}
+
+/* Writes or reads one byte as it is */
+JQ_INLINE unsigned char
+jq_blob_byte(struct jq_blob *b, unsigned char c) {
+    if (b->r) {
+        if (b->pos == b->size) {
+            b->bad = JQ_TRUE;
+            return 0;
+        }
+        return b->r[b->pos++];
+    }
+
+    if (b->pos < b->size) b->w[b->pos] = c;
+    ++b->pos;
+    return c;
+}
+
+/* The fields are written from and read to themselves */
+#define jq_blob_field(b, field, type) ((field) = (type)jq_blob_value((b), (jq_uint64)(field)))
+#define jq_blob_char(b, field) ((field) = (jq_char)jq_blob_value((b), (unsigned char)(field)))
+#define jq_blob_signed(b, field) \
+    ((field) = jq_blob_unzigzag(jq_blob_value((b), (jq_uint64)(field) << 1 ^ ((field) < 0 ? ~(jq_uint64)0 : 0))))
+#define jq_blob_unzigzag(u) ((jq_int64)((u) >> 1) ^ -(jq_int64)((u) & 1))
+
+/* Writes the state of the handler to the blob or reads it from there, the tail goes last */
+JQ_INLINE void
+jq_blob_sync(struct jq_handler *h, struct jq_blob *b) {
+    jq_uint64 features = 0, flags;
+    jq_size offset = jq_get_offset(h), tail_size = jq_get_tail_size(h), k;
+
+    /* The fields below depend on these options */
+#ifdef JQ_WITH_UTF8_CHECK
+    features |= 1;
+#endif
+#ifdef JQ_WITH_UNESCAPE
+    features |= 2;
+#endif
+#ifdef JQ_WITH_NUMBERS
+    features |= 4;
+#endif
+#ifdef JQ_WITH_LOCATION
+    features |= 8;
+#endif
+#ifdef JQ_WITH_STATS
+    features |= 16;
+#endif
+    if (jq_blob_value(b, JQ_BLOB_VERSION) != JQ_BLOB_VERSION || jq_blob_value(b, features) != features) {
+        b->bad = JQ_TRUE;
+        return;
+    }
+
+    jq_blob_field(b, h->error, enum jq_error);
+    jq_blob_char(b, h->state);
+    jq_blob_char(b, h->cnt);
+    jq_blob_char(b, h->lexer_state);
+    jq_blob_char(b, h->nft_cnt);
+    jq_blob_char(b, h->skip_state);
+    flags = jq_blob_value(b, (jq_uint64)(h->multi ? 1 : 0) | (h->doc_open ? 2 : 0) | (h->readonly ? 4 : 0)
+            | (h->skip_rest ? 8 : 0) | (h->input_end ? 16 : 0));
+    h->multi = (flags & 1) != 0;
+    h->doc_open = (flags & 2) != 0;
+    h->readonly = (flags & 4) != 0;
+    h->skip_rest = (flags & 8) != 0;
+    h->input_end = (flags & 16) != 0;
+    jq_blob_field(b, offset, jq_size);
+    jq_blob_field(b, h->doc_offset, jq_size);
+    jq_blob_field(b, h->lexed, jq_size);
+    jq_blob_field(b, h->skip_depth, jq_size);
+
+    /* The levels above the top one, 8 per byte */
+    jq_blob_field(b, h->stack_pos, jq_size);
+    if (h->stack_pos >= JQ_STACK_SIZE) {
+        b->bad = JQ_TRUE;
+        return;
+    }
+    for (k = 0; k <= h->stack_pos / 8; ++k) {
+        unsigned char c = 0;
+
+        if (!b->r) {
+            c = (unsigned char)(h->stack[k / 8] >> k % 8 * 8);
+            /* The bits above the top level are left by the levels closed, they are not kept */
+            if (k == h->stack_pos / 8) c &= (unsigned char)((2u << h->stack_pos % 8) - 1);
+        }
+        c = jq_blob_byte(b, c);
+        if (b->r) h->stack[k / 8] = (k % 8 ? h->stack[k / 8] : 0) | (jq_uint64)c << k % 8 * 8;
+    }
+
+#ifdef JQ_WITH_UTF8_CHECK
+    jq_blob_char(b, h->utf8_state);
+#endif
+#ifdef JQ_WITH_UNESCAPE
+    jq_blob_field(b, h->unesc_len, jq_size);
+    jq_blob_field(b, h->unesc_src, jq_size);
+    jq_blob_field(b, h->unesc_cp, unsigned long);
+    jq_blob_field(b, h->unesc_hi, unsigned long);
+  #ifdef JQ_WITH_LOCATION
+    jq_blob_field(b, h->unesc_newline, jq_bool);
+  #endif
+#endif
+#ifdef JQ_WITH_NUMBERS
+    jq_blob_field(b, h->num_mantissa, jq_uint64);
+    jq_blob_signed(b, h->num_exp10);
+    jq_blob_signed(b, h->num_exp);
+    jq_blob_field(b, h->num_len, jq_size);
+    jq_blob_char(b, h->num_flags);
+#endif
+#ifdef JQ_WITH_LOCATION
+    jq_blob_field(b, h->loc_offset, jq_size);
+    jq_blob_field(b, h->loc_line, jq_size);
+    jq_blob_field(b, h->loc_line_offset, jq_size);
+#endif
+#ifdef JQ_WITH_STATS
+    jq_blob_field(b, h->stats.tokens, jq_uint64);
+    jq_blob_field(b, h->stats.documents, jq_uint64);
+    jq_blob_field(b, h->stats.need_more, jq_uint64);
+    jq_blob_field(b, h->stats.rewinds, jq_uint64);
+    jq_blob_field(b, h->stats.tail_bytes, jq_uint64);
+    jq_blob_field(b, h->stats.max_depth, jq_size);
+    jq_blob_field(b, h->stats.nulls, jq_uint64);
+    jq_blob_field(b, h->stats.trues, jq_uint64);
+    jq_blob_field(b, h->stats.falses, jq_uint64);
+    jq_blob_field(b, h->stats.strings, jq_uint64);
+    jq_blob_field(b, h->stats.numbers, jq_uint64);
+    jq_blob_field(b, h->stats.keys, jq_uint64);
+    jq_blob_field(b, h->stats.objects, jq_uint64);
+    jq_blob_field(b, h->stats.arrays, jq_uint64);
+    for (k = 0; k < JQ_STATS_BUCKETS; ++k) jq_blob_field(b, h->stats.latency[k], jq_uint64);
+    jq_blob_field(b, h->stats_offset, jq_size);
+    jq_blob_field(b, h->stats_start, jq_uint64);
+    jq_blob_field(b, h->stats_open, jq_bool);
+#endif
+
+    /* The tail is copied to the memory given, the blob is not needed after it */
+    jq_blob_field(b, tail_size, jq_size);
+    if (b->r) {
+        if (b->bad || b->size - b->pos != tail_size || tail_size > b->tail_cap) {
+            b->bad = JQ_TRUE;
+            return;
+        }
+        for (k = 0; k < tail_size; ++k) b->tail[k] = (jq_char)b->r[b->pos + k];
+        h->buf = b->tail;
+        h->buf_size = tail_size;
+        h->i = 0;
+        h->buf_offset = offset;
+    } else {
+        for (k = 0; k < tail_size; ++k) jq_blob_byte(b, (unsigned char)h->buf[h->i + k]);
+    }
+}
+
+JQ_API jq_size
+jq_suspend(struct jq_handler *h, jq_char *blob, jq_size size) {
+    struct jq_blob b;
+
+    /* The handler must wait for the next buffer, which starts with the tail */
+    if (jq_get_error(h) != JQ_ERR_LEXER_NEED_MORE && (jq_get_error(h) != JQ_ERR_OK || jq_get_tail_size(h) != 0)) {
+        return 0;
+    }
+#ifdef JQ_WITH_TAPE
+    if (h->tape_on) return 0;
+#endif
+
+    b.w = (unsigned char *)blob;
+    b.r = JQ_NULL;
+    b.size = blob ? size : 0;
+    b.pos = 0;
+    b.bad = JQ_FALSE;
+    b.tail = JQ_NULL;
+    b.tail_cap = 0;
+    jq_blob_sync(h, &b);
+
+    return b.pos;
+}
+
+JQ_API jq_bool
+jq_resume(struct jq_handler *h, const jq_char *blob, jq_size size, jq_char *buf, jq_size buf_size) {
+    struct jq_blob b;
+
+    b.w = JQ_NULL;
+    b.r = (const unsigned char *)blob;
+    b.size = size;
+    b.pos = 0;
+    b.bad = !blob;
+    b.tail = buf;
+    b.tail_cap = buf ? buf_size : 0;
+
+    jq_init(h);
+    if (!b.bad) jq_blob_sync(h, &b);
+
+    /* The states are checked, so a broken blob can't lead the lexer out of the tail */
+    if (b.bad || (h->error != JQ_ERR_OK && h->error != JQ_ERR_LEXER_NEED_MORE)
+            || (unsigned char)h->state > JQ_S_COMPLETE || (unsigned char)h->cnt > JQ_CNT_OBJECT_COMMA
+            || (unsigned char)h->lexer_state > JQ_L_NUM_EXPO_INT || (unsigned char)h->skip_state > JQ_SKIP_ESCAPE
+            || (h->stack_pos == 0) != (h->state != JQ_S_OBJECT && h->state != JQ_S_ARRAY)
+            || h->lexed > h->buf_size || (h->lexer_state != JQ_L_NORMAL) != (h->lexed != 0)
+#ifdef JQ_WITH_UTF8_CHECK
+            || (unsigned char)h->utf8_state >= sizeof(jq_utf8_next) / sizeof(jq_utf8_next[0])
+#endif
+#ifdef JQ_WITH_UNESCAPE
+            || (h->lexer_state >= JQ_L_STRING && h->lexer_state <= JQ_L_UNICODE
+                && (h->unesc_len > h->unesc_src || h->unesc_src > h->lexed))
+#endif
+            ) {
+        jq_init(h);
+        return JQ_FALSE;
+    }
+
+    return JQ_TRUE;
+}
+
+#endif /* JQ_WITH_SUSPEND */
+
+/* ==========================================================================
+ *
+ * Validation
+ *
+ * ========================================================================== */
+
+/* Returns position of the first non whitespace char, the single spaces between the tokens are skipped first */
+JQ_INLINE jq_size
+jq_validate_skip(const jq_char *buf, jq_size i, jq_size sz) {
+    if (i < sz && !jq_iswc(buf[i])) return i;
+    if (i + 1 < sz && !jq_iswc(buf[i + 1])) return i + 1;
+    return jq_skip_whitespace(buf, i, sz);
+}
+
+/* Returns the position after the closing quote of the string, i is the one after the opening quote */
+JQ_INLINE jq_size
+jq_validate_string(const jq_char *buf, jq_size i, jq_size sz, enum jq_error *e) {
+#ifdef JQ_WITH_UTF8_CHECK
+    unsigned char state = JQ_UTF8_ACCEPT;
+#endif
+    int n;
+
+    for (;;) {
+        unsigned char c;
+
+#ifdef JQ_WITH_UTF8_CHECK
+        if (state == JQ_UTF8_ACCEPT) i = jq_scan_ascii(buf, i, sz);
+#else
+        i = jq_scan_string(buf, i, sz);
+#endif
+        if (i == sz) {
+            *e = JQ_ERR_LEXER_NEED_MORE;
+            return i;
+        }
+
+        c = (unsigned char)buf[i];
+#ifdef JQ_WITH_UTF8_CHECK
+        if (c < 0x20) {
+            *e = JQ_ERR_LEXER_CONTROL_CHAR;
+            return i;
+        }
+        if (c >= 0x80 || state != JQ_UTF8_ACCEPT) {
+            state = jq_utf8_step(state, c);
+            if (state == JQ_UTF8_REJECT) {
+                *e = JQ_ERR_LEXER_INVALID_UTF8;
+                return i;
+            }
+            ++i;
+            continue;
+        }
+#endif
+        ++i;
+        if (c == '"') return i;
+
+        /* The escape sequence after '\\' */
+        if (i == sz) {
+            *e = JQ_ERR_LEXER_NEED_MORE;
+            return i;
+        }
+        if (buf[i] != 'u') {
+            if (!jq_isesc(buf[i])) {
+                *e = JQ_ERR_LEXER_UNKNOWN_ESCAPE_SYMBOL;
+                return i;
+            }
+            ++i;
+            continue;
+        }
+        for (n = 0; n < 4; ++n) {
+            if (++i == sz) {
+                *e = JQ_ERR_LEXER_NEED_MORE;
+                return i;
+            }
+            if (!jq_ishex(buf[i])) {
+                *e = JQ_ERR_LEXER_UNKNOWN_ESCAPE_SYMBOL;
+                return i;
+            }
+        }
+        ++i;
+    }
+}
+
+/* Returns the position after the digits starting from i */
+JQ_INLINE jq_size
+jq_validate_digits(const jq_char *buf, jq_size i, jq_size sz) {
+    while (i < sz && jq_isdigit(buf[i])) ++i;
+    return i;
+}
+
+/* Returns the position after the number starting at i */
+JQ_INLINE jq_size
+jq_validate_number(const jq_char *buf, jq_size i, jq_size sz, enum jq_error *e) {
+    if (buf[i] == '-') ++i;
+    if (i < sz && buf[i] == '0') {
+        ++i;
+    } else if (i < sz && jq_isint(buf[i])) {
+        i = jq_validate_digits(buf, i + 1, sz);
+    } else {
+        /* Nothing found after '-' */
+        *e = i == sz ? JQ_ERR_LEXER_NEED_MORE : JQ_ERR_LEXER_UNKNOWN_TOKEN;
+        return i;
+    }
+
+    if (i < sz && buf[i] == '.') {
+        if (++i == sz || !jq_isdigit(buf[i])) {
+            *e = i == sz ? JQ_ERR_LEXER_NEED_MORE : JQ_ERR_LEXER_UNKNOWN_TOKEN;
+            return i;
+        }
+        i = jq_validate_digits(buf, i + 1, sz);
+    }
+
+    if (i < sz && jq_isexp(buf[i])) {
+        if (++i < sz && jq_issign(buf[i])) ++i;
+        if (i == sz || !jq_isdigit(buf[i])) {
+            *e = i == sz ? JQ_ERR_LEXER_NEED_MORE : JQ_ERR_LEXER_EXPONENT_ERROR;
+            return i;
+        }
+        i = jq_validate_digits(buf, i + 1, sz);
+    }
+
+    return i;
+}
+
+/* Returns the position after null, true or false starting at i */
+JQ_INLINE jq_size
+jq_validate_literal(const jq_char *buf, jq_size i, jq_size sz, const char *lit, enum jq_error *e) {
+    for (; *lit; ++lit, ++i) {
+        if (i == sz) {
+            *e = JQ_ERR_LEXER_NEED_MORE;
+            return i;
+        }
+        if (buf[i] != *lit) {
+            *e = JQ_ERR_LEXER_UNKNOWN_TOKEN;
+            return i;
+        }
+    }
+
+    return i;
+}
+
+/* The error at the char which is not expected there, the lexer reads the token before the parser gets it */
+JQ_INLINE jq_size
+jq_validate_unexpected(const jq_char *buf, jq_size i, jq_size sz, enum jq_error *e) {
+    jq_size end = i;
+
+    switch (buf[i]) {
+    case '{': case '}': case '[': case ']': case ':': case ',': break;
+    case '"': end = jq_validate_string(buf, i + 1, sz, e); break;
+    case 'n': end = jq_validate_literal(buf, i, sz, "null", e); break;
+    case 't': end = jq_validate_literal(buf, i, sz, "true", e); break;
+    case 'f': end = jq_validate_literal(buf, i, sz, "false", e); break;
+    default:
+        if (!jq_isnum(buf[i])) {
+            *e = JQ_ERR_LEXER_UNKNOWN_TOKEN;
+            return i;
+        }
+        end = jq_validate_number(buf, i, sz, e);
+    }
+    if (*e != JQ_ERR_OK) return end;
+
+    *e = JQ_ERR_PARSER_UNEXPECTED_TOKEN;
+    return i;
+}
+
+/* Returns the position after ':' of the object key starting from i */
+JQ_INLINE jq_size
+jq_validate_key(const jq_char *buf, jq_size i, jq_size sz, enum jq_error *e) {
+    i = jq_validate_skip(buf, i, sz);
+    if (i == sz) {
+        *e = JQ_ERR_LEXER_NEED_MORE;
+        return i;
+    }
+    if (buf[i] != '"') return jq_validate_unexpected(buf, i, sz, e);
+    i = jq_validate_string(buf, i + 1, sz, e);
+    if (*e != JQ_ERR_OK) return i;
+
+    i = jq_validate_skip(buf, i, sz);
+    if (i == sz) {
+        *e = JQ_ERR_LEXER_NEED_MORE;
+        return i;
+    }
+    if (buf[i] != ':') return jq_validate_unexpected(buf, i, sz, e);
+
+    return i + 1;
+}
+
+/* The closing char of the object or array at the depth, the objects are the bits set */
+#define jq_validate_close(objects, depth) \
+    ((depth) && (objects)[((depth) - 1) / 64] >> ((depth) - 1) % 64 & 1 ? '}' : ']')
+
+JQ_API enum jq_error
+jq_validate(const jq_char *buf, jq_size sz, jq_size *offset) {
+    /* The objects and arrays not closed yet are the bits, 1 for an object */
+    jq_uint64 objects[JQ_STACK_WORDS] = { 0 };
+    jq_size depth = 0, i = 0;
+    jq_char close = ']';
+    enum jq_error e = JQ_ERR_OK;
+
+    while (e == JQ_ERR_OK) {
+        /* A value */
+        i = jq_validate_skip(buf, i, sz);
+        if (i == sz) {
+            e = JQ_ERR_LEXER_NEED_MORE;
+            break;
+        }
+
+        switch (buf[i]) {
+        case '{': case '[':
+            if (depth + 1 >= JQ_STACK_SIZE) {
+                e = JQ_ERR_MAX_DEPTH;
+                break;
+            }
+            if (buf[i] == '{') {
+                objects[depth / 64] |= (jq_uint64)1 << depth % 64;
+                close = '}';
+            } else {
+                objects[depth / 64] &= ~((jq_uint64)1 << depth % 64);
+                close = ']';
+            }
+            ++depth;
+
+            i = jq_validate_skip(buf, i + 1, sz);
+            if (i < sz && buf[i] == close) {
+                /* Empty */
+                ++i;
+                --depth;
+                close = jq_validate_close(objects, depth);
+                break;
+            }
+            if (close == '}') i = jq_validate_key(buf, i, sz, &e);
+            continue;
+
+        case '"':
+            i = jq_validate_string(buf, i + 1, sz, &e);
+            break;
+
+        case 'n':
+            i = jq_validate_literal(buf, i, sz, "null", &e);
+            break;
+
+        case 't':
+            i = jq_validate_literal(buf, i, sz, "true", &e);
+            break;
+
+        case 'f':
+            i = jq_validate_literal(buf, i, sz, "false", &e);
+            break;
+
+        default:
+            i = jq_isnum(buf[i]) ? jq_validate_number(buf, i, sz, &e) : jq_validate_unexpected(buf, i, sz, &e);
+        }
+
+        /* After the value, the objects and arrays closed go after it too */
+        while (e == JQ_ERR_OK) {
+            i = jq_validate_skip(buf, i, sz);
+            if (depth == 0) {
+                if (i < sz) i = jq_validate_unexpected(buf, i, sz, &e);
+                break;
+            }
+            if (i == sz) {
+                e = JQ_ERR_LEXER_NEED_MORE;
+            } else if (buf[i] == ',') {
+                if (close == '}') {
+                    i = jq_validate_key(buf, i + 1, sz, &e);
+                } else {
+                    ++i;
+                }
+                break;
+            } else if (buf[i] == close) {
+                ++i;
+                --depth;
+                close = jq_validate_close(objects, depth);
+            } else {
+                i = jq_validate_unexpected(buf, i, sz, &e);
+            }
+        }
+        if (e == JQ_ERR_OK && depth == 0) break;
+    }
+
+    if (offset) *offset = i;
+
+    return e;
+}
+
+/* ==========================================================================
+ *
+ * Writer
+ *
  * ========================================================================== */
 
-#ifdef JQ_WITH_IMPLEMENTATION
+#ifdef JQ_WITH_WRITER
+
+/* Returns position of the first '"', '\\' or control char in buf starting from i, or size */
+JQ_INLINE jq_size
+jq_scan_escape(const jq_char *buf, jq_size i, jq_size size) {
+#if defined(JQ_SIMD_AVX2)
+    for (; i + 32 <= size; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(buf + i));
+        /* Unsigned v <= 0x1f, the bytes from 0x80 are not control chars */
+        __m256i m = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+                _mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8(0x1f)), _mm256_set1_epi8(0x1f)));
+        unsigned int bits = (unsigned int)_mm256_movemask_epi8(m);
+        if (bits) return i + jq_ctz64(bits);
+    }
+#elif defined(JQ_SIMD_SSE2)
+    for (; i + 16 <= size; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(buf + i));
+        /* Unsigned v <= 0x1f, the bytes from 0x80 are not control chars */
+        __m128i m = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+                _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(0x1f)), _mm_set1_epi8(0x1f)));
+        unsigned int bits = (unsigned int)_mm_movemask_epi8(m);
+        if (bits) return i + jq_ctz64(bits);
+    }
+#endif
+    for (; i + 8 <= size; i += 8) {
+        jq_uint64 v = jq_swar_load(buf + i);
+        /* Bytes below 0x20 may give false positives above the first one only */
+        jq_uint64 m = jq_swar_eq(v, '"') | jq_swar_eq(v, '\\') | ((v - JQ_SWAR_ONES * 0x20) & ~v & JQ_SWAR_HIGHS);
+        if (m) return i + (jq_ctz64(m) >> 3);
+    }
+
+    while (i < size && buf[i] != '"' && buf[i] != '\\' && (unsigned char)buf[i] >= 0x20) ++i;
+    return i;
+}
+
+JQ_API jq_bool
+jq_writer_init(struct jq_writer *w, jq_char *buf, jq_size size, jq_flush_callback flush, void *udata) {
+    w->buf = buf;
+    w->buf_size = size;
+    w->i = 0;
+    w->depth = 0;
+    w->sep = '\0';
+#ifdef JQ_WITH_WRITER_CHECK
+    w->cnt = 0;
+    memset(w->stack, 0, sizeof(w->stack));
+#endif
+    w->flush = flush;
+    w->udata = udata;
+    w->error = JQ_ERR_OK;
+
+    if (!buf || !size) {
+        jq_set_error(w, JQ_ERR_WRITER_FLUSH);
+        return JQ_FALSE;
+    }
+
+    return JQ_TRUE;
+}
+
+JQ_API jq_bool
+jq_writer_flush(struct jq_writer *w) {
+    if (jq_get_error(w) != JQ_ERR_OK) return JQ_FALSE;
+    /* Without the callback the output stays in buf */
+    if (w->i == 0 || !w->flush) return JQ_TRUE;
+
+    if (!w->flush(w->udata, w->buf, w->i)) {
+        jq_set_error(w, JQ_ERR_WRITER_FLUSH);
+        return JQ_FALSE;
+    }
+    w->i = 0;
+
+    return JQ_TRUE;
+}
+
+/* Empties the full buffer, it can't be done without the callback */
+JQ_INLINE jq_bool
+jq_writer_spill(struct jq_writer *w) {
+    if (!w->flush) {
+        jq_set_error(w, JQ_ERR_WRITER_FLUSH);
+        return JQ_FALSE;
+    }
+
+    return jq_writer_flush(w);
+}
+
+/* Copies n chars to buf flushing it as many times as needed */
+JQ_INLINE jq_bool
+jq_writer_put(struct jq_writer *w, const jq_char *s, jq_size n) {
+    while (n > w->buf_size - w->i) {
+        jq_size part = w->buf_size - w->i;
+
+        memcpy(w->buf + w->i, s, part);
+        w->i += part;
+        s += part;
+        n -= part;
+        if (!jq_writer_spill(w)) return JQ_FALSE;
+    }
+    memcpy(w->buf + w->i, s, n);
+    w->i += n;
+
+    return JQ_TRUE;
+}
+
+JQ_INLINE jq_bool
+jq_writer_putc(struct jq_writer *w, jq_char c) {
+    if (w->i == w->buf_size && !jq_writer_spill(w)) return JQ_FALSE;
+    w->buf[w->i++] = c;
+
+    return JQ_TRUE;
+}
+
+#ifdef JQ_WITH_WRITER_CHECK
+/* Checks that a key (or a value if key is JQ_FALSE) can be written and moves the state on */
+JQ_INLINE jq_bool
+jq_writer_check(struct jq_writer *w, jq_bool key) {
+    jq_bool object = w->depth && jq_stack_object(w->stack, w->depth);
+
+    if (key ? !object || w->cnt == JQ_CNT_OBJECT_KEY : object && w->cnt != JQ_CNT_OBJECT_KEY) {
+        jq_set_error(w, JQ_ERR_WRITER_UNEXPECTED);
+        return JQ_FALSE;
+    }
+    w->cnt = key ? JQ_CNT_OBJECT_KEY : JQ_CNT_OBJECT_VALUE;
+
+    return JQ_TRUE;
+}
+#endif
+
+/* Writes the separator before a value or a key */
+JQ_INLINE jq_bool
+jq_writer_begin_value(struct jq_writer *w, jq_bool key) {
+    if (jq_get_error(w) != JQ_ERR_OK) return JQ_FALSE;
+#ifdef JQ_WITH_WRITER_CHECK
+    if (!jq_writer_check(w, key)) return JQ_FALSE;
+#else
+    (void)key;
+#endif
+    if (w->sep && !jq_writer_putc(w, w->sep)) return JQ_FALSE;
+    w->sep = w->depth ? ',' : '\n';
+
+    return JQ_TRUE;
+}
+
+JQ_INLINE jq_bool
+jq_writer_begin(struct jq_writer *w, enum jq_parser_state state, jq_char c) {
+    if (!jq_writer_begin_value(w, JQ_FALSE)) return JQ_FALSE;
+#ifdef JQ_WITH_WRITER_CHECK
+    if (w->depth + 1 >= JQ_STACK_SIZE) {
+        jq_set_error(w, JQ_ERR_MAX_DEPTH);
+        return JQ_FALSE;
+    }
+    jq_stack_put(w->stack, w->depth + 1, state == JQ_S_OBJECT);
+    w->cnt = JQ_CNT_OBJECT_VALUE;
+#else
+    (void)state;
+#endif
+    ++w->depth;
+    w->sep = '\0';
+
+    return jq_writer_putc(w, c);
+}
+
+JQ_INLINE jq_bool
+jq_writer_end(struct jq_writer *w, enum jq_parser_state state, jq_char c) {
+    if (jq_get_error(w) != JQ_ERR_OK) return JQ_FALSE;
+#ifdef JQ_WITH_WRITER_CHECK
+    /* An object can't end after a key */
+    if (w->depth == 0 || jq_stack_object(w->stack, w->depth) != (state == JQ_S_OBJECT) || w->cnt == JQ_CNT_OBJECT_KEY) {
+        jq_set_error(w, JQ_ERR_WRITER_UNEXPECTED);
+        return JQ_FALSE;
+    }
+    w->cnt = JQ_CNT_OBJECT_VALUE;
+#else
+    (void)state;
+#endif
+    --w->depth;
+    w->sep = w->depth ? ',' : '\n';
+
+    return jq_writer_putc(w, c);
+}
+
+JQ_API jq_bool
+jq_write_object_begin(struct jq_writer *w) {
+    return jq_writer_begin(w, JQ_S_OBJECT, '{');
+}
+
+JQ_API jq_bool
+jq_write_object_end(struct jq_writer *w) {
+    return jq_writer_end(w, JQ_S_OBJECT, '}');
+}
+
+JQ_API jq_bool
+jq_write_array_begin(struct jq_writer *w) {
+    return jq_writer_begin(w, JQ_S_ARRAY, '[');
+}
+
+JQ_API jq_bool
+jq_write_array_end(struct jq_writer *w) {
+    return jq_writer_end(w, JQ_S_ARRAY, ']');
+}
+
+/* Writes the string in quotes, the runs of chars which need no escaping are copied at once */
+JQ_INLINE jq_bool
+jq_writer_string(struct jq_writer *w, const jq_char *s, jq_size len) {
+    static const char hex[] = "0123456789abcdef";
+    jq_size i = 0;
+
+    if (!jq_writer_putc(w, '"')) return JQ_FALSE;
+
+    for (;;) {
+        jq_size end = jq_scan_escape(s, i, len);
+        unsigned char c;
+        jq_char esc[6];
+        jq_size n = 2;
+
+        if (!jq_writer_put(w, s + i, end - i)) return JQ_FALSE;
+        if (end == len) break;
+
+        c = (unsigned char)s[end];
+        esc[0] = '\\';
+        switch (c) {
+        case '"': esc[1] = '"'; break;
+        case '\\': esc[1] = '\\'; break;
+        case '\b': esc[1] = 'b'; break;
+        case '\f': esc[1] = 'f'; break;
+        case '\n': esc[1] = 'n'; break;
+        case '\r': esc[1] = 'r'; break;
+        case '\t': esc[1] = 't'; break;
+        default:
+            esc[1] = 'u';
+            esc[2] = '0';
+            esc[3] = '0';
+            esc[4] = hex[c >> 4];
+            esc[5] = hex[c & 0xf];
+            n = 6;
+        }
+        if (!jq_writer_put(w, esc, n)) return JQ_FALSE;
+        i = end + 1;
+    }
+
+    return jq_writer_putc(w, '"');
+}
+
+JQ_API jq_bool
+jq_write_key(struct jq_writer *w, const jq_char *s, jq_size len) {
+    if (!jq_writer_begin_value(w, JQ_TRUE) || !jq_writer_string(w, s, len)) return JQ_FALSE;
+    /* The value goes after ':' without a separator */
+    w->sep = '\0';
+
+    return jq_writer_putc(w, ':');
+}
+
+JQ_API jq_bool
+jq_write_string(struct jq_writer *w, const jq_char *s, jq_size len) {
+    return jq_writer_begin_value(w, JQ_FALSE) && jq_writer_string(w, s, len);
+}
+
+static const jq_uint64 jq_pow10_uint64[] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+    1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+    100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+    1000000000000000000ull, 10000000000000000000ull
+};
+
+static const char jq_digits2[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* Returns the number of decimal digits of v, log2 of v gives log10 but one, 0 has one digit too */
+JQ_INLINE int
+jq_count_digits(jq_uint64 v) {
+    int t = ((64 - jq_clz64(v | 1)) * 1233) >> 12;
+    /* Setting the lowest bit keeps the comparison with the even powers of ten */
+    return t + 1 - ((v | 1) < jq_pow10_uint64[t]);
+}
+
+/* Writes the digits of v backwards from end, two at a time */
+JQ_INLINE void
+jq_put_digits(jq_char *end, jq_uint64 v) {
+    while (v >= 100) {
+        const char *d = &jq_digits2[(v % 100) * 2];
+        v /= 100;
+        *--end = d[1];
+        *--end = d[0];
+    }
+    if (v >= 10) {
+        *--end = jq_digits2[v * 2 + 1];
+        *--end = jq_digits2[v * 2];
+    } else {
+        *--end = (jq_char)('0' + v);
+    }
+}
+
+JQ_API jq_size
+jq_format_uint64(jq_char *buf, jq_uint64 v) {
+    int n = jq_count_digits(v);
+
+    jq_put_digits(buf + n, v);
+
+    return (jq_size)n;
+}
+
+JQ_API jq_size
+jq_format_int64(jq_char *buf, jq_int64 v) {
+    if (v >= 0) return jq_format_uint64(buf, (jq_uint64)v);
+
+    /* The magnitude of the least jq_int64 doesn't fit it, it does fit jq_uint64 */
+    buf[0] = '-';
+    return 1 + jq_format_uint64(buf + 1, 0 - (jq_uint64)v);
+}
+
+JQ_INLINE jq_uint64
+jq_double_bits(double d) {
+    union { jq_uint64 u; double d; } v;
+    v.d = d;
+    return v.u;
+}
+
+/* Returns the high 64 bits of g * cp rounded to odd, g is 128 bit g1:g0 */
+JQ_INLINE jq_uint64
+jq_round_to_odd(jq_uint64 g1, jq_uint64 g0, jq_uint64 cp) {
+    jq_uint64 x1, y0, y1;
+
+    jq_mul128(g0, cp, &x1);
+    y0 = jq_mul128(g1, cp, &y1) + x1;
+    y1 += y0 < x1;
+
+    return y1 | (y0 > 1);
+}
+
+/*
+ * Schubfach algorithm (Raffaello Giulietti, The Schubfach way to render doubles),
+ * returns the shortest m with m * 10^k in the rounding interval of c * 2^q, the
+ * closest to it if there are several, and sets k. closer is set if the interval
+ * is narrower below, c is a power of two then.
+ */
+JQ_INLINE jq_uint64
+jq_schubfach(jq_uint64 c, int q, jq_bool closer, int *k10) {
+    jq_bool even = !(c & 1);
+    jq_uint64 cbl = 4 * c - 2 + closer, cb = 4 * c, cbr = 4 * c + 2;
+    jq_uint64 g1, g0, vbl, vb, vbr, lower, upper, s;
+    /* floor(log10(2^q)) or floor(log10(3/4 * 2^q)) */
+    int k = (q * 1262611 - (closer ? 524031 : 0)) >> 22;
+    /* 1 to 4, 10^-k is g * 2^(floor(log2(10^-k)) - 127) */
+    int h = q + ((-k * 1741647) >> 19) + 1;
+
+    /* The power of ten rounded up */
+    g1 = jq_pow5_128[-k + 342][0];
+    g0 = jq_pow5_128[-k + 342][1];
+    if (-k < -27 || -k > 55) {
+        g1 += ++g0 == 0;
+    }
+
+    vbl = jq_round_to_odd(g1, g0, cbl << h);
+    vb = jq_round_to_odd(g1, g0, cb << h);
+    vbr = jq_round_to_odd(g1, g0, cbr << h);
+    lower = vbl + !even;
+    upper = vbr - !even;
+
+    /* One digit less if a multiple of ten is in the interval */
+    s = vb / 4;
+    if (s >= 10) {
+        jq_uint64 sp = s / 10;
+        jq_bool up_inside = lower <= 40 * sp, wp_inside = 40 * sp + 40 <= upper;
+
+        if (up_inside != wp_inside) {
+            *k10 = k + 1;
+            return sp + wp_inside;
+        }
+    }
+
+    *k10 = k;
+    {
+        jq_bool u_inside = lower <= 4 * s, w_inside = 4 * s + 4 <= upper;
+
+        if (u_inside != w_inside) return s + w_inside;
+    }
+
+    /* Both s and s + 1 are in the interval, the closest one wins, the even one if it's a tie */
+    return s + (vb > 4 * s + 2 || (vb == 4 * s + 2 && (s & 1)));
+}
+
+JQ_API jq_size
+jq_format_double(jq_char *buf, double v) {
+    jq_uint64 bits = jq_double_bits(v), c = bits & (((jq_uint64)1 << 52) - 1), m;
+    int e = (int)(bits >> 52 & 0x7ff), k, n, point;
+    jq_char *p = buf;
+
+    if (e == 0x7ff) return 0;
+    if (bits >> 63) *p++ = '-';
+
+    if (e == 0 && c == 0) {
+        *p++ = '0';
+        return (jq_size)(p - buf);
+    }
+
+    if (e == 0) {
+        /* Subnormal */
+        m = jq_schubfach(c, -1074, JQ_FALSE, &k);
+    } else if (e >= 1023 && e < 1075 && !((c | (jq_uint64)1 << 52) & (((jq_uint64)1 << (1075 - e)) - 1))) {
+        /* An integer below 2^53 is written as it is */
+        m = (c | (jq_uint64)1 << 52) >> (1075 - e);
+        k = 0;
+    } else {
+        m = jq_schubfach(c | (jq_uint64)1 << 52, e - 1075, c == 0 && e > 1, &k);
+    }
+
+    while (m % 10 == 0) {
+        m /= 10;
+        ++k;
+    }
+    n = jq_count_digits(m);
+    /* The value is 0.digits * 10^point */
+    point = n + k;
+
+    if (point > 0 && point <= 21) {
+        if (n <= point) {
+            jq_put_digits(p + n, m);
+            for (p += n; n < point; ++n) *p++ = '0';
+        } else {
+            jq_put_digits(p + n + 1, m);
+            memmove(p, p + 1, (size_t)point);
+            p[point] = '.';
+            p += n + 1;
+        }
+    } else if (point > -6 && point <= 0) {
+        *p++ = '0';
+        *p++ = '.';
+        for (; point < 0; ++point) *p++ = '0';
+        jq_put_digits(p + n, m);
+        p += n;
+    } else {
+        jq_put_digits(p + n + 1, m);
+        p[0] = p[1];
+        if (n > 1) {
+            p[1] = '.';
+            p += n + 1;
+        } else {
+            ++p;
+        }
+        *p++ = 'e';
+        if (--point < 0) {
+            *p++ = '-';
+            point = -point;
+        }
+        p += jq_format_uint64(p, (jq_uint64)point);
+    }
+
+    return (jq_size)(p - buf);
+}
+
+JQ_API jq_bool
+jq_write_uint64(struct jq_writer *w, jq_uint64 v) {
+    jq_char num[JQ_FORMAT_SIZE];
+
+    return jq_writer_begin_value(w, JQ_FALSE) && jq_writer_put(w, num, jq_format_uint64(num, v));
+}
+
+JQ_API jq_bool
+jq_write_int64(struct jq_writer *w, jq_int64 v) {
+    jq_char num[JQ_FORMAT_SIZE];
+
+    return jq_writer_begin_value(w, JQ_FALSE) && jq_writer_put(w, num, jq_format_int64(num, v));
+}
+
+JQ_API jq_bool
+jq_write_double(struct jq_writer *w, double v) {
+    jq_char num[JQ_FORMAT_SIZE];
+    jq_size n = jq_format_double(num, v);
+
+    /* Infinities and NaN */
+    if (n == 0) return jq_write_null(w);
+
+    return jq_writer_begin_value(w, JQ_FALSE) && jq_writer_put(w, num, n);
+}
+
+JQ_API jq_bool
+jq_write_bool(struct jq_writer *w, jq_bool v) {
+    return jq_writer_begin_value(w, JQ_FALSE) && (v ? jq_writer_put(w, "true", 4) : jq_writer_put(w, "false", 5));
+}
+
+JQ_API jq_bool
+jq_write_null(struct jq_writer *w) {
+    return jq_writer_begin_value(w, JQ_FALSE) && jq_writer_put(w, "null", 4);
+}
+
+JQ_API jq_bool
+jq_write_raw(struct jq_writer *w, const jq_char *s, jq_size len) {
+    return jq_writer_begin_value(w, JQ_FALSE) && jq_writer_put(w, s, len);
+}
+
+/* Writes the line end and the indentation of the writer depth before the next token */
+JQ_INLINE jq_bool
+jq_reformat_newline(struct jq_writer *w, unsigned indent) {
+    static const char spaces[] = "                                                                ";
+    jq_size n = w->depth * indent;
+
+    w->sep = '\0';
+    if (!jq_writer_putc(w, '\n')) return JQ_FALSE;
+    for (; n > sizeof(spaces) - 1; n -= sizeof(spaces) - 1) {
+        if (!jq_writer_put(w, spaces, sizeof(spaces) - 1)) return JQ_FALSE;
+    }
+
+    return jq_writer_put(w, spaces, n);
+}
+
+/*
+ * Checks the grammar moving the parser state of the handler past the token as jq_next
+ * does it, the top-level values follow one another. Sets the error if it can't be here
+ */
+JQ_INLINE jq_bool
+jq_reformat_check(struct jq_handler *h, enum jq_token_type t) {
+    enum jq_parser_state state = jq_parser_get_state(h);
+
+    switch (t) {
+    case JQ_T_COLON:
+        if (state != JQ_S_OBJECT || h->cnt != JQ_CNT_OBJECT_KEY) break;
+        h->cnt = JQ_CNT_OBJECT_COLON;
+        return JQ_TRUE;
+
+    case JQ_T_COMMA:
+        if (state == JQ_S_OBJECT && h->cnt == JQ_CNT_OBJECT_VALUE) {
+            h->cnt = JQ_CNT_OBJECT_COMMA;
+        } else if (state == JQ_S_ARRAY && h->cnt == JQ_CNT_ARRAY_VALUE) {
+            h->cnt = JQ_CNT_ARRAY_COMMA;
+        } else {
+            break;
+        }
+        return JQ_TRUE;
+
+    case JQ_T_RIGHT_BRACE: case JQ_T_RIGHT_BRACKET:
+        if (t == JQ_T_RIGHT_BRACE ? state != JQ_S_OBJECT || (h->cnt != 0 && h->cnt != JQ_CNT_OBJECT_VALUE)
+                : state != JQ_S_ARRAY || h->cnt == JQ_CNT_ARRAY_COMMA) {
+            break;
+        }
+        switch (jq_parser_pop_state(h)) {
+        case JQ_S_OBJECT: h->cnt = JQ_CNT_OBJECT_VALUE; break;
+        case JQ_S_ARRAY: h->cnt = JQ_CNT_ARRAY_VALUE; break;
+        default: jq_parser_set_state(h, JQ_S_COMPLETE); break;
+        }
+        return JQ_TRUE;
+
+    default:
+        if (state == JQ_S_OBJECT && t == JQ_T_STRING && (h->cnt == 0 || h->cnt == JQ_CNT_OBJECT_COMMA)) {
+            h->cnt = JQ_CNT_OBJECT_KEY;
+            return JQ_TRUE;
+        }
+        if (state == JQ_S_COMPLETE) state = JQ_S_UNDEFINED;
+        if (!jq_parser_value(h, state)) break;
+
+        if (t == JQ_T_LEFT_BRACE || t == JQ_T_LEFT_BRACKET) {
+            if (!jq_parser_push_state(h, t == JQ_T_LEFT_BRACE ? JQ_S_OBJECT : JQ_S_ARRAY)) {
+                jq_set_error(h, JQ_ERR_MAX_DEPTH);
+                return JQ_FALSE;
+            }
+            h->cnt = 0;
+        } else if (state == JQ_S_UNDEFINED) {
+            jq_parser_set_state(h, JQ_S_COMPLETE);
+        }
+        return JQ_TRUE;
+    }
+
+    jq_set_error(h, JQ_ERR_PARSER_UNEXPECTED_TOKEN);
+    return JQ_FALSE;
+}
+
+/*
+ * The writer keeps the state between the buffers, sep is '\n' if the line ends before
+ * the next token and '[' if it ends unless the next token closes the object or array.
+ * The handler keeps the state of the grammar, see jq_reformat_check()
+ */
+JQ_API jq_bool
+jq_reformat(struct jq_handler *h, struct jq_writer *w, unsigned indent) {
+    jq_set_readonly(h, JQ_TRUE);
+
+    if (jq_get_error(w) != JQ_ERR_OK) return JQ_FALSE;
+
+    for (;;) {
+        enum jq_token_type t = jq_get_token(h);
+        jq_bool ok;
+
+        if (t == JQ_T_NEED_MORE) {
+            /* The buffer ends between the top-level values */
+            if (h->stack_pos == 0 && jq_get_tail_size(h) == 0) {
+                jq_reset_error(h);
+                return JQ_TRUE;
+            }
+            return JQ_FALSE;
+        }
+        if (t == JQ_T_ERROR || !jq_reformat_check(h, t)) return JQ_FALSE;
+
+        switch (t) {
+        case JQ_T_RIGHT_BRACE: case JQ_T_RIGHT_BRACKET:
+            --w->depth;
+            ok = w->sep == '[' || !indent || jq_reformat_newline(w, indent);
+            ok = ok && jq_writer_putc(w, (jq_char)t);
+            w->sep = w->depth ? '\0' : '\n';
+            break;
+
+        case JQ_T_COMMA:
+            ok = jq_writer_putc(w, ',');
+            w->sep = indent ? '\n' : '\0';
+            break;
+
+        case JQ_T_COLON:
+            ok = jq_writer_putc(w, ':') && (!indent || jq_writer_putc(w, ' '));
+            break;
+
+        default:
+            ok = !w->sep || jq_reformat_newline(w, indent);
+            if (t == JQ_T_LEFT_BRACE || t == JQ_T_LEFT_BRACKET) {
+                ok = ok && jq_writer_putc(w, (jq_char)t);
+                ++w->depth;
+                w->sep = indent ? '[' : '\0';
+            } else {
+                /* The string value is between the quotes */
+                ok = ok && (t == JQ_T_STRING ? jq_writer_put(w, h->val - 1, h->vlen + 2) : jq_writer_put(w, h->val, h->vlen));
+                if (w->depth == 0) w->sep = '\n';
+            }
+        }
+
+        if (!ok) return JQ_FALSE;
+    }
+}
 
-#define JQ_NULL 0
+#endif /* JQ_WITH_WRITER */
 
-JQ_API jq_bool
-jq_init(struct jq_handler *h) {
-    h->buf = JQ_NULL;
-    h->buf_size = 0;
-    h->i = 0;
-    h->cnt = 0;
-    h->stack[0] = JQ_S_UNDEFINED;
-    h->stack_pos = 0;
-    h->val = JQ_NULL;
-#ifdef JQ_WITH_VLEN
-    h->vlen = 0;
-#endif
-#ifdef JQ_WITH_LOCATION
-    h->position = 0;
-    h->line = 0;
-#endif
-#ifdef JQ_WITH_NULLTERM
-    h->subst_char = '\0';
-    h->subst_pos = 0; /* subst_pos init doesn't matter, only subst_char is checked */
-#endif
-    h->callback = JQ_NULL;
-    h->error = JQ_ERR_OK;
+/* ==========================================================================
+ *
+ * File mapping
+ *
+ * ========================================================================== */
 
-    return JQ_TRUE;
-}
+#ifdef JQ_WITH_MMAP
 
-JQ_INLINE void
-jq_append_buf(struct jq_handler *h, jq_char *src, jq_size sz) {
-    h->buf = src;
-    h->buf_size = sz;
-    h->i = 0;
+JQ_API jq_bool
+jq_parse_file(struct jq_handler *h, const char *path) {
+    struct stat st;
+    void *map = JQ_NULL;
+    jq_size sz = 0;
+    jq_bool rv;
+    int fd = open(path, O_RDONLY);
+    jq_bool ok = fd >= 0 && fstat(fd, &st) == 0;
 
-    if (jq_get_error(h) == JQ_ERR_LEXER_NEED_MORE) {
-        jq_reset_error(h);
+    if (ok && st.st_size > 0) {
+        sz = (jq_size)st.st_size;
+        map = mmap(JQ_NULL, sz, PROT_READ, MAP_PRIVATE, fd, 0);
+        ok = map != MAP_FAILED;
     }
-}
+    if (fd >= 0) close(fd); /* the mapping stays */
 
-JQ_INLINE void
-jq_set_callback(struct jq_handler *h, jq_callback callback) {
-    h->callback = callback;
-}
+    if (!ok) {
+        jq_set_error(h, JQ_ERR_FILE);
+        return JQ_FALSE;
+    }
 
-JQ_API const char *
-jq_errstr(enum jq_error error) {
-    switch (error) {
-    case JQ_ERR_OK: return "Ok";
-    case JQ_ERR_LEXER_NEED_MORE: return "Unexpected end of file";
-    case JQ_ERR_LEXER_UNKNOWN_TOKEN: return "Syntax error";
-    case JQ_ERR_LEXER_UNKNOWN_ESCAPE_SYMBOL: return "Syntax error, unknown escape symbol";
-    case JQ_ERR_LEXER_UNKNOWN_HEX_SYMBOL: return "Syntax error, unknown hex symbol after '\\u' escape symbol";
-    case JQ_ERR_LEXER_EXPONENT_ERROR: return "Syntax error in exponent part";
-    case JQ_ERR_PARSER_UNEXPECTED_TOKEN: return "Unexpected token";
-    default: return "Ok";
+    if (sz) {
+#if defined(POSIX_MADV_SEQUENTIAL)
+        posix_madvise(map, sz, POSIX_MADV_SEQUENTIAL);
+#elif defined(MADV_SEQUENTIAL)
+        madvise(map, sz, MADV_SEQUENTIAL);
+#endif
     }
+
+    /* The mapping is read-only and it is the whole input, a number at its end is finished by the end */
+    jq_set_readonly(h, JQ_TRUE);
+    jq_set_input_end(h, JQ_TRUE);
+    jq_append_buf(h, (jq_char *)map, sz);
+    rv = jq_parse(h);
+
+    if (sz) munmap(map, sz);
+
+    return rv;
 }
 
+#endif /* JQ_WITH_MMAP */
+
 /* ==========================================================================
  *
- * Lexer
+ * Streaming reader
  *
  * ========================================================================== */
 
-/* Forward declarations */
-JQ_INLINE enum jq_token_type jq_finish_number(struct jq_handler *h);
-JQ_API enum jq_token_type jq_handle_lexer_error(struct jq_handler *h, jq_size start_pos, enum jq_error error);
+#ifdef JQ_WITH_READER
+
+#define JQ_READER_DEPTH                 4  /* reads in flight by default */
+#define JQ_READER_MAX_DEPTH             64
+
+/*
+ * The memory is cut into depth buffers, every one is the room for the tail of the
+ * buffer before and the area the input is read to, the tail is copied to its room
+ */
+struct jq_reader {
+    struct jq_handler *h;
+    int fd;
+    jq_char *mem;
+    jq_size buf_size;                   /* tail room and read area */
+    jq_size room;                       /* tail room, the longest token */
+    unsigned depth;                     /* number of buffers */
+    jq_size tail;                       /* tail carried to the next buffer */
+    jq_bool complete;                   /* the latest jq_parse() returned JQ_TRUE */
+};
 
-#define jq_iswc(c) (JQ_STRCHR(" \n\r\t", c) != JQ_NULL)
-#define jq_isesc(c) (JQ_STRCHR("\"\\/bfnrt", c) != JQ_NULL)
-#define jq_isnum(c) (JQ_STRCHR("-0123456789", c) != JQ_NULL)
-#define jq_isint(c) (JQ_STRCHR("123456789", c) != JQ_NULL)
+#define jq_reader_area(r, k) ((r)->mem + (jq_size)(k) * (r)->buf_size + (r)->room)
+#define jq_reader_area_size(r) ((r)->buf_size - (r)->room)
 
-/* This function cannot be implemented as a macro because c can be a return of a function */
+/* Parses n bytes read to buffer k after the tail carried there, then carries the new tail to the next one */
 JQ_INLINE jq_bool
-jq_ishex(jq_char c) {
-    return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f');
-}
+jq_reader_parse(struct jq_reader *r, unsigned k, jq_size n) {
+    struct jq_handler *h = r->h;
+    jq_char *area = jq_reader_area(r, k);
+    jq_size tail;
 
-JQ_INLINE const jq_char *
-JQ_STRCHR(const jq_char *s, jq_char c) {
-    while (*s) {
-        if (*s == c) return s;
-        ++s;
+    jq_append_buf(h, area - r->tail, r->tail + n);
+    r->complete = jq_parse(h);
+    if (!r->complete && jq_get_error(h) != JQ_ERR_LEXER_NEED_MORE) return JQ_FALSE;
+
+    tail = jq_get_tail_size(h);
+    if (tail > r->room) {
+        jq_set_error(h, JQ_ERR_BUFFER_FULL);
+        return JQ_FALSE;
     }
+    memmove(jq_reader_area(r, (k + 1) % r->depth) - tail, jq_get_tail(h), tail);
+    r->tail = tail;
 
-    return JQ_NULL;
+    return JQ_TRUE;
 }
 
-JQ_API int
-jq_lexer_getchar(struct jq_handler *h) {
-    if (h->i < h->buf_size) {
-#ifdef JQ_WITH_LOCATION
-        if (h->buf[h->i] == '\n') {
-            h->position = 0;
-            ++h->line;
-        } else {
-            ++h->position;
-        }
-#endif
-#ifdef JQ_WITH_NULLTERM
-        /* Restoring previously saved char */
-        if (h->subst_char) {
-            h->buf[h->subst_pos] = h->subst_char;
-            h->subst_char = '\0';
-        }
-#endif
+/* The end of the input after buffer k, a number at the end is finished by a space */
+JQ_INLINE jq_bool
+jq_reader_end(struct jq_reader *r, unsigned k) {
+    jq_char *area = jq_reader_area(r, (k + 1) % r->depth);
 
-        return h->buf[h->i++];
-    } else {
-        return JQ_T_NEED_MORE;
-    }
+    if (r->complete) return JQ_TRUE;
+
+    area[0] = ' ';
+    jq_append_buf(r->h, area - r->tail, r->tail + 1);
+
+    return jq_parse(r->h);
 }
 
-JQ_API void
-jq_lexer_unget(struct jq_handler *h) {
-/*
- * h->i can be 0 at the beginning of the buf! So this function should be called after a successive call of jq_getchar(jq_handler *h) only,
- * i.e. jq_getchar(jq_handler *h) should not have returned JQ_T_NEED_MORE!
-*/
-    --h->i;
-#ifdef JQ_WITH_LOCATION
-    if (h->buf[h->i] == '\n') {
-        jq_char *b = &h->buf[h->i];
-        do ++h->position; while (--*b != '\n' && b != h->buf); /* TODO: test it! */
-        --h->line;
-    } else {
-        --h->position;
+/* Reads up to n bytes, returns the number of bytes read or -1 */
+JQ_INLINE long
+jq_reader_read(int fd, jq_char *buf, jq_size n) {
+    jq_size got = 0;
+
+    while (got < n) {
+        long rv = (long)read(fd, buf + got, n - got);
+
+        if (rv < 0 && errno == EINTR) continue;
+        if (rv < 0) return -1;
+        if (rv == 0) break;
+        got += (jq_size)rv;
     }
-#endif
+
+    return (long)got;
 }
 
-JQ_API enum jq_token_type
-jq_get_token(struct jq_handler *h) {
-    static const char Null[] = "null";
-    static const char True[] = "true";
-    static const char False[] = "false";
+/* The plain one read at a time loop, it works with pipes and sockets too */
+JQ_INLINE jq_bool
+jq_reader_run_sync(struct jq_reader *r) {
+    unsigned k;
 
-    int nft_cnt; /* current symbol inside null, true, false or unicode (\uxxxx) */
-    enum jq_lexer_state lexer_state = JQ_L_NORMAL;
-    jq_size start_pos = h->i; /* start position of the token */
+    for (k = 0;; k = (k + 1) % r->depth) {
+        long n = jq_reader_read(r->fd, jq_reader_area(r, k), jq_reader_area_size(r));
 
-    for (;;) {
-        int c = jq_lexer_getchar(h);
-        if (c == JQ_T_NEED_MORE) {
-            jq_handle_lexer_error(h, start_pos, JQ_ERR_LEXER_NEED_MORE);
-            return JQ_T_NEED_MORE;
+        if (n < 0) {
+            jq_set_error(r->h, JQ_ERR_FILE);
+            return JQ_FALSE;
         }
+        if (n == 0) return jq_reader_end(r, (k + r->depth - 1) % r->depth);
+        if (!jq_reader_parse(r, k, (jq_size)n)) return JQ_FALSE;
+    }
+}
 
-        switch (lexer_state) {
-        case JQ_L_STRING:
-            switch (c) {
-            case '"':
-#ifdef JQ_WITH_VLEN
-                h->vlen = h->i - 1 - (h->val - h->buf);
-#endif
-#ifdef JQ_WITH_NULLTERM
-                /* Remembering the char in h->subst_char and h->subst_pos */
-                h->subst_pos = h->i - 1;
-                h->subst_char = c;
-                h->buf[h->subst_pos] = '\0'; /* and setting it to null terminator, then we should restore it */
-#endif
+#ifdef JQ_IO_URING
 
-                return JQ_T_STRING;
+long syscall(long number, ...);
 
-            case '\\':
-                lexer_state = JQ_L_ESCAPE;
-                continue;
-            }
-            break;
+struct jq_uring {
+    int fd;
+    unsigned *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ptr, *cq_ptr;
+    size_t sq_len, cq_len, sqes_len;
+    unsigned inflight;                  /* reads queued and not reaped yet */
+};
 
-        case JQ_L_ESCAPE:
-            if (c == 'u') {
-                nft_cnt = 0;
-                lexer_state = JQ_L_UNICODE;
-            } else if (jq_isesc(c)) {
-                lexer_state = JQ_L_STRING;
-            } else {
-                return jq_handle_lexer_error(h, start_pos, JQ_ERR_LEXER_UNKNOWN_ESCAPE_SYMBOL);
-            }
-            break;
+JQ_INLINE void
+jq_uring_free(struct jq_uring *u) {
+    if (u->sqes) munmap(u->sqes, u->sqes_len);
+    if (u->cq_ptr && u->cq_ptr != u->sq_ptr) munmap(u->cq_ptr, u->cq_len);
+    if (u->sq_ptr) munmap(u->sq_ptr, u->sq_len);
+    close(u->fd);
+}
 
-        case JQ_L_UNICODE:
-            if (nft_cnt++ < 4) {
-                if (!jq_ishex(c)) {
-                    return jq_handle_lexer_error(h, start_pos, JQ_ERR_LEXER_UNKNOWN_ESCAPE_SYMBOL);
-                }
-            } else {
-                jq_lexer_unget(h);
-                lexer_state = JQ_L_STRING;
-            }
-            break;
+/* Sets the ring up with raw system calls, returns JQ_FALSE if io_uring is not there */
+JQ_INLINE jq_bool
+jq_uring_init(struct jq_uring *u, unsigned entries) {
+    struct io_uring_params p;
+    void *m;
 
-        case JQ_L_NULL:
-            if (Null[nft_cnt]) {
-                if (c == Null[nft_cnt]) {
-                    ++nft_cnt;
-                    continue;
-                } else {
-                    return jq_handle_lexer_error(h, start_pos, JQ_ERR_LEXER_UNKNOWN_TOKEN);
-                }
-            } else {
-                jq_lexer_unget(h);
-                return JQ_T_NULL;
-            }
-            break;
+    memset(&p, 0, sizeof(p));
+    memset(u, 0, sizeof(*u));
+    u->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (u->fd < 0) return JQ_FALSE;
 
-        case JQ_L_TRUE:
-            if (True[nft_cnt]) {
-                if (c == True[nft_cnt]) {
-                    ++nft_cnt;
-                    continue;
-                } else {
-                    return jq_handle_lexer_error(h, start_pos, JQ_ERR_LEXER_UNKNOWN_TOKEN);
-                }
-            } else {
-                jq_lexer_unget(h);
-                return JQ_T_TRUE;
-            }
-            break;
+    u->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    u->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (u->cq_len > u->sq_len) u->sq_len = u->cq_len;
+        u->cq_len = u->sq_len;
+    }
 
-        case JQ_L_FALSE:
-            if (False[nft_cnt]) {
-                if (c == False[nft_cnt]) {
-                    ++nft_cnt;
-                    continue;
-                } else {
-                    return jq_handle_lexer_error(h, start_pos, JQ_ERR_LEXER_UNKNOWN_TOKEN);
-                }
-            } else {
-                jq_lexer_unget(h);
-                return JQ_T_FALSE;
-            }
-            break;
+    m = mmap(JQ_NULL, u->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED, u->fd, IORING_OFF_SQ_RING);
+    if (m == MAP_FAILED) goto fail;
+    u->sq_ptr = m;
 
-        case JQ_L_NORMAL:
-            if (jq_iswc(c)) continue;
-            if (jq_isnum(c)) {
-                jq_lexer_unget(h);
-                lexer_state = JQ_L_NUM_BEGIN;
-                continue;
-            }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        u->cq_ptr = u->sq_ptr;
+    } else {
+        m = mmap(JQ_NULL, u->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED, u->fd, IORING_OFF_CQ_RING);
+        if (m == MAP_FAILED) goto fail;
+        u->cq_ptr = m;
+    }
 
-            switch (c) {
-            case '"':
-                h->val = &h->buf[h->i];
-                lexer_state = JQ_L_STRING;
-                continue;
+    u->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    m = mmap(JQ_NULL, u->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED, u->fd, IORING_OFF_SQES);
+    if (m == MAP_FAILED) goto fail;
+    u->sqes = (struct io_uring_sqe *)m;
 
-            case '{': case '}': case '[': case ']': case ':': case ',':
-                return (enum jq_token_type)c;
+    u->sq_tail = (unsigned *)((char *)u->sq_ptr + p.sq_off.tail);
+    u->sq_mask = (unsigned *)((char *)u->sq_ptr + p.sq_off.ring_mask);
+    u->sq_array = (unsigned *)((char *)u->sq_ptr + p.sq_off.array);
+    u->cq_head = (unsigned *)((char *)u->cq_ptr + p.cq_off.head);
+    u->cq_tail = (unsigned *)((char *)u->cq_ptr + p.cq_off.tail);
+    u->cq_mask = (unsigned *)((char *)u->cq_ptr + p.cq_off.ring_mask);
+    u->cqes = (struct io_uring_cqe *)((char *)u->cq_ptr + p.cq_off.cqes);
 
-            case 'n':
-                nft_cnt = 1;
-                lexer_state = JQ_L_NULL;
-                continue;
+    return JQ_TRUE;
 
-            case 't':
-                nft_cnt = 1;
-                lexer_state = JQ_L_TRUE;
-                continue;
+fail:
+    jq_uring_free(u);
+    return JQ_FALSE;
+}
 
-            case 'f':
-                nft_cnt = 1;
-                lexer_state = JQ_L_FALSE;
-                continue;
+/* Queues a read of n bytes at off to buf, buffer k gets the result */
+JQ_INLINE jq_bool
+jq_uring_read(struct jq_uring *u, int fd, struct iovec *iov, jq_char *buf, jq_size n, jq_uint64 off, unsigned k) {
+    unsigned tail = *u->sq_tail, i = tail & *u->sq_mask;
+    struct io_uring_sqe *sqe = &u->sqes[i];
 
-            default:
-                return jq_handle_lexer_error(h, start_pos, JQ_ERR_LEXER_UNKNOWN_TOKEN);
-            }
-            break;
+    iov->iov_base = buf;
+    iov->iov_len = n;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = fd;
+    sqe->addr = (unsigned long)iov;
+    sqe->len = 1;
+    sqe->off = off;
+    sqe->user_data = k;
+    u->sq_array[i] = i;
+    __atomic_store_n(u->sq_tail, tail + 1, __ATOMIC_RELEASE);
 
-        case JQ_L_NUM_BEGIN:
-                h->val = &h->buf[h->i - 1];
+    while (syscall(__NR_io_uring_enter, u->fd, 1, 0, 0, JQ_NULL, 0) < 0) {
+        if (errno != EINTR) return JQ_FALSE;
+    }
+    ++u->inflight;
 
-                switch (c) {
-                case '-':   lexer_state = JQ_L_NUM_INT1_9; break;
-                case '0':   lexer_state = JQ_L_NUM_POINT; break;
-                default:    jq_lexer_unget(h); lexer_state = JQ_L_NUM_INT1_9; break;
-                }
-            continue;
+    return JQ_TRUE;
+}
 
-        case JQ_L_NUM_POINT:
-            if (c == '.') {
-                lexer_state = JQ_L_NUM_FRACTION;
-            } else {
-                return jq_finish_number(h);
-            }
-            continue;
+/* Takes the completed reads, waits for one if there are none */
+JQ_INLINE jq_bool
+jq_uring_reap(struct jq_uring *u, long *res, jq_bool *ready) {
+    unsigned head = *u->cq_head;
+
+    while (head == __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE)) {
+        if (syscall(__NR_io_uring_enter, u->fd, 0, 1, IORING_ENTER_GETEVENTS, JQ_NULL, 0) < 0 && errno != EINTR) {
+            return JQ_FALSE;
+        }
+    }
+
+    do {
+        struct io_uring_cqe *cqe = &u->cqes[head & *u->cq_mask];
+
+        res[cqe->user_data] = cqe->res;
+        ready[cqe->user_data] = JQ_TRUE;
+        --u->inflight;
+    } while (++head != __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE));
+    __atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+
+    return JQ_TRUE;
+}
 
-        case JQ_L_NUM_INT0_9:
-            if (JQ_STRCHR("0123456789", c) == JQ_NULL) {
-                if (c == '.') {
-                    lexer_state = JQ_L_NUM_FRACTION;
-                } else {
-                    return jq_finish_number(h);
-                }
-            }
-            continue;
+/* Returns the result of the read of buffer k, the reads of the others completed meanwhile are kept */
+JQ_INLINE long
+jq_uring_wait(struct jq_uring *u, long *res, jq_bool *ready, unsigned k) {
+    while (!ready[k]) {
+        if (!jq_uring_reap(u, res, ready)) return -1;
+    }
+    ready[k] = JQ_FALSE;
 
-        case JQ_L_NUM_INT1_9:
-            if (jq_isint(c)) {
-                lexer_state = JQ_L_NUM_INT0_9;
-            } else {
-                if (c == '.') {
-                    lexer_state = JQ_L_NUM_FRACTION;
-                } else {
-                    return jq_finish_number(h);
-                }
-            }
-            continue;
+    return res[k];
+}
 
-        case JQ_L_NUM_FRACTION:
-            if (JQ_STRCHR("0123456789", c) == JQ_NULL) {
-                if (JQ_STRCHR("Ee", c) != JQ_NULL) {
-                    lexer_state = JQ_L_NUM_EXPO_PLUS_MINUS;
-                } else {
-                    return jq_finish_number(h);
-                }
-            }
-            continue;
+/* Keeps all the buffers but the one being parsed reading, they are parsed in the input order */
+JQ_INLINE jq_bool
+jq_reader_run_uring(struct jq_reader *r, struct jq_uring *u, jq_uint64 pos) {
+    struct iovec iov[JQ_READER_MAX_DEPTH];
+    jq_uint64 offs[JQ_READER_MAX_DEPTH];
+    long res[JQ_READER_MAX_DEPTH];
+    jq_bool ready[JQ_READER_MAX_DEPTH];
+    jq_size area = jq_reader_area_size(r);
+    jq_bool ok = JQ_TRUE, eof = JQ_FALSE;
+    unsigned k;
 
-        case JQ_L_NUM_EXPO_PLUS_MINUS:
-            if (JQ_STRCHR("+-", c) != JQ_NULL) {
-                lexer_state = JQ_L_NUM_EXPO_INT1;
-            } else if (JQ_STRCHR("0123456789", c) != JQ_NULL) {
-                lexer_state = JQ_L_NUM_EXPO_INT;
-            } else {
-                /* Nothing found after exponent E(e) */
-                return jq_handle_lexer_error(h, start_pos, JQ_ERR_LEXER_EXPONENT_ERROR);
-            }
-            continue;
+    for (k = 0; k < r->depth; ++k) ready[k] = JQ_FALSE;
+    for (k = 0; k < r->depth && ok; ++k) {
+        offs[k] = pos;
+        pos += area;
+        ok = jq_uring_read(u, r->fd, &iov[k], jq_reader_area(r, k), area, offs[k], k);
+    }
 
-        case JQ_L_NUM_EXPO_INT1:
-            if (JQ_STRCHR("0123456789", c) == JQ_NULL) {
-                /* Nothing found after exponent E(e)+- */
-                return jq_handle_lexer_error(h, start_pos, JQ_ERR_LEXER_EXPONENT_ERROR);
-            } else {
-                lexer_state = JQ_L_NUM_EXPO_INT;
+    for (k = 0; ok; k = (k + 1) % r->depth) {
+        jq_size n = 0;
+        long got;
+
+        /* A short read is read on, it's the end of the file if nothing comes */
+        while ((got = jq_uring_wait(u, res, ready, k)) > 0 && (n += (jq_size)got) < area) {
+            if (!jq_uring_read(u, r->fd, &iov[k], jq_reader_area(r, k) + n, area - n, offs[k] + n, k)) {
+                got = -1;
+                break;
             }
-            continue;
+        }
+        if (got < 0) {
+            ok = JQ_FALSE;
+            jq_set_error(r->h, JQ_ERR_FILE);
+        } else if (n == 0) {
+            ok = jq_reader_end(r, (k + r->depth - 1) % r->depth);
+            break;
+        } else {
+            ok = jq_reader_parse(r, k, n);
+        }
+        if (!ok) break;
 
-        case JQ_L_NUM_EXPO_INT:
-            if (JQ_STRCHR("0123456789", c) == JQ_NULL) {
-                return jq_finish_number(h);
+        if (n < area) eof = JQ_TRUE;
+        if (!eof) {
+            offs[k] = pos;
+            pos += area;
+            if (!jq_uring_read(u, r->fd, &iov[k], jq_reader_area(r, k), area, offs[k], k)) {
+                ok = JQ_FALSE;
+                jq_set_error(r->h, JQ_ERR_FILE);
             }
-            continue;
+        } else if (u->inflight == 0) {
+            ok = jq_reader_end(r, k);
+            break;
         }
     }
+
+    /* The memory can't be given back with the reads going on */
+    while (u->inflight && jq_uring_reap(u, res, ready)) {}
+
+    return ok;
 }
 
-JQ_INLINE enum jq_token_type
-jq_finish_number(struct jq_handler *h) {
-    jq_lexer_unget(h);
-#ifdef JQ_WITH_VLEN
-    h->vlen = h->i - (h->val - h->buf);
+#endif /* JQ_IO_URING */
+
+JQ_API jq_bool
+jq_parse_fd(struct jq_handler *h, int fd, jq_char *mem, jq_size size, unsigned depth) {
+    struct jq_reader r;
+#ifdef JQ_IO_URING
+    struct stat st;
+    struct jq_uring u;
+    off_t pos;
 #endif
-#ifdef JQ_WITH_NULLTERM
-    /* Remembering the char in h->subst_char and h->subst_pos */
-    h->subst_pos = h->i;
-    h->subst_char = h->buf[h->subst_pos];
-    h->buf[h->subst_pos] = '\0'; /* and setting it to null terminator, then we should restore it */
+
+    r.h = h;
+    r.fd = fd;
+    r.mem = mem;
+    r.depth = depth ? (depth < JQ_READER_MAX_DEPTH ? depth : JQ_READER_MAX_DEPTH) : JQ_READER_DEPTH;
+    r.buf_size = size / r.depth;
+    r.room = r.buf_size / 2;
+    r.tail = 0;
+    r.complete = JQ_FALSE;
+
+    if (r.room == 0) {
+        jq_set_error(h, JQ_ERR_BUFFER_FULL);
+        return JQ_FALSE;
+    }
+
+#ifdef JQ_IO_URING
+    /* The reads of a regular file go at their offsets, the rest is read one by one */
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && (pos = lseek(fd, 0, SEEK_CUR)) >= 0
+            && jq_uring_init(&u, r.depth)) {
+        jq_bool ok = jq_reader_run_uring(&r, &u, (jq_uint64)pos);
+
+        jq_uring_free(&u);
+        return ok;
+    }
 #endif
 
-    return JQ_T_NUMBER;
+    return jq_reader_run_sync(&r);
 }
 
-JQ_API enum jq_token_type
-jq_handle_lexer_error(struct jq_handler *h, jq_size start_pos, enum jq_error error) {
-    jq_size n = h->i - start_pos;
-    while (n--) jq_lexer_unget(h);
-    jq_set_error(h, error);
-    return JQ_T_ERROR;
-}
+#endif /* JQ_WITH_READER */
 
 /* ==========================================================================
  *
- * Parser
+ * Parallel
  *
  * ========================================================================== */
 
-/* Forward declarations */
-JQ_INLINE enum jq_parser_state jq_parser_get_state(struct jq_handler *h);
-JQ_INLINE void jq_parser_push_state(struct jq_handler *h, enum jq_parser_state state);
-JQ_INLINE enum jq_parser_state jq_parser_pop_state(struct jq_handler *h);
-#define jq_parser_inc_cnt(h) h->cnt = ++h->cnt & 3
+#ifdef JQ_WITH_THREADS
 
-JQ_API jq_bool
-jq_parse(struct jq_handler *h) {
-    enum jq_parser_state state = jq_parser_get_state(h);
+#define JQ_PARALLEL_CHUNK_SIZE          (1ul << 20)
+#define JQ_PARALLEL_LEVELS              16 /* nesting levels a split point is resolved for */
 
-    if (jq_get_error(h) != JQ_ERR_OK) return JQ_FALSE;
+/* Records of a chunk and their tape */
+struct jq_parallel_slot {
+    jq_uint64 *tape;
+    jq_size tape_cap;
+    struct jq_record *records;
+    jq_size records_cap;
+    jq_size records_size;
+    jq_bool done;                       /* the chunk is parsed, waiting for its turn */
+    jq_bool error;                      /* the chunk of the array ends with an error */
+};
 
-    for (;;) {
-        enum jq_token_type token = jq_get_token(h);
+/*
+ * Pre-pass results of a range of the array. The range can start inside or outside a string,
+ * it is known when the ranges before are done, so both cases are counted, [0] is outside
+ */
+struct jq_parallel_range {
+    jq_bool quotes_odd;                 /* the number of quotes in the range is odd */
+    long depth[2];                      /* depth change */
+    jq_size comma[2][JQ_PARALLEL_LEVELS]; /* position after the first ',' at the depth */
+                                        /* of -level relatively to the start, or 0 */
+};
 
-        if (state == JQ_S_COMPLETE && token == JQ_T_NEED_MORE) {
-            jq_reset_error(h);
-            return JQ_TRUE;
-        }
+struct jq_parallel_ctx {
+    const struct jq_parallel *p;
+    jq_char *buf;
+    jq_size size;
+    jq_size chunk_size;
+    jq_size chunks;                     /* number of chunks */
+    jq_size *bounds;                    /* chunk k is from bounds[k] to bounds[k + 1] */
+    struct jq_parallel_range *ranges;   /* pre-pass results of the array, chunk_size each */
+    jq_size next;                       /* next chunk or range to take */
+    jq_size delivered;                  /* chunks delivered in order */
+    jq_size window;                     /* number of slots, chunks in work or waiting */
+    struct jq_parallel_slot *slots;
+    jq_bool array;                      /* the chunks are elements of the array */
+    jq_bool seeded;                     /* the top-level value is an array, the chunks */
+                                        /* but the first one start inside it */
+    jq_bool delivering;                 /* a thread is delivering records */
+    jq_bool stopped;                    /* the array has an error, nothing goes after it */
+    jq_bool failed;                     /* out of memory */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
 
-        switch (token) {
-        case JQ_T_ERROR: case JQ_T_NEED_MORE:
-            return JQ_FALSE; /* Lexer already set error */
+/*
+ * Returns the beginning of chunk k, it is the beginning of a line. The bounds are found
+ * before the parsing, as the threads change the input of their chunks (see JQ_WITH_NULLTERM)
+ */
+JQ_INLINE jq_size
+jq_parallel_boundary(const struct jq_parallel_ctx *c, jq_size k) {
+    jq_size pos = k * c->chunk_size;
+    const jq_char *nl;
 
-        case JQ_T_NULL: case JQ_T_TRUE: case JQ_T_FALSE: case JQ_T_NUMBER: case JQ_T_STRING:
-            switch (state) {
-            case JQ_S_OBJECT:
-                switch (h->cnt) {
-                case 0: if (token == JQ_T_STRING) {
-                    if (h->callback) h->callback(h, JQ_E_OBJECT_KEY);
-                } else {
-                    jq_set_error(h, JQ_ERR_PARSER_UNEXPECTED_TOKEN); /* Expected object key */
-                    return JQ_FALSE;
-                }
-                break;
+    if (k == 0) return 0;
+    if (pos >= c->size) return c->size;
+    nl = (const jq_char *)memchr(c->buf + pos - 1, '\n', c->size - pos + 1);
+    return nl ? (jq_size)(nl - c->buf) + 1 : c->size;
+}
 
-                case 1:
-                    jq_set_error(h, JQ_ERR_PARSER_UNEXPECTED_TOKEN); /* Expected ':' */
-                    return JQ_FALSE;
+/* Makes room for the tape of n input bytes, the values take less than two words per byte, "[1]" takes 4 words */
+JQ_INLINE jq_bool
+jq_parallel_reserve(struct jq_parallel_slot *s, jq_size n) {
+    if (s->tape_cap < 2 * n + 3) {
+        jq_uint64 *tape = (jq_uint64 *)realloc(s->tape, (2 * n + 3) * sizeof(jq_uint64));
 
-                case 2:
-                    if (h->callback) h->callback(h, (enum jq_event_type)token);
-                    break;
+        if (!tape) return JQ_FALSE;
+        s->tape = tape;
+        s->tape_cap = 2 * n + 3;
+    }
+    s->records_size = 0;
+    s->error = JQ_FALSE;
 
-                case 3:
-                    jq_set_error(h, JQ_ERR_PARSER_UNEXPECTED_TOKEN); /* Expected ',' or '}' */
-                    return JQ_FALSE;
-                }
+    return JQ_TRUE;
+}
+
+/* Starts from scratch at pos of the input, the records before are on the tape */
+JQ_INLINE void
+jq_parallel_restart(struct jq_parallel_ctx *c, struct jq_handler *h, struct jq_parallel_slot *s,
+                    jq_size pos, jq_size tape_size) {
+    jq_init(h);
+    jq_set_multi(h, !c->array);
+    jq_set_callback(h, c->p->callback);
+    h->udata = c->p->udata;
+    h->tape = s->tape;
+    h->tape_cap = s->tape_cap;
+    h->tape_size = tape_size;
+    h->tape_on = JQ_TRUE;
+    h->buf_offset = pos;
+}
+
+JQ_INLINE jq_bool
+jq_parallel_put(struct jq_parallel_ctx *c, struct jq_parallel_slot *s, const struct jq_record *r) {
+    if (!c->p->ordered) {
+        if (c->p->record) c->p->record(c->p->udata, r);
+        return JQ_TRUE;
+    }
+
+    if (s->records_size == s->records_cap) {
+        jq_size cap = s->records_cap ? s->records_cap * 2 : 64;
+        struct jq_record *records = (struct jq_record *)realloc(s->records, cap * sizeof(struct jq_record));
+
+        if (!records) return JQ_FALSE;
+        s->records = records;
+        s->records_cap = cap;
+    }
+    s->records[s->records_size++] = *r;
+
+    return JQ_TRUE;
+}
+
+/* Parses the chunk line by line, so a broken line can't take the next ones with it */
+JQ_INLINE jq_bool
+jq_parallel_lines(struct jq_parallel_ctx *c, struct jq_handler *h, struct jq_parallel_slot *s,
+                  jq_size begin, jq_size end) {
+    struct jq_record r;
+    jq_size pos = begin, line_end;
+
+    if (!jq_parallel_reserve(s, end - begin)) return JQ_FALSE;
+    r.offset = begin;
+    r.tape_pos = 0;
+
+    jq_parallel_restart(c, h, s, begin, 0);
+    for (; pos < end; pos = line_end) {
+        const jq_char *nl = (const jq_char *)memchr(c->buf + pos, '\n', end - pos);
+
+        line_end = nl ? (jq_size)(nl - c->buf) + 1 : end;
+        /* The last line can end without the line end, a number is finished by the end of the input then */
+        jq_set_input_end(h, line_end == c->size);
+        jq_append_buf(h, c->buf + pos, line_end - pos);
+
+        for (;;) {
+            enum jq_event_type e = jq_next(h);
+
+            if (e == JQ_E_DONE) break;
+
+            switch (e) {
+            case JQ_E_DOCUMENT_BEGIN:
+                r.offset = jq_get_document_offset(h);
+                r.tape_pos = h->tape_size;
                 break;
 
-            case JQ_S_ARRAY:
-                if (h->cnt & 1) {
-                    jq_set_error(h, JQ_ERR_PARSER_UNEXPECTED_TOKEN); /* Expected ',' or ']' */
-                    return JQ_FALSE;
-                } else {
-                    if (h->callback) h->callback(h, (enum jq_event_type)token);
-                }
+            case JQ_E_DOCUMENT_END:
+                r.json = c->buf + r.offset;
+                r.size = jq_get_offset(h) - r.offset;
+                r.tape = s->tape;
+                r.tape_size = h->tape_size - r.tape_pos;
+                r.error = JQ_ERR_OK;
+                if (!jq_parallel_put(c, s, &r)) return JQ_FALSE;
                 break;
 
-            case JQ_S_UNDEFINED:
-                if (h->callback) h->callback(h, (enum jq_event_type)token);
-                state = JQ_S_COMPLETE;
-                break;    
-            }
-            break;
+            case JQ_E_ERROR: case JQ_E_NEED_MORE:
+                /* The record lasts to the end of the line, the parsing goes on from the next one */
+                r.json = c->buf + r.offset;
+                r.size = (nl ? line_end - 1 : line_end) - r.offset;
+                r.tape = JQ_NULL;
+                r.tape_size = 0;
+                r.error = jq_get_error(h);
+                if (!jq_parallel_put(c, s, &r)) return JQ_FALSE;
+                jq_parallel_restart(c, h, s, line_end, r.tape_pos);
+                break;
 
-        case ':':
-            if (state != JQ_S_OBJECT || h->cnt != 1) {
-                jq_set_error(h, JQ_ERR_PARSER_UNEXPECTED_TOKEN); /* Unexpected ':' */
-                JQ_FALSE;
+            default:
+                if (h->callback) h->callback(h, e);
+                continue;
             }
-            break;
-                
-        case ',':
-            switch (state) {
-            case JQ_S_OBJECT:
-                if (h->cnt != 3) {
-                    jq_set_error(h, JQ_ERR_PARSER_UNEXPECTED_TOKEN); /* Unexpected ',' */
-                    JQ_FALSE;
-                }
+
+            if (e == JQ_E_ERROR || e == JQ_E_NEED_MORE) break;
+        }
+    }
+
+    return JQ_TRUE;
+}
+
+/* Sets the high bit of every byte of v equal to '"', '\\', ',', '{', '}', '[' or ']' and clears the rest */
+JQ_INLINE jq_uint64
+jq_swar_structural(jq_uint64 v) {
+    jq_uint64 l = v | JQ_SWAR_ONES * 0x20; /* '[' and ']' go to '{' and '}', nothing else does */
+    return jq_swar_eq(v, '"') | jq_swar_eq(v, '\\') | jq_swar_eq(v, ',') | jq_swar_eq(l, '{') | jq_swar_eq(l, '}');
+}
+
+/* The pre-pass of the array range from begin to end, see struct jq_parallel_range */
+JQ_INLINE void
+jq_parallel_scan(const jq_char *buf, jq_size begin, jq_size end, struct jq_parallel_range *r) {
+    jq_size i, skip = begin, bs = 0;
+    int in = 0; /* the chars are outside strings if the range starts inside one, [in] is counted */
+    long depth[2] = { 0, 0 };
+
+    memset(r->comma, 0, sizeof(r->comma));
+
+    /* The first char can be escaped by the backslashes of the range before */
+    while (bs < begin && buf[begin - bs - 1] == '\\') ++bs;
+    if (bs & 1) ++skip;
+
+    for (i = begin; i < end; i += 8) {
+        jq_uint64 m = 0;
+
+        if (i + 8 <= end) {
+            m = jq_swar_structural(jq_swar_load(buf + i));
+        } else {
+            jq_size j;
+            for (j = i; j < end; ++j) m |= jq_swar_structural((unsigned char)buf[j]) << 8 * (j - i);
+        }
+
+        for (; m; m &= m - 1) {
+            jq_size j = i + (jq_ctz64(m) >> 3);
+            long *d = &depth[in];
+
+            if (j < skip) continue;
+
+            switch (buf[j]) {
+            case '\\':
+                skip = j + 2; /* the escaped char can be the first one of the next range */
                 break;
 
-            case JQ_S_ARRAY:
-                if (!(h->cnt & 1)) {
-                    jq_set_error(h, JQ_ERR_PARSER_UNEXPECTED_TOKEN); /* Unexpected ',' array element delimeter */
-                    return JQ_FALSE;
-                }
+            case '"':
+                in ^= 1;
                 break;
 
-            default:
-                jq_set_error(h, JQ_ERR_PARSER_UNEXPECTED_TOKEN); /* Unexpected ',' array element delimeter */
-                return JQ_FALSE;
+            case ',':
+                if (*d <= 0 && -*d < JQ_PARALLEL_LEVELS && !r->comma[in][-*d]) r->comma[in][-*d] = j + 1;
+                break;
+
+            case '{': case '[':
+                ++*d;
+                break;
 
+            default:
+                --*d;
+                break;
             }
+        }
+    }
+
+    r->quotes_odd = in;
+    r->depth[0] = depth[0];
+    r->depth[1] = depth[1];
+}
+
+/* Returns the offset of the value of the latest event */
+JQ_INLINE jq_size
+jq_parallel_value_offset(struct jq_parallel_ctx *c, struct jq_handler *h, enum jq_event_type e) {
+    switch (e) {
+    case JQ_E_STRING: return (jq_size)(h->val - c->buf) - 1;
+    case JQ_E_NUMBER: case JQ_E_NULL: case JQ_E_TRUE: case JQ_E_FALSE: return (jq_size)(h->val - c->buf);
+    default: return jq_get_offset(h) - 1;
+    }
+}
+
+/* Parses the elements of the array of the chunk, the chunks but the first start after ',' */
+JQ_INLINE jq_bool
+jq_parallel_elements(struct jq_parallel_ctx *c, struct jq_handler *h, struct jq_parallel_slot *s,
+                     jq_size k, jq_size begin, jq_size end) {
+    struct jq_record r;
+    jq_size depth = c->seeded ? 1 : 0; /* elements are values at this depth */
+    jq_bool open = JQ_FALSE;
+    jq_bool last = k + 1 == c->chunks;
+
+    if (!jq_parallel_reserve(s, end - begin)) return JQ_FALSE;
+    jq_parallel_restart(c, h, s, begin, 0);
+    jq_set_input_end(h, last); /* a number can be the whole value */
+    if (k > 0) {
+        /* The array begin is here for its end to link to */
+        s->tape[0] = jq_tape_word(JQ_TAPE_ARRAY_BEGIN, 0);
+        h->tape_size = 1;
+        jq_parser_push_state(h, JQ_S_ARRAY);
+        h->cnt = JQ_CNT_ARRAY_COMMA;
+    }
+    jq_append_buf(h, c->buf + begin, end - begin);
+
+    r.offset = begin;
+    for (;;) {
+        jq_size tape_size = h->tape_size;
+        enum jq_event_type e = jq_next(h);
+
+        switch (e) {
+        case JQ_E_DONE:
+            if (!last) jq_set_error(h, JQ_ERR_PARSER_UNEXPECTED_TOKEN); /* a value after the array */
             break;
 
-        case '{':
-            jq_parser_push_state(h, JQ_S_OBJECT);
-            state = JQ_S_OBJECT;
-            h->cnt = 3; /* jq_parser_inc_cnt() which is called at the bottom of this loop will make it 0 */
-            if (h->callback) h->callback(h, (enum jq_event_type)token);
+        case JQ_E_NEED_MORE:
+            /* The chunk must end between elements, the next one goes on */
+            if (!last && h->stack_pos == 1 && h->cnt == JQ_CNT_ARRAY_COMMA && jq_get_tail_size(h) == 0) {
+                jq_reset_error(h);
+            } else if (!last) {
+                jq_set_error(h, JQ_ERR_PARSER_UNEXPECTED_TOKEN);
+            }
             break;
 
-        case '[':
-            jq_parser_push_state(h, JQ_S_ARRAY);
-            state = JQ_S_ARRAY;
-            h->cnt = 3; /* jq_parser_inc_cnt() which is called at the bottom of this loop will make it 0 */
-            if (h->callback) h->callback(h, (enum jq_event_type)token);
+        case JQ_E_ERROR:
             break;
 
-        case '}': case ']':
-            if (state == JQ_S_UNDEFINED) {
-                jq_set_error(h, JQ_ERR_PARSER_UNEXPECTED_TOKEN); /* Unexpected token and the beginning */ 
+        default:
+            if (h->callback) h->callback(h, e);
 
-                return JQ_FALSE;
+            if (e == JQ_E_OBJECT_BEGIN || e == JQ_E_ARRAY_BEGIN ? h->stack_pos == depth + 1
+                    : e != JQ_E_OBJECT_END && e != JQ_E_ARRAY_END && h->stack_pos == depth) {
+                open = JQ_TRUE;
+                r.offset = jq_parallel_value_offset(c, h, e);
+                r.tape_pos = tape_size;
             }
+            if (open && h->stack_pos == depth) {
+                open = JQ_FALSE;
+                r.json = c->buf + r.offset;
+                r.size = jq_get_offset(h) - r.offset;
+                r.tape = s->tape;
+                r.tape_size = h->tape_size - r.tape_pos;
+                r.error = JQ_ERR_OK;
+                if (!jq_parallel_put(c, s, &r)) return JQ_FALSE;
+            }
+            continue;
+        }
+        break;
+    }
 
-            state = jq_parser_pop_state(h);
-            if (h->callback) h->callback(h, (enum jq_event_type)token);
+    if (jq_get_error(h) != JQ_ERR_OK) {
+        if (!open) r.offset = jq_get_offset(h);
+        r.json = c->buf + r.offset;
+        r.size = jq_get_offset(h) - r.offset;
+        r.tape = JQ_NULL;
+        r.tape_pos = 0;
+        r.tape_size = 0;
+        r.error = jq_get_error(h);
+        s->error = JQ_TRUE;
+        if (!jq_parallel_put(c, s, &r)) return JQ_FALSE;
+    }
+
+    return JQ_TRUE;
+}
+
+/* Delivers the chunks parsed in order, c->lock is held on the call and the return */
+JQ_INLINE void
+jq_parallel_deliver(struct jq_parallel_ctx *c) {
+    struct jq_parallel_slot *s;
+
+    /* The callbacks are called unlocked, the other threads go on meanwhile */
+    c->delivering = JQ_TRUE;
+    while (c->delivered < c->chunks && (s = &c->slots[c->delivered % c->window])->done) {
+        jq_size i;
 
-            h->cnt = 2; /* jq_parser_inc_cnt() which is called at the bottom of this loop will make it 3 */
+        pthread_mutex_unlock(&c->lock);
+        if (c->p->record) {
+            for (i = 0; i < s->records_size; ++i) c->p->record(c->p->udata, &s->records[i]);
+        }
+        pthread_mutex_lock(&c->lock);
+
+        s->done = JQ_FALSE;
+        ++c->delivered;
+        if (s->error) {
+            /* Nothing is delivered after the error of the array */
+            c->delivered = c->chunks;
+            c->stopped = JQ_TRUE;
+        }
+        pthread_cond_broadcast(&c->cond);
+    }
+    c->delivering = JQ_FALSE;
+}
+
+JQ_INLINE void *
+jq_parallel_worker(void *arg) {
+    struct jq_parallel_ctx *c = (struct jq_parallel_ctx *)arg;
+    struct jq_parallel_slot own = { JQ_NULL, 0, JQ_NULL, 0, 0, JQ_FALSE, JQ_FALSE };
+    struct jq_handler h;
+
+    pthread_mutex_lock(&c->lock);
+    for (;;) {
+        struct jq_parallel_slot *s = &own;
+        jq_size k;
+        jq_bool ok;
 
-            if (state == JQ_S_UNDEFINED) state = JQ_S_COMPLETE;
+        /* In the ordered mode a chunk waits for its slot to be delivered */
+        while (c->p->ordered && !c->failed && !c->stopped && c->next < c->chunks && c->next >= c->delivered + c->window) {
+            pthread_cond_wait(&c->cond, &c->lock);
+        }
+        if (c->failed || c->stopped || c->next >= c->chunks) break;
+
+        k = c->next++;
+        if (c->p->ordered) s = &c->slots[k % c->window];
+        pthread_mutex_unlock(&c->lock);
+
+        if (c->array) {
+            ok = jq_parallel_elements(c, &h, s, k, c->bounds[k], c->bounds[k + 1]);
+        } else {
+            ok = jq_parallel_lines(c, &h, s, c->bounds[k], c->bounds[k + 1]);
+        }
+
+        pthread_mutex_lock(&c->lock);
+        if (!ok) {
+            c->failed = JQ_TRUE;
+            pthread_cond_broadcast(&c->cond);
             break;
         }
+        if (c->p->ordered) {
+            s->done = JQ_TRUE;
+            if (!c->delivering) jq_parallel_deliver(c);
+        } else if (s->error) {
+            c->stopped = JQ_TRUE;
+        }
+    }
+    pthread_mutex_unlock(&c->lock);
 
-        jq_parser_inc_cnt(h);
+    free(own.tape);
+
+    return JQ_NULL;
+}
+
+/* Pre-pass of the array ranges */
+JQ_INLINE void *
+jq_parallel_scanner(void *arg) {
+    struct jq_parallel_ctx *c = (struct jq_parallel_ctx *)arg;
+
+    for (;;) {
+        jq_size k, end;
+
+        pthread_mutex_lock(&c->lock);
+        k = c->next++;
+        pthread_mutex_unlock(&c->lock);
+        if (k >= c->chunks) break;
+
+        end = (k + 1) * c->chunk_size < c->size ? (k + 1) * c->chunk_size : c->size;
+        jq_parallel_scan(c->buf, k * c->chunk_size, end, &c->ranges[k]);
     }
 
-    return JQ_TRUE;
+    return JQ_NULL;
 }
 
-JQ_INLINE jq_bool
-jq_parse_buf(struct jq_handler *h, jq_char *src, jq_size sz) {
-    jq_append_buf(h, src, sz);
-    return jq_parse(h);
+/* Runs fn on n threads, the calling one is among them */
+JQ_INLINE void
+jq_parallel_run(struct jq_parallel_ctx *c, pthread_t *threads, unsigned n, void *(*fn)(void *)) {
+    unsigned started = 1, i;
+
+    c->next = 0;
+    for (; started < n; ++started) {
+        if (pthread_create(&threads[started], JQ_NULL, fn, c) != 0) break;
+    }
+    fn(c);
+    for (i = 1; i < started; ++i) pthread_join(threads[i], JQ_NULL);
 }
 
-JQ_INLINE enum jq_parser_state
-jq_parser_get_state(struct jq_handler *h) {
-    return (enum jq_parser_state)h->stack[h->stack_pos];
+/* Splits the array after the first ',' of its depth in every range */
+JQ_INLINE void
+jq_parallel_split(struct jq_parallel_ctx *c, jq_size ranges) {
+    jq_size k;
+    long depth = 0;
+    int in = 0;
+
+    c->chunks = 0;
+    c->bounds[c->chunks++] = 0;
+    for (k = 0; k < ranges; ++k) {
+        const struct jq_parallel_range *r = &c->ranges[k];
+
+        /* An element over the whole range or too deep a split point goes to the chunk before */
+        if (k > 0 && depth >= 1 && depth - 1 < JQ_PARALLEL_LEVELS && r->comma[in][depth - 1]) {
+            c->bounds[c->chunks++] = r->comma[in][depth - 1];
+        }
+        depth += r->depth[in];
+        in ^= r->quotes_odd;
+    }
+    c->bounds[c->chunks] = c->size;
+}
+
+JQ_INLINE jq_bool
+jq_parallel_init(struct jq_parallel_ctx *c, jq_char *buf, jq_size sz, const struct jq_parallel *p, unsigned n) {
+    c->p = p;
+    c->buf = buf;
+    c->size = sz;
+    c->chunk_size = p->chunk_size ? p->chunk_size : JQ_PARALLEL_CHUNK_SIZE;
+    c->chunks = (sz + c->chunk_size - 1) / c->chunk_size;
+    c->ranges = JQ_NULL;
+    c->next = 0;
+    c->delivered = 0;
+    c->window = 2 * (jq_size)n;
+    c->array = JQ_FALSE;
+    c->seeded = JQ_FALSE;
+    c->delivering = JQ_FALSE;
+    c->stopped = JQ_FALSE;
+    c->failed = JQ_FALSE;
+    c->slots = (struct jq_parallel_slot *)calloc(c->window, sizeof(struct jq_parallel_slot));
+    /* The whole value is one chunk in jq_parse_parallel_array, even when the input is empty */
+    c->bounds = (jq_size *)malloc((c->chunks + 2) * sizeof(jq_size));
+    pthread_mutex_init(&c->lock, JQ_NULL);
+    pthread_cond_init(&c->cond, JQ_NULL);
+
+    return c->slots && c->bounds;
 }
 
 JQ_INLINE void
-jq_parser_push_state(struct jq_handler *h, enum jq_parser_state state) {
-    h->stack[++h->stack_pos] = state;
+jq_parallel_free(struct jq_parallel_ctx *c) {
+    jq_size i;
+
+    pthread_cond_destroy(&c->cond);
+    pthread_mutex_destroy(&c->lock);
+    for (i = 0; c->slots && i < c->window; ++i) {
+        free(c->slots[i].tape);
+        free(c->slots[i].records);
+    }
+    free(c->slots);
+    free(c->bounds);
+    free(c->ranges);
 }
 
-JQ_INLINE enum jq_parser_state
-jq_parser_pop_state(struct jq_handler *h) {
-    return (enum jq_parser_state)h->stack[--h->stack_pos];
+JQ_API jq_bool
+jq_parse_parallel(jq_char *buf, jq_size sz, const struct jq_parallel *p) {
+    struct jq_parallel_ctx c;
+    unsigned n = p->threads ? p->threads : 1;
+    pthread_t *threads = (pthread_t *)malloc(n * sizeof(pthread_t));
+    jq_bool ok = jq_parallel_init(&c, buf, sz, p, n) && threads;
+    jq_size k;
+
+    if (ok) {
+        for (k = 0; k <= c.chunks; ++k) c.bounds[k] = jq_parallel_boundary(&c, k);
+        jq_parallel_run(&c, threads, n, jq_parallel_worker);
+        ok = !c.failed;
+    }
+    jq_parallel_free(&c);
+    free(threads);
+
+    return ok;
+}
+
+JQ_API jq_bool
+jq_parse_parallel_array(jq_char *buf, jq_size sz, const struct jq_parallel *p) {
+    struct jq_parallel_ctx c;
+    unsigned n = p->threads ? p->threads : 1;
+    pthread_t *threads = (pthread_t *)malloc(n * sizeof(pthread_t));
+    jq_bool ok = jq_parallel_init(&c, buf, sz, p, n) && threads;
+    jq_size first = jq_skip_whitespace(buf, 0, sz);
+
+    c.array = JQ_TRUE;
+    c.seeded = first < sz && buf[first] == '[';
+    if (ok && c.seeded && c.chunks > 1) {
+        jq_size ranges = c.chunks;
+
+        c.ranges = (struct jq_parallel_range *)malloc(ranges * sizeof(struct jq_parallel_range));
+        ok = c.ranges != JQ_NULL;
+        if (ok) {
+            jq_parallel_run(&c, threads, n, jq_parallel_scanner);
+            jq_parallel_split(&c, ranges);
+        }
+    } else if (ok) {
+        /* Anything but an array is parsed at once */
+        c.chunks = 1;
+        c.bounds[0] = 0;
+        c.bounds[1] = sz;
+    }
+
+    if (ok) {
+        jq_parallel_run(&c, threads, n, jq_parallel_worker);
+        ok = !c.failed && !c.stopped;
+    }
+    jq_parallel_free(&c);
+    free(threads);
+
+    return ok;
 }
 
+#endif /* JQ_WITH_THREADS */
+
 #endif /* JQ_WITH_IMPLEMENTATION */
 
 #ifdef __cplusplus
@@ -1,8 +1,27 @@
 #include "quin.h"
 #define JQ_WITH_IMPLEMENTATION
+/* The chars the lexer takes are counted, see test_stream_scanned_once */
+static unsigned long lexer_steps;
+#define JQ_PROFILE(h, kind, id) do { if ((kind) == JQ_PROFILE_LEXER) ++lexer_steps; } while (0)
+/* JQ_TEST_DEFAULT tests the default configuration, the tests of the options are left out then */
+#ifndef JQ_TEST_DEFAULT
 #define JQ_WITH_NULLTERM
+#define JQ_WITH_INDEX
+#define JQ_WITH_NUMBERS
+#define JQ_WITH_UNESCAPE
+#define JQ_WITH_UTF8_CHECK
+#define JQ_WITH_TAPE
+#define JQ_WITH_THREADS
+#define JQ_WITH_MMAP
+#define JQ_WITH_READER
+#define JQ_WITH_WRITER
+#define JQ_WITH_STATS
+#define JQ_WITH_LOCATION
+#define JQ_WITH_SUSPEND
+#endif
 #include "jquick.h"
 #include <malloc.h>
+#include <stddef.h>
 #include <string.h>
 
 char *read_json(const char *fname, size_t *rsz) {
@@ -75,6 +94,20 @@ size_t get_file_size(const char *fname) {
     return sz;
 }
 
+static char event_log[65536];
+static size_t event_log_size;
+
+void log_events(struct jq_handler *h, enum jq_event_type e) {
+    const char *val = "";
+    int len = 0;
+
+    if (e == JQ_E_STRING || e == JQ_E_NUMBER || e == JQ_E_OBJECT_KEY) {
+        val = h->val;
+        len = (int)h->vlen;
+    }
+    event_log_size += sprintf(event_log + event_log_size, "%d:%.*s|", (int)e, len, val);
+}
+
 /* ==============================
  *
  * Test suite suite_basic
@@ -143,6 +176,56 @@ TEST_CASE(test_grammar_error)
     TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_PARSER_UNEXPECTED_TOKEN);
 TEST_CASE_END()
 
+/* Objects and arrays mixed at every level, as deep as the stack allows */
+TEST_CASE(test_nesting)
+    static char json[JQ_STACK_SIZE * 8], levels[JQ_STACK_SIZE];
+    struct jq_handler h;
+    jq_uint64 x = 88172645463325252ull;
+    size_t depth = JQ_STACK_SIZE - 1, n = 0, k;
+
+    for (k = 0; k < depth; ++k) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        levels[k] = x & 1 ? '{' : '[';
+        if (levels[k] == '{') {
+            memcpy(json + n, "{\"k\":", 5);
+            n += 5;
+        } else {
+            json[n++] = '[';
+        }
+    }
+    json[n++] = '0';
+    for (k = depth; k--; ) json[n++] = levels[k] == '{' ? '}' : ']';
+
+    jq_init(&h);
+    TEST_REQUIRE(jq_parse_buf(&h, json, n) == JQ_TRUE);
+
+    /* The wrong bracket is found at any depth */
+    for (k = 60; k < 70; ++k) {
+        size_t i = n - 1 - k;
+        json[i] = json[i] == '}' ? ']' : '}';
+        jq_init(&h);
+        TEST_REQUIRE(jq_parse_buf(&h, json, n) == JQ_FALSE);
+        TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_PARSER_UNEXPECTED_TOKEN && jq_get_offset(&h) == i + 1);
+        json[i] = json[i] == '}' ? ']' : '}';
+    }
+
+    /* One level more is too deep, for the streaming parse too */
+    memset(json, '[', JQ_STACK_SIZE);
+    jq_init(&h);
+    TEST_REQUIRE(jq_parse_buf(&h, json, JQ_STACK_SIZE) == JQ_FALSE);
+    TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_MAX_DEPTH && jq_get_offset(&h) == JQ_STACK_SIZE);
+    jq_init(&h);
+    for (k = 0; k < JQ_STACK_SIZE; k += 100) {
+        TEST_REQUIRE(jq_parse_buf(&h, json + k, JQ_STACK_SIZE - k < 100 ? JQ_STACK_SIZE - k : 100) == JQ_FALSE);
+    }
+    TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_MAX_DEPTH);
+
+    /* The fields used for every token come first */
+    if (sizeof(void *) == 8 && sizeof(jq_size) == 8) {
+        TEST_REQUIRE(offsetof(struct jq_handler, stack) <= 64);
+    }
+TEST_CASE_END()
+
 TEST_CASE(test_webapp)
     struct jq_handler h;
     jq_bool r;
@@ -155,6 +238,134 @@ TEST_CASE(test_webapp)
     TEST_REQUIRE(r == JQ_TRUE);
 TEST_CASE_END()
 
+/* Long strings and whitespace runs are scanned by 8 bytes, checking the values on the edges */
+TEST_CASE(test_long_values)
+    struct jq_handler h;
+    char json[] = "[\"0123456789abcdef0123456789\\\"bcdef0123456\",        \"x\"              ,\"0123456\"]";
+
+    jq_init(&h);
+    jq_set_callback(&h, log_events);
+    event_log_size = 0;
+    TEST_REQUIRE(jq_parse_buf(&h, json, sizeof(json) - 1) == JQ_TRUE);
+#ifdef JQ_WITH_UNESCAPE
+    TEST_REQUIRE(strcmp(event_log, "91:|260:0123456789abcdef0123456789\"bcdef0123456|260:x|260:0123456|93:|") == 0);
+#else
+    TEST_REQUIRE(strcmp(event_log, "91:|260:0123456789abcdef0123456789\\\"bcdef0123456|260:x|260:0123456|93:|") == 0);
+#endif
+TEST_CASE_END()
+
+#ifdef JQ_WITH_UNESCAPE
+static char strings[256];
+static size_t strings_size;
+
+void collect_strings(struct jq_handler *h, enum jq_event_type e) {
+    if (e != JQ_E_STRING && e != JQ_E_OBJECT_KEY) return;
+
+    memcpy(strings + strings_size, h->val, h->vlen);
+    strings_size += h->vlen;
+    strings[strings_size++] = '|';
+}
+
+/* Escapes are decoded in place, surrogate pairs go to 4 byte UTF-8, lone surrogates to U+FFFD */
+TEST_CASE(test_unescape)
+    struct jq_handler h;
+    char json[] = "[\"a\\u00e9\\uD83D\\uDE00\\n\\u0000z\", {\"k\\\"\\/ey\": \"\\uD800x\\uDC00\"}, \"plain\"]";
+    const char expected[] = "a\xc3\xa9\xf0\x9f\x98\x80\n\0z|k\"/ey|\xef\xbf\xbdx\xef\xbf\xbd|plain|";
+    size_t chunk;
+
+    jq_init(&h);
+    jq_set_callback(&h, collect_strings);
+    strings_size = 0;
+    TEST_REQUIRE(jq_parse_buf(&h, json, sizeof(json) - 1) == JQ_TRUE);
+    TEST_REQUIRE(strings_size == sizeof(expected) - 1);
+    TEST_REQUIRE(memcmp(strings, expected, strings_size) == 0);
+
+    /* The same with every escape sequence interrupted by the end of the buffer */
+    for (chunk = 1; chunk < 8; ++chunk) {
+        const char src[] = "[\"a\\u00e9\\uD83D\\uDE00\\n\\u0000z\", {\"k\\\"\\/ey\": \"\\uD800x\\uDC00\"}, \"plain\"]";
+        char part[sizeof(src) + 8];
+        size_t cur;
+
+        jq_init(&h);
+        jq_set_callback(&h, collect_strings);
+        strings_size = 0;
+        for (cur = 0; cur < sizeof(src) - 1; cur += chunk) {
+            size_t n = sizeof(src) - 1 - cur < chunk ? sizeof(src) - 1 - cur : chunk;
+            size_t tail_size = jq_get_tail_size(&h);
+
+            memmove(part, jq_get_tail(&h), tail_size);
+            memcpy(part + tail_size, src + cur, n);
+            jq_parse_buf(&h, part, tail_size + n);
+        }
+        TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_OK);
+        TEST_REQUIRE(strings_size == sizeof(expected) - 1);
+        TEST_REQUIRE(memcmp(strings, expected, strings_size) == 0);
+    }
+TEST_CASE_END()
+#endif
+
+#if defined(JQ_WITH_UTF8_CHECK) && defined(JQ_WITH_INDEX)
+/* UTF-8 of strings is validated while they are scanned, raw control chars are rejected */
+TEST_CASE(test_utf8)
+    struct jq_handler h;
+    jq_index index[64];
+    const char *valid = "[\"caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80 \xf4\x8f\xbf\xbf and some ASCII to fill a SIMD block\", \"\xed\x9f\xbf\"]";
+    const char *invalid[] = {
+        "[\"overlong \xc0\xaf\"]",
+        "[\"surrogate \xed\xa0\x80\"]",
+        "[\"too big \xf4\x90\x80\x80\"]",
+        "[\"truncated \xe2\x82\"]",
+        "[\"stray continuation \x80 in a long enough string to be scanned by blocks\"]",
+        "[\"invalid byte \xff\"]"
+    };
+    char json[128];
+    size_t k, chunk;
+
+    for (k = 0; k < 2; ++k) {
+        strcpy(json, valid);
+        jq_init(&h);
+        if (k) jq_set_index(&h, index, 64);
+        TEST_REQUIRE(jq_parse_buf(&h, json, strlen(json)) == JQ_TRUE);
+
+        strcpy(json, "[\"tab\tinside\"]");
+        jq_init(&h);
+        if (k) jq_set_index(&h, index, 64);
+        TEST_REQUIRE(jq_parse_buf(&h, json, strlen(json)) == JQ_FALSE);
+        TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_LEXER_CONTROL_CHAR);
+    }
+
+    for (k = 0; k < sizeof(invalid) / sizeof(invalid[0]); ++k) {
+        strcpy(json, invalid[k]);
+        jq_init(&h);
+        TEST_REQUIRE(jq_parse_buf(&h, json, strlen(json)) == JQ_FALSE);
+        TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_LEXER_INVALID_UTF8);
+
+        strcpy(json, invalid[k]);
+        jq_init(&h);
+        jq_set_index(&h, index, 64);
+        TEST_REQUIRE(jq_parse_buf(&h, json, strlen(json)) == JQ_FALSE);
+        TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_LEXER_INVALID_UTF8);
+    }
+
+    /* Multibyte sequences interrupted by the end of the buffer */
+    for (chunk = 1; chunk < 5; ++chunk) {
+        char part[sizeof(json) + 8];
+        size_t cur, sz = strlen(valid);
+
+        jq_init(&h);
+        for (cur = 0; cur < sz; cur += chunk) {
+            size_t n = sz - cur < chunk ? sz - cur : chunk;
+            size_t tail_size = jq_get_tail_size(&h);
+
+            memmove(part, jq_get_tail(&h), tail_size);
+            memcpy(part + tail_size, valid + cur, n);
+            jq_parse_buf(&h, part, tail_size + n);
+        }
+        TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_OK);
+    }
+TEST_CASE_END()
+#endif
+
 /*
  * main suite_basic function
  */
@@ -165,7 +376,15 @@ TEST_SUITE(suite_basic)
     TEST_CASE_RUN(test_esc_unicode);
     TEST_CASE_RUN(test_lexical_error);
     TEST_CASE_RUN(test_grammar_error);
+    TEST_CASE_RUN(test_nesting);
     TEST_CASE_RUN(test_webapp);
+    TEST_CASE_RUN(test_long_values);
+#ifdef JQ_WITH_UNESCAPE
+    TEST_CASE_RUN(test_unescape);
+#endif
+#if defined(JQ_WITH_UTF8_CHECK) && defined(JQ_WITH_INDEX)
+    TEST_CASE_RUN(test_utf8);
+#endif
 TEST_SUITE_END()
 
 /* ==============================
@@ -293,6 +512,152 @@ TEST_CASE(test_stream_sequential)
     TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_OK);
 TEST_CASE_END()
 
+static int event_count;
+
+void count_events(struct jq_handler *h, enum jq_event_type e) {
+    (void)h;
+    (void)e;
+    ++event_count;
+}
+
+/* Parses fname feeding it by chunk bytes with the tail carried over to the next chunk, index is of jq_index */
+jq_bool parse_by_chunks(struct jq_handler *h, const char *fname, size_t chunk, void *index, jq_size cap) {
+    jq_bool r = JQ_FALSE;
+    size_t sz, cur;
+    char *part;
+    char *json = read_json(fname, &sz);
+    if (!json) return JQ_FALSE;
+
+    part = (char *)malloc(sz);
+    jq_init(h);
+    jq_set_callback(h, count_events);
+#ifdef JQ_WITH_INDEX
+    if (index) jq_set_index(h, (jq_index *)index, cap);
+#else
+    (void)index;
+    (void)cap;
+#endif
+    for (cur = 0; cur < sz; cur += chunk) {
+        size_t n = sz - cur < chunk ? sz - cur : chunk;
+        size_t tail_size = jq_get_tail_size(h);
+
+        memmove(part, jq_get_tail(h), tail_size);
+        memcpy(part + tail_size, json + cur, n);
+        r = jq_parse_buf(h, part, tail_size + n);
+        if (!r && jq_get_error(h) != JQ_ERR_LEXER_NEED_MORE) break;
+    }
+
+    free(part);
+    free(json);
+
+    return r;
+}
+
+/* Feeding json by small chunks, every token is interrupted at every possible position */
+TEST_CASE(test_stream_chunks)
+    struct jq_handler h;
+    const char *files[] = { "../assets/web-app.json", "../assets/glossary-esc-unicode.json" };
+    size_t chunks[] = { 1, 2, 3, 7, 64 };
+    size_t f, c;
+
+    for (f = 0; f < sizeof(files) / sizeof(files[0]); ++f) {
+        int expected;
+
+        event_count = 0;
+        TEST_REQUIRE(parse_by_chunks(&h, files[f], (size_t)-1 / 2, NULL, 0) == JQ_TRUE);
+        expected = event_count;
+        for (c = 0; c < sizeof(chunks) / sizeof(chunks[0]); ++c) {
+            event_count = 0;
+            TEST_REQUIRE(parse_by_chunks(&h, files[f], chunks[c], NULL, 0) == JQ_TRUE);
+            TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_OK);
+            TEST_REQUIRE(event_count == expected);
+        }
+    }
+TEST_CASE_END()
+
+/* The end of the input finishes a number of any length, a cut literal stays cut */
+TEST_CASE(test_stream_input_end)
+    struct jq_handler h;
+    size_t chunks[] = { 1, 7, 64, 100 };
+    char expected[128], part[128], cut[] = "[1, tru";
+    size_t c, cur, sz;
+    char *json = read_json("../assets/long-number.json", &sz);
+    jq_bool r = JQ_FALSE;
+
+    TEST_REQUIRE(json != NULL && sz == 100);
+    sprintf(expected, "%d:%.*s|", JQ_E_NUMBER, (int)sz, json);
+    for (c = 0; c < sizeof(chunks) / sizeof(chunks[0]); ++c) {
+        event_log_size = 0;
+        jq_init(&h);
+        jq_set_callback(&h, log_events);
+        for (cur = 0; cur < sz; cur += chunks[c]) {
+            size_t n = sz - cur < chunks[c] ? sz - cur : chunks[c];
+            size_t tail_size = jq_get_tail_size(&h);
+
+            memmove(part, jq_get_tail(&h), tail_size);
+            memcpy(part + tail_size, json + cur, n);
+            jq_set_input_end(&h, cur + n == sz);
+            r = jq_parse_buf(&h, part, tail_size + n);
+        }
+        TEST_REQUIRE(r == JQ_TRUE);
+        TEST_REQUIRE(strcmp(event_log, expected) == 0);
+    }
+    free(json);
+
+    jq_init(&h);
+    jq_set_input_end(&h, JQ_TRUE);
+    TEST_REQUIRE(jq_parse_buf(&h, cut, sizeof(cut) - 1) == JQ_FALSE);
+    TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_LEXER_NEED_MORE);
+TEST_CASE_END()
+
+/* A token longer than the buffer is scanned once, its tail is moved to every next buffer though */
+TEST_CASE(test_stream_scanned_once)
+    static char json[65536], part[65536];
+    size_t sz = sizeof(json) - 2, chunk = 1024, cur, moved, k, i;
+    unsigned long whole;
+    struct jq_handler h;
+    jq_bool r = JQ_FALSE;
+
+    /* The digits of a number and the escapes of a string are taken by the lexer one by one */
+    for (k = 0; k < 2; ++k) {
+        json[0] = k ? '"' : '[';
+        for (i = 1; i < sz - 1; ++i) json[i] = k ? (i % 2 ? '\\' : 't') : '7';
+        json[sz - 1] = k ? '"' : ']';
+
+        lexer_steps = 0;
+        memcpy(part, json, sz);
+        jq_init(&h);
+        TEST_REQUIRE(jq_parse_buf(&h, part, sz) == JQ_TRUE);
+        whole = lexer_steps;
+
+        lexer_steps = 0;
+        moved = 0;
+        jq_init(&h);
+        for (cur = 0; cur < sz; cur += chunk) {
+            size_t n = sz - cur < chunk ? sz - cur : chunk;
+            size_t tail_size = jq_get_tail_size(&h);
+
+            memmove(part, jq_get_tail(&h), tail_size);
+            memcpy(part + tail_size, json + cur, n);
+            moved += tail_size;
+            r = jq_parse_buf(&h, part, tail_size + n);
+        }
+        TEST_REQUIRE(r == JQ_TRUE);
+        /* A char more for every buffer, which ends it */
+        TEST_REQUIRE(lexer_steps <= whole + sz / chunk + 1);
+        /* The tails moved are about sz * sz / chunk / 2 bytes */
+        TEST_REQUIRE(moved > sz / chunk * (sz / 4));
+#ifdef JQ_WITH_STATS
+        {
+            struct jq_stats st;
+
+            jq_get_stats(&h, &st);
+            TEST_REQUIRE(st.tail_bytes == moved);
+        }
+#endif
+    }
+TEST_CASE_END()
+
 /*
  * main suite_stream function
  */
@@ -301,7 +666,2356 @@ TEST_SUITE(suite_streaming)
     TEST_CASE_RUN(test_stream);
     TEST_CASE_RUN(test_stream_four_parts);
     TEST_CASE_RUN(test_stream_sequential);
+    TEST_CASE_RUN(test_stream_chunks);
+    TEST_CASE_RUN(test_stream_input_end);
+    TEST_CASE_RUN(test_stream_scanned_once);
+TEST_SUITE_END()
+
+/* ==============================
+ *
+ * Test suite suite_index
+ *
+ ================================ */
+
+/* Parses fname logging the events into event_log, index is of jq_index */
+jq_bool parse_logged(const char *fname, void *index, jq_size cap) {
+    struct jq_handler h;
+    jq_bool r;
+    size_t sz;
+    char *json = read_json(fname, &sz);
+    if (!json) return JQ_FALSE;
+
+    event_log_size = 0;
+    jq_init(&h);
+    jq_set_callback(&h, log_events);
+#ifdef JQ_WITH_INDEX
+    if (index) jq_set_index(&h, (jq_index *)index, cap);
+#else
+    (void)index;
+    (void)cap;
+#endif
+    r = jq_parse_buf(&h, json, sz);
+    free(json);
+
+    return r;
+}
+
+#ifdef JQ_WITH_INDEX
+/* The index must give the same events as the lexer */
+TEST_CASE(test_index_events)
+    const char *files[] = { "../assets/glossary.json", "../assets/glossary-esc.json",
+        "../assets/glossary-esc-unicode.json", "../assets/web-app.json" };
+    jq_size caps[] = { 64, 100, 4096 };
+    jq_index index[4096];
+    static char expected[sizeof(event_log)];
+    size_t f, c;
+
+    for (f = 0; f < sizeof(files) / sizeof(files[0]); ++f) {
+        TEST_REQUIRE(parse_logged(files[f], NULL, 0) == JQ_TRUE);
+        memcpy(expected, event_log, event_log_size + 1);
+        for (c = 0; c < sizeof(caps) / sizeof(caps[0]); ++c) {
+            TEST_REQUIRE(parse_logged(files[f], index, caps[c]) == JQ_TRUE);
+            TEST_REQUIRE(strcmp(expected, event_log) == 0);
+        }
+    }
+TEST_CASE_END()
+
+TEST_CASE(test_index_errors)
+    struct jq_handler h;
+    jq_index index[64];
+    char lexical[] = "{ \"a\": [1, 2, nulx] }";
+    char grammar[] = "{ \"a\": [1, 2 3] }";
+    char escape[] = "{ \"a\\q\": 1 }";
+    char scalar[] = "[ 1, 2x ] ";
+
+    jq_init(&h);
+    TEST_REQUIRE(jq_set_index(&h, index, 63) == JQ_FALSE);
+    TEST_REQUIRE(jq_set_index(&h, index, 64) == JQ_TRUE);
+    TEST_REQUIRE(jq_parse_buf(&h, lexical, sizeof(lexical) - 1) == JQ_FALSE);
+    TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_LEXER_UNKNOWN_TOKEN);
+
+    jq_init(&h);
+    jq_set_index(&h, index, 64);
+    TEST_REQUIRE(jq_parse_buf(&h, grammar, sizeof(grammar) - 1) == JQ_FALSE);
+    TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_PARSER_UNEXPECTED_TOKEN);
+
+    jq_init(&h);
+    jq_set_index(&h, index, 64);
+    TEST_REQUIRE(jq_parse_buf(&h, escape, sizeof(escape) - 1) == JQ_FALSE);
+    TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_LEXER_UNKNOWN_ESCAPE_SYMBOL);
+
+    jq_init(&h);
+    jq_set_index(&h, index, 64);
+    TEST_REQUIRE(jq_parse_buf(&h, scalar, sizeof(scalar) - 1) == JQ_FALSE);
+    TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_LEXER_UNKNOWN_TOKEN);
+TEST_CASE_END()
+
+TEST_CASE(test_index_stream_chunks)
+    struct jq_handler h;
+    jq_index index[64];
+    size_t chunks[] = { 1, 7, 64, 100 };
+    size_t c;
+    int expected;
+
+    event_count = 0;
+    TEST_REQUIRE(parse_by_chunks(&h, "../assets/web-app.json", (size_t)-1 / 2, NULL, 0) == JQ_TRUE);
+    expected = event_count;
+    for (c = 0; c < sizeof(chunks) / sizeof(chunks[0]); ++c) {
+        event_count = 0;
+        TEST_REQUIRE(parse_by_chunks(&h, "../assets/web-app.json", chunks[c], index, 64) == JQ_TRUE);
+        TEST_REQUIRE(event_count == expected);
+    }
+TEST_CASE_END()
+
+/*
+ * main suite_index function
+ */
+
+TEST_SUITE(suite_index)
+    TEST_CASE_RUN(test_index_events);
+    TEST_CASE_RUN(test_index_errors);
+    TEST_CASE_RUN(test_index_stream_chunks);
+TEST_SUITE_END()
+#endif
+
+/* ==============================
+ *
+ * Test suite suite_numbers
+ *
+ ================================ */
+
+#ifdef JQ_WITH_NUMBERS
+static struct {
+    jq_bool is_int64, is_uint64;
+    jq_int64 i;
+    jq_uint64 u;
+    double d;
+    int flags;
+} numbers[16];
+static int number_count;
+
+void collect_numbers(struct jq_handler *h, enum jq_event_type e) {
+    if (e != JQ_E_NUMBER || number_count == 16) return;
+
+    numbers[number_count].is_int64 = jq_get_int64(h, &numbers[number_count].i);
+    numbers[number_count].is_uint64 = jq_get_uint64(h, &numbers[number_count].u);
+    numbers[number_count].d = jq_get_double(h);
+    numbers[number_count].flags = jq_get_number_flags(h);
+    ++number_count;
+}
+
+jq_bool parse_numbers(char *json, size_t sz) {
+    struct jq_handler h;
+
+    number_count = 0;
+    jq_init(&h);
+    jq_set_callback(&h, collect_numbers);
+
+    return jq_parse_buf(&h, json, sz);
+}
+
+TEST_CASE(test_number_integers)
+    char json[] = "[0, -0, 42, -42, 9223372036854775807, -9223372036854775808, 9223372036854775808, "
+                  "18446744073709551615, 18446744073709551616, -9223372036854775809]";
+
+    TEST_REQUIRE(parse_numbers(json, sizeof(json) - 1) == JQ_TRUE);
+    TEST_REQUIRE(number_count == 10);
+    TEST_REQUIRE(numbers[0].is_int64 && numbers[0].i == 0 && numbers[0].is_uint64 && numbers[0].flags == JQ_N_INTEGRAL);
+    TEST_REQUIRE(numbers[1].is_int64 && numbers[1].i == 0 && numbers[1].is_uint64 && numbers[1].flags == (JQ_N_INTEGRAL | JQ_N_NEGATIVE));
+    TEST_REQUIRE(numbers[2].is_int64 && numbers[2].i == 42 && numbers[2].is_uint64 && numbers[2].u == 42);
+    TEST_REQUIRE(numbers[3].is_int64 && numbers[3].i == -42 && !numbers[3].is_uint64 && numbers[3].d == -42.0);
+    TEST_REQUIRE(numbers[4].is_int64 && numbers[4].i == 0x7fffffffffffffffll);
+    TEST_REQUIRE(numbers[5].is_int64 && numbers[5].i == -0x7fffffffffffffffll - 1 && !numbers[5].is_uint64);
+    TEST_REQUIRE(!numbers[6].is_int64 && numbers[6].is_uint64 && numbers[6].u == 0x8000000000000000ull);
+    TEST_REQUIRE(!numbers[7].is_int64 && numbers[7].is_uint64 && numbers[7].u == 0xffffffffffffffffull);
+    TEST_REQUIRE(!numbers[8].is_int64 && !numbers[8].is_uint64 && (numbers[8].flags & JQ_N_OVERFLOW));
+    TEST_REQUIRE(numbers[8].d == 18446744073709551616.0);
+    TEST_REQUIRE(!numbers[9].is_int64 && !numbers[9].is_uint64 && (numbers[9].flags & JQ_N_OVERFLOW));
+TEST_CASE_END()
+
+TEST_CASE(test_number_doubles)
+    char json[] = "[0.1, -2.5e-3, 1e5, 1E+2, 0e10, -0.0, 1.7976931348623157e308, 1e309, 4.9406564584124654e-324, 1e-400, "
+                  "9007199254740993, 9007199254740993.000000000000000000001, 0.30000000000000000000000000000000000001]";
+
+    TEST_REQUIRE(parse_numbers(json, sizeof(json) - 1) == JQ_TRUE);
+    TEST_REQUIRE(number_count == 13);
+    TEST_REQUIRE(numbers[0].d == 0.1 && !numbers[0].is_int64 && numbers[0].flags == 0);
+    TEST_REQUIRE(numbers[1].d == -2.5e-3 && numbers[1].flags == JQ_N_NEGATIVE);
+    TEST_REQUIRE(numbers[2].d == 1e5 && !numbers[2].is_int64);
+    TEST_REQUIRE(numbers[3].d == 100.0);
+    TEST_REQUIRE(numbers[4].d == 0.0);
+    TEST_REQUIRE(numbers[5].d == 0.0 && numbers[5].flags == JQ_N_NEGATIVE);
+    TEST_REQUIRE(numbers[6].d == 1.7976931348623157e308);
+    TEST_REQUIRE(numbers[7].d > 1.7976931348623157e308);
+    TEST_REQUIRE(numbers[8].d == 4.9406564584124654e-324);
+    TEST_REQUIRE(numbers[9].d == 0.0);
+    /* Halfway between two doubles, rounding to even, then the digits far away break the tie */
+    TEST_REQUIRE(numbers[10].d == 9007199254740992.0);
+    TEST_REQUIRE(numbers[11].d == 9007199254740994.0);
+    TEST_REQUIRE(numbers[12].d == 0.3);
+TEST_CASE_END()
+
+TEST_CASE(test_number_grammar)
+    char minus[] = "[-]";
+    char point[] = "[1.]";
+    char minus_point[] = "[-.5]";
+    char exponent[] = "[1e]";
+    char leading_zero[] = "[01]";
+
+    TEST_REQUIRE(parse_numbers(minus, sizeof(minus) - 1) == JQ_FALSE);
+    TEST_REQUIRE(parse_numbers(point, sizeof(point) - 1) == JQ_FALSE);
+    TEST_REQUIRE(parse_numbers(minus_point, sizeof(minus_point) - 1) == JQ_FALSE);
+    TEST_REQUIRE(parse_numbers(exponent, sizeof(exponent) - 1) == JQ_FALSE);
+    TEST_REQUIRE(parse_numbers(leading_zero, sizeof(leading_zero) - 1) == JQ_FALSE);
+TEST_CASE_END()
+
+/*
+ * main suite_numbers function
+ */
+
+TEST_SUITE(suite_numbers)
+    TEST_CASE_RUN(test_number_integers);
+    TEST_CASE_RUN(test_number_doubles);
+    TEST_CASE_RUN(test_number_grammar);
+TEST_SUITE_END()
+#endif
+
+/* ==============================
+ *
+ * Test suite suite_tape
+ *
+ ================================ */
+
+#if defined(JQ_WITH_TAPE) && defined(JQ_WITH_NUMBERS)
+TEST_CASE(test_tape_layout)
+    struct jq_handler h;
+    jq_uint64 tape[32];
+    char json[] = "{\"a\": [1, -2, 18446744073709551615, 0.5], \"b\": {\"c\": null}, \"d\": \"str\", \"e\": true}";
+    jq_size i;
+
+    jq_init(&h);
+    jq_set_tape(&h, tape, 32);
+    TEST_REQUIRE(jq_parse_buf(&h, json, sizeof(json) - 1) == JQ_TRUE);
+    TEST_REQUIRE(jq_get_tape_size(&h) == 28);
+
+    TEST_REQUIRE(jq_tape_type(tape[0]) == JQ_TAPE_OBJECT_BEGIN && jq_tape_payload(tape[0]) == 27);
+    TEST_REQUIRE(jq_tape_type(tape[27]) == JQ_TAPE_OBJECT_END && jq_tape_payload(tape[27]) == 0);
+    TEST_REQUIRE(jq_tape_type(tape[1]) == JQ_TAPE_KEY && jq_tape_payload(tape[1]) == 2 && tape[2] == 1);
+    TEST_REQUIRE(jq_tape_type(tape[3]) == JQ_TAPE_ARRAY_BEGIN && jq_tape_payload(tape[3]) == 12);
+    TEST_REQUIRE(jq_tape_type(tape[4]) == JQ_TAPE_INT64 && (jq_int64)tape[5] == 1);
+    TEST_REQUIRE(jq_tape_type(tape[6]) == JQ_TAPE_INT64 && (jq_int64)tape[7] == -2);
+    TEST_REQUIRE(jq_tape_type(tape[8]) == JQ_TAPE_UINT64 && tape[9] == 0xffffffffffffffffull);
+    TEST_REQUIRE(jq_tape_type(tape[10]) == JQ_TAPE_DOUBLE && jq_tape_double(tape[11]) == 0.5);
+    TEST_REQUIRE(jq_tape_type(tape[12]) == JQ_TAPE_ARRAY_END && jq_tape_payload(tape[12]) == 3);
+
+    /* Walking the keys of the root object, the values are skipped in one step */
+    i = 1;
+    TEST_REQUIRE(json[jq_tape_payload(tape[i])] == 'a');
+    i = jq_tape_next(tape, jq_tape_next(tape, i));
+    TEST_REQUIRE(i == 13 && json[jq_tape_payload(tape[i])] == 'b');
+    i = jq_tape_next(tape, jq_tape_next(tape, i));
+    TEST_REQUIRE(i == 20 && json[jq_tape_payload(tape[i])] == 'd');
+    TEST_REQUIRE(jq_tape_type(tape[22]) == JQ_TAPE_STRING && tape[23] == 3);
+    TEST_REQUIRE(memcmp(json + jq_tape_payload(tape[22]), "str", 3) == 0);
+    i = jq_tape_next(tape, jq_tape_next(tape, i));
+    TEST_REQUIRE(i == 24 && jq_tape_type(tape[26]) == JQ_TAPE_TRUE);
+    TEST_REQUIRE(jq_tape_next(tape, jq_tape_next(tape, i)) == 27);
+TEST_CASE_END()
+
+/* The size is queried first, then the tape of exactly that size is filled */
+TEST_CASE(test_tape_size_query)
+    struct jq_handler h;
+    jq_uint64 *tape;
+    jq_size size;
+    size_t sz;
+    char *json = read_json("../assets/web-app.json", &sz);
+    if (!json) return 0;
+
+    jq_init(&h);
+    jq_set_tape(&h, JQ_NULL, 0);
+    TEST_REQUIRE(jq_parse_buf(&h, json, sz) == JQ_TRUE);
+    size = jq_get_tape_size(&h);
+    TEST_REQUIRE(size > 0);
+    free(json);
+
+    tape = (jq_uint64 *)malloc(size * sizeof(jq_uint64));
+    json = read_json("../assets/web-app.json", &sz);
+    jq_init(&h);
+    jq_set_tape(&h, tape, size - 1);
+    TEST_REQUIRE(jq_parse_buf(&h, json, sz) == JQ_FALSE);
+    TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_TAPE_FULL);
+    free(json);
+
+    json = read_json("../assets/web-app.json", &sz);
+    jq_init(&h);
+    jq_set_tape(&h, tape, size);
+    TEST_REQUIRE(jq_parse_buf(&h, json, sz) == JQ_TRUE);
+    TEST_REQUIRE(jq_get_tape_size(&h) == size);
+    TEST_REQUIRE(jq_tape_next(tape, 0) == size);
+
+    free(tape);
+    free(json);
+TEST_CASE_END()
+
+/* Offsets of the values are counted from the beginning of the first buffer */
+TEST_CASE(test_tape_stream)
+    struct jq_handler h;
+    jq_uint64 whole[64], chunked[64];
+    const char src[] = "[\"abc\", 12, {\"key\": false}, [], \"long enough string\"]";
+    char part[sizeof(src) + 8];
+    size_t chunk, cur;
+    jq_size size;
+
+    strcpy(part, src);
+    jq_init(&h);
+    jq_set_tape(&h, whole, 64);
+    TEST_REQUIRE(jq_parse_buf(&h, part, sizeof(src) - 1) == JQ_TRUE);
+    size = jq_get_tape_size(&h);
+
+    for (chunk = 1; chunk < 8; ++chunk) {
+        jq_init(&h);
+        jq_set_tape(&h, chunked, 64);
+        for (cur = 0; cur < sizeof(src) - 1; cur += chunk) {
+            size_t n = sizeof(src) - 1 - cur < chunk ? sizeof(src) - 1 - cur : chunk;
+            size_t tail_size = jq_get_tail_size(&h);
+
+            memmove(part, jq_get_tail(&h), tail_size);
+            memcpy(part + tail_size, src + cur, n);
+            jq_parse_buf(&h, part, tail_size + n);
+        }
+        TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_OK);
+        TEST_REQUIRE(jq_get_tape_size(&h) == size);
+        TEST_REQUIRE(memcmp(whole, chunked, size * sizeof(jq_uint64)) == 0);
+    }
+TEST_CASE_END()
+
+/*
+ * main suite_tape function
+ */
+
+TEST_SUITE(suite_tape)
+    TEST_CASE_RUN(test_tape_layout);
+    TEST_CASE_RUN(test_tape_size_query);
+    TEST_CASE_RUN(test_tape_stream);
+TEST_SUITE_END()
+#endif
+
+/* ==============================
+ *
+ * Test suite suite_cursor
+ *
+ ================================ */
+
+/* Pulls all the events logging them the same way as log_events does */
+enum jq_event_type pull_logged(struct jq_handler *h, char *json, size_t sz) {
+    enum jq_event_type e;
+
+    jq_append_buf(h, json, sz);
+    while ((e = jq_next(h)) != JQ_E_DONE && e != JQ_E_ERROR && e != JQ_E_NEED_MORE) {
+        log_events(h, e);
+    }
+
+    return e;
+}
+
+TEST_CASE(test_cursor_events)
+    struct jq_handler h;
+    char json[] = "{\"a\": [1, \"x\", null], \"b\": {}}";
+    char expected[64];
+
+    event_log_size = 0;
+    jq_init(&h);
+    TEST_REQUIRE(pull_logged(&h, json, sizeof(json) - 1) == JQ_E_DONE);
+    sprintf(expected, "%d:|%d:a|%d:|%d:1|%d:x|%d:|%d:|%d:b|%d:|%d:|%d:|",
+            JQ_E_OBJECT_BEGIN, JQ_E_OBJECT_KEY, JQ_E_ARRAY_BEGIN, JQ_E_NUMBER, JQ_E_STRING,
+            JQ_E_NULL, JQ_E_ARRAY_END, JQ_E_OBJECT_KEY, JQ_E_OBJECT_BEGIN, JQ_E_OBJECT_END,
+            JQ_E_OBJECT_END);
+    TEST_REQUIRE(strcmp(event_log, expected) == 0);
+    TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_OK);
+
+    /* Once the document is done there is nothing more to pull */
+    TEST_REQUIRE(jq_next(&h) == JQ_E_DONE);
+TEST_CASE_END()
+
+/* Pull and push parsers give the same events for a real file */
+TEST_CASE(test_cursor_same_as_callback)
+    struct jq_handler h;
+    char push_log[sizeof(event_log)];
+    size_t sz;
+    char *json = read_json("../assets/web-app.json", &sz);
+    if (!json) return 0;
+
+    event_log_size = 0;
+    jq_init(&h);
+    jq_set_callback(&h, log_events);
+    TEST_REQUIRE(jq_parse_buf(&h, json, sz) == JQ_TRUE);
+    memcpy(push_log, event_log, event_log_size + 1);
+    free(json);
+
+    json = read_json("../assets/web-app.json", &sz);
+    event_log_size = 0;
+    jq_init(&h);
+    TEST_REQUIRE(pull_logged(&h, json, sz) == JQ_E_DONE);
+    TEST_REQUIRE(strcmp(push_log, event_log) == 0);
+    free(json);
+TEST_CASE_END()
+
+TEST_CASE(test_cursor_chunks)
+    struct jq_handler h;
+    const char src[] = "[\"abc\", 12, {\"key\": false}, [], \"long enough string\"]";
+    char part[sizeof(src) + 8];
+    char whole_log[256];
+    size_t chunk, cur;
+    enum jq_event_type e = JQ_E_NEED_MORE;
+
+    strcpy(part, src);
+    event_log_size = 0;
+    jq_init(&h);
+    TEST_REQUIRE(pull_logged(&h, part, sizeof(src) - 1) == JQ_E_DONE);
+    strcpy(whole_log, event_log);
+
+    for (chunk = 1; chunk < 8; ++chunk) {
+        event_log_size = 0;
+        jq_init(&h);
+        for (cur = 0; cur < sizeof(src) - 1; cur += chunk) {
+            size_t n = sizeof(src) - 1 - cur < chunk ? sizeof(src) - 1 - cur : chunk;
+            size_t tail_size = jq_get_tail_size(&h);
+            TEST_REQUIRE(e == JQ_E_NEED_MORE);
+            memmove(part, jq_get_tail(&h), tail_size);
+            memcpy(part + tail_size, src + cur, n);
+            e = pull_logged(&h, part, tail_size + n);
+        }
+        TEST_REQUIRE(e == JQ_E_DONE);
+        TEST_REQUIRE(strcmp(whole_log, event_log) == 0);
+        e = JQ_E_NEED_MORE;
+    }
+TEST_CASE_END()
+
+TEST_CASE(test_cursor_grammar)
+    static const char *bad[] = {
+        "[1}", "{\"a\"}", "{\"a\" 1}", "{\"a\": 1 \"b\": 2}", "{{}}", "{1: 2}", "[1 2]", "[1,]",
+        "{\"a\": 1,}", "[,1]", "1 [2]", "\"a\" \"b\"", "[] []", "]", "[]]", "{}}", ":", "[:]"
+    };
+    static const char *good[] = {
+        "[]", "{}", "[[], {}]", "{\"a\": {\"b\": [1, {}]}, \"c\": []}", "  \"str\"  ", "[1, [2, [3]]]"
+    };
+    char json[64];
+    struct jq_handler h;
+    size_t i;
+
+    for (i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+        strcpy(json, bad[i]);
+        jq_init(&h);
+        TEST_REQUIRE(jq_parse_buf(&h, json, strlen(json)) == JQ_FALSE);
+        TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_PARSER_UNEXPECTED_TOKEN);
+    }
+
+    for (i = 0; i < sizeof(good) / sizeof(good[0]); ++i) {
+        strcpy(json, good[i]);
+        jq_init(&h);
+        TEST_REQUIRE(jq_parse_buf(&h, json, strlen(json)) == JQ_TRUE);
+    }
+TEST_CASE_END()
+
+/*
+ * main suite_cursor function
+ */
+
+TEST_SUITE(suite_cursor)
+    TEST_CASE_RUN(test_cursor_events);
+    TEST_CASE_RUN(test_cursor_same_as_callback);
+    TEST_CASE_RUN(test_cursor_chunks);
+    TEST_CASE_RUN(test_cursor_grammar);
+TEST_SUITE_END()
+
+/* ==============================
+ *
+ * Test suite suite_control
+ *
+ ================================ */
+
+static jq_bool stop_at_keys;
+
+/* Keeps "id" keys only and skips arrays, but the root one */
+enum jq_control skip_but_id(struct jq_handler *h, enum jq_event_type e) {
+    log_events(h, e);
+
+    if (e == JQ_E_ARRAY_BEGIN && h->stack_pos > 1) return JQ_C_SKIP;
+    if (e != JQ_E_OBJECT_KEY) return JQ_C_CONTINUE;
+    if (h->vlen != 2 || memcmp(h->val, "id", 2) != 0) return JQ_C_SKIP;
+    return stop_at_keys ? JQ_C_STOP : JQ_C_CONTINUE;
+}
+
+static const char control_json[] =
+    "[{\"a\": {\"x\": [1, \"}]\\\"\", {}]}, \"id\": 7, \"b\": [[1], \"s\"], \"c\": \"q\\\"x\", \"d\": true},"
+    " [1, [2, \"]\"]], {\"n\": -1.5e3, \"id\": \"z\", \"m\": null}]";
+
+jq_bool parse_controlled(char *json, size_t sz) {
+    struct jq_handler h;
+
+    event_log_size = 0;
+    jq_init(&h);
+    jq_set_control_callback(&h, skip_but_id);
+    return jq_parse_buf(&h, json, sz);
+}
+
+TEST_CASE(test_control_skip)
+    char json[sizeof(control_json)];
+    char expected[128];
+
+    strcpy(json, control_json);
+    stop_at_keys = JQ_FALSE;
+    TEST_REQUIRE(parse_controlled(json, sizeof(json) - 1) == JQ_TRUE);
+    sprintf(expected, "%d:|%d:|%d:a|%d:id|%d:7|%d:b|%d:c|%d:d|%d:|%d:|%d:|%d:|%d:n|%d:id|%d:z|%d:m|%d:|%d:|",
+            JQ_E_ARRAY_BEGIN, JQ_E_OBJECT_BEGIN, JQ_E_OBJECT_KEY, JQ_E_OBJECT_KEY, JQ_E_NUMBER,
+            JQ_E_OBJECT_KEY, JQ_E_OBJECT_KEY, JQ_E_OBJECT_KEY, JQ_E_OBJECT_END,
+            JQ_E_ARRAY_BEGIN, JQ_E_ARRAY_END, JQ_E_OBJECT_BEGIN, JQ_E_OBJECT_KEY, JQ_E_OBJECT_KEY,
+            JQ_E_STRING, JQ_E_OBJECT_KEY, JQ_E_OBJECT_END, JQ_E_ARRAY_END);
+    TEST_REQUIRE(strcmp(event_log, expected) == 0);
+
+    /* The closing bracket of skipped content is still checked */
+    strcpy(json, "[[1, 2}]");
+    TEST_REQUIRE(parse_controlled(json, strlen(json)) == JQ_FALSE);
+TEST_CASE_END()
+
+TEST_CASE(test_control_stream)
+    struct jq_handler h;
+    char part[sizeof(control_json) + 8];
+    char whole_log[256];
+    size_t chunk, cur;
+
+    strcpy(part, control_json);
+    stop_at_keys = JQ_FALSE;
+    TEST_REQUIRE(parse_controlled(part, sizeof(control_json) - 1) == JQ_TRUE);
+    strcpy(whole_log, event_log);
+
+    for (chunk = 1; chunk < 10; ++chunk) {
+        event_log_size = 0;
+        jq_init(&h);
+        jq_set_control_callback(&h, skip_but_id);
+        for (cur = 0; cur < sizeof(control_json) - 1; cur += chunk) {
+            size_t n = sizeof(control_json) - 1 - cur < chunk ? sizeof(control_json) - 1 - cur : chunk;
+            size_t tail_size = jq_get_tail_size(&h);
+            memmove(part, jq_get_tail(&h), tail_size);
+            memcpy(part + tail_size, control_json + cur, n);
+            jq_parse_buf(&h, part, tail_size + n);
+        }
+        TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_OK);
+        TEST_REQUIRE(strcmp(whole_log, event_log) == 0);
+    }
+TEST_CASE_END()
+
+/* jq_parse stopped goes on from the next event */
+TEST_CASE(test_control_stop)
+    struct jq_handler h;
+    char json[sizeof(control_json)];
+    char whole_log[256];
+    int stops = 0;
+
+    strcpy(json, control_json);
+    stop_at_keys = JQ_FALSE;
+    TEST_REQUIRE(parse_controlled(json, sizeof(json) - 1) == JQ_TRUE);
+    strcpy(whole_log, event_log);
+
+    strcpy(json, control_json);
+    stop_at_keys = JQ_TRUE;
+    event_log_size = 0;
+    jq_init(&h);
+    jq_set_control_callback(&h, skip_but_id);
+    jq_append_buf(&h, json, sizeof(json) - 1);
+    while (!jq_parse(&h)) {
+        TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_STOPPED);
+        TEST_REQUIRE(h.vlen == 2 && memcmp(h.val, "id", 2) == 0);
+        ++stops;
+    }
+    TEST_REQUIRE(stops == 2);
+    TEST_REQUIRE(strcmp(whole_log, event_log) == 0);
+TEST_CASE_END()
+
+#if defined(JQ_WITH_TAPE) && defined(JQ_WITH_NUMBERS)
+/* Skipped values are left out of the tape, the rest of it is linked as usual */
+TEST_CASE(test_control_tape)
+    struct jq_handler h;
+    jq_uint64 tape[32];
+    char json[sizeof(control_json)];
+
+    strcpy(json, control_json);
+    stop_at_keys = JQ_FALSE;
+    event_log_size = 0;
+    jq_init(&h);
+    jq_set_tape(&h, tape, 32);
+    jq_set_control_callback(&h, skip_but_id);
+    TEST_REQUIRE(jq_parse_buf(&h, json, sizeof(json) - 1) == JQ_TRUE);
+    TEST_REQUIRE(jq_get_tape_size(&h) == 16);
+    TEST_REQUIRE(jq_tape_next(tape, 0) == 16);
+    TEST_REQUIRE(jq_tape_type(tape[1]) == JQ_TAPE_OBJECT_BEGIN && jq_tape_next(tape, 1) == 7);
+    TEST_REQUIRE(jq_tape_type(tape[2]) == JQ_TAPE_KEY && json[jq_tape_payload(tape[2])] == 'i');
+    TEST_REQUIRE(jq_tape_type(tape[4]) == JQ_TAPE_INT64 && tape[5] == 7);
+    TEST_REQUIRE(jq_tape_type(tape[7]) == JQ_TAPE_ARRAY_BEGIN && jq_tape_next(tape, 7) == 9);
+    TEST_REQUIRE(jq_tape_type(tape[9]) == JQ_TAPE_OBJECT_BEGIN && jq_tape_next(tape, 9) == 15);
+    TEST_REQUIRE(jq_tape_type(tape[10]) == JQ_TAPE_KEY && jq_tape_type(tape[12]) == JQ_TAPE_STRING);
+    TEST_REQUIRE(tape[13] == 1 && json[jq_tape_payload(tape[12])] == 'z');
+TEST_CASE_END()
+#endif
+
+/* jq_skip works the same way for the pull parser */
+TEST_CASE(test_control_pull_skip)
+    struct jq_handler h;
+    char json[] = "{\"skip\": {\"deep\": [1, 2, {\"x\": \"{\"}]}, \"keep\": [true, [false], null]}";
+    enum jq_event_type e;
+    int n = 0;
+
+    jq_init(&h);
+    jq_append_buf(&h, json, sizeof(json) - 1);
+    while ((e = jq_next(&h)) != JQ_E_DONE) {
+        TEST_REQUIRE(e != JQ_E_ERROR && e != JQ_E_NEED_MORE);
+        ++n;
+        if (e == JQ_E_OBJECT_KEY && h.vlen == 4 && memcmp(h.val, "skip", 4) == 0) jq_skip(&h);
+        if (e == JQ_E_TRUE) jq_skip(&h);
+    }
+    /* {, "skip", "keep", [, true, ], } */
+    TEST_REQUIRE(n == 7);
+TEST_CASE_END()
+
+/*
+ * main suite_control function
+ */
+
+TEST_SUITE(suite_control)
+    TEST_CASE_RUN(test_control_skip);
+    TEST_CASE_RUN(test_control_stream);
+    TEST_CASE_RUN(test_control_stop);
+#if defined(JQ_WITH_TAPE) && defined(JQ_WITH_NUMBERS)
+    TEST_CASE_RUN(test_control_tape);
+#endif
+    TEST_CASE_RUN(test_control_pull_skip);
+TEST_SUITE_END()
+
+/* ==============================
+ *
+ * Test suite suite_multi
+ *
+ ================================ */
+
+static const char multi_json[] =
+    "{\"a\": [1, \"x\"]}\n{\"b\": null}\r\n\x1e[true]\n\x1e\"str\"\n 42 \n{}[]\"x\"-1.5 ";
+
+/* Logs the events with the document offsets */
+void log_documents(struct jq_handler *h, enum jq_event_type e) {
+    if (e == JQ_E_DOCUMENT_BEGIN) {
+        event_log_size += sprintf(event_log + event_log_size, "<%lu ", (unsigned long)jq_get_document_offset(h));
+    } else if (e == JQ_E_DOCUMENT_END) {
+        event_log_size += sprintf(event_log + event_log_size, "%lu> ", (unsigned long)jq_get_offset(h));
+    } else {
+        log_events(h, e);
+    }
+}
+
+TEST_CASE(test_multi_documents)
+    struct jq_handler h;
+    char json[sizeof(multi_json)];
+    char *p;
+    int begins = 0;
+
+    strcpy(json, multi_json);
+    event_log_size = 0;
+    jq_init(&h);
+    jq_set_multi(&h, JQ_TRUE);
+    jq_set_callback(&h, log_documents);
+    TEST_REQUIRE(jq_parse_buf(&h, json, sizeof(json) - 1) == JQ_TRUE);
+    TEST_REQUIRE(jq_get_tail_size(&h) == 0);
+
+    for (p = event_log; (p = strchr(p, '<')) != NULL; ++p) ++begins;
+    TEST_REQUIRE(begins == 9);
+    TEST_REQUIRE(strncmp(event_log, "<0 ", 3) == 0);
+    TEST_REQUIRE(strstr(event_log, "15> <16 ") != NULL); /* "\n" between */
+    TEST_REQUIRE(strstr(event_log, "27> <30 ") != NULL); /* "\r\n\x1e" between */
+    TEST_REQUIRE(strstr(event_log, "53> <53 ") != NULL); /* "{}[]" */
+    TEST_REQUIRE(strstr(event_log, "60> ") == event_log + event_log_size - 4);
+
+    /* The same input is one document and something unexpected after it without the mode */
+    strcpy(json, multi_json);
+    jq_init(&h);
+    TEST_REQUIRE(jq_parse_buf(&h, json, sizeof(json) - 1) == JQ_FALSE);
+    TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_PARSER_UNEXPECTED_TOKEN);
+TEST_CASE_END()
+
+TEST_CASE(test_multi_stream)
+    struct jq_handler h;
+    char part[sizeof(multi_json) + 8];
+    char whole_log[512];
+#ifdef JQ_WITH_INDEX
+    jq_index index[64];
+    int passes = 2;
+#else
+    int passes = 1;
+#endif
+    size_t chunk, cur;
+    int with_index;
+
+    strcpy(part, multi_json);
+    event_log_size = 0;
+    jq_init(&h);
+    jq_set_multi(&h, JQ_TRUE);
+    jq_set_callback(&h, log_documents);
+    TEST_REQUIRE(jq_parse_buf(&h, part, sizeof(multi_json) - 1) == JQ_TRUE);
+    strcpy(whole_log, event_log);
+
+    for (with_index = 0; with_index < passes; ++with_index) {
+        for (chunk = 1; chunk < 10; ++chunk) {
+            jq_bool r = JQ_FALSE;
+
+            event_log_size = 0;
+            jq_init(&h);
+            jq_set_multi(&h, JQ_TRUE);
+            jq_set_callback(&h, log_documents);
+#ifdef JQ_WITH_INDEX
+            if (with_index) jq_set_index(&h, index, 64);
+#endif
+            for (cur = 0; cur < sizeof(multi_json) - 1; cur += chunk) {
+                size_t n = sizeof(multi_json) - 1 - cur < chunk ? sizeof(multi_json) - 1 - cur : chunk;
+                size_t tail_size = jq_get_tail_size(&h);
+                memmove(part, jq_get_tail(&h), tail_size);
+                memcpy(part + tail_size, multi_json + cur, n);
+                r = jq_parse_buf(&h, part, tail_size + n);
+                /* A buffer ending between documents leaves nothing behind */
+                TEST_REQUIRE(r == (jq_get_error(&h) == JQ_ERR_OK));
+                TEST_REQUIRE(!r || jq_get_tail_size(&h) == 0);
+            }
+            TEST_REQUIRE(r == JQ_TRUE);
+            TEST_REQUIRE(strcmp(whole_log, event_log) == 0);
+        }
+    }
+TEST_CASE_END()
+
+/*
+ * main suite_multi function
+ */
+
+TEST_SUITE(suite_multi)
+    TEST_CASE_RUN(test_multi_documents);
+    TEST_CASE_RUN(test_multi_stream);
+TEST_SUITE_END()
+
+/* ==============================
+ *
+ * Test suite suite_parallel
+ *
+ ================================ */
+
+#ifdef JQ_WITH_THREADS
+#define NDJSON_LINES 3000
+
+struct parallel_record {
+    jq_size offset, size, tape_size;
+    enum jq_error error;
+    jq_int64 id;
+};
+
+static struct parallel_record parallel_records[2 * NDJSON_LINES];
+static size_t parallel_count;
+static size_t parallel_events;
+static pthread_mutex_t parallel_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Every 7th line is broken, every 11th has two values, every 13th is empty */
+char *make_ndjson(size_t *sz) {
+    char *json = (char *)malloc(NDJSON_LINES * 64);
+    size_t i;
+
+    *sz = 0;
+    for (i = 0; i < NDJSON_LINES; ++i) {
+        if (i % 13 == 0) {
+            *sz += sprintf(json + *sz, "\n");
+        } else if (i % 7 == 3) {
+            *sz += sprintf(json + *sz, "{\"id\": %u, \"x\": [1, 2}\n", (unsigned)i);
+        } else if (i % 11 == 5) {
+            *sz += sprintf(json + *sz, "[%u] \"x\"\r\n", (unsigned)i);
+        } else {
+            *sz += sprintf(json + *sz, "{\"id\": %u, \"s\": \"a\\\"b\", \"a\": [1.5, true, null, {}]}\n", (unsigned)i);
+        }
+    }
+
+    return json;
+}
+
+void collect_record(void *udata, const struct jq_record *r) {
+    struct parallel_record *pr;
+    (void)udata;
+
+    pthread_mutex_lock(&parallel_lock);
+    pr = &parallel_records[parallel_count++];
+    pr->offset = r->offset;
+    pr->size = r->size;
+    pr->tape_size = r->tape_size;
+    pr->error = r->error;
+    pr->id = -1;
+    if (r->error == JQ_ERR_OK && jq_tape_type(r->tape[r->tape_pos]) == JQ_TAPE_OBJECT_BEGIN) {
+        pr->id = (jq_int64)r->tape[r->tape_pos + 4];
+    }
+    pthread_mutex_unlock(&parallel_lock);
+}
+
+void count_parallel_events(struct jq_handler *h, enum jq_event_type e) {
+    (void)h;
+    (void)e;
+    pthread_mutex_lock(&parallel_lock);
+    ++parallel_events;
+    pthread_mutex_unlock(&parallel_lock);
+}
+
+int compare_records(const void *a, const void *b) {
+    const struct parallel_record *ra = (const struct parallel_record *)a, *rb = (const struct parallel_record *)b;
+    return ra->offset < rb->offset ? -1 : ra->offset > rb->offset;
+}
+
+jq_bool parse_parallel(unsigned threads, jq_size chunk_size, jq_bool ordered) {
+    struct jq_parallel p;
+    jq_bool r;
+    size_t sz;
+    char *json = make_ndjson(&sz);
+
+    p.threads = threads;
+    p.chunk_size = chunk_size;
+    p.ordered = ordered;
+    p.record = collect_record;
+    p.callback = count_parallel_events;
+    p.udata = JQ_NULL;
+    parallel_count = 0;
+    parallel_events = 0;
+    r = jq_parse_parallel(json, sz, &p);
+    free(json);
+
+    return r;
+}
+
+TEST_CASE(test_parallel_records)
+    char arrays[] = "[1][1][1][1][1][1][1][1]\n";
+    struct jq_parallel p;
+    size_t i, errors = 0;
+    size_t sz;
+    char *json = make_ndjson(&sz);
+
+    TEST_REQUIRE(parse_parallel(1, 0, JQ_TRUE) == JQ_TRUE);
+    for (i = 0; i < parallel_count; ++i) {
+        struct parallel_record *r = &parallel_records[i];
+
+        if (r->error != JQ_ERR_OK) {
+            ++errors;
+            TEST_REQUIRE(r->error == JQ_ERR_PARSER_UNEXPECTED_TOKEN);
+            TEST_REQUIRE(r->tape_size == 0);
+            TEST_REQUIRE(json[r->offset + r->size] == '\n');
+        } else if (json[r->offset] == '{') {
+            TEST_REQUIRE(r->tape_size == 20);
+            TEST_REQUIRE(json[r->offset + r->size - 1] == '}' && json[r->offset + r->size] == '\n');
+            TEST_REQUIRE(r->id == strtol(json + r->offset + 7, NULL, 10));
+        }
+        if (i) TEST_REQUIRE(r->offset > parallel_records[i - 1].offset);
+    }
+    /* 3000 lines, 231 empty, 396 broken, 216 with two values */
+    TEST_REQUIRE(errors == 396);
+    TEST_REQUIRE(parallel_count == 3000 - 231 + 216);
+    free(json);
+
+    /* The tape of a record can be longer than its input */
+    p.threads = 1;
+    p.chunk_size = 0;
+    p.ordered = JQ_TRUE;
+    p.record = collect_record;
+    p.callback = JQ_NULL;
+    p.udata = JQ_NULL;
+    parallel_count = 0;
+    TEST_REQUIRE(jq_parse_parallel(arrays, sizeof(arrays) - 1, &p) == JQ_TRUE);
+    TEST_REQUIRE(parallel_count == 8);
+    for (i = 0; i < parallel_count; ++i) {
+        TEST_REQUIRE(parallel_records[i].error == JQ_ERR_OK && parallel_records[i].tape_size == 4);
+    }
+TEST_CASE_END()
+
+/* More threads and any chunk size give the same records, in order or not */
+TEST_CASE(test_parallel_threads)
+    static struct parallel_record reference[2 * NDJSON_LINES];
+    jq_size chunk_sizes[] = { 1, 100, 4096, 0 };
+    size_t count, events, c;
+    int ordered;
+
+    TEST_REQUIRE(parse_parallel(1, 0, JQ_TRUE) == JQ_TRUE);
+    count = parallel_count;
+    events = parallel_events;
+    memcpy(reference, parallel_records, count * sizeof(struct parallel_record));
+
+    for (ordered = 0; ordered < 2; ++ordered) {
+        for (c = 0; c < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); ++c) {
+            TEST_REQUIRE(parse_parallel(4, chunk_sizes[c], ordered) == JQ_TRUE);
+            TEST_REQUIRE(parallel_count == count);
+            TEST_REQUIRE(parallel_events == events);
+            if (!ordered) qsort(parallel_records, count, sizeof(struct parallel_record), compare_records);
+            TEST_REQUIRE(memcmp(reference, parallel_records, count * sizeof(struct parallel_record)) == 0);
+        }
+    }
+TEST_CASE_END()
+
+/* The last line can end without a newline, a number there is not cut */
+TEST_CASE(test_parallel_last_line)
+    const char *inputs[] = { "{\"a\":1}\n42", "[1]\n-2.5e3", "7\n{\"id\": 3}", "1\n{\"a\"", "1\ntru",
+        "[1]\n1234567890123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890" };
+    enum jq_error errors[] = { JQ_ERR_OK, JQ_ERR_OK, JQ_ERR_OK, JQ_ERR_LEXER_NEED_MORE, JQ_ERR_LEXER_NEED_MORE,
+        JQ_ERR_OK };
+    jq_size chunk_sizes[] = { 1, 3, 0 };
+    struct jq_parallel p;
+    char json[128];
+    size_t i, c;
+
+    p.threads = 4;
+    p.ordered = JQ_TRUE;
+    p.record = collect_record;
+    p.callback = JQ_NULL;
+    p.udata = JQ_NULL;
+    for (i = 0; i < sizeof(inputs) / sizeof(inputs[0]); ++i) {
+        size_t sz = strlen(inputs[i]);
+
+        for (c = 0; c < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); ++c) {
+            memcpy(json, inputs[i], sz + 1);
+            p.chunk_size = chunk_sizes[c];
+            parallel_count = 0;
+            TEST_REQUIRE(jq_parse_parallel(json, sz, &p) == JQ_TRUE);
+            TEST_REQUIRE(parallel_count == 2);
+            TEST_REQUIRE(parallel_records[0].error == JQ_ERR_OK);
+            TEST_REQUIRE(parallel_records[1].error == errors[i]);
+            TEST_REQUIRE(parallel_records[1].offset == (size_t)(strchr(inputs[i], '\n') - inputs[i]) + 1);
+            TEST_REQUIRE(parallel_records[1].offset + parallel_records[1].size == sz);
+        }
+    }
+TEST_CASE_END()
+
+#define ARRAY_ELEMENTS 2000
+
+/* Elements with commas and brackets in strings, escaped quotes and backslashes, deep nesting */
+char *make_json_array(size_t *sz) {
+    char *json = (char *)malloc(ARRAY_ELEMENTS * 96 + 16);
+    size_t i;
+
+    *sz = sprintf(json, " [\n");
+    for (i = 0; i < ARRAY_ELEMENTS; ++i) {
+        if (i) *sz += sprintf(json + *sz, i % 5 ? ",\n" : " , ");
+        if (i % 17 == 0) {
+            *sz += sprintf(json + *sz, "[[[[[[[[[[[[[[[[[[[%u, [], {}]]]]]]]]]]]]]]]]]]]", (unsigned)i);
+        } else if (i % 5 == 1) {
+            *sz += sprintf(json + *sz, "\"s,]\\\\\\\",[%u\\\\\"", (unsigned)i);
+        } else if (i % 5 == 2) {
+            *sz += sprintf(json + *sz, "%u.5", (unsigned)i);
+        } else if (i % 5 == 3) {
+            *sz += sprintf(json + *sz, i % 3 ? "true" : i % 3 == 1 ? "null" : "false");
+        } else {
+            *sz += sprintf(json + *sz, "{\"id\": %u, \"k,]\": [\"\\\\\", {\"x\": \",\"}], \"e\": []}", (unsigned)i);
+        }
+    }
+    *sz += sprintf(json + *sz, "\n]\n");
+
+    return json;
+}
+
+jq_bool parse_parallel_array(const char *input, size_t sz, unsigned threads, jq_size chunk_size, jq_bool ordered) {
+    struct jq_parallel p;
+    jq_bool r;
+    char *json = (char *)malloc(sz + 1);
+
+    memcpy(json, input, sz + 1);
+    p.threads = threads;
+    p.chunk_size = chunk_size;
+    p.ordered = ordered;
+    p.record = collect_record;
+    p.callback = count_parallel_events;
+    p.udata = JQ_NULL;
+    parallel_count = 0;
+    parallel_events = 0;
+    r = jq_parse_parallel_array(json, sz, &p);
+    free(json);
+
+    return r;
+}
+
+/* The elements are the records, the events are those of jq_parse */
+TEST_CASE(test_parallel_array_elements)
+    size_t i, sz, events;
+    char *json = make_json_array(&sz);
+    struct jq_handler h;
+
+    json[sz] = '\0';
+    TEST_REQUIRE(parse_parallel_array(json, sz, 1, 0, JQ_TRUE) == JQ_TRUE);
+    TEST_REQUIRE(parallel_count == ARRAY_ELEMENTS);
+    events = parallel_events;
+    for (i = 0; i < parallel_count; ++i) {
+        struct parallel_record *r = &parallel_records[i];
+        char first = json[r->offset], last = json[r->offset + r->size - 1];
+
+        TEST_REQUIRE(r->error == JQ_ERR_OK);
+        TEST_REQUIRE(strchr("[{\"tfn0123456789", first) != NULL);
+        TEST_REQUIRE(strchr("]}\"el5", last) != NULL);
+        TEST_REQUIRE(strchr(", \n", json[r->offset + r->size]) != NULL);
+        if (first == '{') TEST_REQUIRE(r->id == strtol(json + r->offset + 7, NULL, 10));
+        if (i % 17 == 0) TEST_REQUIRE(r->tape_size == 2 * 19 + 6);
+        if (i) TEST_REQUIRE(r->offset > parallel_records[i - 1].offset + parallel_records[i - 1].size);
+    }
+
+    jq_init(&h);
+    jq_set_callback(&h, count_parallel_events);
+    parallel_events = 0;
+    jq_append_buf(&h, json, sz);
+    TEST_REQUIRE(jq_parse(&h) == JQ_TRUE);
+    TEST_REQUIRE(parallel_events == events);
+    free(json);
+TEST_CASE_END()
+
+/* The split points in strings and deep in the elements don't change the records */
+TEST_CASE(test_parallel_array_threads)
+    static struct parallel_record reference[ARRAY_ELEMENTS];
+    jq_size chunk_sizes[] = { 1, 7, 100, 4096, 0 };
+    size_t sz, count, events, c;
+    char *json = make_json_array(&sz);
+    int ordered;
+
+    json[sz] = '\0';
+    TEST_REQUIRE(parse_parallel_array(json, sz, 1, 0, JQ_TRUE) == JQ_TRUE);
+    count = parallel_count;
+    events = parallel_events;
+    memcpy(reference, parallel_records, count * sizeof(struct parallel_record));
+
+    for (ordered = 0; ordered < 2; ++ordered) {
+        for (c = 0; c < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); ++c) {
+            TEST_REQUIRE(parse_parallel_array(json, sz, 4, chunk_sizes[c], ordered) == JQ_TRUE);
+            TEST_REQUIRE(parallel_count == count);
+            TEST_REQUIRE(parallel_events == events);
+            if (!ordered) qsort(parallel_records, count, sizeof(struct parallel_record), compare_records);
+            TEST_REQUIRE(memcmp(reference, parallel_records, count * sizeof(struct parallel_record)) == 0);
+        }
+    }
+    free(json);
+TEST_CASE_END()
+
+/* An error stops the records, anything but an array is one record */
+TEST_CASE(test_parallel_array_errors)
+    const char *broken = "[1, {\"a\": [true, false]}, \"x\", {\"b\": ]}, 2, 3, 4, 5, 6]";
+    const char *after = "[1, 2, 3, 4] [5]";
+    const char *object = "{\"id\": 7, \"a\": [1, 2]}";
+    jq_size chunk_sizes[] = { 1, 5, 0 };
+    size_t c, i;
+
+    for (c = 0; c < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); ++c) {
+        TEST_REQUIRE(parse_parallel_array(broken, strlen(broken), 4, chunk_sizes[c], JQ_TRUE) == JQ_FALSE);
+        TEST_REQUIRE(parallel_count == 4);
+        for (i = 0; i < 3; ++i) TEST_REQUIRE(parallel_records[i].error == JQ_ERR_OK);
+        TEST_REQUIRE(parallel_records[3].error == JQ_ERR_PARSER_UNEXPECTED_TOKEN);
+        TEST_REQUIRE(parallel_records[3].offset == 31);
+
+        TEST_REQUIRE(parse_parallel_array(after, strlen(after), 4, chunk_sizes[c], JQ_TRUE) == JQ_FALSE);
+        TEST_REQUIRE(parallel_count == 5);
+        TEST_REQUIRE(parallel_records[4].error == JQ_ERR_PARSER_UNEXPECTED_TOKEN);
+    }
+
+    TEST_REQUIRE(parse_parallel_array(object, strlen(object), 4, 3, JQ_TRUE) == JQ_TRUE);
+    TEST_REQUIRE(parallel_count == 1);
+    TEST_REQUIRE(parallel_records[0].offset == 0 && parallel_records[0].size == strlen(object));
+    TEST_REQUIRE(parallel_records[0].id == 7);
+
+    /* The end of the input finishes a number */
+    TEST_REQUIRE(parse_parallel_array("-12.5e3", 7, 4, 3, JQ_TRUE) == JQ_TRUE);
+    TEST_REQUIRE(parallel_count == 1 && parallel_records[0].error == JQ_ERR_OK && parallel_records[0].size == 7);
+
+    /* An empty input is not a JSON */
+    TEST_REQUIRE(parse_parallel_array("", 0, 4, 0, JQ_TRUE) == JQ_FALSE);
+    TEST_REQUIRE(parallel_count == 1 && parallel_records[0].error == JQ_ERR_LEXER_NEED_MORE);
+    TEST_REQUIRE(parse_parallel_array(" \n", 2, 4, 1, JQ_TRUE) == JQ_FALSE);
+    TEST_REQUIRE(parallel_count == 1 && parallel_records[0].error == JQ_ERR_LEXER_NEED_MORE);
+TEST_CASE_END()
+
+static const char shared_json[] = "{\"glossary\": {\"title\": \"example\\n glossary\", \"n\": [1, 2.5e3, -7],"
+    " \"GlossDiv\": {\"title\": \"S\", \"ok\": true, \"no\": false, \"nil\": null, \"list\": [\"GML\", \"XML\"]}}}";
+
+/* Counts the events and the length of the values, the buffer is shared by the threads */
+void *parse_shared(void *arg) {
+    size_t *sum = (size_t *)arg;
+    struct jq_handler h;
+    enum jq_event_type e;
+
+    jq_init(&h);
+    jq_append_const_buf(&h, shared_json, sizeof(shared_json) - 1);
+    while ((e = jq_next(&h)) != JQ_E_DONE && e != JQ_E_ERROR && e != JQ_E_NEED_MORE) {
+        sum[0] += 1;
+        if (e == JQ_E_STRING || e == JQ_E_OBJECT_KEY || e == JQ_E_NUMBER) sum[1] += jq_get_view(&h).len;
+    }
+    if (e != JQ_E_DONE) sum[0] = 0;
+
+    return NULL;
+}
+
+/* Many readers parse one constant buffer at the same time */
+TEST_CASE(test_shared_buffer)
+    pthread_t threads[4];
+    size_t sums[4][2], reference[2] = { 0, 0 };
+    int i;
+
+    parse_shared(reference);
+    TEST_REQUIRE(reference[0] == 29);
+    memset(sums, 0, sizeof(sums));
+    for (i = 0; i < 4; ++i) TEST_REQUIRE(pthread_create(&threads[i], NULL, parse_shared, sums[i]) == 0);
+    for (i = 0; i < 4; ++i) pthread_join(threads[i], NULL);
+    for (i = 0; i < 4; ++i) TEST_REQUIRE(sums[i][0] == reference[0] && sums[i][1] == reference[1]);
+TEST_CASE_END()
+
+/*
+ * main suite_parallel function
+ */
+
+TEST_SUITE(suite_parallel)
+    TEST_CASE_RUN(test_parallel_records);
+    TEST_CASE_RUN(test_parallel_threads);
+    TEST_CASE_RUN(test_parallel_last_line);
+    TEST_CASE_RUN(test_parallel_array_elements);
+    TEST_CASE_RUN(test_parallel_array_threads);
+    TEST_CASE_RUN(test_parallel_array_errors);
+    TEST_CASE_RUN(test_shared_buffer);
+TEST_SUITE_END()
+#endif
+
+/* ==============================
+ *
+ * Test suite suite_file
+ *
+ ================================ */
+
+#ifdef JQ_WITH_MMAP
+static size_t raw_strings;
+
+/* In the read-only mode a string is kept as it is, up to its closing quote */
+void check_raw_string(struct jq_handler *h, enum jq_event_type e) {
+    if ((e == JQ_E_STRING || e == JQ_E_OBJECT_KEY) && h->val[h->vlen] == '"' && h->val[-1] == '"') ++raw_strings;
+}
+
+#ifdef JQ_WITH_TAPE
+/* The mapped file gives the same tape as the file read into memory */
+TEST_CASE(test_file_tape)
+    static jq_uint64 tape[1024], mapped[1024];
+    struct jq_handler h;
+    size_t sz;
+    char *json = read_json("../assets/glossary.json", &sz);
+    if (!json) return 0;
+
+    jq_init(&h);
+    jq_set_tape(&h, tape, 1024);
+    TEST_REQUIRE(jq_parse_buf(&h, json, sz) == JQ_TRUE);
+    free(json);
+    sz = h.tape_size;
+
+    jq_init(&h);
+    jq_set_tape(&h, mapped, 1024);
+    TEST_REQUIRE(jq_parse_file(&h, "../assets/glossary.json") == JQ_TRUE);
+    TEST_REQUIRE(h.tape_size == sz);
+    TEST_REQUIRE(memcmp(tape, mapped, sz * sizeof(jq_uint64)) == 0);
+TEST_CASE_END()
+#endif
+
+/* The strings are not decoded or terminated, the mapping is read-only */
+TEST_CASE(test_file_raw_strings)
+    struct jq_handler h;
+
+    jq_init(&h);
+    jq_set_callback(&h, check_raw_string);
+    raw_strings = 0;
+    TEST_REQUIRE(jq_parse_file(&h, "../assets/glossary-esc-unicode.json") == JQ_TRUE);
+    TEST_REQUIRE(raw_strings > 0);
+    TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_OK);
+TEST_CASE_END()
+
+#ifdef JQ_WITH_NUMBERS
+/* The end of the file ends a number */
+TEST_CASE(test_file_number)
+    struct jq_handler h;
+
+    jq_init(&h);
+    TEST_REQUIRE(jq_parse_file(&h, "../assets/number.json") == JQ_TRUE);
+    TEST_REQUIRE(jq_get_double(&h) == -12500.0);
+    TEST_REQUIRE(h.vlen == 7);
+TEST_CASE_END()
+#endif
+
+/* The end of the file finishes a number longer than any tail copy */
+TEST_CASE(test_file_long_number)
+    struct jq_handler h;
+    char expected[128];
+    size_t sz;
+    char *json = read_json("../assets/long-number.json", &sz);
+
+    TEST_REQUIRE(json != NULL);
+    sprintf(expected, "%d:%.*s|", JQ_E_NUMBER, (int)sz, json);
+    free(json);
+
+    event_log_size = 0;
+    jq_init(&h);
+    jq_set_callback(&h, log_events);
+    TEST_REQUIRE(jq_parse_file(&h, "../assets/long-number.json") == JQ_TRUE);
+    TEST_REQUIRE(strcmp(event_log, expected) == 0);
+TEST_CASE_END()
+
+TEST_CASE(test_file_errors)
+    struct jq_handler h;
+
+    jq_init(&h);
+    TEST_REQUIRE(jq_parse_file(&h, "../assets/no-such-file.json") == JQ_FALSE);
+    TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_FILE);
+
+    jq_init(&h);
+    TEST_REQUIRE(jq_parse_file(&h, "../assets/glossary-grammar-error.json") == JQ_FALSE);
+    TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_PARSER_UNEXPECTED_TOKEN);
+
+    jq_init(&h);
+    TEST_REQUIRE(jq_parse_file(&h, "../assets/glossary-lexical-error.json") == JQ_FALSE);
+    TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_LEXER_UNKNOWN_TOKEN);
+TEST_CASE_END()
+#endif
+
+/* A string literal is read-only memory, it can be parsed in the read-only mode only */
+TEST_CASE(test_readonly_buffer)
+    static const char json[] = "{\"a\\n\": [1, 2.5, \"x\\u0041\", true], \"b\": {\"c\": null}}";
+#ifdef JQ_WITH_INDEX
+    static jq_index index[64];
+    int passes = 2;
+#else
+    int passes = 1;
+#endif
+    struct jq_handler h;
+    enum jq_event_type e;
+    size_t strings;
+    int indexed;
+
+    for (indexed = 0; indexed < passes; ++indexed) {
+        jq_init(&h);
+        jq_set_readonly(&h, JQ_TRUE);
+#ifdef JQ_WITH_INDEX
+        if (indexed) jq_set_index(&h, index, 64);
+#endif
+        jq_append_buf(&h, (jq_char *)json, sizeof(json) - 1);
+        strings = 0;
+        while ((e = jq_next(&h)) != JQ_E_DONE) {
+            TEST_REQUIRE(e != JQ_E_ERROR && e != JQ_E_NEED_MORE);
+            if (e == JQ_E_STRING || e == JQ_E_OBJECT_KEY) {
+                TEST_REQUIRE(h.val[h.vlen] == '"');
+                ++strings;
+            }
+            if (e == JQ_E_NUMBER) TEST_REQUIRE(h.vlen == 1 || h.vlen == 3);
+        }
+        TEST_REQUIRE(strings == 4);
+    }
+TEST_CASE_END()
+
+/* Every scalar is a view of the constant buffer */
+TEST_CASE(test_const_views)
+    static const char json[] = "{\"k\": [\"a\\\"b\", -1.5e2, null, true, false, 42]}";
+    static const char *views[] = { "k", "a\\\"b", "-1.5e2", "null", "true", "false", "42" };
+    struct jq_handler h;
+    enum jq_event_type e;
+    size_t n = 0;
+
+    jq_init(&h);
+    jq_append_const_buf(&h, json, sizeof(json) - 1);
+    while ((e = jq_next(&h)) != JQ_E_DONE) {
+        struct jq_view v = jq_get_view(&h);
+
+        TEST_REQUIRE(e != JQ_E_ERROR && e != JQ_E_NEED_MORE);
+        if (e == JQ_E_OBJECT_BEGIN || e == JQ_E_OBJECT_END || e == JQ_E_ARRAY_BEGIN || e == JQ_E_ARRAY_END) continue;
+        TEST_REQUIRE(n < sizeof(views) / sizeof(views[0]));
+        TEST_REQUIRE(v.len == strlen(views[n]) && memcmp(v.ptr, views[n], v.len) == 0);
+        ++n;
+    }
+    TEST_REQUIRE(n == sizeof(views) / sizeof(views[0]));
+#ifdef JQ_WITH_LOCATION
+    /* The number is ended by the line end, which is put back */
+    jq_init(&h);
+    jq_append_const_buf(&h, "[1,\n 22\n]", 9);
+    while ((e = jq_next(&h)) != JQ_E_NUMBER || h.vlen != 2) TEST_REQUIRE(e != JQ_E_DONE);
+    TEST_REQUIRE(jq_get_location(&h).line == 1 && jq_get_location(&h).column == 3);
+#endif
+TEST_CASE_END()
+
+#ifdef JQ_WITH_READER
+/* Parses the file descriptor with the buffers of sz bytes logging the events into event_log */
+jq_bool parse_fd_logged(int fd, jq_size sz, unsigned depth) {
+    static jq_char mem[65536];
+    struct jq_handler h;
+
+    event_log_size = 0;
+    event_log[0] = '\0';
+    jq_init(&h);
+    jq_set_callback(&h, log_events);
+    return jq_parse_fd(&h, fd, mem, sz * depth, depth);
+}
+
+/* Every buffer size and depth must give the same events as the whole file */
+TEST_CASE(test_reader_events)
+    const char *files[] = { "../assets/glossary.json", "../assets/glossary-esc.json",
+        "../assets/glossary-esc-unicode.json", "../assets/web-app.json" };
+    jq_size sizes[] = { 200, 256, 1000, 4096 };
+    unsigned depths[] = { 1, 2, 4, 8 };
+    static char expected[sizeof(event_log)];
+    size_t f, s, d;
+
+    for (f = 0; f < sizeof(files) / sizeof(files[0]); ++f) {
+        TEST_REQUIRE(parse_logged(files[f], NULL, 0) == JQ_TRUE);
+        memcpy(expected, event_log, event_log_size + 1);
+        for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+            for (d = 0; d < sizeof(depths) / sizeof(depths[0]); ++d) {
+                int fd = open(files[f], O_RDONLY);
+
+                TEST_REQUIRE(fd >= 0);
+                TEST_REQUIRE(parse_fd_logged(fd, sizes[s], depths[d]) == JQ_TRUE);
+                TEST_REQUIRE(strcmp(expected, event_log) == 0);
+                close(fd);
+            }
+        }
+    }
+
+    /* The end of the file ends the number */
+    for (d = 0; d < sizeof(depths) / sizeof(depths[0]); ++d) {
+        int fd = open("../assets/number.json", O_RDONLY);
+
+        TEST_REQUIRE(fd >= 0);
+        TEST_REQUIRE(parse_fd_logged(fd, 64, depths[d]) == JQ_TRUE);
+        TEST_REQUIRE(strcmp(event_log, "261:-12.5e3|") == 0);
+        close(fd);
+    }
+TEST_CASE_END()
+
+/* A pipe can't be read at offsets, it's read one buffer at a time */
+TEST_CASE(test_reader_pipe)
+    static char expected[sizeof(event_log)];
+    size_t sz;
+    char *json = read_json("../assets/web-app.json", &sz);
+    int fds[2];
+
+    TEST_REQUIRE(json != NULL);
+    TEST_REQUIRE(parse_logged("../assets/web-app.json", NULL, 0) == JQ_TRUE);
+    memcpy(expected, event_log, event_log_size + 1);
+
+    /* The file fits the pipe, so it's written before it's read */
+    TEST_REQUIRE(pipe(fds) == 0);
+    TEST_REQUIRE(write(fds[1], json, sz) == (long)sz);
+    close(fds[1]);
+    TEST_REQUIRE(parse_fd_logged(fds[0], 128, 3) == JQ_TRUE);
+    TEST_REQUIRE(strcmp(expected, event_log) == 0);
+    close(fds[0]);
+    free(json);
+TEST_CASE_END()
+
+TEST_CASE(test_reader_errors)
+    static jq_char mem[256];
+    struct jq_handler h;
+    int fd;
+
+    /* The longest string of glossary.json doesn't fit the room of 16 bytes */
+    fd = open("../assets/glossary.json", O_RDONLY);
+    TEST_REQUIRE(fd >= 0);
+    jq_init(&h);
+    TEST_REQUIRE(jq_parse_fd(&h, fd, mem, 256, 8) == JQ_FALSE);
+    TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_BUFFER_FULL);
+    close(fd);
+
+    fd = open("../assets/glossary-grammar-error.json", O_RDONLY);
+    jq_init(&h);
+    TEST_REQUIRE(jq_parse_fd(&h, fd, mem, 256, 2) == JQ_FALSE);
+    TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_PARSER_UNEXPECTED_TOKEN);
+    close(fd);
+
+    jq_init(&h);
+    TEST_REQUIRE(jq_parse_fd(&h, -1, mem, 256, 2) == JQ_FALSE);
+    TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_FILE);
+
+    /* An empty input is not a JSON */
+    fd = open("/dev/null", O_RDONLY);
+    jq_init(&h);
+    TEST_REQUIRE(jq_parse_fd(&h, fd, mem, 256, 2) == JQ_FALSE);
+    TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_LEXER_NEED_MORE);
+    close(fd);
+TEST_CASE_END()
+#endif
+
+/*
+ * main suite_file function
+ */
+
+TEST_SUITE(suite_file)
+#ifdef JQ_WITH_MMAP
+#ifdef JQ_WITH_TAPE
+    TEST_CASE_RUN(test_file_tape);
+#endif
+    TEST_CASE_RUN(test_file_raw_strings);
+#ifdef JQ_WITH_NUMBERS
+    TEST_CASE_RUN(test_file_number);
+#endif
+    TEST_CASE_RUN(test_file_long_number);
+    TEST_CASE_RUN(test_file_errors);
+#endif
+    TEST_CASE_RUN(test_readonly_buffer);
+    TEST_CASE_RUN(test_const_views);
+#ifdef JQ_WITH_READER
+    TEST_CASE_RUN(test_reader_events);
+    TEST_CASE_RUN(test_reader_pipe);
+    TEST_CASE_RUN(test_reader_errors);
+#endif
+TEST_SUITE_END()
+
+/* ==============================
+ *
+ * Test suite suite_validate
+ *
+ ================================ */
+
+/* The files are valid json and the lexical and grammar errors are found */
+TEST_CASE(test_validate_files)
+    const char *files[] = { "../assets/glossary.json", "../assets/glossary-esc.json",
+        "../assets/glossary-esc-unicode.json", "../assets/web-app.json", "../assets/number.json",
+        "../assets/glossary-lexical-error.json", "../assets/glossary-grammar-error.json" };
+    enum jq_error errors[] = { JQ_ERR_OK, JQ_ERR_OK, JQ_ERR_OK, JQ_ERR_OK, JQ_ERR_OK,
+        JQ_ERR_LEXER_UNKNOWN_TOKEN, JQ_ERR_PARSER_UNEXPECTED_TOKEN };
+    size_t f, sz;
+    jq_size offset;
+
+    for (f = 0; f < sizeof(files) / sizeof(files[0]); ++f) {
+        char *json = read_json(files[f], &sz);
+
+        TEST_REQUIRE(json != NULL);
+        TEST_REQUIRE(jq_validate(json, sz, &offset) == errors[f]);
+        TEST_REQUIRE(errors[f] != JQ_ERR_OK || offset == sz);
+        free(json);
+    }
+TEST_CASE_END()
+
+/* The error codes and offsets */
+TEST_CASE(test_validate_errors)
+    static const struct { const char *json; enum jq_error error; jq_size offset; } cases[] = {
+        { "1", JQ_ERR_OK, 1 }, { " -0.5e-3 ", JQ_ERR_OK, 9 }, { "[]", JQ_ERR_OK, 2 },
+        { " { } ", JQ_ERR_OK, 5 }, { "[[], {\"a\": [{}, null]}, true, false]", JQ_ERR_OK, 36 },
+        { "\"\\u00e9\xc3\xa9\\n\"", JQ_ERR_OK, 12 },
+        { "", JQ_ERR_LEXER_NEED_MORE, 0 }, { "  ", JQ_ERR_LEXER_NEED_MORE, 2 },
+        { "[1, 2", JQ_ERR_LEXER_NEED_MORE, 5 }, { "{\"a\"", JQ_ERR_LEXER_NEED_MORE, 4 },
+        { "\"abc", JQ_ERR_LEXER_NEED_MORE, 4 }, { "1e+", JQ_ERR_LEXER_NEED_MORE, 3 },
+        { "nul", JQ_ERR_LEXER_NEED_MORE, 3 },
+        { "[1, 2]]", JQ_ERR_PARSER_UNEXPECTED_TOKEN, 6 }, { "{\"a\" 1}", JQ_ERR_PARSER_UNEXPECTED_TOKEN, 5 },
+        { "{\"a\": 1,}", JQ_ERR_PARSER_UNEXPECTED_TOKEN, 8 }, { "[1,]", JQ_ERR_PARSER_UNEXPECTED_TOKEN, 3 },
+        { "{1: 2}", JQ_ERR_PARSER_UNEXPECTED_TOKEN, 1 }, { "[1}", JQ_ERR_PARSER_UNEXPECTED_TOKEN, 2 },
+        { "1 2", JQ_ERR_PARSER_UNEXPECTED_TOKEN, 2 }, { "01", JQ_ERR_PARSER_UNEXPECTED_TOKEN, 1 },
+        { "true", JQ_ERR_OK, 4 }, { "5true", JQ_ERR_PARSER_UNEXPECTED_TOKEN, 1 },
+        { "{\"ID\": \"x\", true", JQ_ERR_PARSER_UNEXPECTED_TOKEN, 12 }, { "5 tru", JQ_ERR_LEXER_NEED_MORE, 5 },
+        { "[1, x]", JQ_ERR_LEXER_UNKNOWN_TOKEN, 4 }, { "-x", JQ_ERR_LEXER_UNKNOWN_TOKEN, 1 },
+        { "1.e5", JQ_ERR_LEXER_UNKNOWN_TOKEN, 2 }, { "nulL", JQ_ERR_LEXER_UNKNOWN_TOKEN, 3 },
+        { "1e+x", JQ_ERR_LEXER_EXPONENT_ERROR, 3 }, { "\"a\\x\"", JQ_ERR_LEXER_UNKNOWN_ESCAPE_SYMBOL, 3 },
+#ifdef JQ_WITH_UTF8_CHECK
+        { "\"\x01\"", JQ_ERR_LEXER_CONTROL_CHAR, 1 }, { "\"\xc3\x28\"", JQ_ERR_LEXER_INVALID_UTF8, 2 },
+#endif
+        { "\"\\u12g4\"", JQ_ERR_LEXER_UNKNOWN_ESCAPE_SYMBOL, 5 }
+    };
+    static char deep[2 * JQ_STACK_SIZE];
+    size_t k;
+    jq_size offset;
+
+    for (k = 0; k < sizeof(cases) / sizeof(cases[0]); ++k) {
+        TEST_REQUIRE(jq_validate(cases[k].json, strlen(cases[k].json), &offset) == cases[k].error);
+        TEST_REQUIRE(offset == cases[k].offset);
+    }
+    TEST_REQUIRE(jq_validate("[1, x]", 6, JQ_NULL) == JQ_ERR_LEXER_UNKNOWN_TOKEN);
+
+    /* The nesting deeper than the stack */
+    memset(deep, '[', JQ_STACK_SIZE - 1);
+    memset(deep + JQ_STACK_SIZE - 1, ']', JQ_STACK_SIZE - 1);
+    TEST_REQUIRE(jq_validate(deep, 2 * JQ_STACK_SIZE - 2, &offset) == JQ_ERR_OK);
+    memset(deep, '[', JQ_STACK_SIZE);
+    TEST_REQUIRE(jq_validate(deep, 2 * JQ_STACK_SIZE, &offset) == JQ_ERR_MAX_DEPTH);
+    TEST_REQUIRE(offset == JQ_STACK_SIZE - 1);
+TEST_CASE_END()
+
+/* The damaged files are valid and invalid as the parser finds them */
+TEST_CASE(test_validate_mutations)
+    const char *files[] = { "../assets/glossary.json", "../assets/glossary-esc-unicode.json",
+        "../assets/web-app.json" };
+    static const char bytes[] = "{}[]:,\" \\0-.e+u\x80\xc3\x01tn";
+    static char json[8192], copy[8192 + 1];
+    jq_uint64 x = 88172645463325252ull;
+    struct jq_handler h;
+    size_t f, k, sz;
+    jq_size pos, offset;
+    enum jq_error e;
+    jq_bool ok;
+
+    for (f = 0; f < sizeof(files) / sizeof(files[0]); ++f) {
+        char *orig = read_json(files[f], &sz);
+
+        TEST_REQUIRE(orig != NULL && sz < sizeof(json));
+        for (k = 0; k < 20000; ++k) {
+            size_t n = sz;
+
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            memcpy(json, orig, sz);
+            pos = (jq_size)(x >> 32) % sz;
+            switch (x % 3) {
+            case 0: json[pos] = bytes[(x >> 8) % (sizeof(bytes) - 1)]; break;
+            case 1: memmove(json + pos + 1, json + pos, n - pos); json[pos] = bytes[(x >> 8) % (sizeof(bytes) - 1)]; ++n; break;
+            default: memmove(json + pos, json + pos + 1, n - pos - 1); --n; break;
+            }
+
+            /* The parser needs a char after a number at the end */
+            memcpy(copy, json, n);
+            copy[n] = ' ';
+            jq_init(&h);
+            ok = jq_parse_buf(&h, copy, n + 1);
+
+            e = jq_validate(json, n, &offset);
+            TEST_REQUIRE((e == JQ_ERR_OK) == ok);
+            TEST_REQUIRE(e == JQ_ERR_OK || e == JQ_ERR_LEXER_NEED_MORE || e == jq_get_error(&h));
+            TEST_REQUIRE(offset <= n);
+        }
+        free(orig);
+    }
+TEST_CASE_END()
+
+
+/*
+ * main suite_validate function
+ */
+
+TEST_SUITE(suite_validate)
+    TEST_CASE_RUN(test_validate_files);
+    TEST_CASE_RUN(test_validate_errors);
+    TEST_CASE_RUN(test_validate_mutations);
+TEST_SUITE_END()
+
+/* ==============================
+ *
+ * Test suite suite_stats
+ *
+ ================================ */
+
+#ifdef JQ_WITH_STATS
+static struct jq_stats counted;
+static jq_size counted_depth;
+
+/* Counts the events as struct jq_stats does */
+void count_stats(struct jq_handler *h, enum jq_event_type e) {
+    (void)h;
+    switch (e) {
+    case JQ_E_NULL: ++counted.nulls; break;
+    case JQ_E_TRUE: ++counted.trues; break;
+    case JQ_E_FALSE: ++counted.falses; break;
+    case JQ_E_STRING: ++counted.strings; break;
+    case JQ_E_NUMBER: ++counted.numbers; break;
+    case JQ_E_OBJECT_KEY: ++counted.keys; break;
+    case JQ_E_OBJECT_BEGIN: ++counted.objects; break;
+    case JQ_E_ARRAY_BEGIN: ++counted.arrays; break;
+    case JQ_E_OBJECT_END: case JQ_E_ARRAY_END: --counted_depth; break;
+    default: break;
+    }
+    if (e == JQ_E_OBJECT_BEGIN || e == JQ_E_ARRAY_BEGIN) {
+        if (++counted_depth > counted.max_depth) counted.max_depth = counted_depth;
+    }
+}
+
+static jq_bool same_events(const struct jq_stats *a, const struct jq_stats *b) {
+    return a->nulls == b->nulls && a->trues == b->trues && a->falses == b->falses && a->strings == b->strings
+        && a->numbers == b->numbers && a->keys == b->keys && a->objects == b->objects && a->arrays == b->arrays
+        && a->max_depth == b->max_depth;
+}
+
+static jq_uint64 fake_time;
+
+/* Every document takes 1000 ticks between its beginning and end */
+jq_uint64 fake_clock(void) {
+    return fake_time += 1000;
+}
+
+TEST_CASE(test_stats_document)
+    struct jq_handler h;
+    struct jq_stats st;
+    size_t sz;
+    char *json = read_json("../assets/web-app.json", &sz);
+
+    TEST_REQUIRE(json != NULL);
+    memset(&counted, 0, sizeof(counted));
+    counted_depth = 0;
+    jq_init(&h);
+    jq_set_callback(&h, count_stats);
+    TEST_REQUIRE(jq_parse_buf(&h, json, sz) == JQ_TRUE);
+    free(json);
+
+    jq_get_stats(&h, &st);
+    TEST_REQUIRE(same_events(&st, &counted));
+    TEST_REQUIRE(st.max_depth >= 3);
+    TEST_REQUIRE(st.bytes == sz && st.documents == 1);
+    /* Every key has its ':' */
+    TEST_REQUIRE(st.tokens > st.nulls + st.trues + st.falses + st.strings + st.numbers + 2 * st.keys
+        + 2 * (st.objects + st.arrays));
+    TEST_REQUIRE(st.need_more == 1 && st.rewinds == 0 && st.tail_bytes == 0);
+    TEST_REQUIRE(st.latency[0] == 0); /* no clock */
+
+    jq_reset_stats(&h);
+    jq_get_stats(&h, &st);
+    TEST_REQUIRE(st.bytes == 0 && st.tokens == 0 && st.documents == 0 && st.strings == 0 && st.max_depth == 0);
+TEST_CASE_END()
+
+/* The same counts when the input comes in chunks, and the tails are counted */
+TEST_CASE(test_stats_chunks)
+    struct jq_handler h;
+    struct jq_stats whole, st;
+    static char part[1024];
+    size_t sz, cur, chunk = 7;
+    char *json = read_json("../assets/glossary-esc-unicode.json", &sz);
+    char *copy = (char *)malloc(sz);
+
+    TEST_REQUIRE(json != NULL && copy != NULL);
+    memcpy(copy, json, sz);
+    jq_init(&h);
+    TEST_REQUIRE(jq_parse_buf(&h, copy, sz) == JQ_TRUE);
+    jq_get_stats(&h, &whole);
+    free(copy);
+
+    jq_init(&h);
+    for (cur = 0; cur < sz; cur += chunk) {
+        size_t n = sz - cur < chunk ? sz - cur : chunk;
+        size_t tail_size = jq_get_tail_size(&h);
+
+        memmove(part, jq_get_tail(&h), tail_size);
+        memcpy(part + tail_size, json + cur, n);
+        jq_parse_buf(&h, part, tail_size + n);
+    }
+    TEST_REQUIRE(jq_get_error(&h) == JQ_ERR_OK);
+    jq_get_stats(&h, &st);
+    free(json);
+
+    TEST_REQUIRE(same_events(&st, &whole));
+    TEST_REQUIRE(st.tokens == whole.tokens && st.bytes == sz && st.documents == 1);
+    TEST_REQUIRE(st.need_more >= sz / chunk - 1 && st.rewinds > 0 && st.rewinds <= st.need_more);
+    TEST_REQUIRE(st.tail_bytes >= st.rewinds);
+TEST_CASE_END()
+
+/* Documents of the multi document mode and their times */
+TEST_CASE(test_stats_documents)
+    struct jq_handler h;
+    struct jq_stats st;
+    char json[sizeof(multi_json)];
+    size_t half;
+    int k;
+
+    strcpy(json, multi_json);
+    jq_init(&h);
+    jq_set_multi(&h, JQ_TRUE);
+    jq_set_stats_clock(&h, fake_clock);
+    TEST_REQUIRE(jq_parse_buf(&h, json, sizeof(json) - 1) == JQ_TRUE);
+    jq_get_stats(&h, &st);
+
+    TEST_REQUIRE(st.documents == 9 && st.bytes == sizeof(json) - 1);
+    TEST_REQUIRE(st.objects == 3 && st.arrays == 3 && st.keys == 2 && st.nulls == 1 && st.trues == 1);
+    TEST_REQUIRE(st.strings == 3 && st.numbers == 3 && st.max_depth == 2);
+    /* 1000 is in 512 to 1023 */
+    for (k = 0; k < JQ_STATS_BUCKETS; ++k) TEST_REQUIRE(st.latency[k] == (k == 9 ? 9u : 0u));
+
+    /* The bytes are counted from the reset */
+    strcpy(json, multi_json);
+    half = strchr(json, '4') - json;
+    jq_init(&h);
+    jq_set_multi(&h, JQ_TRUE);
+    TEST_REQUIRE(jq_parse_buf(&h, json, half) == JQ_TRUE);
+    jq_reset_stats(&h);
+    jq_append_buf(&h, json + half, sizeof(json) - 1 - half);
+    TEST_REQUIRE(jq_parse(&h) == JQ_TRUE);
+    jq_get_stats(&h, &st);
+    TEST_REQUIRE(st.bytes == sizeof(json) - 1 - half && st.documents == 5 && st.latency[9] == 0);
+TEST_CASE_END()
+
+
+/*
+ * main suite_stats function
+ */
+
+TEST_SUITE(suite_stats)
+    TEST_CASE_RUN(test_stats_document);
+    TEST_CASE_RUN(test_stats_chunks);
+    TEST_CASE_RUN(test_stats_documents);
+TEST_SUITE_END()
+#endif
+
+/* ==============================
+ *
+ * Location
+ *
+ ================================ */
+
+#ifdef JQ_WITH_LOCATION
+/* Documents with line ends around the values and "\n" decoded into the strings */
+static const char location_json[] =
+    "{\"a\\nb\": [1,\n 2, \"x\\u000ay\\n\"], \"c\":\n\ttrue}\n"
+    "[null,\n\n\"\\\\n\", -1.5e3\n]\n"
+    "  42\n"
+    "\"\\n\\n\"\n";
+
+/* Checks the location of the parser against the one counted in the original input */
+static jq_bool same_location(struct jq_handler *h, const char *json) {
+    struct jq_location loc = jq_get_location(h);
+    jq_size offset = jq_get_offset(h), line = 0, column = 0, i;
+
+    for (i = 0; i < offset; ++i) {
+        if (json[i] == '\n') {
+            ++line;
+            column = 0;
+        } else {
+            ++column;
+        }
+    }
+
+    return loc.line == line && loc.column == column;
+}
+
+/* Parses json in chunks of the size given, checking the location at every event */
+static jq_bool parse_located(const char *json, size_t chunk, struct jq_location *last) {
+    static char part[1024];
+    struct jq_handler h;
+    size_t sz = strlen(json), cur = chunk < sz ? chunk : sz;
+    enum jq_event_type e;
+
+    memcpy(part, json, cur);
+    jq_init(&h);
+    jq_set_multi(&h, JQ_TRUE);
+    jq_append_buf(&h, part, cur);
+    for (;;) {
+        e = jq_next(&h);
+        if (!same_location(&h, json)) return JQ_FALSE;
+        if (e == JQ_E_ERROR) break;
+        /* JQ_E_DONE is the end of the buffer between the documents */
+        if (e == JQ_E_NEED_MORE || e == JQ_E_DONE) {
+            size_t n = sz - cur < chunk ? sz - cur : chunk, tail_size = jq_get_tail_size(&h);
+            if (n == 0) break;
+            memmove(part, jq_get_tail(&h), tail_size);
+            memcpy(part + tail_size, json + cur, n);
+            cur += n;
+            jq_append_buf(&h, part, tail_size + n);
+        }
+    }
+
+    *last = jq_get_location(&h);
+    return JQ_TRUE;
+}
+
+TEST_CASE(test_location_events)
+    struct jq_location whole, loc;
+    size_t chunk;
+
+    TEST_REQUIRE(parse_located(location_json, sizeof(location_json), &whole));
+    TEST_REQUIRE(whole.line == 9 && whole.column == 0);
+    for (chunk = 1; chunk <= 16; ++chunk) {
+        TEST_REQUIRE(parse_located(location_json, chunk, &loc));
+        TEST_REQUIRE(loc.line == whole.line && loc.column == whole.column);
+    }
+TEST_CASE_END()
+
+TEST_CASE(test_location_errors)
+    static const struct {
+        const char *json;
+        jq_size line, column;
+    } cases[] = {
+        /* The lexer errors are at the beginning of the broken token */
+        { "{\n  \"a\": 1,\n  \"b\": tru\n}", 2, 7 },
+        { "[\"a\\nb\",\n  \"c\\u000a\",\n  \"\\x\"]", 2, 2 },
+        { "[\"\\n\\n\", \"\\n\", 1.e5]", 0, 15 },
+        /* The parser errors are right after the unexpected token */
+        { "{\n\t\"a\\n\" 1}", 1, 8 },
+        { "[1,\r\n2,\r\n]", 2, 1 }
+    };
+    struct jq_location whole, loc;
+    size_t k, chunk;
+
+    for (k = 0; k < sizeof(cases) / sizeof(cases[0]); ++k) {
+        TEST_REQUIRE(parse_located(cases[k].json, strlen(cases[k].json), &whole));
+        TEST_REQUIRE(whole.line == cases[k].line && whole.column == cases[k].column);
+        for (chunk = 1; chunk <= 8; ++chunk) {
+            TEST_REQUIRE(parse_located(cases[k].json, chunk, &loc));
+            TEST_REQUIRE(loc.line == whole.line && loc.column == whole.column);
+        }
+    }
+TEST_CASE_END()
+
+
+/*
+ * main suite_location function
+ */
+
+TEST_SUITE(suite_location)
+    TEST_CASE_RUN(test_location_events);
+    TEST_CASE_RUN(test_location_errors);
+TEST_SUITE_END()
+#endif
+
+/* ==============================
+ *
+ * Suspending
+ *
+ ================================ */
+
+#ifdef JQ_WITH_SUSPEND
+/* Logs the documents and the values of the numbers too */
+void log_suspended(struct jq_handler *h, enum jq_event_type e) {
+    log_documents(h, e);
+    if (e == JQ_E_NUMBER) event_log_size += sprintf(event_log + event_log_size, "%.17g|", jq_get_double(h));
+}
+
+/*
+ * Parses json in chunks, the handler is suspended before every chunk and resumed from
+ * the blob, then the handler, the blob and the previous buffer are wiped.
+ * The largest blob without its tail goes to max_blob.
+ */
+jq_bool parse_suspended(const char *json, size_t sz, size_t chunk, jq_bool multi, size_t *max_blob) {
+    static char part[8192];
+    static jq_char blob[8192];
+    struct jq_handler h;
+    size_t cur;
+    jq_bool r = JQ_FALSE;
+
+    event_log_size = 0;
+    event_log[0] = '\0';
+    *max_blob = 0;
+    jq_init(&h);
+    jq_set_multi(&h, multi);
+    for (cur = 0; cur < sz; cur += chunk) {
+        size_t n = sz - cur < chunk ? sz - cur : chunk, tail_size, blob_size;
+
+        blob_size = jq_suspend(&h, JQ_NULL, 0);
+        if (blob_size == 0 || blob_size > sizeof(blob) || jq_suspend(&h, blob, blob_size) != blob_size) return JQ_FALSE;
+        memset(&h, 0xa5, sizeof(h));
+        memset(part, 0xa5, sizeof(part));
+        if (!jq_resume(&h, blob, blob_size, part, sizeof(part))) return JQ_FALSE;
+        memset(blob, 0xa5, blob_size);
+        jq_set_callback(&h, log_suspended);
+
+        /* The tail is at the beginning of part already */
+        tail_size = jq_get_tail_size(&h);
+        if (blob_size - tail_size > *max_blob) *max_blob = blob_size - tail_size;
+        memmove(part, jq_get_tail(&h), tail_size);
+        memcpy(part + tail_size, json + cur, n);
+        r = jq_parse_buf(&h, part, tail_size + n);
+        if (!r && jq_get_error(&h) != JQ_ERR_LEXER_NEED_MORE) return JQ_FALSE;
+    }
+
+    return r && jq_get_error(&h) == JQ_ERR_OK;
+}
+
+/* The events are the same as the ones of the whole input */
+TEST_CASE(test_suspend_chunks)
+    static const char numbers[] =
+        "[{\"a\\u00e9\\ud83d\\ude00\": [-12.5e-3, 123456789012345678901234, 0.1, true, false, null]}, \"\\n\", 7]";
+    const char *files[] = { "../assets/web-app.json", "../assets/glossary-esc-unicode.json" };
+    static char json[8192], expected[sizeof(event_log)];
+    size_t chunks[] = { 1, 2, 3, 7, 64 };
+    size_t f, c, sz = 0, max_blob;
+
+    for (f = 0; f < sizeof(files) / sizeof(files[0]) + 3; ++f) {
+        jq_bool multi = f == sizeof(files) / sizeof(files[0]) + 1;
+
+        if (f < sizeof(files) / sizeof(files[0])) {
+            char *file = read_json(files[f], &sz);
+            TEST_REQUIRE(file != NULL && sz < sizeof(json));
+            memcpy(json, file, sz);
+            free(file);
+        } else if (f == sizeof(files) / sizeof(files[0])) {
+            sz = sizeof(numbers) - 1;
+            memcpy(json, numbers, sz);
+        } else if (multi) {
+            sz = sizeof(multi_json) - 1;
+            memcpy(json, multi_json, sz);
+        } else {
+            /* The levels cross the bytes of the stack in the blob */
+            sz = 0;
+            for (c = 0; c < 100; ++c) {
+                if (c % 3) {
+                    json[sz++] = '[';
+                } else {
+                    memcpy(json + sz, "{\"k\":", 5);
+                    sz += 5;
+                }
+            }
+            json[sz++] = '1';
+            for (c = 100; c--; ) json[sz++] = c % 3 ? ']' : '}';
+        }
+
+        TEST_REQUIRE(parse_suspended(json, sz, sz, multi, &max_blob));
+        memcpy(expected, event_log, event_log_size + 1);
+        for (c = 0; c < sizeof(chunks) / sizeof(chunks[0]); ++c) {
+            TEST_REQUIRE(parse_suspended(json, sz, chunks[c], multi, &max_blob));
+            /* A few dozen bytes, the statistics take a half of them, 100 levels take 13 */
+            TEST_REQUIRE(max_blob <= 112);
+            TEST_REQUIRE(strcmp(expected, event_log) == 0);
+        }
+    }
+TEST_CASE_END()
+
+/* The handler can be suspended only when it waits for more input, a broken blob is not resumed */
+TEST_CASE(test_suspend_errors)
+    struct jq_handler h;
+    static jq_char blob[1024], tail[1024];
+    char json[] = "{\"a\": [1, 2], \"b\": \"abc";
+    size_t blob_size, k;
+    jq_bool ok = JQ_TRUE;
+
+    jq_init(&h);
+    jq_append_buf(&h, json, sizeof(json) - 1);
+    TEST_REQUIRE(jq_next(&h) == JQ_E_OBJECT_BEGIN);
+    /* The rest of the buffer is not parsed yet */
+    TEST_REQUIRE(jq_suspend(&h, blob, sizeof(blob)) == 0);
+    while (jq_next(&h) != JQ_E_NEED_MORE) {}
+    blob_size = jq_suspend(&h, blob, sizeof(blob));
+    TEST_REQUIRE(blob_size > jq_get_tail_size(&h) && jq_get_tail_size(&h) == 4);
+    /* Too small memory is not written */
+    memset(blob + blob_size - 1, 0, 1);
+    TEST_REQUIRE(jq_suspend(&h, blob, blob_size - 1) == blob_size && blob[blob_size - 1] == '\0');
+    TEST_REQUIRE(jq_suspend(&h, blob, blob_size) == blob_size);
+
+    for (k = 0; k < blob_size; ++k) ok = ok && !jq_resume(&h, blob, k, tail, sizeof(tail));
+    TEST_REQUIRE(ok);
+    ++blob[0];
+    TEST_REQUIRE(jq_resume(&h, blob, blob_size, tail, sizeof(tail)) == JQ_FALSE);
+    --blob[0];
+    /* The tail doesn't fit */
+    TEST_REQUIRE(jq_resume(&h, blob, blob_size, tail, 3) == JQ_FALSE);
+    TEST_REQUIRE(jq_resume(&h, blob, blob_size, JQ_NULL, 0) == JQ_FALSE);
+    /* The blob is not needed after it */
+    TEST_REQUIRE(jq_resume(&h, blob, blob_size, tail, 4) == JQ_TRUE);
+    memset(blob, 0, blob_size);
+    TEST_REQUIRE(jq_get_tail(&h) == tail && memcmp(tail, "\"abc", 4) == 0);
+    TEST_REQUIRE(jq_next(&h) == JQ_E_NEED_MORE && jq_get_offset(&h) == sizeof(json) - 5);
+
+    /* The error is not suspended */
+    jq_init(&h);
+    jq_append_const_buf(&h, "[1, }", 5);
+    TEST_REQUIRE(jq_parse(&h) == JQ_FALSE);
+    TEST_REQUIRE(jq_suspend(&h, blob, sizeof(blob)) == 0);
+TEST_CASE_END()
+
+
+/*
+ * main suite_suspend function
+ */
+
+TEST_SUITE(suite_suspend)
+    TEST_CASE_RUN(test_suspend_chunks);
+    TEST_CASE_RUN(test_suspend_errors);
+TEST_SUITE_END()
+#endif
+
+/* ==============================
+ *
+ * Test suite suite_writer
+ *
+ ================================ */
+
+#ifdef JQ_WITH_WRITER
+static char write_out[65536];
+static size_t write_out_size;
+
+jq_bool collect_output(void *udata, const jq_char *data, jq_size sz) {
+    (void)udata;
+    if (write_out_size + sz > sizeof(write_out)) return JQ_FALSE;
+    memcpy(write_out + write_out_size, data, sz);
+    write_out_size += sz;
+    return JQ_TRUE;
+}
+
+/* Writes the same document with any writer */
+jq_bool write_document(struct jq_writer *w) {
+    return jq_write_object_begin(w)
+        && jq_write_key(w, "a", 1)
+        && jq_write_array_begin(w)
+        && jq_write_int64(w, 1) && jq_write_int64(w, -2)
+        && jq_write_bool(w, JQ_TRUE) && jq_write_bool(w, JQ_FALSE) && jq_write_null(w)
+        && jq_write_string(w, "x\ny\"", 4)
+        && jq_write_array_end(w)
+        && jq_write_key(w, "b\t", 2)
+        && jq_write_object_begin(w) && jq_write_object_end(w)
+        && jq_write_key(w, "c", 1)
+        && jq_write_array_begin(w) && jq_write_raw(w, "{\"d\": 1}", 8) && jq_write_array_end(w)
+        && jq_write_object_end(w)
+        && jq_write_uint64(w, 5)
+        && jq_writer_flush(w);
+}
+
+TEST_CASE(test_writer_document)
+    static const char expected[] = "{\"a\":[1,-2,true,false,null,\"x\\ny\\\"\"],\"b\\t\":{},\"c\":[{\"d\": 1}]}\n5";
+    jq_char buf[256];
+    struct jq_writer w;
+
+    TEST_REQUIRE(jq_writer_init(&w, buf, sizeof(buf), JQ_NULL, JQ_NULL) == JQ_TRUE);
+    TEST_REQUIRE(write_document(&w) == JQ_TRUE);
+    TEST_REQUIRE(jq_writer_get_size(&w) == sizeof(expected) - 1);
+    TEST_REQUIRE(memcmp(buf, expected, sizeof(expected) - 1) == 0);
+TEST_CASE_END()
+
+/* Any buffer size gives the same output with the flush callback */
+TEST_CASE(test_writer_flush)
+    static const char expected[] = "{\"a\":[1,-2,true,false,null,\"x\\ny\\\"\"],\"b\\t\":{},\"c\":[{\"d\": 1}]}\n5";
+    jq_char buf[32];
+    struct jq_writer w;
+    jq_size sz;
+
+    for (sz = 1; sz <= sizeof(buf); ++sz) {
+        write_out_size = 0;
+        TEST_REQUIRE(jq_writer_init(&w, buf, sz, collect_output, JQ_NULL) == JQ_TRUE);
+        TEST_REQUIRE(write_document(&w) == JQ_TRUE);
+        TEST_REQUIRE(write_out_size == sizeof(expected) - 1);
+        TEST_REQUIRE(memcmp(write_out, expected, sizeof(expected) - 1) == 0);
+    }
+TEST_CASE_END()
+
+/* Every char is escaped or not so that the string is parsed back as it was */
+TEST_CASE(test_writer_escape)
+    static jq_char s[400];
+    static const char utf8[] = "\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80";
+    jq_char buf[1024];
+    struct jq_writer w;
+    struct jq_handler h;
+    jq_size len = 0, k;
+    int c;
+
+    for (c = 0; c < 0x80; ++c) s[len++] = (jq_char)c;
+    for (k = 0; k < sizeof(utf8) - 1; ++k) s[len++] = utf8[k];
+    /* The long runs without escaping go through the wide scans */
+    for (k = 0; k < 100; ++k) s[len++] = (jq_char)('a' + k % 26);
+    s[len++] = '"';
+    for (k = 0; k < 4 * (sizeof(utf8) - 1); ++k) s[len++] = utf8[k % (sizeof(utf8) - 1)];
+    s[len++] = '\x1f';
+
+    jq_writer_init(&w, buf, sizeof(buf), JQ_NULL, JQ_NULL);
+    TEST_REQUIRE(jq_write_string(&w, s, len) == JQ_TRUE);
+    TEST_REQUIRE(memchr(buf, '\n', jq_writer_get_size(&w)) == NULL);
+    TEST_REQUIRE(memcmp(buf, "\"\\u0000\\u0001", 13) == 0);
+
+    jq_init(&h);
+    jq_append_buf(&h, buf, jq_writer_get_size(&w));
+    TEST_REQUIRE(jq_next(&h) == JQ_E_STRING);
+    TEST_REQUIRE(h.vlen == len && memcmp(h.val, s, len) == 0);
+TEST_CASE_END()
+
+TEST_CASE(test_writer_numbers)
+    static const char expected[] = "[-9223372036854775808,9223372036854775807,18446744073709551615,0,null,null]";
+    double doubles[] = { 0.1, -1e300, 5e-324, 1.5, 1e21, -0.0, 123456789012345680.0 };
+    jq_char buf[256];
+    struct jq_writer w;
+    struct jq_handler h;
+    size_t k;
+
+    jq_writer_init(&w, buf, sizeof(buf), JQ_NULL, JQ_NULL);
+    jq_write_array_begin(&w);
+    jq_write_int64(&w, -9223372036854775807ll - 1);
+    jq_write_int64(&w, 9223372036854775807ll);
+    jq_write_uint64(&w, 18446744073709551615ull);
+    jq_write_int64(&w, 0);
+    jq_write_double(&w, 0.0 / 0.0);
+    jq_write_double(&w, 1e308 * 10);
+    TEST_REQUIRE(jq_write_array_end(&w) == JQ_TRUE);
+    TEST_REQUIRE(jq_writer_get_size(&w) == sizeof(expected) - 1 && memcmp(buf, expected, sizeof(expected) - 1) == 0);
+
+    /* The doubles are parsed back to the same bits */
+    for (k = 0; k < sizeof(doubles) / sizeof(doubles[0]); ++k) {
+        double v;
+
+        jq_writer_init(&w, buf, sizeof(buf), JQ_NULL, JQ_NULL);
+        TEST_REQUIRE(jq_write_double(&w, doubles[k]) == JQ_TRUE);
+        buf[jq_writer_get_size(&w)] = ' ';
+        jq_init(&h);
+        jq_append_buf(&h, buf, jq_writer_get_size(&w) + 1);
+        TEST_REQUIRE(jq_next(&h) == JQ_E_NUMBER);
+        v = jq_get_double(&h);
+        TEST_REQUIRE(memcmp(&v, &doubles[k], sizeof(v)) == 0);
+    }
+TEST_CASE_END()
+
+/* The shortest text of a double, it's parsed back to the same bits by jquick */
+TEST_CASE(test_writer_format)
+    static const struct { double v; const char *text; } cases[] = {
+        { 0.0, "0" }, { -0.0, "-0" }, { 1.0, "1" }, { -3.5, "-3.5" }, { 0.1, "0.1" },
+        { 0.30000000000000004, "0.30000000000000004" }, { 100.0, "100" }, { 1e20, "100000000000000000000" },
+        { 1e21, "1e21" }, { 1.5e300, "1.5e300" }, { 0.000001, "0.000001" }, { 1e-7, "1e-7" },
+        { 1.7976931348623157e308, "1.7976931348623157e308" }, { 5e-324, "5e-324" },
+        { 2.2250738585072014e-308, "2.2250738585072014e-308" }, { 9007199254740993.0, "9007199254740992" },
+        { 123456789012345680.0, "123456789012345680" }, { 1.0 / 3, "0.3333333333333333" }
+    };
+    jq_char buf[JQ_FORMAT_SIZE + 1];
+    struct jq_handler h;
+    jq_uint64 x = 88172645463325252ull, bits;
+    size_t k;
+    jq_size n;
+    double v, back;
+
+    for (k = 0; k < sizeof(cases) / sizeof(cases[0]); ++k) {
+        n = jq_format_double(buf, cases[k].v);
+        TEST_REQUIRE(n == strlen(cases[k].text) && memcmp(buf, cases[k].text, n) == 0);
+    }
+    TEST_REQUIRE(jq_format_double(buf, 1e308 * 10) == 0);
+
+    for (k = 0; k < 100000; ++k) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        /* Subnormals and integers too */
+        bits = k % 3 == 0 ? x & 0x800fffffffffffffull : x;
+        memcpy(&v, &bits, sizeof(v));
+        if (k % 3 == 1) v = (double)(jq_int64)(x >> 11) / (double)(k % 1000 + 1);
+
+        n = jq_format_double(buf, v);
+        if (n == 0) continue;
+        buf[n] = ' ';
+        jq_init(&h);
+        jq_append_buf(&h, buf, n + 1);
+        TEST_REQUIRE(jq_next(&h) == JQ_E_NUMBER && h.vlen == n);
+        back = jq_get_double(&h);
+        TEST_REQUIRE(memcmp(&back, &v, sizeof(v)) == 0);
+    }
+TEST_CASE_END()
+
+/* The digits are counted right at the powers of ten */
+TEST_CASE(test_writer_integers)
+    char expected[32];
+    jq_char buf[JQ_FORMAT_SIZE];
+    jq_uint64 p = 1;
+    jq_size n;
+    int k;
+
+    for (k = 0; k < 20; ++k, p *= 10) {
+        jq_uint64 v[3];
+        int j;
+
+        v[0] = p - 1;
+        v[1] = p;
+        v[2] = p + 1;
+        for (j = 0; j < 3; ++j) {
+            n = jq_format_uint64(buf, v[j]);
+            sprintf(expected, "%llu", v[j]);
+            TEST_REQUIRE(n == strlen(expected) && memcmp(buf, expected, n) == 0);
+            n = jq_format_int64(buf, -(jq_int64)(v[j] >> 1));
+            sprintf(expected, "%lld", -(jq_int64)(v[j] >> 1));
+            TEST_REQUIRE(n == strlen(expected) && memcmp(buf, expected, n) == 0);
+        }
+    }
+    n = jq_format_uint64(buf, 18446744073709551615ull);
+    TEST_REQUIRE(n == 20 && memcmp(buf, "18446744073709551615", n) == 0);
+    n = jq_format_int64(buf, -9223372036854775807ll - 1);
+    TEST_REQUIRE(n == 20 && memcmp(buf, "-9223372036854775808", n) == 0);
+TEST_CASE_END()
+
+/* Reformats the whole json into write_out */
+jq_bool reformat_json(const char *json, size_t sz, unsigned indent) {
+    static jq_char buf[64];
+    struct jq_handler h;
+    struct jq_writer w;
+
+    write_out_size = 0;
+    jq_init(&h);
+    jq_writer_init(&w, buf, sizeof(buf), collect_output, JQ_NULL);
+    jq_append_const_buf(&h, json, sz);
+    return jq_reformat(&h, &w, indent) && jq_writer_flush(&w);
+}
+
+TEST_CASE(test_reformat_output)
+    static const char json[] = " {\"a\" :[1 , {}, [ ],\"x\\n\\u0041\"], \"b\":\n null, \"c\": [[-0.5e+3]]} 7 true\n";
+    static const char pretty[] =
+        "{\n  \"a\": [\n    1,\n    {},\n    [],\n    \"x\\n\\u0041\"\n  ],\n  \"b\": null,\n"
+        "  \"c\": [\n    [\n      -0.5e+3\n    ]\n  ]\n}\n7\ntrue";
+    static const char minified[] = "{\"a\":[1,{},[],\"x\\n\\u0041\"],\"b\":null,\"c\":[[-0.5e+3]]}\n7\ntrue";
+
+    TEST_REQUIRE(reformat_json(json, sizeof(json) - 1, 2) == JQ_TRUE);
+    TEST_REQUIRE(write_out_size == sizeof(pretty) - 1 && memcmp(write_out, pretty, write_out_size) == 0);
+    TEST_REQUIRE(reformat_json(json, sizeof(json) - 1, 0) == JQ_TRUE);
+    TEST_REQUIRE(write_out_size == sizeof(minified) - 1 && memcmp(write_out, minified, write_out_size) == 0);
+TEST_CASE_END()
+
+/* The output has the same events, the minified one has no whitespace out of the strings */
+TEST_CASE(test_reformat_files)
+    const char *files[] = { "../assets/glossary.json", "../assets/glossary-esc.json",
+        "../assets/glossary-esc-unicode.json", "../assets/web-app.json" };
+    static char expected[sizeof(event_log)];
+    unsigned indents[] = { 0, 1, 4, 70 };
+    static char out[sizeof(write_out)];
+    struct jq_handler h;
+    size_t f, k, sz;
+
+    for (f = 0; f < sizeof(files) / sizeof(files[0]); ++f) {
+        char *json = read_json(files[f], &sz);
+
+        TEST_REQUIRE(json != NULL);
+        TEST_REQUIRE(parse_logged(files[f], NULL, 0) == JQ_TRUE);
+        memcpy(expected, event_log, event_log_size + 1);
+
+        for (k = 0; k < sizeof(indents) / sizeof(indents[0]); ++k) {
+            TEST_REQUIRE(reformat_json(json, sz, indents[k]) == JQ_TRUE);
+            memcpy(out, write_out, write_out_size);
+            event_log_size = 0;
+            jq_init(&h);
+            jq_set_callback(&h, log_events);
+            TEST_REQUIRE(jq_parse_buf(&h, out, write_out_size) == JQ_TRUE);
+            TEST_REQUIRE(strcmp(expected, event_log) == 0);
+
+            if (indents[k] == 0) {
+                jq_bool in_string = JQ_FALSE;
+                size_t i;
+
+                for (i = 0; i < write_out_size; ++i) {
+                    if (write_out[i] == '"' && write_out[i - 1] != '\\') in_string = !in_string;
+                    TEST_REQUIRE(in_string || !strchr(" \t\r\n", write_out[i]));
+                }
+            }
+        }
+        free(json);
+    }
+TEST_CASE_END()
+
+/* The output doesn't depend on the chunks the input comes in */
+TEST_CASE(test_reformat_chunks)
+    size_t chunks[] = { 1, 7, 64, 1000 };
+    static char expected[sizeof(write_out)];
+    static char part[2048];
+    size_t sz, c, pos;
+    char *json = read_json("../assets/glossary-esc-unicode.json", &sz);
+    unsigned indent;
+
+    TEST_REQUIRE(json != NULL);
+    for (indent = 0; indent < 3; indent += 2) {
+        TEST_REQUIRE(reformat_json(json, sz, indent) == JQ_TRUE);
+        memcpy(expected, write_out, write_out_size + 1);
+
+        for (c = 0; c < sizeof(chunks) / sizeof(chunks[0]); ++c) {
+            static jq_char buf[16];
+            struct jq_handler h;
+            struct jq_writer w;
+            jq_bool r = JQ_FALSE;
+            size_t expected_size = write_out_size;
+
+            write_out_size = 0;
+            jq_init(&h);
+            jq_writer_init(&w, buf, sizeof(buf), collect_output, JQ_NULL);
+            for (pos = 0; pos < sz; pos += chunks[c]) {
+                size_t tail = jq_get_tail_size(&h), n = sz - pos < chunks[c] ? sz - pos : chunks[c];
+
+                memmove(part, jq_get_tail(&h), tail);
+                memcpy(part + tail, json + pos, n);
+                jq_append_buf(&h, part, tail + n);
+                r = jq_reformat(&h, &w, indent);
+                TEST_REQUIRE(r == JQ_TRUE || jq_get_error(&h) == JQ_ERR_LEXER_NEED_MORE);
+            }
+            TEST_REQUIRE(r == JQ_TRUE && jq_writer_flush(&w) == JQ_TRUE);
+            TEST_REQUIRE(write_out_size == expected_size && memcmp(write_out, expected, expected_size) == 0);
+        }
+    }
+    free(json);
+TEST_CASE_END()
+
+/* Reformats the json, returns the error code of the handler */
+enum jq_error reformat_error(const char *json) {
+    static jq_char buf[64];
+    struct jq_handler h;
+    struct jq_writer w;
+
+    write_out_size = 0;
+    jq_init(&h);
+    jq_writer_init(&w, buf, sizeof(buf), collect_output, JQ_NULL);
+    jq_append_const_buf(&h, json, strlen(json));
+    jq_reformat(&h, &w, 2);
+    return jq_get_error(&h);
+}
+
+TEST_CASE(test_reformat_errors)
+    /* The separators and the brackets are checked as jq_parse does it */
+    const char *unexpected[] = { "[1 2]", "[true false]", "{\"a\" \"b\"}", "{]", "[}", "[1, 2]]", "[1,]",
+        "{\"a\": 1,}", "{\"a\", 1}", "{1: 2}", "{\"a\"}", "[\"a\": 1]", "1, 2 ", ": 1 " };
+    size_t i;
+
+    for (i = 0; i < sizeof(unexpected) / sizeof(unexpected[0]); ++i) {
+        TEST_REQUIRE(reformat_error(unexpected[i]) == JQ_ERR_PARSER_UNEXPECTED_TOKEN);
+    }
+    TEST_REQUIRE(reformat_error("[1, 2") == JQ_ERR_LEXER_NEED_MORE);
+    TEST_REQUIRE(reformat_error("[1, x]") == JQ_ERR_LEXER_UNKNOWN_TOKEN);
+    TEST_REQUIRE(reformat_error("[] {} 1 \"a\" ") == JQ_ERR_OK);
+    /* The number is not finished at the end */
+    TEST_REQUIRE(reformat_json("12", 2, 0) == JQ_FALSE);
+    TEST_REQUIRE(reformat_json("12 ", 3, 0) == JQ_TRUE);
+TEST_CASE_END()
+
+TEST_CASE(test_writer_errors)
+    jq_char buf[8];
+    struct jq_writer w;
+#ifdef JQ_WITH_WRITER_CHECK
+    static jq_char deep[JQ_STACK_SIZE * 8];
+    size_t k;
+#endif
+
+    TEST_REQUIRE(jq_writer_init(&w, buf, 0, JQ_NULL, JQ_NULL) == JQ_FALSE);
+    TEST_REQUIRE(jq_write_null(&w) == JQ_FALSE);
+
+    /* Without the callback the output must fit the buffer */
+    jq_writer_init(&w, buf, sizeof(buf), JQ_NULL, JQ_NULL);
+    TEST_REQUIRE(jq_write_bool(&w, JQ_FALSE) == JQ_TRUE);
+    TEST_REQUIRE(jq_write_null(&w) == JQ_FALSE);
+    TEST_REQUIRE(jq_get_error(&w) == JQ_ERR_WRITER_FLUSH);
+
+#ifdef JQ_WITH_WRITER_CHECK
+    jq_writer_init(&w, buf, sizeof(buf), JQ_NULL, JQ_NULL);
+    TEST_REQUIRE(jq_write_key(&w, "a", 1) == JQ_FALSE);
+    TEST_REQUIRE(jq_get_error(&w) == JQ_ERR_WRITER_UNEXPECTED);
+    /* The error is kept */
+    TEST_REQUIRE(jq_write_null(&w) == JQ_FALSE);
+
+    jq_writer_init(&w, buf, sizeof(buf), JQ_NULL, JQ_NULL);
+    TEST_REQUIRE(jq_write_object_begin(&w) == JQ_TRUE);
+    TEST_REQUIRE(jq_write_null(&w) == JQ_FALSE);
+
+    jq_writer_init(&w, buf, sizeof(buf), JQ_NULL, JQ_NULL);
+    TEST_REQUIRE(jq_write_object_begin(&w) == JQ_TRUE);
+    TEST_REQUIRE(jq_write_key(&w, "a", 1) == JQ_TRUE);
+    TEST_REQUIRE(jq_write_key(&w, "b", 1) == JQ_FALSE);
+
+    jq_writer_init(&w, buf, sizeof(buf), JQ_NULL, JQ_NULL);
+    TEST_REQUIRE(jq_write_object_begin(&w) == JQ_TRUE);
+    TEST_REQUIRE(jq_write_key(&w, "a", 1) == JQ_TRUE);
+    TEST_REQUIRE(jq_write_object_end(&w) == JQ_FALSE);
+
+    jq_writer_init(&w, buf, sizeof(buf), JQ_NULL, JQ_NULL);
+    TEST_REQUIRE(jq_write_array_begin(&w) == JQ_TRUE);
+    TEST_REQUIRE(jq_write_object_end(&w) == JQ_FALSE);
+
+    jq_writer_init(&w, buf, sizeof(buf), JQ_NULL, JQ_NULL);
+    TEST_REQUIRE(jq_write_array_end(&w) == JQ_FALSE);
+    TEST_REQUIRE(jq_get_error(&w) == JQ_ERR_WRITER_UNEXPECTED);
+
+    /* The nesting deeper than the stack */
+    jq_writer_init(&w, deep, sizeof(deep), JQ_NULL, JQ_NULL);
+    for (k = 0; k < JQ_STACK_SIZE - 1; ++k) {
+        TEST_REQUIRE((k % 2 ? jq_write_array_begin(&w) : jq_write_object_begin(&w) && jq_write_key(&w, "a", 1)));
+    }
+    TEST_REQUIRE(jq_write_array_begin(&w) == JQ_FALSE);
+    TEST_REQUIRE(jq_get_error(&w) == JQ_ERR_MAX_DEPTH);
+#endif
+TEST_CASE_END()
+
+/*
+ * main suite_writer function
+ */
+
+TEST_SUITE(suite_writer)
+    TEST_CASE_RUN(test_writer_document);
+    TEST_CASE_RUN(test_writer_flush);
+    TEST_CASE_RUN(test_writer_escape);
+    TEST_CASE_RUN(test_writer_numbers);
+    TEST_CASE_RUN(test_writer_format);
+    TEST_CASE_RUN(test_writer_integers);
+    TEST_CASE_RUN(test_writer_errors);
+    TEST_CASE_RUN(test_reformat_output);
+    TEST_CASE_RUN(test_reformat_files);
+    TEST_CASE_RUN(test_reformat_chunks);
+    TEST_CASE_RUN(test_reformat_errors);
 TEST_SUITE_END()
+#endif
 
 /* ==============================
  *
@@ -312,6 +3026,35 @@ TEST_SUITE_END()
 TEST(jquick)
     TEST_SUITE_RUN(suite_basic);
     TEST_SUITE_RUN(suite_streaming);
+#ifdef JQ_WITH_INDEX
+    TEST_SUITE_RUN(suite_index);
+#endif
+#ifdef JQ_WITH_NUMBERS
+    TEST_SUITE_RUN(suite_numbers);
+#endif
+#if defined(JQ_WITH_TAPE) && defined(JQ_WITH_NUMBERS)
+    TEST_SUITE_RUN(suite_tape);
+#endif
+    TEST_SUITE_RUN(suite_cursor);
+    TEST_SUITE_RUN(suite_control);
+    TEST_SUITE_RUN(suite_multi);
+#ifdef JQ_WITH_THREADS
+    TEST_SUITE_RUN(suite_parallel);
+#endif
+    TEST_SUITE_RUN(suite_file);
+    TEST_SUITE_RUN(suite_validate);
+#ifdef JQ_WITH_STATS
+    TEST_SUITE_RUN(suite_stats);
+#endif
+#ifdef JQ_WITH_LOCATION
+    TEST_SUITE_RUN(suite_location);
+#endif
+#ifdef JQ_WITH_SUSPEND
+    TEST_SUITE_RUN(suite_suspend);
+#endif
+#ifdef JQ_WITH_WRITER
+    TEST_SUITE_RUN(suite_writer);
+#endif
 TEST_END()
 
 int main() {